@@ -69,6 +69,18 @@ mod ffi_inner {
         pub undo_pos: u32,
     }
 
+    /// Location of a tx and its undo data within the block and undo files.
+    #[derive(Clone, Debug, Default, Eq, PartialEq)]
+    pub struct TxLocation {
+        /// File number of the block and undo files the tx is stored in.
+        pub file_num: u32,
+        /// Where the tx is stored within the block file.
+        pub data_pos: u32,
+        /// Where the tx's undo data is stored within the undo file, or 0 for
+        /// coinbase txs, which don't have any.
+        pub undo_pos: u32,
+    }
+
     /// CTransaction, in a block or in the mempool.
     #[derive(Clone, Debug, Default, Eq, PartialEq)]
     pub struct Tx {
@@ -255,6 +267,14 @@ mod ffi_inner {
             undo_pos: u32,
         ) -> Result<Tx>;
 
+        /// Load many txs like `load_tx`, in one go. The disk reads are done
+        /// in file order, which is much faster than loading the txs one by
+        /// one when they are scattered across the block files.
+        fn load_txs(
+            self: &ChronikBridge,
+            locations: &[TxLocation],
+        ) -> Result<Vec<Tx>>;
+
         /// Load the CTransaction from disk and serialize it.
         fn load_raw_tx(
             self: &ChronikBridge,
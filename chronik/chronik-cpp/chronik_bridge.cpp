@@ -289,6 +289,41 @@ Tx ChronikBridge::load_tx(uint32_t file_num, uint32_t data_pos,
     return BridgeTx(isCoinbase, CTransaction(std::move(tx)), txundo.vprevout);
 }
 
+rust::Vec<Tx>
+ChronikBridge::load_txs(rust::Slice<const TxLocation> locations) const {
+    std::vector<FlatFilePos> tx_positions;
+    std::vector<FlatFilePos> undo_positions;
+    tx_positions.reserve(locations.size());
+    for (const TxLocation &location : locations) {
+        tx_positions.emplace_back(location.file_num, location.data_pos);
+        if (location.undo_pos != 0) {
+            undo_positions.emplace_back(location.file_num, location.undo_pos);
+        }
+    }
+
+    std::vector<CMutableTransaction> txs;
+    if (!m_node.chainman->m_blockman.ReadTxsFromDisk(txs, tx_positions)) {
+        throw std::runtime_error("Reading tx data from disk failed");
+    }
+    std::vector<CTxUndo> tx_undos;
+    if (!m_node.chainman->m_blockman.ReadTxUndosFromDisk(tx_undos,
+                                                         undo_positions)) {
+        throw std::runtime_error("Reading tx undo data from disk failed");
+    }
+
+    rust::Vec<Tx> bridged_txs;
+    bridged_txs.reserve(locations.size());
+    auto tx_undo = tx_undos.begin();
+    for (size_t i = 0; i < locations.size(); ++i) {
+        const bool isCoinbase = locations[i].undo_pos == 0;
+        bridged_txs.push_back(
+            BridgeTx(isCoinbase, CTransaction(std::move(txs[i])),
+                     isCoinbase ? std::vector<::Coin>{}
+                                : (tx_undo++)->vprevout));
+    }
+    return bridged_txs;
+}
+
 rust::Vec<uint8_t> ChronikBridge::load_raw_tx(uint32_t file_num,
                                               uint32_t data_pos) const {
     CMutableTransaction tx;
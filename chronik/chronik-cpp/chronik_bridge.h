@@ -30,6 +30,7 @@ namespace chronik_bridge {
 struct BlockInfo;
 struct Block;
 struct Tx;
+struct TxLocation;
 struct OutPoint;
 struct WrappedBlockHash;
 struct RawBlockHeader;
@@ -82,6 +83,8 @@ public:
 
     Tx load_tx(uint32_t file_num, uint32_t data_pos, uint32_t undo_pos) const;
 
+    rust::Vec<Tx> load_txs(rust::Slice<const TxLocation> locations) const;
+
     rust::Vec<uint8_t> load_raw_tx(uint32_t file_num, uint32_t data_pos) const;
 
     rust::Vec<uint8_t> get_block_header(const CBlockIndex &index) const;
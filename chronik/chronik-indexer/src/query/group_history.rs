@@ -12,6 +12,7 @@ use bitcoinsuite_core::{
     tx::{Tx, TxId},
 };
 use bytes::Bytes;
+use chronik_bridge::ffi::TxLocation;
 use chronik_db::{
     db::Db,
     group::{Group, GroupMember},
@@ -179,7 +180,7 @@ impl<'a, G: Group> QueryGroupHistory<'a, G> {
         // attacks are not possible.
         let num_returned_txs =
             request_page_size.min(num_db_txs.saturating_sub(first_tx_idx));
-        let mut page_txs = Vec::with_capacity(num_returned_txs);
+        let mut page_tx_nums = Vec::with_capacity(num_returned_txs);
 
         // Short-circuit so we don't fetch DB again if no results.
         if num_returned_txs == 0 {
@@ -194,22 +195,22 @@ impl<'a, G: Group> QueryGroupHistory<'a, G> {
         // Iterate DB pages, starting from the DB page the first tx is in.
         // Since DB pages are much larger than MAX_HISTORY_PAGE_SIZE, this will
         // only fetch 2 pages at most.
-        for current_page_num in db_page_num_start..num_db_pages {
+        'outer: for current_page_num in db_page_num_start..num_db_pages {
             let db_page_tx_nums = db_reader
                 .page_txs(member_ser.as_ref(), current_page_num as u32)?
                 .unwrap_or_default();
             for &tx_num in db_page_tx_nums.iter().skip(first_inner_idx) {
-                page_txs.push(self.read_block_tx(tx_num)?);
-                // We filled up the requested page size -> return
-                if page_txs.len() == request_page_size {
-                    return Ok(make_result(page_txs));
+                page_tx_nums.push(tx_num);
+                // We filled up the requested page size -> stop
+                if page_tx_nums.len() == request_page_size {
+                    break 'outer;
                 }
             }
             first_inner_idx = 0;
         }
 
-        // Couldn't fill requested page size completely
-        Ok(make_result(page_txs))
+        // The page might not be completely filled
+        Ok(make_result(self.read_block_txs(&page_tx_nums)?))
     }
 
     /// Return the group history in reverse chronological order, i.e. the latest
@@ -357,20 +358,21 @@ impl<'a, G: Group> QueryGroupHistory<'a, G> {
         // First tx index within that page, from there we go backwards.
         let mut first_inner_idx = first_db_tx_idx % db_reader.page_size();
 
+        let mut page_tx_nums = Vec::with_capacity(num_page_db_txs);
         'outer: for current_page_num in (0..=db_page_num_start).rev() {
             let db_page_tx_nums = db_reader
                 .page_txs(member_ser.as_ref(), current_page_num as u32)?
                 .unwrap_or_default();
             for inner_idx in (0..=first_inner_idx).rev() {
-                let tx_num = db_page_tx_nums[inner_idx];
-                page_txs.push(self.read_block_tx(tx_num)?);
+                page_tx_nums.push(db_page_tx_nums[inner_idx]);
                 // Filled up page: break out of outer loop.
-                if page_txs.len() == request_page_size {
+                if page_tx_nums.len() == num_page_db_txs {
                     break 'outer;
                 }
             }
             first_inner_idx = db_reader.page_size() - 1;
         }
+        page_txs.extend(self.read_block_txs(&page_tx_nums)?);
 
         // We use stable sort, so the block order is retained when timestamps
         // are identical.
@@ -444,49 +446,63 @@ impl<'a, G: Group> QueryGroupHistory<'a, G> {
         })
     }
 
-    fn read_block_tx(&self, tx_num: TxNum) -> Result<proto::Tx> {
+    /// Read the given confirmed txs, with the disk reads of all of them done
+    /// at once by the node.
+    fn read_block_txs(&self, tx_nums: &[TxNum]) -> Result<Vec<proto::Tx>> {
         let tx_reader = TxReader::new(self.db)?;
         let block_reader = BlockReader::new(self.db)?;
         let spent_by_reader = SpentByReader::new(self.db)?;
-        let block_tx =
-            tx_reader.tx_by_tx_num(tx_num)?.ok_or(MissingDbTx(tx_num))?;
-        let block = block_reader
-            .by_height(block_tx.block_height)?
-            .ok_or(MissingDbTxBlock(tx_num))?;
-        let tx = Tx::from(self.node.bridge.load_tx(
-            block.file_num,
-            block_tx.entry.data_pos,
-            block_tx.entry.undo_pos,
-        )?);
-        let outputs_spent = OutputsSpent::query(
-            &spent_by_reader,
-            &tx_reader,
-            self.mempool.spent_by().outputs_spent(&block_tx.entry.txid),
-            tx_num,
-        )?;
-        let token = TxTokenData::from_db(
-            self.db,
-            tx_num,
-            &tx,
-            self.is_token_index_enabled,
-        )?;
-        let plugin_outputs = read_plugin_outputs(
-            self.db,
-            self.mempool,
-            &tx,
-            Some(tx_num),
-            !self.plugin_name_map.is_empty(),
-        )?;
-        Ok(make_tx_proto(MakeTxProtoParams {
-            tx: &tx,
-            outputs_spent: &outputs_spent,
-            time_first_seen: block_tx.entry.time_first_seen,
-            is_coinbase: block_tx.entry.is_coinbase,
-            block: Some(&block),
-            avalanche: self.avalanche,
-            token: token.as_ref(),
-            plugin_outputs: &plugin_outputs,
-            plugin_name_map: self.plugin_name_map,
-        }))
+        let mut block_txs = Vec::with_capacity(tx_nums.len());
+        let mut locations = Vec::with_capacity(tx_nums.len());
+        for &tx_num in tx_nums {
+            let block_tx =
+                tx_reader.tx_by_tx_num(tx_num)?.ok_or(MissingDbTx(tx_num))?;
+            let block = block_reader
+                .by_height(block_tx.block_height)?
+                .ok_or(MissingDbTxBlock(tx_num))?;
+            locations.push(TxLocation {
+                file_num: block.file_num,
+                data_pos: block_tx.entry.data_pos,
+                undo_pos: block_tx.entry.undo_pos,
+            });
+            block_txs.push((tx_num, block_tx, block));
+        }
+        let txs = self.node.bridge.load_txs(&locations)?;
+
+        let mut protos = Vec::with_capacity(tx_nums.len());
+        for ((tx_num, block_tx, block), tx) in block_txs.into_iter().zip(txs) {
+            let tx = Tx::from(tx);
+            let outputs_spent = OutputsSpent::query(
+                &spent_by_reader,
+                &tx_reader,
+                self.mempool.spent_by().outputs_spent(&block_tx.entry.txid),
+                tx_num,
+            )?;
+            let token = TxTokenData::from_db(
+                self.db,
+                tx_num,
+                &tx,
+                self.is_token_index_enabled,
+            )?;
+            let plugin_outputs = read_plugin_outputs(
+                self.db,
+                self.mempool,
+                &tx,
+                Some(tx_num),
+                !self.plugin_name_map.is_empty(),
+            )?;
+            protos.push(make_tx_proto(MakeTxProtoParams {
+                tx: &tx,
+                outputs_spent: &outputs_spent,
+                time_first_seen: block_tx.entry.time_first_seen,
+                is_coinbase: block_tx.entry.is_coinbase,
+                block: Some(&block),
+                avalanche: self.avalanche,
+                token: token.as_ref(),
+                plugin_outputs: &plugin_outputs,
+                plugin_name_map: self.plugin_name_map,
+            }));
+        }
+        Ok(protos)
     }
 }
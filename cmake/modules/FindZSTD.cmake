@@ -0,0 +1,75 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#.rst
+# FindZSTD
+# --------
+#
+# Find the zstd library. The following
+# components are available::
+#   zstd
+#
+# This will define the following variables::
+#
+#   ZSTD_FOUND - system has zstd lib
+#   ZSTD_INCLUDE_DIRS - the zstd include directories
+#   ZSTD_LIBRARIES - Libraries needed to use zstd
+#   ZSTD_VERSION - The library version MAJOR.MINOR.RELEASE
+#
+# And the following imported target::
+#
+#   ZSTD::zstd
+
+include(BrewHelper)
+find_brew_prefix(_ZSTD_BREW_HINT zstd)
+
+find_package(PkgConfig)
+pkg_check_modules(PC_ZSTD QUIET libzstd)
+
+find_path(ZSTD_INCLUDE_DIR
+	NAMES zstd.h
+	HINTS ${_ZSTD_BREW_HINT}
+	PATHS ${PC_ZSTD_INCLUDE_DIRS}
+)
+
+set(ZSTD_INCLUDE_DIRS "${ZSTD_INCLUDE_DIR}")
+mark_as_advanced(ZSTD_INCLUDE_DIR)
+
+if(ZSTD_INCLUDE_DIR)
+	# Extract version information from the zstd.h header.
+	if(NOT DEFINED ZSTD_VERSION)
+		file(READ "${ZSTD_INCLUDE_DIR}/zstd.h" _ZSTD_HEADER)
+
+		foreach(_ZSTD_VERSION_PART MAJOR MINOR RELEASE)
+			string(REGEX REPLACE
+				".*#define[ \t]+ZSTD_VERSION_${_ZSTD_VERSION_PART}[ \t]+([0-9]+).*" "\\1"
+				ZSTD_VERSION_${_ZSTD_VERSION_PART}
+				"${_ZSTD_HEADER}"
+			)
+		endforeach()
+
+		# Cache the result.
+		set(ZSTD_VERSION
+			"${ZSTD_VERSION_MAJOR}.${ZSTD_VERSION_MINOR}.${ZSTD_VERSION_RELEASE}"
+			CACHE INTERNAL "zstd full version"
+		)
+	endif()
+
+	include(ExternalLibraryHelper)
+	find_component(ZSTD zstd
+		NAMES zstd
+		HINTS ${_ZSTD_BREW_HINT}
+		PATHS ${PC_ZSTD_LIBRARY_DIRS}
+		INCLUDE_DIRS ${ZSTD_INCLUDE_DIRS}
+	)
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ZSTD
+	REQUIRED_VARS
+		ZSTD_INCLUDE_DIR
+	VERSION_VAR ZSTD_VERSION
+	REASON_FAILURE_MESSAGE "if block file compression is not required, it can be skipped by passing -DENABLE_ZSTD=OFF to the cmake command line"
+	HANDLE_COMPONENTS
+)
@@ -16,4 +16,17 @@
 #define LIFETIMEBOUND
 #endif
 
+/**
+ * Let the compiler place the following members of a struct in the tail padding
+ * of the member this is applied to.
+ */
+#if defined(__has_cpp_attribute)
+#if __has_cpp_attribute(no_unique_address)
+#define NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+#endif
+#ifndef NO_UNIQUE_ADDRESS
+#define NO_UNIQUE_ADDRESS
+#endif
+
 #endif // BITCOIN_ATTRIBUTES_H
@@ -17,6 +17,7 @@
 #include <test/util/mining.h>
 #include <test/util/setup_common.h>
 
+#include <cmath>
 #include <list>
 #include <queue>
 #include <vector>
@@ -316,6 +316,7 @@ epilogue:
     }
     StopScriptCheckWorkerThreads();
     StopPowCheckWorkerThreads();
+    StopCoinPrefetchWorkerThreads();
 
     GetMainSignals().FlushBackgroundCallbacks();
     {
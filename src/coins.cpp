@@ -10,6 +10,9 @@
 #include <util/trace.h>
 #include <version.h>
 
+#include <algorithm>
+#include <vector>
+
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return false;
 }
@@ -26,6 +29,14 @@ bool CCoinsView::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
 CCoinsViewCursor *CCoinsView::Cursor() const {
     return nullptr;
 }
+std::vector<std::unique_ptr<CCoinsViewCursor>>
+CCoinsView::RangeCursors(size_t count) const {
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    if (CCoinsViewCursor *cursor = Cursor()) {
+        cursors.emplace_back(cursor);
+    }
+    return cursors;
+}
 bool CCoinsView::HaveCoin(const COutPoint &outpoint) const {
     Coin coin;
     return GetCoin(outpoint, coin);
@@ -54,6 +65,10 @@ bool CCoinsViewBacked::BatchWrite(CCoinsMap &mapCoins,
 CCoinsViewCursor *CCoinsViewBacked::Cursor() const {
     return base->Cursor();
 }
+std::vector<std::unique_ptr<CCoinsViewCursor>>
+CCoinsViewBacked::RangeCursors(size_t count) const {
+    return base->RangeCursors(count);
+}
 size_t CCoinsViewBacked::EstimateSize() const {
     return base->EstimateSize();
 }
@@ -68,6 +83,18 @@ size_t CCoinsViewCache::DynamicMemoryUsage() const {
     return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
 }
 
+//! Estimated size of a cache entry, including the map node overhead
+static constexpr size_t COINS_MAP_NODE_BYTES{sizeof(CCoinsMap::value_type) +
+                                             sizeof(void *)};
+
+size_t CCoinsViewCache::LiveMemoryUsage() const {
+    const size_t entries_usage{
+        memusage::MallocUsage(sizeof(void *) * cacheCoins.bucket_count()) +
+        COINS_MAP_NODE_BYTES * cacheCoins.size()};
+    return std::min(entries_usage, memusage::DynamicUsage(cacheCoins)) +
+           cachedCoinsUsage;
+}
+
 CCoinsMap::iterator
 CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
     CCoinsMap::iterator it = cacheCoins.find(outpoint);
@@ -153,6 +180,17 @@ void CCoinsViewCache::EmplaceCoinInternalDANGER(COutPoint &&outpoint,
         std::forward_as_tuple(std::move(coin), CCoinsCacheEntry::DIRTY));
 }
 
+void CCoinsViewCache::PrefetchCoin(const COutPoint &outpoint, Coin &&coin) {
+    assert(!coin.IsSpent());
+    auto [it, inserted] =
+        cacheCoins.emplace(std::piecewise_construct,
+                           std::forward_as_tuple(outpoint),
+                           std::forward_as_tuple(std::move(coin)));
+    if (inserted) {
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+}
+
 void AddCoins(CCoinsViewCache &cache, const CTransaction &tx, int nHeight,
               bool check_for_overwrite) {
     bool fCoinbase = tx.IsCoinBase();
@@ -339,6 +377,43 @@ void CCoinsViewCache::Uncache(const COutPoint &outpoint) {
     }
 }
 
+void CCoinsViewCache::EvictColdCoins(size_t max_usage) {
+    size_t usage{LiveMemoryUsage()};
+    if (usage <= max_usage) {
+        return;
+    }
+
+    // Find the height below which removing all the unmodified coins brings the
+    // usage down to max_usage, in steps of 1024 blocks.
+    static constexpr int HEIGHT_STEP_BITS{10};
+    std::vector<size_t> evictable_usage;
+    for (const auto &[outpoint, entry] : cacheCoins) {
+        if (entry.flags != 0) {
+            continue;
+        }
+        const size_t step{entry.coin.GetHeight() >> HEIGHT_STEP_BITS};
+        if (step >= evictable_usage.size()) {
+            evictable_usage.resize(step + 1);
+        }
+        evictable_usage[step] +=
+            COINS_MAP_NODE_BYTES + entry.coin.DynamicMemoryUsage();
+    }
+    size_t cutoff_step{0};
+    while (cutoff_step < evictable_usage.size() && usage > max_usage) {
+        usage -= std::min(usage, evictable_usage[cutoff_step++]);
+    }
+
+    for (auto it = cacheCoins.begin(); it != cacheCoins.end();) {
+        if (it->second.flags == 0 &&
+            (it->second.coin.GetHeight() >> HEIGHT_STEP_BITS) < cutoff_step) {
+            cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+            it = cacheCoins.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 unsigned int CCoinsViewCache::GetCacheSize() const {
     return cacheCoins.size();
 }
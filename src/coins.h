@@ -6,6 +6,7 @@
 #ifndef BITCOIN_COINS_H
 #define BITCOIN_COINS_H
 
+#include <attributes.h>
 #include <compressor.h>
 #include <memusage.h>
 #include <primitives/blockhash.h>
@@ -16,7 +17,9 @@
 #include <cassert>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -89,8 +92,9 @@ public:
  *   flushed to the parent)
  */
 struct CCoinsCacheEntry {
-    // The actual cached data.
-    Coin coin;
+    // The actual cached data. The flags go in the padding at the end of the
+    // coin, which saves 8 bytes per cache entry on 64 bits platforms.
+    NO_UNIQUE_ADDRESS Coin coin;
     uint8_t flags;
 
     enum Flags {
@@ -121,6 +125,11 @@ struct CCoinsCacheEntry {
         : coin(std::move(coin_)), flags(flag) {}
 };
 
+// Catch a change to Coin or to the attribute that moves the flags out of the
+// tail padding of the coin, as it grows every entry of the cache.
+static_assert(sizeof(void *) != 8 || sizeof(CCoinsCacheEntry) == 48,
+              "CCoinsCacheEntry flags should fit in the padding of the coin");
+
 /**
  * PoolAllocator's MAX_BLOCK_SIZE_BYTES parameter here uses sizeof the data, and
  * adds the size of 4 pointers. We do not know the exact node size used in the
@@ -190,6 +199,14 @@ public:
     //! Get a cursor to iterate over the whole state
     virtual CCoinsViewCursor *Cursor() const;
 
+    //! Get cursors over consecutive, disjoint ranges of the state that all
+    //! see the same state, so it can be iterated on in parallel. The outputs
+    //! of a transaction are never split between ranges. Up to @p count
+    //! cursors are returned, in iteration order, or none if Cursor() would
+    //! return nullptr.
+    virtual std::vector<std::unique_ptr<CCoinsViewCursor>>
+    RangeCursors(size_t count) const;
+
     //! As we use CCoinsViews polymorphically, have a virtual destructor
     virtual ~CCoinsView() {}
 
@@ -212,6 +229,8 @@ public:
     bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                     bool erase = true) override;
     CCoinsViewCursor *Cursor() const override;
+    std::vector<std::unique_ptr<CCoinsViewCursor>>
+    RangeCursors(size_t count) const override;
     size_t EstimateSize() const override;
 };
 
@@ -254,6 +273,11 @@ public:
         throw std::logic_error(
             "CCoinsViewCache cursor iteration not supported.");
     }
+    std::vector<std::unique_ptr<CCoinsViewCursor>>
+    RangeCursors(size_t count) const override {
+        throw std::logic_error(
+            "CCoinsViewCache cursor iteration not supported.");
+    }
 
     /**
      * Check if we have the given utxo already loaded in this cache.
@@ -289,6 +313,13 @@ public:
      */
     void EmplaceCoinInternalDANGER(COutPoint &&outpoint, Coin &&coin);
 
+    /**
+     * Add an unspent coin that was read from the backing view ahead of time,
+     * the same way FetchCoin() would. The entry is not dirty, and nothing
+     * happens if the cache already has an entry for the outpoint.
+     */
+    void PrefetchCoin(const COutPoint &outpoint, Coin &&coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call has no
@@ -319,12 +350,23 @@ public:
      */
     void Uncache(const COutPoint &outpoint);
 
+    /**
+     * Remove unmodified coins from the cache, oldest first, until its memory
+     * usage as estimated by LiveMemoryUsage() is at most max_usage. Recently
+     * created coins are the most likely to be spent soon, so they are kept.
+     */
+    void EvictColdCoins(size_t max_usage);
+
     //! Calculate the size of the cache (in number of transaction outputs)
     unsigned int GetCacheSize() const;
 
     //! Calculate the size of the cache (in bytes)
     size_t DynamicMemoryUsage() const;
 
+    //! Estimate the memory used by the entries of the cache, not counting the
+    //! memory kept by the allocator for reuse after entries were removed.
+    size_t LiveMemoryUsage() const;
+
     //! Check whether all prevouts of the transaction are present in the UTXO
     //! set represented by this view
     bool HaveInputs(const CTransaction &tx) const;
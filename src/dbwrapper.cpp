@@ -247,6 +247,23 @@ bool CDBWrapper::IsEmpty() {
     return !(it->Valid());
 }
 
+std::vector<std::unique_ptr<CDBIterator>>
+CDBWrapper::NewIterators(size_t count) {
+    const leveldb::Snapshot *snapshot{pdb->GetSnapshot()};
+    leveldb::ReadOptions options{iteroptions};
+    options.snapshot = snapshot;
+    std::vector<std::unique_ptr<CDBIterator>> iterators;
+    iterators.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        iterators.push_back(
+            std::make_unique<CDBIterator>(*this, pdb->NewIterator(options)));
+    }
+    // The iterators keep the data they read from alive on their own, the
+    // snapshot is only needed so they all read it at the same sequence number.
+    pdb->ReleaseSnapshot(snapshot);
+    return iterators;
+}
+
 CDBIterator::~CDBIterator() {
     delete piter;
 }
@@ -17,7 +17,9 @@
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
+#include <memory>
 #include <optional>
+#include <vector>
 
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
@@ -321,6 +323,12 @@ public:
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
     }
 
+    /**
+     * Return @p count iterators that all see the same state of the database,
+     * so different ranges of it can be iterated on in parallel.
+     */
+    std::vector<std::unique_ptr<CDBIterator>> NewIterators(size_t count);
+
     /**
      * Return true if the database managed by this class contains no entries.
      */
@@ -3,13 +3,231 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <flatfile.h>
+
+#include <clientversion.h>
 #include <logging.h>
+#include <streams.h>
 #include <tinyformat.h>
 #include <util/fs_helpers.h>
 
+#include <algorithm>
 #include <stdexcept>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <vector>
+#endif
+
+#ifdef ENABLE_ZSTD
+namespace {
+/**
+ * Compressed files start with a header holding the magic, the chunk size and
+ * the size of the original file. It is followed by the compressed chunks, then
+ * by the table of where each chunk ends, relative to the end of the header.
+ * The last 8 bytes of the file are the position of that table.
+ */
+constexpr std::array<uint8_t, 4> COMPRESSED_FILE_MAGIC{'z', 'f', 'f', 0x01};
+constexpr uint64_t COMPRESSED_FILE_HEADER_SIZE{16};
+//! Size of the original data in each compressed chunk. Reading anything from
+//! a compressed file decompresses at least one chunk, while larger chunks
+//! compress better.
+constexpr uint32_t COMPRESSED_CHUNK_SIZE{256 * 1024};
+constexpr int COMPRESSION_LEVEL{ZSTD_CLEVEL_DEFAULT};
+
+/** Reads the original content of a compressed file, one chunk at a time. */
+class CompressedFileReader {
+public:
+    static std::unique_ptr<CompressedFileReader> Open(const fs::path &path);
+
+    ~CompressedFileReader() {
+        ZSTD_freeDCtx(m_dctx);
+        fclose(m_file);
+    }
+
+    ssize_t Read(char *buf, size_t size);
+    int Seek(off64_t *offset, int whence);
+
+private:
+    CompressedFileReader(FILE *file, uint32_t chunk_size, uint64_t size,
+                         std::vector<uint64_t> chunk_ends)
+        : m_file(file), m_chunk_size(chunk_size), m_size(size),
+          m_chunk_ends(std::move(chunk_ends)), m_dctx(ZSTD_createDCtx()) {}
+
+    /** Decompress a chunk into m_chunk. */
+    bool LoadChunk(uint64_t chunk);
+
+    FILE *const m_file;
+    const uint32_t m_chunk_size;
+    const uint64_t m_size;
+    const std::vector<uint64_t> m_chunk_ends;
+    ZSTD_DCtx *const m_dctx;
+
+    //! Position in the original file
+    uint64_t m_pos{0};
+    //! Index of the chunk that was decompressed last, if any
+    std::optional<uint64_t> m_chunk_index;
+    std::vector<uint8_t> m_chunk;
+    std::vector<uint8_t> m_compressed_chunk;
+};
+
+std::unique_ptr<CompressedFileReader>
+CompressedFileReader::Open(const fs::path &path) {
+    CAutoFile file(fsbridge::fopen(path, "rb"), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return nullptr;
+    }
+    try {
+        std::array<uint8_t, 4> magic;
+        uint32_t chunk_size;
+        uint64_t size;
+        file >> magic >> chunk_size >> size;
+        if (magic != COMPRESSED_FILE_MAGIC || chunk_size == 0) {
+            throw std::ios_base::failure("Not a compressed file");
+        }
+        uint64_t table_pos;
+        std::vector<uint64_t> chunk_ends;
+        if (std::fseek(file.Get(), -int(sizeof(table_pos)), SEEK_END)) {
+            throw std::ios_base::failure("fseek failed");
+        }
+        file >> table_pos;
+        if (std::fseek(file.Get(), table_pos, SEEK_SET)) {
+            throw std::ios_base::failure("fseek failed");
+        }
+        file >> chunk_ends;
+        if (chunk_ends.size() != (size + chunk_size - 1) / chunk_size ||
+            !std::is_sorted(chunk_ends.begin(), chunk_ends.end())) {
+            throw std::ios_base::failure("Invalid chunk table");
+        }
+        return std::unique_ptr<CompressedFileReader>(new CompressedFileReader(
+            file.release(), chunk_size, size, std::move(chunk_ends)));
+    } catch (const std::exception &e) {
+        LogPrintf("Unable to read compressed file %s: %s\n",
+                  fs::PathToString(path), e.what());
+        return nullptr;
+    }
+}
+
+bool CompressedFileReader::LoadChunk(uint64_t chunk) {
+    m_chunk_index.reset();
+    const uint64_t begin{chunk > 0 ? m_chunk_ends[chunk - 1] : 0};
+    m_compressed_chunk.resize(m_chunk_ends[chunk] - begin);
+    if (std::fseek(m_file, COMPRESSED_FILE_HEADER_SIZE + begin, SEEK_SET) ||
+        fread(m_compressed_chunk.data(), 1, m_compressed_chunk.size(),
+              m_file) != m_compressed_chunk.size()) {
+        return false;
+    }
+    m_chunk.resize(
+        std::min<uint64_t>(m_chunk_size, m_size - chunk * m_chunk_size));
+    const size_t size{ZSTD_decompressDCtx(m_dctx, m_chunk.data(),
+                                          m_chunk.size(),
+                                          m_compressed_chunk.data(),
+                                          m_compressed_chunk.size())};
+    if (ZSTD_isError(size) || size != m_chunk.size()) {
+        return false;
+    }
+    m_chunk_index = chunk;
+    return true;
+}
+
+ssize_t CompressedFileReader::Read(char *buf, size_t size) {
+    size_t read{0};
+    while (read < size && m_pos < m_size) {
+        const uint64_t chunk{m_pos / m_chunk_size};
+        if (m_chunk_index != chunk && !LoadChunk(chunk)) {
+            errno = EIO;
+            return -1;
+        }
+        const size_t offset = m_pos - chunk * m_chunk_size;
+        const size_t count{std::min(size - read, m_chunk.size() - offset)};
+        std::memcpy(buf + read, m_chunk.data() + offset, count);
+        read += count;
+        m_pos += count;
+    }
+    return read;
+}
+
+int CompressedFileReader::Seek(off64_t *offset, int whence) {
+    int64_t base;
+    switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = m_pos;
+            break;
+        case SEEK_END:
+            base = m_size;
+            break;
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+    if (*offset < -base) {
+        errno = EINVAL;
+        return -1;
+    }
+    m_pos = base + *offset;
+    *offset = m_pos;
+    return 0;
+}
+
+ssize_t ReadCompressedFile(void *cookie, char *buf, size_t size) {
+    return static_cast<CompressedFileReader *>(cookie)->Read(buf, size);
+}
+
+int SeekCompressedFile(void *cookie, off64_t *offset, int whence) {
+    return static_cast<CompressedFileReader *>(cookie)->Seek(offset, whence);
+}
+
+int CloseCompressedFile(void *cookie) {
+    delete static_cast<CompressedFileReader *>(cookie);
+    return 0;
+}
+
+/** Open a compressed file as a stream of its original content. */
+FILE *OpenCompressedFile(const fs::path &path) {
+    std::unique_ptr<CompressedFileReader> reader{
+        CompressedFileReader::Open(path)};
+    if (!reader) {
+        return nullptr;
+    }
+    const cookie_io_functions_t functions{ReadCompressedFile, nullptr,
+                                          SeekCompressedFile,
+                                          CloseCompressedFile};
+    FILE *file{fopencookie(reader.get(), "r", functions)};
+    if (file) {
+        // Now owned by the stream
+        reader.release();
+    }
+    return file;
+}
+} // namespace
+#else
+static FILE *OpenCompressedFile(const fs::path &path) {
+    LogPrintf("Unable to read compressed file %s: compression is not "
+              "supported by this build\n",
+              fs::PathToString(path));
+    return nullptr;
+}
+#endif
+
 FlatFileSeq::FlatFileSeq(fs::path dir, const char *prefix, size_t chunk_size)
     : m_dir(std::move(dir)), m_prefix(prefix), m_chunk_size(chunk_size) {
     if (chunk_size == 0) {
@@ -25,6 +243,10 @@ fs::path FlatFileSeq::FileName(const FlatFilePos &pos) const {
     return m_dir / strprintf("%s%05u.dat", m_prefix, pos.nFile);
 }
 
+fs::path FlatFileSeq::CompressedFileName(const FlatFilePos &pos) const {
+    return m_dir / strprintf("%s%05u.dat.zst", m_prefix, pos.nFile);
+}
+
 FILE *FlatFileSeq::Open(const FlatFilePos &pos, bool read_only) {
     if (pos.IsNull()) {
         return nullptr;
@@ -32,6 +254,15 @@ FILE *FlatFileSeq::Open(const FlatFilePos &pos, bool read_only) {
     fs::path path = FileName(pos);
     fs::create_directories(path.parent_path());
     FILE *file = fsbridge::fopen(path, read_only ? "rb" : "rb+");
+    if (!file && fs::exists(CompressedFileName(pos))) {
+        if (!read_only) {
+            LogPrintf("Unable to write to compressed file %s\n",
+                      fs::PathToString(CompressedFileName(pos)));
+            return nullptr;
+        }
+        path = CompressedFileName(pos);
+        file = OpenCompressedFile(path);
+    }
     if (!file && !read_only) {
         file = fsbridge::fopen(path, "wb+");
     }
@@ -78,6 +309,11 @@ size_t FlatFileSeq::Allocate(const FlatFilePos &pos, size_t add_size,
 }
 
 bool FlatFileSeq::Flush(const FlatFilePos &pos, bool finalize) {
+    // Files are only compressed once they are final.
+    if (!fs::exists(FileName(pos)) && fs::exists(CompressedFileName(pos))) {
+        return true;
+    }
+
     // Avoid fseek to nPos
     FILE *file = Open(FlatFilePos(pos.nFile, 0));
     if (!file) {
@@ -96,3 +332,140 @@ bool FlatFileSeq::Flush(const FlatFilePos &pos, bool finalize) {
     fclose(file);
     return true;
 }
+
+bool FlatFileSeq::Compress(const FlatFilePos &pos) {
+#ifdef ENABLE_ZSTD
+    const fs::path compressed_path{CompressedFileName(pos)};
+    CAutoFile in(fsbridge::fopen(FileName(pos), "rb"), SER_DISK,
+                 CLIENT_VERSION);
+    CAutoFile out(fsbridge::fopen(compressed_path, "wb"), SER_DISK,
+                  CLIENT_VERSION);
+    if (in.IsNull() || out.IsNull()) {
+        return error("%s: failed to open file %d", __func__, pos.nFile);
+    }
+
+    ZSTD_CCtx *const cctx{ZSTD_createCCtx()};
+    try {
+        const uint64_t size{pos.nPos};
+        out << COMPRESSED_FILE_MAGIC << COMPRESSED_CHUNK_SIZE << size;
+
+        std::vector<uint8_t> chunk(COMPRESSED_CHUNK_SIZE);
+        std::vector<uint8_t> compressed_chunk(
+            ZSTD_compressBound(COMPRESSED_CHUNK_SIZE));
+        std::vector<uint64_t> chunk_ends;
+        uint64_t compressed_size{0};
+        for (uint64_t offset = 0; offset < size;
+             offset += COMPRESSED_CHUNK_SIZE) {
+            const auto data{MakeWritableByteSpan(chunk).first(
+                std::min<uint64_t>(COMPRESSED_CHUNK_SIZE, size - offset))};
+            in.read(data);
+            const size_t chunk_size{ZSTD_compressCCtx(
+                cctx, compressed_chunk.data(), compressed_chunk.size(),
+                data.data(), data.size(), COMPRESSION_LEVEL)};
+            if (ZSTD_isError(chunk_size)) {
+                throw std::runtime_error(ZSTD_getErrorName(chunk_size));
+            }
+            out.write(MakeByteSpan(compressed_chunk).first(chunk_size));
+            compressed_size += chunk_size;
+            chunk_ends.push_back(compressed_size);
+        }
+        out << chunk_ends << COMPRESSED_FILE_HEADER_SIZE + compressed_size;
+        if (!FileCommit(out.Get())) {
+            throw std::runtime_error("commit failed");
+        }
+    } catch (const std::exception &e) {
+        ZSTD_freeCCtx(cctx);
+        out.fclose();
+        std::error_code error_code;
+        fs::remove(compressed_path, error_code);
+        return error("%s: failed to compress file %d: %s", __func__,
+                     pos.nFile, e.what());
+    }
+    ZSTD_freeCCtx(cctx);
+    out.fclose();
+    DirectoryCommit(m_dir);
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<MappedFile> MappedFile::Map(const fs::path &path,
+                                            size_t length) {
+#ifdef WIN32
+    return nullptr;
+#else
+    // Mapping whole files would exhaust the address space of 32-bit systems.
+    if (sizeof(void *) < 8 || length == 0) {
+        return nullptr;
+    }
+    const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    length = std::min<uint64_t>(length, st.st_size);
+    void *data{length > 0
+                   ? mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0)
+                   : MAP_FAILED};
+    // The mapping remains valid after the file is closed.
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::unique_ptr<MappedFile>(
+        new MappedFile(static_cast<const uint8_t *>(data), length));
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef WIN32
+    munmap(const_cast<uint8_t *>(m_data), m_length);
+#endif
+}
+
+std::shared_ptr<const MappedFile> FlatFileMappings::Get(int file,
+                                                        size_t length) {
+    LOCK(m_mutex);
+    const auto it = m_mappings_by_file.find(file);
+    if (it != m_mappings_by_file.end()) {
+        // A file that was too short to be mapped entirely is not mapped again
+        // until a longer length is requested.
+        if (it->second->length >= length) {
+            m_mappings.splice(m_mappings.begin(), m_mappings, it->second);
+            return it->second->mapping;
+        }
+        // The file grew since it was mapped.
+        m_mappings.erase(it->second);
+        m_mappings_by_file.erase(it);
+    }
+
+    if (m_max_mappings == 0) {
+        return nullptr;
+    }
+    std::shared_ptr<const MappedFile> mapping{
+        MappedFile::Map(m_seq.FileName(FlatFilePos(file, 0)), length)};
+    if (!mapping) {
+        return nullptr;
+    }
+    m_mappings.push_front(CachedMapping{file, length, mapping});
+    m_mappings_by_file.emplace(file, m_mappings.begin());
+    if (m_mappings.size() > m_max_mappings) {
+        m_mappings_by_file.erase(m_mappings.back().file);
+        m_mappings.pop_back();
+    }
+    return mapping;
+}
+
+void FlatFileMappings::Erase(int file) {
+    LOCK(m_mutex);
+    const auto it = m_mappings_by_file.find(file);
+    if (it != m_mappings_by_file.end()) {
+        m_mappings.erase(it->second);
+        m_mappings_by_file.erase(it);
+    }
+}
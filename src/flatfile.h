@@ -7,9 +7,16 @@
 #define BITCOIN_FLATFILE_H
 
 #include <serialize.h>
+#include <span.h>
+#include <sync.h>
 #include <util/fs.h>
 
+#include <cstdint>
+#include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 struct FlatFilePos {
     int nFile;
@@ -66,7 +73,14 @@ public:
     /** Get the name of the file at the given position. */
     fs::path FileName(const FlatFilePos &pos) const;
 
-    /** Open a handle to the file at the given position. */
+    /** Get the name of the compressed version of a file. */
+    fs::path CompressedFileName(const FlatFilePos &pos) const;
+
+    /**
+     * Open a handle to the file at the given position. A file that was
+     * replaced by its compressed version reads as the original when opened
+     * read-only, and can't be opened for writing.
+     */
     FILE *Open(const FlatFilePos &pos, bool read_only = false);
 
     /**
@@ -92,6 +106,87 @@ public:
      * @return true on success, false on failure.
      */
     bool Flush(const FlatFilePos &pos, bool finalize = false);
+
+    /**
+     * Write the compressed version of a file that is no longer written to.
+     * The file is compressed in chunks that can be decompressed independently,
+     * so reading from it only decompresses the chunks that are read. Once this
+     * succeeds, the original file can be deleted.
+     *
+     * @param[in] pos The end of the data in the file.
+     * @return true on success, false on failure or if compression is not
+     * supported by this build.
+     */
+    bool Compress(const FlatFilePos &pos);
+};
+
+/**
+ * A read-only memory mapping of the beginning of a file. The file must not be
+ * truncated below the mapped length while it is mapped.
+ */
+class MappedFile {
+public:
+    /**
+     * Map up to @p length bytes of the file, less if the file is shorter.
+     * Returns nullptr if the file can't be mapped, or if memory mapping is not
+     * supported on this platform.
+     */
+    static std::unique_ptr<MappedFile> Map(const fs::path &path, size_t length);
+
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    Span<const uint8_t> Data() const { return {m_data, m_length}; }
+
+private:
+    MappedFile(const uint8_t *data, size_t length)
+        : m_data(data), m_length(length) {}
+
+    const uint8_t *const m_data;
+    const size_t m_length;
+};
+
+/**
+ * Bounded cache of the read-only mappings of the files of a FlatFileSeq, the
+ * least recently used mapping is released first. The mappings are shared, so
+ * they remain valid for their users after they are evicted.
+ */
+class FlatFileMappings {
+public:
+    FlatFileMappings(FlatFileSeq seq, size_t max_mappings)
+        : m_seq(std::move(seq)), m_max_mappings(max_mappings) {}
+
+    /**
+     * Get a mapping of the first @p length bytes of a file. A cached mapping
+     * that is shorter is replaced. The mapping is shorter than @p length if
+     * the file is, so the callers must check its size. Returns nullptr if the
+     * file can't be mapped.
+     */
+    std::shared_ptr<const MappedFile> Get(int file, size_t length)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Release the mapping of a file, e.g. because it is being deleted. */
+    void Erase(int file) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct CachedMapping {
+        int file;
+        //! Length requested when mapping the file, which may be longer than
+        //! the mapping if the file is short
+        size_t length;
+        std::shared_ptr<const MappedFile> mapping;
+    };
+    using MappingList = std::list<CachedMapping>;
+
+    const FlatFileSeq m_seq;
+    const size_t m_max_mappings;
+
+    Mutex m_mutex;
+    //! Most recently used first
+    MappingList m_mappings GUARDED_BY(m_mutex);
+    std::unordered_map<int, MappingList::iterator>
+        m_mappings_by_file GUARDED_BY(m_mutex);
 };
 
 #endif // BITCOIN_FLATFILE_H
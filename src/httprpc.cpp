@@ -10,6 +10,7 @@
 #include <crypto/hmac_sha256.h>
 #include <logging.h>
 #include <rpc/protocol.h>
+#include <util/jsonwriter.h>
 #include <util/strencodings.h>
 #include <util/string.h>
 #include <util/translation.h>
@@ -18,6 +19,8 @@
 #include <boost/algorithm/string.hpp>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdio>
 #include <functional>
 #include <iterator>
@@ -25,6 +28,8 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
+#include <tuple>
 
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char *WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
@@ -32,6 +37,21 @@ static const char *WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 /** RPC auth failure delay to make brute-forcing expensive */
 static const int64_t RPC_AUTH_BRUTE_FORCE_DELAY = 250;
 
+/** Size of the start of a request body scanned for the methods it calls */
+static const size_t MAX_CLASSIFIED_BODY_SIZE = 16 * 1024;
+
+/**
+ * Methods that may take long, or return large replies. They are run by the
+ * heavy RPC workers so they cannot starve the cheap calls.
+ */
+static const std::set<std::string, std::less<>> HEAVY_RPC_METHODS{
+    "dumptxoutset",      "dumpwallet",        "getaddresshistory",
+    "getaddressutxos",   "getblock",          "getblockstats",
+    "getchaintxstats",   "getrawmempool",     "gettxoutsetinfo",
+    "importdescriptors", "importmulti",       "importwallet",
+    "rescanblockchain",  "scantxoutset",      "verifychain",
+};
+
 /**
  * Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
@@ -75,6 +95,72 @@ static std::unique_ptr<HTTPRPCTimerInterface> httpRPCTimerInterface;
 /* RPC Auth Whitelist */
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
+/* Maximum number of requests of a batch executed at the same time */
+static size_t g_rpc_batch_parallelism = DEFAULT_RPC_BATCH_PARALLELISM;
+/* Helper threads of the batches in each pool of HTTP workers */
+struct BatchHelperBudget {
+    /* Number of worker threads of the pool that may help with batches */
+    int max_helpers{0};
+    /* Number of worker threads of the pool scheduled to help with batches */
+    std::atomic<int> helpers{0};
+};
+/* In HTTPWorkClass order */
+static std::array<BatchHelperBudget, 3> g_rpc_batch_budgets;
+
+/**
+ * Schedule a batch task on the HTTP work queue of the calling worker, as long
+ * as it keeps enough worker threads of that pool available for the other
+ * requests.
+ */
+static bool ScheduleBatchTask(std::function<void()> task) {
+    BatchHelperBudget &budget{
+        g_rpc_batch_budgets.at(size_t(GetHTTPWorkClass()))};
+    if (++budget.helpers > budget.max_helpers) {
+        --budget.helpers;
+        return false;
+    }
+    if (!EnqueueHTTPWork([task = std::move(task), &budget]() {
+            task();
+            --budget.helpers;
+        })) {
+        --budget.helpers;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Classify a request as heavy if it calls any of the heavy methods. This runs
+ * on the HTTP event loop thread, so the start of the body is only scanned for
+ * the method names rather than parsed.
+ */
+static HTTPWorkClass ClassifyJSONRPCRequest(HTTPRequest *req,
+                                            const std::string &) {
+    const std::string body{req->PeekBody(MAX_CLASSIFIED_BODY_SIZE)};
+    static constexpr std::string_view METHOD_KEY{"\"method\""};
+    static constexpr const char *SPACES{" \t\r\n"};
+    size_t pos{0};
+    while ((pos = body.find(METHOD_KEY, pos)) != std::string::npos) {
+        pos = body.find_first_not_of(SPACES, pos + METHOD_KEY.size());
+        if (pos == std::string::npos || body[pos] != ':') {
+            continue;
+        }
+        pos = body.find_first_not_of(SPACES, pos + 1);
+        if (pos == std::string::npos || body[pos] != '"') {
+            continue;
+        }
+        const size_t end{body.find('"', pos + 1)};
+        if (end == std::string::npos) {
+            break;
+        }
+        if (HEAVY_RPC_METHODS.count(
+                std::string_view{body}.substr(pos + 1, end - pos - 1))) {
+            return HTTPWorkClass::RPC_HEAVY;
+        }
+        pos = end + 1;
+    }
+    return HTTPWorkClass::RPC;
+}
 
 static void JSONErrorReply(HTTPRequest *req, const UniValue &objError,
                            const UniValue &id) {
@@ -362,8 +448,19 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
             }
             UniValue result = rpcServer.ExecuteCommand(config, jreq);
 
-            // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            // Send reply as it is serialized, the result can be large
+            req->WriteHeader("Content-Type", "application/json");
+            JSONWriter writer{[req](std::string &&chunk, bool last) {
+                req->WriteReplyPart(HTTP_OK, std::move(chunk), last);
+            }};
+            writer.BeginObject()
+                .Pair("result", result)
+                .Pair("error", NullUniValue)
+                .Pair("id", jreq.id)
+                .EndObject()
+                .Raw("\n")
+                .Finish();
+            return true;
 
             // array of requests
         } else if (valRequest.isArray()) {
@@ -389,7 +486,9 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
                 }
             }
             strReply = JSONRPCExecBatch(config, rpcServer, jreq,
-                                        valRequest.get_array());
+                                        valRequest.get_array(),
+                                        ScheduleBatchTask,
+                                        g_rpc_batch_parallelism);
         } else {
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
         }
@@ -459,13 +558,28 @@ bool StartHTTPRPC(HTTPRPCRequestProcessor &httpRPCRequestProcessor) {
         return false;
     }
 
+    g_rpc_batch_parallelism = std::max<int64_t>(
+        gArgs.GetIntArg("-rpcbatchparallelism", DEFAULT_RPC_BATCH_PARALLELISM),
+        1);
+    // Batches never take more than half of the worker threads of a pool, the
+    // worker running the batch itself excluded. REST workers never run any.
+    for (const auto &[work_class, option, default_threads] :
+         {std::make_tuple(HTTPWorkClass::RPC, "-rpcthreads",
+                          DEFAULT_HTTP_THREADS),
+          std::make_tuple(HTTPWorkClass::RPC_HEAVY, "-rpcheavythreads",
+                          DEFAULT_HTTP_HEAVY_THREADS)}) {
+        g_rpc_batch_budgets.at(size_t(work_class)).max_helpers =
+            std::max<int64_t>(gArgs.GetIntArg(option, default_threads), 1) / 2;
+    }
+
     const std::function<bool(Config &, HTTPRequest *, const std::string &)>
         &rpcFunction =
             std::bind(&HTTPRPCRequestProcessor::DelegateHTTPRequest,
                       &httpRPCRequestProcessor, std::placeholders::_2);
-    RegisterHTTPHandler("/", true, rpcFunction);
+    RegisterHTTPHandler("/", true, rpcFunction, ClassifyJSONRPCRequest);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, rpcFunction);
+        RegisterHTTPHandler("/wallet/", false, rpcFunction,
+                            ClassifyJSONRPCRequest);
     }
     struct event_base *eventBase = EventBase();
     assert(eventBase);
@@ -12,6 +12,13 @@
 
 class Config;
 
+/**
+ * Default maximum number of requests of a JSON-RPC batch executed at the same
+ * time. Batches are executed sequentially unless the user opts in, because the
+ * requests of a batch may depend on each other.
+ */
+static const int DEFAULT_RPC_BATCH_PARALLELISM = 1;
+
 class HTTPRPCRequestProcessor {
 private:
     Config &config;
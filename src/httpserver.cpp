@@ -18,6 +18,7 @@
 #include <util/check.h>
 #include <util/strencodings.h>
 #include <util/threadnames.h>
+#include <util/time.h>
 #include <util/translation.h>
 
 #include <event2/buffer.h>
@@ -32,13 +33,17 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <deque>
 #include <memory>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
@@ -49,6 +54,29 @@ static const size_t MAX_HEADERS_SIZE = 8192;
  */
 static const size_t MIN_SUPPORTED_BODY_SIZE = 0x02000000;
 
+/**
+ * Maximum size of the parts of a reply waiting to be sent to the client before
+ * writing more parts blocks.
+ */
+static const size_t MAX_PENDING_REPLY_SIZE = 8 << 20;
+
+/** State of a reply sent in parts, shared with the event loop thread */
+struct HTTPReplyFlow {
+    Mutex mutex;
+    std::condition_variable cond;
+    //! Size of the parts written but not sent to the client yet
+    size_t pending GUARDED_BY(mutex){0};
+    //! Size of the pending parts already handed to libevent
+    size_t handed GUARDED_BY(mutex){0};
+    //! Whether the connection to the client was closed
+    bool closed GUARDED_BY(mutex){false};
+
+    void Close() EXCLUSIVE_LOCKS_REQUIRED(!mutex) {
+        WITH_LOCK(mutex, closed = true);
+        cond.notify_all();
+    }
+};
+
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure {
 public:
@@ -66,6 +94,18 @@ private:
     Config *config;
 };
 
+/** Work item running an arbitrary function */
+class HTTPFunctionWorkItem final : public HTTPClosure {
+public:
+    explicit HTTPFunctionWorkItem(std::function<void()> func)
+        : m_func(std::move(func)) {}
+
+    void operator()() override { m_func(); }
+
+private:
+    std::function<void()> m_func;
+};
+
 /**
  * Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
@@ -75,9 +115,12 @@ private:
     /** Mutex protects entire object */
     Mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
+    //! The work items and the time they were queued at
+    std::deque<std::pair<std::unique_ptr<WorkItem>, SteadyClock::time_point>>
+        queue;
     bool running;
     size_t maxDepth;
+    HTTPWorkQueueInfo stats;
 
 public:
     explicit WorkQueue(size_t _maxDepth) : running(true), maxDepth(_maxDepth) {}
@@ -90,9 +133,10 @@ public:
     bool Enqueue(WorkItem *item) EXCLUSIVE_LOCKS_REQUIRED(!cs) {
         LOCK(cs);
         if (queue.size() >= maxDepth) {
+            ++stats.rejected;
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        queue.emplace_back(std::unique_ptr<WorkItem>(item), SteadyClock::now());
         cond.notify_one();
         return true;
     }
@@ -101,6 +145,7 @@ public:
     void Run() EXCLUSIVE_LOCKS_REQUIRED(!cs) {
         while (true) {
             std::unique_ptr<WorkItem> i;
+            SteadyClock::time_point start;
             {
                 WAIT_LOCK(cs, lock);
                 while (running && queue.empty()) {
@@ -109,13 +154,37 @@ public:
                 if (!running) {
                     break;
                 }
-                i = std::move(queue.front());
+                start = SteadyClock::now();
+                const auto wait{std::chrono::duration_cast<
+                    std::chrono::microseconds>(start - queue.front().second)};
+                stats.total_wait += wait;
+                stats.max_wait = std::max(stats.max_wait, wait);
+                ++stats.active;
+                i = std::move(queue.front().first);
                 queue.pop_front();
             }
             (*i)();
+            // Destroy the item, which may send the reply, before measuring
+            i.reset();
+            const auto end{SteadyClock::now()};
+            LOCK(cs);
+            stats.total_duration +=
+                std::chrono::duration_cast<std::chrono::microseconds>(end -
+                                                                      start);
+            ++stats.processed;
+            --stats.active;
         }
     }
 
+    /** Get the current depth and the statistics of the queue */
+    HTTPWorkQueueInfo GetInfo() EXCLUSIVE_LOCKS_REQUIRED(!cs) {
+        LOCK(cs);
+        HTTPWorkQueueInfo info{stats};
+        info.depth = queue.size();
+        info.max_depth = maxDepth;
+        return info;
+    }
+
     /** Interrupt and exit loops */
     void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs) {
         LOCK(cs);
@@ -126,11 +195,26 @@ public:
 
 struct HTTPPathHandler {
     HTTPPathHandler(std::string _prefix, bool _exactMatch,
-                    HTTPRequestHandler _handler)
-        : prefix(_prefix), exactMatch(_exactMatch), handler(_handler) {}
+                    HTTPRequestHandler _handler,
+                    HTTPWorkClassifier _classifier)
+        : prefix(_prefix), exactMatch(_exactMatch), handler(_handler),
+          classifier(_classifier) {}
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPWorkClassifier classifier;
+};
+
+/** Work queue and worker threads of a class of requests */
+struct HTTPWorkPool {
+    std::string name;
+    //! Prefix of the worker thread names
+    std::string thread_name;
+    //! Option setting the number of worker threads
+    std::string threads_option;
+    int num_threads;
+    std::unique_ptr<WorkQueue<HTTPClosure>> queue;
+    std::vector<std::thread> threads;
 };
 
 /** HTTP module state */
@@ -141,8 +225,12 @@ static struct event_base *eventBase = nullptr;
 static struct evhttp *eventHTTP = nullptr;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure> *workQueue = nullptr;
+//! Work pools for handling longer requests off the event loop thread, in
+//! HTTPWorkClass order
+static std::vector<HTTPWorkPool> g_work_pools;
+//! Work queue and class of the pool the current thread is a worker of
+static thread_local WorkQueue<HTTPClosure> *g_current_work_queue = nullptr;
+static thread_local HTTPWorkClass g_current_work_class{HTTPWorkClass::RPC};
 //! Handlers for (sub)paths
 static std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
@@ -356,16 +444,22 @@ static void http_request_cb(struct evhttp_request *req, void *arg) {
 
     // Dispatch to worker thread.
     if (i != iend) {
+        const HTTPWorkClass work_class{
+            i->classifier ? i->classifier(hreq.get(), path)
+                          : HTTPWorkClass::RPC};
+        assert(!g_work_pools.empty());
+        HTTPWorkPool &pool = g_work_pools.at(size_t(work_class));
         std::unique_ptr<HTTPWorkItem> item(
             new HTTPWorkItem(config, std::move(hreq), path, i->handler));
-        assert(workQueue);
-        if (workQueue->Enqueue(item.get())) {
+        if (pool.queue->Enqueue(item.get())) {
             /* if true, queue took ownership */
             item.release();
         } else {
-            LogPrintf("WARNING: request rejected because http work queue depth "
-                      "exceeded, it can be increased with the -rpcworkqueue= "
-                      "setting\n");
+            LogPrintf("WARNING: request rejected because the %s http work "
+                      "queue depth exceeded, it can be increased with the "
+                      "-rpcworkqueue= setting, or the queue served by more "
+                      "threads with the %s= setting\n",
+                      pool.name, pool.threads_option);
             item->req->WriteReply(HTTP_SERVICE_UNAVAILABLE,
                                   "Work queue depth exceeded");
         }
@@ -445,8 +539,12 @@ static bool HTTPBindAddresses(struct evhttp *http) {
 }
 
 /** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure> *queue, int worker_num) {
-    util::ThreadRename(strprintf("httpworker.%i", worker_num));
+static void HTTPWorkQueueRun(WorkQueue<HTTPClosure> *queue,
+                             HTTPWorkClass work_class,
+                             std::string thread_name) {
+    util::ThreadRename(std::move(thread_name));
+    g_current_work_queue = queue;
+    g_current_work_class = work_class;
     queue->Run();
 }
 
@@ -521,10 +619,25 @@ bool InitHTTPServer(Config &config) {
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max(
         (long)gArgs.GetIntArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintfCategory(BCLog::HTTP, "creating work queue of depth %d\n",
+    LogPrintfCategory(BCLog::HTTP, "creating work queues of depth %d\n",
                       workQueueDepth);
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    // In HTTPWorkClass order
+    for (const auto &[name, thread_name, option, default_threads] :
+         {std::make_tuple("rpc", "httpworker", "-rpcthreads",
+                          DEFAULT_HTTP_THREADS),
+          std::make_tuple("rpc_heavy", "httpheavy", "-rpcheavythreads",
+                          DEFAULT_HTTP_HEAVY_THREADS),
+          std::make_tuple("rest", "httprest", "-restthreads",
+                          DEFAULT_HTTP_REST_THREADS)}) {
+        HTTPWorkPool &pool = g_work_pools.emplace_back();
+        pool.name = name;
+        pool.thread_name = thread_name;
+        pool.threads_option = option;
+        pool.num_threads =
+            std::max<int64_t>(gArgs.GetIntArg(option, default_threads), 1);
+        pool.queue = std::make_unique<WorkQueue<HTTPClosure>>(workQueueDepth);
+    }
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -540,17 +653,21 @@ void UpdateHTTPServerLogging(bool enable) {
 }
 
 static std::thread g_thread_http;
-static std::vector<std::thread> g_thread_http_workers;
 
 void StartHTTPServer() {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max(
-        (long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintfCategory(BCLog::HTTP, "starting %d worker threads\n", rpcThreads);
     g_thread_http = std::thread(ThreadHTTP, eventBase);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i);
+    for (size_t work_class = 0; work_class < g_work_pools.size();
+         ++work_class) {
+        HTTPWorkPool &pool = g_work_pools[work_class];
+        LogPrintfCategory(BCLog::HTTP, "starting %d %s worker threads\n",
+                          pool.num_threads, pool.name);
+        for (int i = 0; i < pool.num_threads; i++) {
+            pool.threads.emplace_back(HTTPWorkQueueRun, pool.queue.get(),
+                                      HTTPWorkClass(work_class),
+                                      strprintf("%s.%i", pool.thread_name, i));
+        }
     }
 }
 
@@ -560,21 +677,21 @@ void InterruptHTTPServer() {
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
     }
-    if (workQueue) {
-        workQueue->Interrupt();
+    for (HTTPWorkPool &pool : g_work_pools) {
+        pool.queue->Interrupt();
     }
 }
 
 void StopHTTPServer() {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
-    if (workQueue) {
+    if (!g_work_pools.empty()) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
-        for (auto &thread : g_thread_http_workers) {
-            thread.join();
+        for (HTTPWorkPool &pool : g_work_pools) {
+            for (auto &thread : pool.threads) {
+                thread.join();
+            }
         }
-        g_thread_http_workers.clear();
-        delete workQueue;
-        workQueue = nullptr;
+        g_work_pools.clear();
     }
     // Unlisten sockets, these are what make the event loop running, which means
     // that after this and all connections are closed the event loop will quit.
@@ -648,7 +765,11 @@ void HTTPEvent::trigger(struct timeval *tv) {
 HTTPRequest::HTTPRequest(struct evhttp_request *_req, bool _replySent)
     : req(_req), replySent(_replySent) {}
 HTTPRequest::~HTTPRequest() {
-    if (!replySent) {
+    if (replyStarted && !replySent) {
+        // The body is incomplete, but the status was already sent
+        LogPrintf("%s: Unfinished reply\n", __func__);
+        AbortReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -668,6 +789,17 @@ HTTPRequest::GetHeader(const std::string &hdr) const {
     }
 }
 
+std::string HTTPRequest::PeekBody(size_t max_size) const {
+    struct evbuffer *buf = evhttp_request_get_input_buffer(req);
+    if (!buf) {
+        return "";
+    }
+    std::string rv(std::min(evbuffer_get_length(buf), max_size), '\0');
+    const ev_ssize_t copied{evbuffer_copyout(buf, rv.data(), rv.size())};
+    rv.resize(std::max<ev_ssize_t>(copied, 0));
+    return rv;
+}
+
 std::string HTTPRequest::ReadBody() {
     struct evbuffer *buf = evhttp_request_get_input_buffer(req);
     if (!buf) {
@@ -735,6 +867,133 @@ void HTTPRequest::WriteReply(int nStatus, const std::string &strReply) {
     req = nullptr;
 }
 
+bool HTTPRequest::WriteReplyPart(int nStatus, std::string &&part, bool last) {
+    assert(!replySent && req);
+    if (!replyStarted && last) {
+        WriteReply(nStatus, part);
+        return true;
+    }
+    if (!replyStarted) {
+        if (ShutdownRequested()) {
+            WriteHeader("Connection", "close");
+        }
+        replyFlow = std::make_shared<HTTPReplyFlow>();
+    }
+    const size_t part_size{part.size()};
+
+    // Hand the part over to libevent without copying it
+    struct evbuffer *chunk = evbuffer_new();
+    assert(chunk);
+    if (!part.empty()) {
+        auto *data = new std::string(std::move(part));
+        evbuffer_add_reference(
+            chunk, data->data(), data->size(),
+            [](const void *, size_t, void *arg) {
+                delete static_cast<std::string *>(arg);
+            },
+            data);
+    }
+
+    const bool start{!replyStarted};
+    auto req_copy = req;
+    auto flow = replyFlow;
+    // Events triggered from the same thread are handled in order, so the
+    // parts are sent in the order they were written.
+    HTTPEvent *ev = new HTTPEvent(
+        eventBase, true, [req_copy, nStatus, chunk, start, last, flow] {
+            if (start) {
+                evhttp_send_reply_start(req_copy, nStatus, nullptr);
+            }
+            // libevent detaches the request from its connection when the
+            // connection is closed before the reply ends
+            if (!evhttp_request_get_connection(req_copy)) {
+                flow->Close();
+            } else if (const size_t size{evbuffer_get_length(chunk)}) {
+                // An empty chunk would mark the end of the body
+                WITH_LOCK(flow->mutex, flow->handed += size);
+                // Called once the output buffer of the connection is empty,
+                // so all the parts handed so far have been sent. The last
+                // event replaces this callback when the reply ends, and keeps
+                // the flow alive until then.
+                evhttp_send_reply_chunk_with_cb(
+                    req_copy, chunk,
+                    [](evhttp_connection *, void *arg) {
+                        auto *sent_flow = static_cast<HTTPReplyFlow *>(arg);
+                        {
+                            LOCK(sent_flow->mutex);
+                            sent_flow->pending -= sent_flow->handed;
+                            sent_flow->handed = 0;
+                        }
+                        sent_flow->cond.notify_all();
+                    },
+                    flow.get());
+            }
+            evbuffer_free(chunk);
+            if (!last) {
+                return;
+            }
+            // The request may be freed when the reply ends
+            evhttp_connection *conn = evhttp_request_get_connection(req_copy);
+            evhttp_send_reply_end(req_copy);
+            // Re-enable reading from the socket. This is the second part of
+            // the libevent workaround above.
+            if (conn && event_get_version_number() >= 0x02010600 &&
+                event_get_version_number() < 0x02020001) {
+                bufferevent *bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        });
+    ev->trigger(nullptr);
+    replyStarted = true;
+    if (last) {
+        replySent = true;
+        // transferred back to main thread.
+        req = nullptr;
+        replyFlow.reset();
+        return true;
+    }
+
+    // Wait for the client to receive enough of the reply. Check the
+    // connection regularly, as nothing is sent anymore once it is closed.
+    WAIT_LOCK(flow->mutex, lock);
+    flow->pending += part_size;
+    while (flow->pending > MAX_PENDING_REPLY_SIZE && !flow->closed &&
+           !ShutdownRequested()) {
+        if (flow->cond.wait_for(lock, std::chrono::seconds{1}) ==
+            std::cv_status::timeout) {
+            (new HTTPEvent(eventBase, true, [req_copy, flow] {
+                if (!evhttp_request_get_connection(req_copy)) {
+                    flow->Close();
+                }
+            }))->trigger(nullptr);
+        }
+    }
+    return !flow->closed && !ShutdownRequested();
+}
+
+void HTTPRequest::AbortReply() {
+    assert(replyStarted && !replySent && req);
+    auto req_copy = req;
+    auto flow = replyFlow;
+    HTTPEvent *ev = new HTTPEvent(eventBase, true, [req_copy, flow] {
+        if (evhttp_connection *conn = evhttp_request_get_connection(req_copy)) {
+            // Without the terminating chunk, the client can tell the body is
+            // incomplete. Freeing the connection frees the request as well.
+            evhttp_connection_free(conn);
+        } else {
+            // The connection is gone already, this only frees the request
+            evhttp_send_reply_end(req_copy);
+        }
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    // transferred back to main thread.
+    req = nullptr;
+    replyFlow.reset();
+}
+
 CService HTTPRequest::GetPeer() const {
     evhttp_connection *con = evhttp_request_get_connection(req);
     CService peer;
@@ -770,10 +1029,44 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod() const {
 }
 
 void RegisterHTTPHandler(const std::string &prefix, bool exactMatch,
-                         const HTTPRequestHandler &handler) {
+                         const HTTPRequestHandler &handler,
+                         const HTTPWorkClassifier &classifier) {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n",
              prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(
+        HTTPPathHandler(prefix, exactMatch, handler, classifier));
+}
+
+bool EnqueueHTTPWork(std::function<void()> func) {
+    WorkQueue<HTTPClosure> *queue{g_current_work_queue};
+    if (!queue) {
+        if (g_work_pools.empty()) {
+            return false;
+        }
+        queue = g_work_pools.at(size_t(HTTPWorkClass::RPC)).queue.get();
+    }
+    auto item{std::make_unique<HTTPFunctionWorkItem>(std::move(func))};
+    if (!queue->Enqueue(item.get())) {
+        return false;
+    }
+    // The queue took ownership
+    item.release();
+    return true;
+}
+
+HTTPWorkClass GetHTTPWorkClass() {
+    return g_current_work_queue ? g_current_work_class : HTTPWorkClass::RPC;
+}
+
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo() {
+    std::vector<HTTPWorkQueueInfo> infos;
+    for (const HTTPWorkPool &pool : g_work_pools) {
+        HTTPWorkQueueInfo info{pool.queue->GetInfo()};
+        info.name = pool.name;
+        info.threads = pool.num_threads;
+        infos.push_back(std::move(info));
+    }
+    return infos;
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch) {
@@ -6,10 +6,17 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS = 4;
+static const int DEFAULT_HTTP_HEAVY_THREADS = 2;
+static const int DEFAULT_HTTP_REST_THREADS = 2;
 static const int DEFAULT_HTTP_WORKQUEUE = 16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT = 30;
 
@@ -19,6 +26,7 @@ struct event_base;
 class Config;
 class CService;
 class HTTPRequest;
+struct HTTPReplyFlow;
 
 /**
  * Initialize HTTP server.
@@ -42,22 +50,80 @@ void StopHTTPServer();
 /** Change logging level for libevent. */
 void UpdateHTTPServerLogging(bool enable);
 
+/**
+ * Classes of HTTP requests. Each class has its own bounded work queue and
+ * worker threads, so a burst of slow requests of one class cannot starve the
+ * others.
+ */
+enum class HTTPWorkClass {
+    //! RPC calls, handled by -rpcthreads workers
+    RPC,
+    //! RPC calls that may take long, handled by -rpcheavythreads workers
+    RPC_HEAVY,
+    //! REST requests, handled by -restthreads workers
+    REST,
+};
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(Config &config, HTTPRequest *req,
                            const std::string &)>
     HTTPRequestHandler;
 
+/**
+ * Select the work class of a request. It is called on the event loop thread,
+ * so it must be fast and must not consume the request body.
+ */
+typedef std::function<HTTPWorkClass(HTTPRequest *req, const std::string &)>
+    HTTPWorkClassifier;
+
 /**
  * Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. The requests are handled as HTTPWorkClass::RPC unless a
+ * classifier is given.
  */
 void RegisterHTTPHandler(const std::string &prefix, bool exactMatch,
-                         const HTTPRequestHandler &handler);
+                         const HTTPRequestHandler &handler,
+                         const HTTPWorkClassifier &classifier = {});
 
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/**
+ * Run a function on one of the HTTP worker threads, so a request handler can
+ * spread its work over several threads. The function is queued with the
+ * requests of the same class as the calling worker. Returns false if the work
+ * queue is full, in which case the function is not run.
+ */
+bool EnqueueHTTPWork(std::function<void()> func);
+
+/**
+ * Class of the requests the functions passed to EnqueueHTTPWork() by the
+ * calling thread are queued with: the class of the calling worker, or
+ * HTTPWorkClass::RPC if it is not a worker.
+ */
+HTTPWorkClass GetHTTPWorkClass();
+
+/** State and statistics of the work queue of a class of requests */
+struct HTTPWorkQueueInfo {
+    std::string name;
+    int threads{0};
+    //! Number of queued work items, and the maximum before rejecting requests
+    size_t depth{0};
+    size_t max_depth{0};
+    //! Number of work items being run
+    size_t active{0};
+    uint64_t processed{0};
+    uint64_t rejected{0};
+    //! Time the processed work items spent in the queue, and running
+    std::chrono::microseconds total_wait{0};
+    std::chrono::microseconds max_wait{0};
+    std::chrono::microseconds total_duration{0};
+};
+
+/** Get the state of the work queues, in HTTPWorkClass order */
+std::vector<HTTPWorkQueueInfo> GetHTTPWorkQueueInfo();
+
 /**
  * Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
@@ -72,6 +138,10 @@ class HTTPRequest {
 private:
     struct evhttp_request *req;
     bool replySent;
+    //! Whether a reply is being sent in parts
+    bool replyStarted{false};
+    //! Tracks the parts of the reply not sent to the client yet
+    std::shared_ptr<HTTPReplyFlow> replyFlow;
 
 public:
     explicit HTTPRequest(struct evhttp_request *req, bool replySent = false);
@@ -102,6 +172,9 @@ public:
      */
     std::string ReadBody();
 
+    /** Get up to max_size bytes of the start of the body, not consuming it */
+    std::string PeekBody(size_t max_size) const;
+
     /**
      * Write output header.
      *
@@ -120,6 +193,33 @@ public:
      * this.
      */
     void WriteReply(int nStatus, const std::string &strReply = "");
+
+    /**
+     * Write a part of the HTTP reply body, e.g. from a JSONWriter sink.
+     * Unless the whole body is written at once (last is set on the first
+     * call), the reply is sent with chunked transfer encoding, each part as
+     * soon as it is written, so the body never needs to be held in memory as
+     * a whole. nStatus is only used by the first call.
+     *
+     * Blocks while too much of the reply is waiting to be sent to the client.
+     * Returns false if the client is gone or the node is shutting down, in
+     * which case the rest of the reply is not needed, but the reply must still
+     * be ended by a call with last set or by AbortReply().
+     *
+     * @note The same restrictions as for WriteReply apply once called with
+     * last set, and WriteReply cannot be used once a part is written.
+     */
+    bool WriteReplyPart(int nStatus, std::string &&part, bool last);
+
+    /**
+     * End a reply whose body can't be written entirely, once some of it was
+     * written with WriteReplyPart(). The connection is closed without ending
+     * the chunked body, so the client does not mistake the truncated body for
+     * a complete one.
+     *
+     * @note The same restrictions as for WriteReply apply.
+     */
+    void AbortReply();
 };
 
 /** Event handler closure */
@@ -0,0 +1,340 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+
+#include <chain.h>
+#include <common/args.h>
+#include <crypto/sha256.h>
+#include <flatfile.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <undo.h>
+#include <validation.h>
+
+#include <map>
+
+/**
+ * The index database stores two kinds of entries for each scriptPubKey,
+ * identified by the SHA256 of the script:
+ *
+ * - The history entries, keyed by [DB_ADDRESS_HISTORY, script hash, height
+ *   (BE)]. The value holds the position of the block in the block files and
+ *   the offsets of the transactions of the script after the block header, in
+ *   increasing order and delta-encoded as VARINTs. The height is big-endian
+ *   so the history of a script is iterated in chain order.
+ * - The unspent outputs, keyed by [DB_ADDRESS_UTXO, script hash, outpoint].
+ *   The value holds the amount and the height of the output.
+ *
+ * Unspendable outputs and the outputs of the genesis block are not indexed.
+ */
+constexpr uint8_t DB_ADDRESS_HISTORY{'h'};
+constexpr uint8_t DB_ADDRESS_UTXO{'u'};
+
+std::unique_ptr<AddressIndex> g_address_index;
+
+namespace {
+
+uint256 HashScript(const CScript &script) {
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+struct DBHistoryKey {
+    uint256 script_hash;
+    int height;
+
+    DBHistoryKey() : height(0) {}
+    DBHistoryKey(const uint256 &script_hash_in, int height_in)
+        : script_hash(script_hash_in), height(height_in) {}
+
+    template <typename Stream> void Serialize(Stream &s) const {
+        ser_writedata8(s, DB_ADDRESS_HISTORY);
+        s << script_hash;
+        ser_writedata32be(s, height);
+    }
+
+    template <typename Stream> void Unserialize(Stream &s) {
+        const uint8_t prefix{ser_readdata8(s)};
+        if (prefix != DB_ADDRESS_HISTORY) {
+            throw std::ios_base::failure(
+                "Invalid format for addressindex DB history key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+    }
+};
+
+struct DBHistoryVal {
+    FlatFilePos block_pos;
+    std::vector<uint32_t> tx_offsets;
+
+    template <typename Stream> void Serialize(Stream &s) const {
+        s << block_pos;
+        WriteCompactSize(s, tx_offsets.size());
+        uint32_t prev_offset{0};
+        for (const uint32_t offset : tx_offsets) {
+            const uint32_t delta{offset - prev_offset};
+            s << VARINT(delta);
+            prev_offset = offset;
+        }
+    }
+
+    template <typename Stream> void Unserialize(Stream &s) {
+        s >> block_pos;
+        const uint64_t count{ReadCompactSize(s)};
+        tx_offsets.clear();
+        uint32_t offset{0};
+        for (uint64_t i = 0; i < count; ++i) {
+            uint32_t delta;
+            s >> VARINT(delta);
+            offset += delta;
+            tx_offsets.push_back(offset);
+        }
+    }
+};
+
+struct DBUtxoKey {
+    uint256 script_hash;
+    COutPoint outpoint;
+
+    DBUtxoKey() = default;
+    DBUtxoKey(const uint256 &script_hash_in, const COutPoint &outpoint_in)
+        : script_hash(script_hash_in), outpoint(outpoint_in) {}
+
+    SERIALIZE_METHODS(DBUtxoKey, obj) {
+        uint8_t prefix{DB_ADDRESS_UTXO};
+        READWRITE(prefix);
+        if (prefix != DB_ADDRESS_UTXO) {
+            throw std::ios_base::failure(
+                "Invalid format for addressindex DB utxo key");
+        }
+        READWRITE(obj.script_hash, obj.outpoint);
+    }
+};
+
+struct DBUtxoVal {
+    Amount amount;
+    uint32_t height;
+
+    SERIALIZE_METHODS(DBUtxoVal, obj) {
+        READWRITE(obj.amount, VARINT(obj.height));
+    }
+};
+
+} // namespace
+
+/** Access to the addressindex database (indexes/addressindex/) */
+class AddressIndex::DB : public BaseIndex::DB {
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false,
+                bool f_wipe = false)
+        : BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "addressindex",
+                        n_cache_size, f_memory, f_wipe) {}
+};
+
+/** The changes a block makes to the index */
+struct AddressIndex::PreparedScripts : public BaseIndex::PreparedBlock {
+    FlatFilePos block_pos;
+    //! Offsets of the transactions of each script
+    std::map<uint256, std::vector<uint32_t>> history;
+    std::vector<std::pair<DBUtxoKey, DBUtxoVal>> created;
+    std::vector<std::pair<DBUtxoKey, DBUtxoVal>> spent;
+};
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(std::make_unique<AddressIndex::DB>(n_cache_size, f_memory,
+                                              f_wipe)) {}
+
+AddressIndex::~AddressIndex() {}
+
+std::unique_ptr<AddressIndex::PreparedScripts>
+AddressIndex::ReadBlockChanges(const CBlock &block,
+                               const CBlockIndex *pindex) const {
+    auto changes = std::make_unique<PreparedScripts>();
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (pindex->nHeight == 0) {
+        return changes;
+    }
+
+    CBlockUndo block_undo;
+    if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return nullptr;
+    }
+
+    changes->block_pos = WITH_LOCK(::cs_main, return pindex->GetBlockPos());
+    const uint32_t height = pindex->nHeight;
+    uint32_t offset = GetSizeOfCompactSize(block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction &tx = *block.vtx[i];
+        auto add_to_history = [&](const uint256 &script_hash) {
+            std::vector<uint32_t> &offsets = changes->history[script_hash];
+            if (offsets.empty() || offsets.back() != offset) {
+                offsets.push_back(offset);
+            }
+        };
+
+        for (uint32_t n = 0; n < tx.vout.size(); ++n) {
+            const CTxOut &out = tx.vout[n];
+            if (out.scriptPubKey.IsUnspendable()) {
+                continue;
+            }
+            const uint256 script_hash = HashScript(out.scriptPubKey);
+            add_to_history(script_hash);
+            changes->created.emplace_back(
+                DBUtxoKey{script_hash, COutPoint{tx.GetId(), n}},
+                DBUtxoVal{out.nValue, height});
+        }
+
+        if (i > 0) {
+            const CTxUndo &tx_undo = block_undo.vtxundo.at(i - 1);
+            for (size_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin &coin = tx_undo.vprevout.at(j);
+                const uint256 script_hash =
+                    HashScript(coin.GetTxOut().scriptPubKey);
+                add_to_history(script_hash);
+                changes->spent.emplace_back(
+                    DBUtxoKey{script_hash, tx.vin[j].prevout},
+                    DBUtxoVal{coin.GetTxOut().nValue, coin.GetHeight()});
+            }
+        }
+
+        offset += ::GetSerializeSize(tx, CLIENT_VERSION);
+    }
+    return changes;
+}
+
+std::unique_ptr<BaseIndex::PreparedBlock>
+AddressIndex::PrepareBlock(std::shared_ptr<const CBlock> block,
+                           const CBlockIndex *pindex) const {
+    return ReadBlockChanges(*block, pindex);
+}
+
+bool AddressIndex::WritePreparedBlock(PreparedBlock &prepared,
+                                      const CBlockIndex *pindex,
+                                      CDBBatch &batch) {
+    PreparedScripts &changes = static_cast<PreparedScripts &>(prepared);
+    for (auto &[script_hash, offsets] : changes.history) {
+        batch.Write(DBHistoryKey{script_hash, pindex->nHeight},
+                    DBHistoryVal{changes.block_pos, std::move(offsets)});
+    }
+    // The outputs spent in the same block are erased after being created
+    for (const auto &[key, value] : changes.created) {
+        batch.Write(key, value);
+    }
+    for (const auto &[key, value] : changes.spent) {
+        batch.Erase(key);
+    }
+    return true;
+}
+
+bool AddressIndex::Rewind(const CBlockIndex *current_tip,
+                          const CBlockIndex *new_tip) {
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex *pindex = current_tip; pindex != new_tip;
+         pindex = pindex->pprev) {
+        CBlock block;
+        if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
+            return error("%s: Failed to read block %s from disk", __func__,
+                         pindex->GetBlockHash().ToString());
+        }
+        const auto changes = ReadBlockChanges(block, pindex);
+        if (!changes) {
+            return error("%s: Failed to read undo data of block %s", __func__,
+                         pindex->GetBlockHash().ToString());
+        }
+
+        for (const auto &[script_hash, offsets] : changes->history) {
+            batch.Erase(DBHistoryKey{script_hash, pindex->nHeight});
+        }
+        // Reverse order of WritePreparedBlock
+        for (const auto &[key, value] : changes->spent) {
+            batch.Write(key, value);
+        }
+        for (const auto &[key, value] : changes->created) {
+            batch.Erase(key);
+        }
+    }
+
+    if (!m_db->WriteBatch(batch)) {
+        return false;
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB &AddressIndex::GetDB() const {
+    return *m_db;
+}
+
+bool AddressIndex::FindHistory(
+    const CScript &script, size_t skip, size_t count,
+    std::vector<AddressHistoryEntry> &history) const {
+    const uint256 script_hash = HashScript(script);
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    db_it->Seek(DBHistoryKey{script_hash, 0});
+
+    DBHistoryKey key;
+    while (history.size() < count && db_it->Valid() && db_it->GetKey(key) &&
+           key.script_hash == script_hash) {
+        DBHistoryVal value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: Failed to read %s history at height %d",
+                         __func__, GetName(), key.height);
+        }
+        if (skip >= value.tx_offsets.size()) {
+            skip -= value.tx_offsets.size();
+            db_it->Next();
+            continue;
+        }
+
+        for (size_t i = skip; i < value.tx_offsets.size(); ++i) {
+            if (history.size() >= count) {
+                break;
+            }
+            CBlockHeader header;
+            CTransactionRef tx;
+            if (!m_chainstate->m_blockman.ReadTxFromDisk(
+                    header, tx, value.block_pos, value.tx_offsets[i])) {
+                return false;
+            }
+            history.push_back({key.height, header.GetHash(), std::move(tx)});
+        }
+        skip = 0;
+        db_it->Next();
+    }
+    return true;
+}
+
+bool AddressIndex::FindUtxos(const CScript &script, size_t skip, size_t count,
+                             std::vector<AddressUtxo> &utxos) const {
+    const uint256 script_hash = HashScript(script);
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    db_it->Seek(DBUtxoKey{script_hash, COutPoint{TxId{}, 0}});
+
+    DBUtxoKey key;
+    while (utxos.size() < count && db_it->Valid() && db_it->GetKey(key) &&
+           key.script_hash == script_hash) {
+        if (skip > 0) {
+            --skip;
+            db_it->Next();
+            continue;
+        }
+        DBUtxoVal value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: Failed to read %s utxo %s", __func__, GetName(),
+                         key.outpoint.ToString());
+        }
+        utxos.push_back(
+            {key.outpoint, value.amount, static_cast<int>(value.height)});
+        db_it->Next();
+    }
+    return true;
+}
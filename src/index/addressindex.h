@@ -0,0 +1,100 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <consensus/amount.h>
+#include <index/base.h>
+#include <primitives/blockhash.h>
+#include <primitives/transaction.h>
+
+#include <memory>
+#include <vector>
+
+class CScript;
+
+static constexpr bool DEFAULT_ADDRESSINDEX{false};
+
+/** A transaction sending to or spending from a script */
+struct AddressHistoryEntry {
+    int height;
+    BlockHash block_hash;
+    CTransactionRef tx;
+};
+
+/** An unspent output paying to a script */
+struct AddressUtxo {
+    COutPoint outpoint;
+    Amount amount;
+    int height;
+};
+
+/**
+ * AddressIndex is used to look up the transactions and the unspent outputs of
+ * a scriptPubKey. The index is written to a LevelDB database, keyed by the
+ * SHA256 of the scriptPubKey. The history of a script holds one entry per
+ * block, listing the positions of its transactions in the block file so they
+ * can be read from disk without the txindex.
+ */
+class AddressIndex final : public BaseIndex {
+protected:
+    class DB;
+
+private:
+    struct PreparedScripts;
+
+    const std::unique_ptr<DB> m_db;
+
+    /// Compute the changes a block makes to the index
+    std::unique_ptr<PreparedScripts> ReadBlockChanges(const CBlock &block,
+                                                      const CBlockIndex *pindex)
+        const;
+
+    bool AllowPrune() const override { return false; }
+
+protected:
+    std::unique_ptr<PreparedBlock>
+    PrepareBlock(std::shared_ptr<const CBlock> block,
+                 const CBlockIndex *pindex) const override;
+
+    bool WritePreparedBlock(PreparedBlock &prepared, const CBlockIndex *pindex,
+                            CDBBatch &batch) override;
+
+    bool Rewind(const CBlockIndex *current_tip,
+                const CBlockIndex *new_tip) override;
+
+    BaseIndex::DB &GetDB() const override;
+
+    const char *GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false,
+                          bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an
+    // incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Look up the transactions sending to or spending from a script, in
+    /// chain order.
+    ///
+    /// @param[in]   script  The scriptPubKey to look up.
+    /// @param[in]   skip  Number of transactions to skip.
+    /// @param[in]   count  Maximum number of transactions to return.
+    /// @param[out]  history  The transactions found.
+    /// @return  false if the transactions could not be read from disk
+    bool FindHistory(const CScript &script, size_t skip, size_t count,
+                     std::vector<AddressHistoryEntry> &history) const;
+
+    /// Look up the unspent outputs paying to a script, ordered by outpoint.
+    bool FindUtxos(const CScript &script, size_t skip, size_t count,
+                   std::vector<AddressUtxo> &utxos) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_address_index;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
@@ -18,12 +18,21 @@
 #include <validation.h> // For Chainstate
 #include <warnings.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <vector>
 
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30;           // secon
 constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+//! Number of blocks read ahead of the index per sync worker thread
+constexpr size_t SYNC_BLOCKS_AHEAD_PER_THREAD{16};
+//! Size of the database batches written by the sync thread
+constexpr size_t SYNC_BATCH_SIZE{16 << 20};
 
 template <typename... Args>
 static void FatalError(const char *fmt, const Args &...args) {
@@ -124,6 +133,124 @@ bool BaseIndex::Init() {
     return true;
 }
 
+/**
+ * Reads and prepares the blocks ahead of the index on worker threads, so the
+ * sync thread only has to write them in chain order.
+ */
+class BaseIndex::SyncPipeline {
+    struct Job {
+        const CBlockIndex *const pindex;
+        std::unique_ptr<PreparedBlock> prepared;
+        bool done{false};
+        bool read_failed{false};
+
+        explicit Job(const CBlockIndex *pindex_in) : pindex(pindex_in) {}
+    };
+
+    BaseIndex &m_index;
+    const size_t m_max_queued;
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    //! The blocks ahead of the index, in chain order
+    std::deque<std::shared_ptr<Job>> m_queue GUARDED_BY(m_mutex);
+    //! Number of blocks at the front of the queue taken by a worker
+    size_t m_num_started GUARDED_BY(m_mutex){0};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_workers;
+
+    void ThreadWorker() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        WAIT_LOCK(m_mutex, lock);
+        while (true) {
+            m_cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+                return m_stop || m_num_started < m_queue.size();
+            });
+            if (m_stop) {
+                return;
+            }
+            std::shared_ptr<Job> job = m_queue[m_num_started++];
+
+            std::unique_ptr<PreparedBlock> prepared;
+            bool read_failed{false};
+            {
+                REVERSE_LOCK(lock);
+                auto block = std::make_shared<CBlock>();
+                if (m_index.m_chainstate->m_blockman.ReadBlockFromDisk(
+                        *block, *job->pindex)) {
+                    prepared = m_index.PrepareBlock(std::move(block),
+                                                    job->pindex);
+                } else {
+                    read_failed = true;
+                }
+            }
+
+            job->prepared = std::move(prepared);
+            job->read_failed = read_failed;
+            job->done = true;
+            m_cond.notify_all();
+        }
+    }
+
+public:
+    SyncPipeline(BaseIndex &index, int num_threads)
+        : m_index(index),
+          m_max_queued(num_threads * SYNC_BLOCKS_AHEAD_PER_THREAD) {
+        for (int i = 0; i < num_threads; ++i) {
+            m_workers.emplace_back(
+                [this, name = strprintf("%s.%d", m_index.GetName(), i)] {
+                    util::TraceThread(name.c_str(),
+                                      [this] { ThreadWorker(); });
+                });
+        }
+    }
+
+    ~SyncPipeline() {
+        WITH_LOCK(m_mutex, m_stop = true);
+        m_cond.notify_all();
+        for (std::thread &worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    bool Empty() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_queue.empty());
+    }
+
+    bool Full() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_queue.size() >= m_max_queued);
+    }
+
+    /** The last block queued, or nullptr if the queue is empty */
+    const CBlockIndex *Back() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        return m_queue.empty() ? nullptr : m_queue.back()->pindex;
+    }
+
+    void Push(const CBlockIndex *pindex) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        WITH_LOCK(m_mutex, m_queue.push_back(std::make_shared<Job>(pindex)));
+        m_cond.notify_all();
+    }
+
+    /**
+     * Wait for the first block of the queue to be prepared and remove it.
+     * Returns nullptr if the index is interrupted first.
+     */
+    std::shared_ptr<Job> Pop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        WAIT_LOCK(m_mutex, lock);
+        assert(!m_queue.empty());
+        while (!m_queue.front()->done) {
+            if (m_index.m_interrupt) {
+                return nullptr;
+            }
+            m_cond.wait_for(lock, std::chrono::milliseconds{100});
+        }
+        std::shared_ptr<Job> job = std::move(m_queue.front());
+        m_queue.pop_front();
+        --m_num_started;
+        return job;
+    }
+};
+
 static const CBlockIndex *NextSyncBlock(const CBlockIndex *pindex_prev,
                                         CChain &chain)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
@@ -144,39 +271,104 @@ static const CBlockIndex *NextSyncBlock(const CBlockIndex *pindex_prev,
 void BaseIndex::ThreadSync() {
     const CBlockIndex *pindex = m_best_block_index.load();
     if (!m_synced) {
+        const int num_threads{
+            std::clamp<int>(gArgs.GetIntArg("-indexsyncthreads",
+                                            DEFAULT_INDEX_SYNC_THREADS),
+                            1, MAX_INDEX_SYNC_THREADS)};
+        SyncPipeline pipeline(*this, num_threads);
+        CDBBatch batch(GetDB());
+
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
         while (true) {
             if (m_interrupt) {
-                SetBestBlockIndex(pindex);
-                // No need to handle errors in Commit. If it fails, the error
-                // will be already be logged. The best way to recover is to
-                // continue, as index cannot be corrupted by a missed commit to
-                // disk for an advanced index state.
-                Commit();
+                // The index entries of the blocks up to pindex must be written
+                // before the locator moves
+                if (WriteEntries(batch)) {
+                    SetBestBlockIndex(pindex);
+                    // No need to handle errors in Commit. If it fails, the
+                    // error will be already be logged. The best way to recover
+                    // is to continue, as index cannot be corrupted by a missed
+                    // commit to disk for an advanced index state.
+                    Commit();
+                }
                 return;
             }
 
             {
                 LOCK(cs_main);
-                const CBlockIndex *pindex_next =
-                    NextSyncBlock(pindex, m_chainstate->m_chain);
-                if (!pindex_next) {
-                    SetBestBlockIndex(pindex);
-                    m_synced = true;
-                    // No need to handle errors in Commit. See rationale above.
-                    Commit();
-                    break;
+                // Queue the next blocks of the chain for the workers. If the
+                // chain forked from the queued blocks, they are written first
+                // and the index is rewound once the queue is empty.
+                while (!pipeline.Full()) {
+                    const CBlockIndex *pindex_last = pipeline.Back();
+                    const bool queue_empty{pindex_last == nullptr};
+                    if (queue_empty) {
+                        pindex_last = pindex;
+                    }
+                    const CBlockIndex *pindex_next =
+                        NextSyncBlock(pindex_last, m_chainstate->m_chain);
+                    if (!pindex_next) {
+                        if (queue_empty) {
+                            if (!WriteEntries(batch)) {
+                                FatalError("%s: Failed to write index %s",
+                                           __func__, GetName());
+                                return;
+                            }
+                            SetBestBlockIndex(pindex);
+                            m_synced = true;
+                            // No need to handle errors in Commit. See
+                            // rationale above.
+                            Commit();
+                        }
+                        break;
+                    }
+                    if (pindex_next->pprev != pindex_last) {
+                        if (!queue_empty) {
+                            break;
+                        }
+                        if (!WriteEntries(batch)) {
+                            FatalError("%s: Failed to write index %s",
+                                       __func__, GetName());
+                            return;
+                        }
+                        // The written blocks are all the index has
+                        SetBestBlockIndex(pindex);
+                        if (!Rewind(pindex, pindex_next->pprev)) {
+                            FatalError("%s: Failed to rewind index %s to a "
+                                       "previous chain tip",
+                                       __func__, GetName());
+                            return;
+                        }
+                        pindex = pindex_next->pprev;
+                    }
+                    pipeline.Push(pindex_next);
                 }
-                if (pindex_next->pprev != pindex &&
-                    !Rewind(pindex, pindex_next->pprev)) {
-                    FatalError(
-                        "%s: Failed to rewind index %s to a previous chain tip",
-                        __func__, GetName());
-                    return;
-                }
-                pindex = pindex_next;
             }
+            if (m_synced) {
+                break;
+            }
+            if (pipeline.Empty()) {
+                continue;
+            }
+
+            const auto job = pipeline.Pop();
+            if (!job) {
+                // Interrupted
+                continue;
+            }
+            if (job->read_failed) {
+                FatalError("%s: Failed to read block %s from disk", __func__,
+                           job->pindex->GetBlockHash().ToString());
+                return;
+            }
+            if (!job->prepared ||
+                !WritePreparedBlock(*job->prepared, job->pindex, batch)) {
+                FatalError("%s: Failed to write block %s to index database",
+                           __func__, job->pindex->GetBlockHash().ToString());
+                return;
+            }
+            pindex = job->pindex;
 
             int64_t current_time = GetTime();
             if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
@@ -185,25 +377,22 @@ void BaseIndex::ThreadSync() {
                 last_log_time = current_time;
             }
 
-            if (last_locator_write_time + SYNC_LOCATOR_WRITE_INTERVAL <
-                current_time) {
+            const bool write_locator{last_locator_write_time +
+                                         SYNC_LOCATOR_WRITE_INTERVAL <
+                                     current_time};
+            if (write_locator || batch.SizeEstimate() >= SYNC_BATCH_SIZE) {
+                if (!WriteEntries(batch)) {
+                    FatalError("%s: Failed to write block %s to index database",
+                               __func__, pindex->GetBlockHash().ToString());
+                    return;
+                }
+            }
+            if (write_locator) {
                 SetBestBlockIndex(pindex);
                 last_locator_write_time = current_time;
                 // No need to handle errors in Commit. See rationale above.
                 Commit();
             }
-
-            CBlock block;
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
-                FatalError("%s: Failed to read block %s from disk", __func__,
-                           pindex->GetBlockHash().ToString());
-                return;
-            }
-            if (!WriteBlock(block, pindex)) {
-                FatalError("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
-            }
         }
     }
 
@@ -214,6 +403,35 @@ void BaseIndex::ThreadSync() {
     }
 }
 
+bool BaseIndex::WriteEntries(CDBBatch &batch) {
+    if (batch.SizeEstimate() == 0) {
+        return true;
+    }
+    if (!GetDB().WriteBatch(batch)) {
+        return error("%s: Failed to write %s entries", __func__, GetName());
+    }
+    batch.Clear();
+    return true;
+}
+
+struct BaseIndex::UnpreparedBlock : BaseIndex::PreparedBlock {
+    std::shared_ptr<const CBlock> block;
+};
+
+std::unique_ptr<BaseIndex::PreparedBlock>
+BaseIndex::PrepareBlock(std::shared_ptr<const CBlock> block,
+                        const CBlockIndex *pindex) const {
+    auto prepared = std::make_unique<UnpreparedBlock>();
+    prepared->block = std::move(block);
+    return prepared;
+}
+
+bool BaseIndex::WritePreparedBlock(PreparedBlock &prepared,
+                                   const CBlockIndex *pindex,
+                                   CDBBatch &batch) {
+    return WriteBlock(*static_cast<UnpreparedBlock &>(prepared).block, pindex);
+}
+
 bool BaseIndex::Commit() {
     CDBBatch batch(GetDB());
     if (!CommitInternal(batch) || !GetDB().WriteBatch(batch)) {
@@ -292,7 +510,10 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock> &block,
         }
     }
 
-    if (WriteBlock(*block, pindex)) {
+    std::unique_ptr<PreparedBlock> prepared = PrepareBlock(block, pindex);
+    CDBBatch batch(GetDB());
+    if (prepared && WritePreparedBlock(*prepared, pindex, batch) &&
+        WriteEntries(batch)) {
         // Setting the best block index is intentionally the last step of this
         // function, so BlockUntilSyncedToCurrentChain callers waiting for the
         // best block index to be updated can rely on the block being fully
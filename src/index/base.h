@@ -9,10 +9,17 @@
 #include <threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <memory>
+
 class CBlock;
 class CBlockIndex;
 class Chainstate;
 
+/** Default number of threads reading and preparing blocks during index sync */
+static constexpr int DEFAULT_INDEX_SYNC_THREADS{4};
+/** Maximum number of threads reading and preparing blocks during index sync */
+static constexpr int MAX_INDEX_SYNC_THREADS{16};
+
 struct IndexSummary {
     std::string name;
     bool synced{false};
@@ -57,13 +64,24 @@ private:
     std::thread m_thread_sync;
     CThreadInterrupt m_interrupt;
 
+    class SyncPipeline;
+    struct UnpreparedBlock;
+
     /// Sync the index with the block index starting from the current best
     /// block. Intended to be run in its own thread, m_thread_sync, and can be
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
     /// flag is set and the BlockConnected ValidationInterface callback takes
     /// over and the sync thread exits.
+    ///
+    /// The blocks ahead of the index are read and prepared by worker threads
+    /// while the sync thread writes the prepared blocks in chain order,
+    /// grouping their entries into large database batches.
     void ThreadSync();
 
+    /// Write the index entries added to the batch by WritePreparedBlock and
+    /// clear it.
+    bool WriteEntries(CDBBatch &batch);
+
     /// Write the current index state (eg. chain block locator and
     /// subclass-specific items) to disk.
     ///
@@ -91,11 +109,31 @@ protected:
     /// Initialize internal state from the database and block index.
     [[nodiscard]] virtual bool Init();
 
+    /// The data of a block needed to write its index entries.
+    struct PreparedBlock {
+        virtual ~PreparedBlock() = default;
+    };
+
     /// Write update index entries for a newly connected block.
     virtual bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) {
         return true;
     }
 
+    /// Compute what WritePreparedBlock needs to index a block, independently
+    /// of the state of the index. During the sync, it is called for several
+    /// blocks at once from the worker threads. The default keeps the block
+    /// for WriteBlock. Returns nullptr on failure.
+    virtual std::unique_ptr<PreparedBlock>
+    PrepareBlock(std::shared_ptr<const CBlock> block,
+                 const CBlockIndex *pindex) const;
+
+    /// Write the index entries of a prepared block, in chain order. The
+    /// database entries can be added to the batch, which is written before
+    /// the best block of the index moves past this block.
+    virtual bool WritePreparedBlock(PreparedBlock &prepared,
+                                    const CBlockIndex *pindex,
+                                    CDBBatch &batch);
+
     /// Virtual method called internally by Commit that can be overridden to
     /// atomically commit more index state.
     virtual bool CommitInternal(CDBBatch &batch);
@@ -7,10 +7,13 @@
 #include <index/blockfilterindex.h>
 #include <node/blockstorage.h>
 #include <primitives/blockhash.h>
+#include <streams.h>
 #include <util/fs_helpers.h>
 #include <validation.h>
+#include <version.h>
 
 #include <map>
+#include <optional>
 
 /**
  * The index database stores three items for each block: the disk location of
@@ -41,15 +44,6 @@ constexpr unsigned int MAX_FLTR_FILE_SIZE = 0x1000000;
 // 1 MiB
 constexpr unsigned int FLTR_FILE_CHUNK_SIZE = 0x100000;
 
-/**
- *  Maximum size of the cfheaders cache.
- *  We have a limit to prevent a bug in filling this cache
- *  potentially turning into an OOM. At 2000 entries, this cache
- *  is big enough for a 2,000,000 length block chain, which
- *  we should be enough until ~2047.
- */
-constexpr size_t CF_HEADERS_CACHE_MAX_SZ{2000};
-
 namespace {
 
 struct DBVal {
@@ -102,10 +96,31 @@ struct DBHashKey {
 
 static std::map<BlockFilterType, BlockFilterIndex> g_filter_indexes;
 
+/** The filter of a block, built ahead of writing it to the index */
+struct BlockFilterIndex::PreparedFilter : public BaseIndex::PreparedBlock {
+    BlockFilter filter;
+};
+
+/** Serialize the checkpoint headers the way a cfcheckpt message holds them */
+static std::shared_ptr<const std::vector<uint8_t>> SerializeCheckpoints(
+    const std::vector<std::pair<BlockHash, uint256>> &checkpoints) {
+    std::vector<uint256> headers;
+    headers.reserve(checkpoints.size());
+    for (const auto &checkpoint : checkpoints) {
+        headers.push_back(checkpoint.second);
+    }
+    auto serialized = std::make_shared<std::vector<uint8_t>>();
+    CVectorWriter{SER_NETWORK, PROTOCOL_VERSION, *serialized, 0, headers};
+    return serialized;
+}
+
 BlockFilterIndex::BlockFilterIndex(BlockFilterType filter_type,
                                    size_t n_cache_size, bool f_memory,
                                    bool f_wipe)
-    : m_filter_type(filter_type) {
+    : m_filter_type(filter_type),
+      m_cache_size(std::max<int64_t>(
+          0, gArgs.GetIntArg("-blockfiltercache", DEFAULT_BLOCKFILTER_CACHE))),
+      m_serialized_checkpoints(SerializeCheckpoints({})) {
     const std::string &filter_name = BlockFilterTypeName(filter_type);
     if (filter_name.empty()) {
         throw std::invalid_argument("unknown filter_type");
@@ -138,7 +153,137 @@ bool BlockFilterIndex::Init() {
         m_next_filter_pos.nFile = 0;
         m_next_filter_pos.nPos = 0;
     }
-    return BaseIndex::Init();
+    return BaseIndex::Init() && LoadCache();
+}
+
+bool BlockFilterIndex::LoadCache() {
+    const CBlockIndex *tip = CurrentIndex();
+    if (!tip) {
+        return true;
+    }
+
+    const auto read_entry = [&](CDBIterator &db_it, int height,
+                                CachedEntry &entry) {
+        DBHeightKey key;
+        std::pair<BlockHash, DBVal> value;
+        if (!db_it.Valid() || !db_it.GetKey(key) || key.height != height ||
+            !db_it.GetValue(value) ||
+            value.first != tip->GetAncestor(height)->GetBlockHash()) {
+            return error("%s: unable to read value in %s at key (%c, %d)",
+                         __func__, GetName(), DB_BLOCK_HEIGHT, height);
+        }
+        entry.block_hash = value.first;
+        entry.filter_hash = value.second.hash;
+        entry.header = value.second.header;
+        entry.pos = value.second.pos;
+        return true;
+    };
+
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    std::vector<std::pair<BlockHash, uint256>> checkpoints;
+    for (int height = CFCHECKPT_INTERVAL; height <= tip->nHeight;
+         height += CFCHECKPT_INTERVAL) {
+        CachedEntry entry;
+        db_it->Seek(DBHeightKey(height));
+        if (!read_entry(*db_it, height, entry)) {
+            return false;
+        }
+        checkpoints.emplace_back(entry.block_hash, entry.header);
+    }
+
+    const int start_height =
+        std::max<int64_t>(0, int64_t(tip->nHeight) - m_cache_size + 1);
+    std::deque<CachedEntry> cache;
+    db_it->Seek(DBHeightKey(start_height));
+    for (int height = start_height;
+         m_cache_size > 0 && height <= tip->nHeight; ++height) {
+        CachedEntry &entry = cache.emplace_back();
+        if (!read_entry(*db_it, height, entry)) {
+            return false;
+        }
+        if (tip->nHeight - height < BLOCKFILTER_RAW_CACHE &&
+            !ReadRawFilterFromDisk(entry.pos, entry.raw_filter)) {
+            return error("%s: unable to read filter of %s at height %d",
+                         __func__, GetName(), height);
+        }
+        db_it->Next();
+    }
+
+    LOCK(m_cache_mutex);
+    m_cache = std::move(cache);
+    m_cache_start = start_height;
+    m_checkpoints = std::move(checkpoints);
+    m_serialized_checkpoints = SerializeCheckpoints(m_checkpoints);
+    return true;
+}
+
+void BlockFilterIndex::AddCachedEntry(const CBlockIndex *pindex,
+                                      CachedEntry entry) {
+    const int height = pindex->nHeight;
+    TruncateCache(height - 1);
+
+    const size_t checkpoint = height / CFCHECKPT_INTERVAL;
+    if (height > 0 && height % CFCHECKPT_INTERVAL == 0 &&
+        m_checkpoints.size() == checkpoint - 1 &&
+        (m_checkpoints.empty() ||
+         pindex->GetAncestor((checkpoint - 1) * CFCHECKPT_INTERVAL)
+                 ->GetBlockHash() == m_checkpoints.back().first)) {
+        m_checkpoints.emplace_back(entry.block_hash, entry.header);
+        m_serialized_checkpoints = SerializeCheckpoints(m_checkpoints);
+    }
+
+    if (m_cache_size == 0) {
+        return;
+    }
+    // The cache only holds consecutive blocks of a chain
+    if (!m_cache.empty() &&
+        (m_cache_start + int(m_cache.size()) != height ||
+         m_cache.back().block_hash != pindex->pprev->GetBlockHash())) {
+        m_cache.clear();
+    }
+    if (m_cache.empty()) {
+        m_cache_start = height;
+    }
+    m_cache.push_back(std::move(entry));
+    if (m_cache.size() > m_cache_size) {
+        m_cache.pop_front();
+        ++m_cache_start;
+    }
+    if (m_cache.size() > BLOCKFILTER_RAW_CACHE) {
+        std::vector<uint8_t>().swap(
+            m_cache[m_cache.size() - BLOCKFILTER_RAW_CACHE - 1].raw_filter);
+    }
+}
+
+void BlockFilterIndex::TruncateCache(int height) {
+    while (!m_cache.empty() &&
+           m_cache_start + int(m_cache.size()) - 1 > height) {
+        m_cache.pop_back();
+    }
+    const size_t num_checkpoints = std::max(height, 0) / CFCHECKPT_INTERVAL;
+    if (m_checkpoints.size() > num_checkpoints) {
+        m_checkpoints.resize(num_checkpoints);
+        m_serialized_checkpoints = SerializeCheckpoints(m_checkpoints);
+    }
+}
+
+const BlockFilterIndex::CachedEntry *
+BlockFilterIndex::FindCachedEntry(const CBlockIndex *block_index) const {
+    const int i = block_index->nHeight - m_cache_start;
+    if (i < 0 || i >= int(m_cache.size()) ||
+        m_cache[i].block_hash != block_index->GetBlockHash()) {
+        return nullptr;
+    }
+    return &m_cache[i];
+}
+
+bool BlockFilterIndex::IsRangeCached(int start_height,
+                                     const CBlockIndex *stop_index) const {
+    // The cache holds a single chain, so it holds the ancestors of the stop
+    // block down to its start.
+    return start_height >= m_cache_start &&
+           start_height <= stop_index->nHeight &&
+           FindCachedEntry(stop_index) != nullptr;
 }
 
 bool BlockFilterIndex::CommitInternal(CDBBatch &batch) {
@@ -158,6 +303,34 @@ bool BlockFilterIndex::CommitInternal(CDBBatch &batch) {
     return BaseIndex::CommitInternal(batch);
 }
 
+bool BlockFilterIndex::ReadRawFilterFromDisk(
+    const FlatFilePos &pos, std::vector<uint8_t> &raw_filter) const {
+    AutoFile filein{m_filter_fileseq->Open(pos, true)};
+    if (filein.IsNull()) {
+        return false;
+    }
+
+    try {
+        raw_filter.resize(sizeof(BlockHash));
+        filein.read(MakeWritableByteSpan(raw_filter));
+        const uint64_t filter_size = ReadCompactSize(filein);
+        if (filter_size > MAX_FLTR_FILE_SIZE) {
+            return error("%s: Invalid block filter size %u", __func__,
+                         filter_size);
+        }
+        CVectorWriter{SER_DISK, CLIENT_VERSION, raw_filter, raw_filter.size(),
+                      COMPACTSIZE(filter_size)};
+        const size_t header_size = raw_filter.size();
+        raw_filter.resize(header_size + filter_size);
+        filein.read(MakeWritableByteSpan(raw_filter).subspan(header_size));
+    } catch (const std::exception &e) {
+        return error("%s: Failed to read block filter from disk: %s", __func__,
+                     e.what());
+    }
+
+    return true;
+}
+
 bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos &pos,
                                           BlockFilter &filter) const {
     AutoFile filein{m_filter_fileseq->Open(pos, true)};
@@ -179,13 +352,10 @@ bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos &pos,
     return true;
 }
 
-size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos &pos,
-                                           const BlockFilter &filter) {
-    assert(filter.GetFilterType() == GetFilterType());
-
-    size_t data_size =
-        GetSerializeSize(filter.GetBlockHash(), CLIENT_VERSION) +
-        GetSerializeSize(filter.GetEncodedFilter(), CLIENT_VERSION);
+size_t
+BlockFilterIndex::WriteFilterToDisk(FlatFilePos &pos,
+                                    const std::vector<uint8_t> &raw_filter) {
+    const size_t data_size = raw_filter.size();
 
     // If writing the filter would overflow the file, flush and move to the next
     // one.
@@ -225,39 +395,58 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos &pos,
         return 0;
     }
 
-    fileout << filter.GetBlockHash() << filter.GetEncodedFilter();
+    fileout.write(MakeByteSpan(raw_filter));
     return data_size;
 }
 
-bool BlockFilterIndex::WriteBlock(const CBlock &block,
-                                  const CBlockIndex *pindex) {
+std::unique_ptr<BaseIndex::PreparedBlock>
+BlockFilterIndex::PrepareBlock(std::shared_ptr<const CBlock> block,
+                               const CBlockIndex *pindex) const {
     CBlockUndo block_undo;
-    uint256 prev_header;
+    if (pindex->nHeight > 0 &&
+        !m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return nullptr;
+    }
 
-    if (pindex->nHeight > 0) {
-        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
-            return false;
-        }
+    auto prepared = std::make_unique<PreparedFilter>();
+    prepared->filter = BlockFilter(m_filter_type, *block, block_undo);
+    return prepared;
+}
 
-        std::pair<BlockHash, DBVal> read_out;
-        if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
-            return false;
-        }
+bool BlockFilterIndex::WritePreparedBlock(PreparedBlock &prepared,
+                                          const CBlockIndex *pindex,
+                                          CDBBatch &batch) {
+    const BlockFilter &filter =
+        static_cast<PreparedFilter &>(prepared).filter;
+    assert(filter.GetFilterType() == GetFilterType());
+    uint256 prev_header;
 
+    if (pindex->nHeight > 0) {
         BlockHash expected_block_hash = pindex->pprev->GetBlockHash();
-        if (read_out.first != expected_block_hash) {
-            return error("%s: previous block header belongs to unexpected "
-                         "block %s; expected %s",
-                         __func__, read_out.first.ToString(),
-                         expected_block_hash.ToString());
+        if (m_last_block_hash == expected_block_hash) {
+            prev_header = m_last_header;
+        } else {
+            std::pair<BlockHash, DBVal> read_out;
+            if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
+                return false;
+            }
+
+            if (read_out.first != expected_block_hash) {
+                return error("%s: previous block header belongs to unexpected "
+                             "block %s; expected %s",
+                             __func__, read_out.first.ToString(),
+                             expected_block_hash.ToString());
+            }
+
+            prev_header = read_out.second.header;
         }
-
-        prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, block, block_undo);
-
-    size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
+    // Serialized once, for the file and for the cache
+    std::vector<uint8_t> raw_filter;
+    CVectorWriter{SER_DISK, CLIENT_VERSION, raw_filter, 0,
+                  filter.GetBlockHash(), filter.GetEncodedFilter()};
+    size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, raw_filter);
     if (bytes_written == 0) {
         return false;
     }
@@ -268,11 +457,15 @@ bool BlockFilterIndex::WriteBlock(const CBlock &block,
     value.second.header = filter.ComputeHeader(prev_header);
     value.second.pos = m_next_filter_pos;
 
-    if (!m_db->Write(DBHeightKey(pindex->nHeight), value)) {
-        return false;
-    }
+    batch.Write(DBHeightKey(pindex->nHeight), value);
 
     m_next_filter_pos.nPos += bytes_written;
+    m_last_block_hash = value.first;
+    m_last_header = value.second.header;
+
+    LOCK(m_cache_mutex);
+    AddCachedEntry(pindex, {value.first, value.second.hash, value.second.header,
+                            value.second.pos, std::move(raw_filter)});
     return true;
 }
 
@@ -324,6 +517,7 @@ bool BlockFilterIndex::Rewind(const CBlockIndex *current_tip,
     if (!m_db->WriteBatch(batch)) {
         return false;
     }
+    WITH_LOCK(m_cache_mutex, TruncateCache(new_tip->nHeight));
 
     return BaseIndex::Rewind(current_tip, new_tip);
 }
@@ -408,26 +602,40 @@ static bool LookupRange(CDBWrapper &db, const std::string &index_name,
 
 bool BlockFilterIndex::LookupFilter(const CBlockIndex *block_index,
                                     BlockFilter &filter_out) const {
-    DBVal entry;
-    if (!LookupOne(*m_db, block_index, entry)) {
-        return false;
+    std::optional<FlatFilePos> pos;
+    {
+        LOCK(m_cache_mutex);
+        if (const CachedEntry *cached = FindCachedEntry(block_index)) {
+            pos = cached->pos;
+        }
+    }
+    if (!pos) {
+        DBVal entry;
+        if (!LookupOne(*m_db, block_index, entry)) {
+            return false;
+        }
+        pos = entry.pos;
     }
 
-    return ReadFilterFromDisk(entry.pos, filter_out);
+    return ReadFilterFromDisk(*pos, filter_out);
 }
 
 bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex *block_index,
-                                          uint256 &header_out) {
-    LOCK(m_cs_headers_cache);
-
-    bool is_checkpoint{block_index->nHeight % CFCHECKPT_INTERVAL == 0};
+                                          uint256 &header_out) const {
+    {
+        LOCK(m_cache_mutex);
+        if (const CachedEntry *cached = FindCachedEntry(block_index)) {
+            header_out = cached->header;
+            return true;
+        }
 
-    if (is_checkpoint) {
-        // Try to find the block in the headers cache if this is a checkpoint
-        // height.
-        auto header = m_headers_cache.find(block_index->GetBlockHash());
-        if (header != m_headers_cache.end()) {
-            header_out = header->second;
+        const int height = block_index->nHeight;
+        const size_t checkpoint = height / CFCHECKPT_INTERVAL;
+        if (height > 0 && height % CFCHECKPT_INTERVAL == 0 &&
+            checkpoint <= m_checkpoints.size() &&
+            m_checkpoints[checkpoint - 1].first ==
+                block_index->GetBlockHash()) {
+            header_out = m_checkpoints[checkpoint - 1].second;
             return true;
         }
     }
@@ -437,27 +645,49 @@ bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex *block_index,
         return false;
     }
 
-    if (is_checkpoint && m_headers_cache.size() < CF_HEADERS_CACHE_MAX_SZ) {
-        // Add to the headers cache if this is a checkpoint height.
-        m_headers_cache.emplace(block_index->GetBlockHash(), entry.header);
+    header_out = entry.header;
+    return true;
+}
+
+bool BlockFilterIndex::LookupPositionRange(
+    int start_height, const CBlockIndex *stop_index,
+    std::vector<FlatFilePos> &positions_out) const {
+    positions_out.clear();
+    {
+        LOCK(m_cache_mutex);
+        if (IsRangeCached(start_height, stop_index)) {
+            positions_out.reserve(stop_index->nHeight - start_height + 1);
+            for (int height = start_height; height <= stop_index->nHeight;
+                 ++height) {
+                positions_out.push_back(m_cache[height - m_cache_start].pos);
+            }
+            return true;
+        }
     }
 
-    header_out = entry.header;
+    std::vector<DBVal> entries;
+    if (!LookupRange(*m_db, m_name, start_height, stop_index, entries)) {
+        return false;
+    }
+    positions_out.reserve(entries.size());
+    for (const auto &entry : entries) {
+        positions_out.push_back(entry.pos);
+    }
     return true;
 }
 
 bool BlockFilterIndex::LookupFilterRange(
     int start_height, const CBlockIndex *stop_index,
     std::vector<BlockFilter> &filters_out) const {
-    std::vector<DBVal> entries;
-    if (!LookupRange(*m_db, m_name, start_height, stop_index, entries)) {
+    std::vector<FlatFilePos> positions;
+    if (!LookupPositionRange(start_height, stop_index, positions)) {
         return false;
     }
 
-    filters_out.resize(entries.size());
+    filters_out.resize(positions.size());
     auto filter_pos_it = filters_out.begin();
-    for (const auto &entry : entries) {
-        if (!ReadFilterFromDisk(entry.pos, *filter_pos_it)) {
+    for (const auto &pos : positions) {
+        if (!ReadFilterFromDisk(pos, *filter_pos_it)) {
             return false;
         }
         ++filter_pos_it;
@@ -466,17 +696,67 @@ bool BlockFilterIndex::LookupFilterRange(
     return true;
 }
 
+bool BlockFilterIndex::LookupRawFilterRange(
+    int start_height, const CBlockIndex *stop_index,
+    std::vector<std::vector<uint8_t>> &raw_filters_out) const {
+    std::vector<FlatFilePos> positions;
+    raw_filters_out.clear();
+    {
+        LOCK(m_cache_mutex);
+        if (IsRangeCached(start_height, stop_index)) {
+            const size_t count = stop_index->nHeight - start_height + 1;
+            positions.reserve(count);
+            raw_filters_out.reserve(count);
+            for (int height = start_height; height <= stop_index->nHeight;
+                 ++height) {
+                const CachedEntry &cached = m_cache[height - m_cache_start];
+                positions.push_back(cached.pos);
+                raw_filters_out.push_back(cached.raw_filter);
+            }
+        }
+    }
+    if (positions.empty()) {
+        if (!LookupPositionRange(start_height, stop_index, positions)) {
+            return false;
+        }
+        raw_filters_out.resize(positions.size());
+    }
+
+    // Read the filters that are not cached anymore
+    for (size_t i = 0; i < positions.size(); ++i) {
+        if (raw_filters_out[i].empty() &&
+            !ReadRawFilterFromDisk(positions[i], raw_filters_out[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool BlockFilterIndex::LookupFilterHashRange(
     int start_height, const CBlockIndex *stop_index,
     std::vector<uint256> &hashes_out) const
 
 {
+    hashes_out.clear();
+    {
+        LOCK(m_cache_mutex);
+        if (IsRangeCached(start_height, stop_index)) {
+            hashes_out.reserve(stop_index->nHeight - start_height + 1);
+            for (int height = start_height; height <= stop_index->nHeight;
+                 ++height) {
+                hashes_out.push_back(
+                    m_cache[height - m_cache_start].filter_hash);
+            }
+            return true;
+        }
+    }
+
     std::vector<DBVal> entries;
     if (!LookupRange(*m_db, m_name, start_height, stop_index, entries)) {
         return false;
     }
 
-    hashes_out.clear();
     hashes_out.reserve(entries.size());
     for (const auto &entry : entries) {
         hashes_out.push_back(entry.hash);
@@ -484,6 +764,35 @@ bool BlockFilterIndex::LookupFilterHashRange(
     return true;
 }
 
+bool BlockFilterIndex::LookupCheckpoints(
+    const CBlockIndex *stop_index,
+    std::shared_ptr<const std::vector<uint8_t>> &checkpoints_out) const {
+    const size_t count = stop_index->nHeight / CFCHECKPT_INTERVAL;
+    {
+        LOCK(m_cache_mutex);
+        // The checkpoints of the chain of the index are ready to be sent
+        if (m_checkpoints.size() == count &&
+            (count == 0 ||
+             stop_index->GetAncestor(count * CFCHECKPT_INTERVAL)
+                     ->GetBlockHash() == m_checkpoints.back().first)) {
+            checkpoints_out = m_serialized_checkpoints;
+            return true;
+        }
+    }
+
+    std::vector<std::pair<BlockHash, uint256>> checkpoints(count);
+    const CBlockIndex *block_index = stop_index;
+    for (int i = count - 1; i >= 0; i--) {
+        block_index = block_index->GetAncestor((i + 1) * CFCHECKPT_INTERVAL);
+        checkpoints[i].first = block_index->GetBlockHash();
+        if (!LookupFilterHeader(block_index, checkpoints[i].second)) {
+            return false;
+        }
+    }
+    checkpoints_out = SerializeCheckpoints(checkpoints);
+    return true;
+}
+
 BlockFilterIndex *GetBlockFilterIndex(BlockFilterType filter_type) {
     auto it = g_filter_indexes.find(filter_type);
     return it != g_filter_indexes.end() ? &it->second : nullptr;
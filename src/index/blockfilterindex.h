@@ -9,13 +9,26 @@
 #include <chain.h>
 #include <flatfile.h>
 #include <index/base.h>
-#include <util/hasher.h>
+#include <sync.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
 
 static const char *const DEFAULT_BLOCKFILTERINDEX = "0";
 
 /** Interval between compact filter checkpoints. See BIP 157. */
 static constexpr int CFCHECKPT_INTERVAL = 1000;
 
+/**
+ * Default number of the most recent blocks of the index whose filter hashes
+ * and headers are kept in memory.
+ */
+static constexpr int DEFAULT_BLOCKFILTER_CACHE = 50000;
+
+/** Number of the most recent blocks whose encoded filters are also cached */
+static constexpr int BLOCKFILTER_RAW_CACHE = 2000;
+
 /**
  * BlockFilterIndex is used to store and retrieve block filters, hashes, and
  * headers for a range of blocks by height. An index is constructed for each
@@ -26,6 +39,8 @@ static constexpr int CFCHECKPT_INTERVAL = 1000;
  */
 class BlockFilterIndex final : public BaseIndex {
 private:
+    struct PreparedFilter;
+
     BlockFilterType m_filter_type;
     std::string m_name;
     std::unique_ptr<BaseIndex::DB> m_db;
@@ -34,15 +49,68 @@ private:
     std::unique_ptr<FlatFileSeq> m_filter_fileseq;
 
     bool ReadFilterFromDisk(const FlatFilePos &pos, BlockFilter &filter) const;
-    size_t WriteFilterToDisk(FlatFilePos &pos, const BlockFilter &filter);
+    bool ReadRawFilterFromDisk(const FlatFilePos &pos,
+                               std::vector<uint8_t> &raw_filter) const;
+    size_t WriteFilterToDisk(FlatFilePos &pos,
+                             const std::vector<uint8_t> &raw_filter);
 
-    Mutex m_cs_headers_cache;
     /**
-     * Cache of block hash to filter header, to avoid disk access when
-     * responding to getcfcheckpt.
+     * Hash and filter header of the last block written, so the header of the
+     * next block does not have to be read back from the database.
      */
-    std::unordered_map<BlockHash, uint256, FilterHeaderHasher>
-        m_headers_cache GUARDED_BY(m_cs_headers_cache);
+    BlockHash m_last_block_hash;
+    uint256 m_last_header;
+
+    /** The index entry of a block of the chain of the index */
+    struct CachedEntry {
+        BlockHash block_hash;
+        uint256 filter_hash;
+        uint256 header;
+        FlatFilePos pos;
+        //! The filter as stored on disk, only for the most recent blocks
+        std::vector<uint8_t> raw_filter;
+    };
+
+    const size_t m_cache_size;
+
+    mutable Mutex m_cache_mutex;
+    /**
+     * Entries of the most recent blocks of the chain of the index, from
+     * height m_cache_start. Ranges of filter hashes and headers requested by
+     * light clients are served from there without database reads.
+     */
+    std::deque<CachedEntry> m_cache GUARDED_BY(m_cache_mutex);
+    int m_cache_start GUARDED_BY(m_cache_mutex){0};
+    /**
+     * Block hash and filter header of each checkpoint height of the chain of
+     * the index, and the headers serialized as in a cfcheckpt message.
+     */
+    std::vector<std::pair<BlockHash, uint256>>
+        m_checkpoints GUARDED_BY(m_cache_mutex);
+    std::shared_ptr<const std::vector<uint8_t>>
+        m_serialized_checkpoints GUARDED_BY(m_cache_mutex);
+
+    /** Load the entries of the chain of the index into the cache */
+    bool LoadCache() EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
+
+    /** Add an entry at the tip of the cache, dropping those above it */
+    void AddCachedEntry(const CBlockIndex *pindex, CachedEntry entry)
+        EXCLUSIVE_LOCKS_REQUIRED(m_cache_mutex);
+
+    /** Drop the cached entries above a height */
+    void TruncateCache(int height) EXCLUSIVE_LOCKS_REQUIRED(m_cache_mutex);
+
+    const CachedEntry *FindCachedEntry(const CBlockIndex *block_index) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_cache_mutex);
+
+    /** Whether the cache holds the entries of all the blocks of a range */
+    bool IsRangeCached(int start_height, const CBlockIndex *stop_index) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_cache_mutex);
+
+    /** Get the filter positions of a range of blocks */
+    bool LookupPositionRange(int start_height, const CBlockIndex *stop_index,
+                             std::vector<FlatFilePos> &positions_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
 
     bool AllowPrune() const override { return true; }
 
@@ -51,7 +119,12 @@ protected:
 
     bool CommitInternal(CDBBatch &batch) override;
 
-    bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override;
+    std::unique_ptr<PreparedBlock>
+    PrepareBlock(std::shared_ptr<const CBlock> block,
+                 const CBlockIndex *pindex) const override;
+
+    bool WritePreparedBlock(PreparedBlock &prepared, const CBlockIndex *pindex,
+                            CDBBatch &batch) override;
 
     bool Rewind(const CBlockIndex *current_tip,
                 const CBlockIndex *new_tip) override;
@@ -72,16 +145,39 @@ public:
                       BlockFilter &filter_out) const;
 
     /** Get a single filter header by block. */
-    bool LookupFilterHeader(const CBlockIndex *block_index, uint256 &header_out)
-        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_headers_cache);
+    bool LookupFilterHeader(const CBlockIndex *block_index,
+                            uint256 &header_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
 
     /** Get a range of filters between two heights on a chain. */
     bool LookupFilterRange(int start_height, const CBlockIndex *stop_index,
-                           std::vector<BlockFilter> &filters_out) const;
+                           std::vector<BlockFilter> &filters_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
+
+    /**
+     * Get a range of filters between two heights on a chain, each serialized
+     * as the block hash followed by the encoded filter. The filters are not
+     * decoded, so they can be relayed as is.
+     */
+    bool
+    LookupRawFilterRange(int start_height, const CBlockIndex *stop_index,
+                         std::vector<std::vector<uint8_t>> &raw_filters_out)
+        const EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
 
     /** Get a range of filter hashes between two heights on a chain. */
     bool LookupFilterHashRange(int start_height, const CBlockIndex *stop_index,
-                               std::vector<uint256> &hashes_out) const;
+                               std::vector<uint256> &hashes_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
+
+    /**
+     * Get the filter headers of every CFCHECKPT_INTERVAL blocks up to a
+     * block, serialized as a vector. They are pre-serialized for the chain of
+     * the index.
+     */
+    bool LookupCheckpoints(const CBlockIndex *stop_index,
+                           std::shared_ptr<const std::vector<uint8_t>>
+                               &checkpoints_out) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cache_mutex);
 };
 
 /**
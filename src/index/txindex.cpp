@@ -25,8 +25,14 @@ public:
     /// Returns false if the transaction ID is not indexed.
     bool ReadTxPos(const TxId &txid, CDiskTxPos &pos) const;
 
-    /// Write a batch of transaction positions to the DB.
-    bool WriteTxs(const std::vector<std::pair<TxId, CDiskTxPos>> &v_pos);
+    /// Add the transaction positions to a batch of writes to the DB.
+    void WriteTxs(CDBBatch &batch,
+                  const std::vector<std::pair<TxId, CDiskTxPos>> &v_pos);
+};
+
+/** The positions of the transactions of a block */
+struct TxIndex::PreparedTxs : public BaseIndex::PreparedBlock {
+    std::vector<std::pair<TxId, CDiskTxPos>> positions;
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe)
@@ -37,13 +43,11 @@ bool TxIndex::DB::ReadTxPos(const TxId &txid, CDiskTxPos &pos) const {
     return Read(std::make_pair(DB_TXINDEX, txid), pos);
 }
 
-bool TxIndex::DB::WriteTxs(
-    const std::vector<std::pair<TxId, CDiskTxPos>> &v_pos) {
-    CDBBatch batch(*this);
+void TxIndex::DB::WriteTxs(
+    CDBBatch &batch, const std::vector<std::pair<TxId, CDiskTxPos>> &v_pos) {
     for (const auto &tuple : v_pos) {
         batch.Write(std::make_pair(DB_TXINDEX, tuple.first), tuple.second);
     }
-    return WriteBatch(batch);
 }
 
 TxIndex::TxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
@@ -51,21 +55,30 @@ TxIndex::TxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
 
 TxIndex::~TxIndex() {}
 
-bool TxIndex::WriteBlock(const CBlock &block, const CBlockIndex *pindex) {
+std::unique_ptr<BaseIndex::PreparedBlock>
+TxIndex::PrepareBlock(std::shared_ptr<const CBlock> block,
+                      const CBlockIndex *pindex) const {
+    auto prepared = std::make_unique<PreparedTxs>();
     // Exclude genesis block transaction because outputs are not spendable.
     if (pindex->nHeight == 0) {
-        return true;
+        return prepared;
     }
 
     CDiskTxPos pos(WITH_LOCK(::cs_main, return pindex->GetBlockPos()),
-                   GetSizeOfCompactSize(block.vtx.size()));
-    std::vector<std::pair<TxId, CDiskTxPos>> vPos;
-    vPos.reserve(block.vtx.size());
-    for (const auto &tx : block.vtx) {
+                   GetSizeOfCompactSize(block->vtx.size()));
+    std::vector<std::pair<TxId, CDiskTxPos>> &vPos = prepared->positions;
+    vPos.reserve(block->vtx.size());
+    for (const auto &tx : block->vtx) {
         vPos.emplace_back(tx->GetId(), pos);
         pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
     }
-    return m_db->WriteTxs(vPos);
+    return prepared;
+}
+
+bool TxIndex::WritePreparedBlock(PreparedBlock &prepared,
+                                 const CBlockIndex *pindex, CDBBatch &batch) {
+    m_db->WriteTxs(batch, static_cast<PreparedTxs &>(prepared).positions);
+    return true;
 }
 
 BaseIndex::DB &TxIndex::GetDB() const {
@@ -79,20 +92,10 @@ bool TxIndex::FindTx(const TxId &txid, BlockHash &block_hash,
         return false;
     }
 
-    CAutoFile file(m_chainstate->m_blockman.OpenBlockFile(postx, true),
-                   SER_DISK, CLIENT_VERSION);
-    if (file.IsNull()) {
-        return error("%s: OpenBlockFile failed", __func__);
-    }
     CBlockHeader header;
-    try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
-        }
-        file >> tx;
-    } catch (const std::exception &e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    if (!m_chainstate->m_blockman.ReadTxFromDisk(header, tx, postx,
+                                                 postx.nTxOffset)) {
+        return false;
     }
     if (tx->GetId() != txid) {
         return error("%s: txid mismatch", __func__);
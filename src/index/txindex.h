@@ -24,12 +24,19 @@ protected:
     class DB;
 
 private:
+    struct PreparedTxs;
+
     const std::unique_ptr<DB> m_db;
 
     bool AllowPrune() const override { return false; }
 
 protected:
-    bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override;
+    std::unique_ptr<PreparedBlock>
+    PrepareBlock(std::shared_ptr<const CBlock> block,
+                 const CBlockIndex *pindex) const override;
+
+    bool WritePreparedBlock(PreparedBlock &prepared, const CBlockIndex *pindex,
+                            CDBBatch &batch) override;
 
     BaseIndex::DB &GetDB() const override;
 
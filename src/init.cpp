@@ -9,6 +9,7 @@
 
 #include <init.h>
 
+#include <kernel/mempool_journal.h>
 #include <kernel/mempool_persist.h>
 #include <kernel/validation_cache_sizes.h>
 
@@ -31,6 +32,7 @@
 #include <hash.h>
 #include <httprpc.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
 #include <index/txindex.h>
@@ -95,6 +97,7 @@
 #if ENABLE_ZMQ
 #include <zmq/zmqabstractnotifier.h>
 #include <zmq/zmqnotificationinterface.h>
+#include <zmq/zmqpublishnotifier.h>
 #include <zmq/zmqrpc.h>
 #endif
 
@@ -114,20 +117,25 @@
 #include <thread>
 #include <vector>
 
+using kernel::DEFAULT_BLOCKCOMPRESSION;
 using kernel::DEFAULT_STOPAFTERBLOCKIMPORT;
 using kernel::DumpMempool;
+using kernel::MempoolJournal;
+using kernel::MempoolJournalPath;
 using kernel::ValidationCacheSizes;
 
 using node::ApplyArgsManOptions;
 using node::BlockManager;
 using node::CacheSizes;
 using node::CalculateCacheSizes;
+using node::DEFAULT_MEMPOOL_JOURNAL;
 using node::DEFAULT_PERSIST_MEMPOOL;
 using node::fReindex;
 using node::KernelNotifications;
 using node::LoadChainstate;
 using node::MempoolPath;
 using node::NodeContext;
+using node::ShouldJournalMempool;
 using node::ShouldPersistMempool;
 using node::ThreadImport;
 using node::VerifyLoadedChainstate;
@@ -220,6 +228,9 @@ void Interrupt(NodeContext &node) {
     if (g_coin_stats_index) {
         g_coin_stats_index->Interrupt();
     }
+    if (g_address_index) {
+        g_address_index->Interrupt();
+    }
 }
 
 void Shutdown(NodeContext &node) {
@@ -278,8 +289,13 @@ void Shutdown(NodeContext &node) {
     if (node.chainman && node.chainman->m_load_block.joinable()) {
         node.chainman->m_load_block.join();
     }
+    if (node.chainman) {
+        node.chainman->m_blockman.StopBlockFileCompression();
+        node.chainman->m_blockman.StopBlockWriter();
+    }
     StopScriptCheckWorkerThreads();
     StopPowCheckWorkerThreads();
+    StopCoinPrefetchWorkerThreads();
 
     // After the threads that potentially access these pointers have been
     // stopped, destruct and reset all to nullptr.
@@ -311,6 +327,11 @@ void Shutdown(NodeContext &node) {
     // generate CValidationInterface callbacks, flush them...
     GetMainSignals().FlushBackgroundCallbacks();
 
+    if (node.mempool_journal) {
+        UnregisterValidationInterface(node.mempool_journal.get());
+        node.mempool_journal.reset();
+    }
+
 #if ENABLE_CHRONIK
     if (node.args->GetBoolArg("-chronik", DEFAULT_CHRONIK)) {
         chronik::Stop();
@@ -326,6 +347,10 @@ void Shutdown(NodeContext &node) {
         g_coin_stats_index->Stop();
         g_coin_stats_index.reset();
     }
+    if (g_address_index) {
+        g_address_index->Stop();
+        g_address_index.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex &index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
@@ -498,6 +523,18 @@ void SetupServerArgs(NodeContext &node) {
             defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(),
             testnetChainParams->GetConsensus().defaultAssumeValid.GetHex()),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+#ifdef ENABLE_ZSTD
+    argsman.AddArg(
+        "-blockcompression",
+        strprintf("Compress the block files that are no longer written to, in "
+                  "the background. Compressed block files can't be read by "
+                  "builds without block file compression support (default: "
+                  "%u)",
+                  DEFAULT_BLOCKCOMPRESSION),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+#else
+    hidden_args.emplace_back("-blockcompression");
+#endif
     argsman.AddArg("-blocksdir=<dir>",
                    "Specify directory to hold blocks subdirectory for *.dat "
                    "files (default: <datadir>)",
@@ -527,6 +564,13 @@ void SetupServerArgs(NodeContext &node) {
                   " not affected. (default: %u)",
                   DEFAULT_BLOCKSONLY),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-addressindex",
+                   strprintf("Maintain an index of the transactions and the "
+                             "unspent outputs of each address, used by the "
+                             "getaddresshistory and getaddressutxos RPCs "
+                             "(default: %u)",
+                             DEFAULT_ADDRESSINDEX),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-coinstatsindex",
                    strprintf("Maintain coinstats index used by the "
                              "gettxoutsetinfo RPC (default: %u)",
@@ -551,6 +595,13 @@ void SetupServerArgs(NodeContext &node) {
         strprintf("Set database cache size in MiB (%d to %d, default: %d)",
                   MIN_DB_CACHE_MB, MAX_DB_CACHE_MB, DEFAULT_DB_CACHE_MB),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-incrementalcoinsflush",
+        strprintf("Write the coins cache to disk in the background when it "
+                  "gets full and only evict the oldest coins from it, instead "
+                  "of writing and emptying it at once (default: %u)",
+                  DEFAULT_INCREMENTAL_COINS_FLUSH),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-includeconf=<file>",
         "Specify additional configuration file, relative to the -datadir path "
@@ -583,6 +634,13 @@ void SetupServerArgs(NodeContext &node) {
             testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()),
         ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
         OptionsCategory::OPTIONS);
+    argsman.AddArg("-mempooljournal",
+                   strprintf("Whether to log the mempool changes to disk as "
+                             "they happen, so the mempool is restored after an "
+                             "unclean shutdown. Requires -persistmempool "
+                             "(default: %u)",
+                             DEFAULT_MEMPOOL_JOURNAL),
+                   ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-par=<n>",
         strprintf("Set the number of script verification threads (%u to %d, 0 "
@@ -615,12 +673,12 @@ void SetupServerArgs(NodeContext &node) {
                   "of old blocks. This allows the pruneblockchain RPC to be "
                   "called to delete specific blocks, and enables automatic "
                   "pruning of old blocks if a target size in MiB is provided. "
-                  "This mode is incompatible with -txindex, -coinstatsindex "
-                  "and -rescan. Warning: Reverting this setting requires "
-                  "re-downloading the entire blockchain. (default: 0 = disable "
-                  "pruning blocks, 1 = allow manual pruning via RPC, >=%u = "
-                  "automatically prune block files to stay under the specified "
-                  "target size in MiB)",
+                  "This mode is incompatible with -txindex, -coinstatsindex, "
+                  "-addressindex and -rescan. Warning: Reverting this setting "
+                  "requires re-downloading the entire blockchain. (default: "
+                  "0 = disable pruning blocks, 1 = allow manual pruning via "
+                  "RPC, >=%u = automatically prune block files to stay under "
+                  "the specified target size in MiB)",
                   MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
@@ -758,6 +816,19 @@ void SetupServerArgs(NodeContext &node) {
             " If <type> is not supplied or if <type> = 1, indexes for "
             "all known types are enabled.",
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-blockfiltercache=<n>",
+        strprintf("Number of the most recent blocks whose compact filter "
+                  "hashes and headers are kept in memory to serve BIP 157 "
+                  "requests (default: %u)",
+                  DEFAULT_BLOCKFILTER_CACHE),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-indexsyncthreads=<n>",
+        strprintf("Number of threads reading and preparing blocks while an "
+                  "index is being built (%d to %d, default: %d)",
+                  1, MAX_INDEX_SYNC_THREADS, DEFAULT_INDEX_SYNC_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-usecashaddr",
         "Use Cash Address for destination encoding instead of base58 "
@@ -1034,6 +1105,10 @@ void SetupServerArgs(NodeContext &node) {
     argsman.AddArg("-zmqpubrawtx=<address>",
                    "Enable publish raw transaction in <address>",
                    ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawtxbatch=<address>",
+                   "Enable publish batches of raw transactions in <address>, "
+                   "as multipart messages holding one transaction per part",
+                   ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequence=<address>",
                    "Enable publish hash block and tx sequence in <address>",
                    ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
@@ -1061,6 +1136,25 @@ void SetupServerArgs(NodeContext &node) {
                   "water mark (default: %d)",
                   CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM),
         ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg(
+        "-zmqpubrawtxbatchhwm=<n>",
+        strprintf("Set publish raw transaction batch outbound message high "
+                  "water mark (default: %d)",
+                  CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM),
+        ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg(
+        "-zmqpubrawtxbatchsize=<n>",
+        strprintf("Maximum number of transactions in a raw transaction batch "
+                  "(default: %u)",
+                  CZMQPublishRawTransactionBatchNotifier::DEFAULT_BATCH_SIZE),
+        ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg(
+        "-zmqpubrawtxbatchdelay=<n>",
+        strprintf("Maximum time in milliseconds a transaction waits for its "
+                  "raw transaction batch to be published (default: %d)",
+                  CZMQPublishRawTransactionBatchNotifier::DEFAULT_MAX_DELAY
+                      .count()),
+        ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequencehwm=<n>",
                    strprintf("Set publish hash sequence message high water mark"
                              " (default: %d)",
@@ -1071,11 +1165,15 @@ void SetupServerArgs(NodeContext &node) {
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
+    hidden_args.emplace_back("-zmqpubrawtxbatch=<address>");
     hidden_args.emplace_back("-zmqpubsequence=<n>");
     hidden_args.emplace_back("-zmqpubhashblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawtxbatchhwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawtxbatchsize=<n>");
+    hidden_args.emplace_back("-zmqpubrawtxbatchdelay=<n>");
     hidden_args.emplace_back("-zmqpubsequencehwm=<n>");
 #endif
 
@@ -1269,6 +1367,12 @@ void SetupServerArgs(NodeContext &node) {
                    strprintf("Accept public REST requests (default: %d)",
                              DEFAULT_REST_ENABLE),
                    ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg(
+        "-restthreads=<n>",
+        strprintf(
+            "Set the number of threads to service REST requests (default: %d)",
+            DEFAULT_HTTP_REST_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg(
         "-rpcbind=<addr>[:port]",
         "Bind to given address to listen for JSON-RPC connections. Do not "
@@ -1343,14 +1447,30 @@ void SetupServerArgs(NodeContext &node) {
             "Set the number of threads to service RPC calls (default: %d)",
             DEFAULT_HTTP_THREADS),
         ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg(
+        "-rpcheavythreads=<n>",
+        strprintf("Set the number of threads to service the RPC calls that "
+                  "may take long, like getblock or scantxoutset, separately "
+                  "from the other calls (default: %d)",
+                  DEFAULT_HTTP_HEAVY_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg(
+        "-rpcbatchparallelism=<n>",
+        strprintf("Set the maximum number of requests of a JSON-RPC batch "
+                  "that are executed at the same time, on other RPC threads. "
+                  "With a value above 1 the requests of a batch are no longer "
+                  "executed in order, so a batch must not contain requests "
+                  "that depend on each other (default: %d)",
+                  DEFAULT_RPC_BATCH_PARALLELISM),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg(
         "-rpccorsdomain=value",
         "Domain from which to accept cross origin requests (browser enforced)",
         ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
 
     argsman.AddArg("-rpcworkqueue=<n>",
-                   strprintf("Set the depth of the work queue to service RPC "
-                             "calls (default: %d)",
+                   strprintf("Set the depth of the work queues to service RPC "
+                             "calls and REST requests (default: %d)",
                              DEFAULT_HTTP_WORKQUEUE),
                    ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY,
                    OptionsCategory::RPC);
@@ -1829,11 +1949,16 @@ bool AppInitParameterInteraction(Config &config, const ArgsManager &args) {
         nLocalServices = ServiceFlags(nLocalServices | NODE_COMPACT_FILTERS);
     }
 
-    // if using block pruning, then disallow txindex, coinstatsindex and chronik
+    // if using block pruning, then disallow txindex, coinstatsindex,
+    // addressindex and chronik
     if (args.GetIntArg("-prune", 0)) {
         if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
             return InitError(_("Prune mode is incompatible with -txindex."));
         }
+        if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+            return InitError(
+                _("Prune mode is incompatible with -addressindex."));
+        }
         if (args.GetBoolArg("-coinstatsindex", DEFAULT_COINSTATSINDEX)) {
             return InitError(
                 _("Prune mode is incompatible with -coinstatsindex."));
@@ -2175,6 +2300,7 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
     if (script_threads >= 1) {
         StartScriptCheckWorkerThreads(script_threads);
         StartPowCheckWorkerThreads(script_threads);
+        StartCoinPrefetchWorkerThreads(script_threads);
     }
 
     assert(!node.scheduler);
@@ -2453,6 +2579,10 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         LogPrintf("* Using %.1f MiB for transaction index database\n",
                   cache_sizes.tx_index * (1.0 / 1024 / 1024));
     }
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        LogPrintf("* Using %.1f MiB for address index database\n",
+                  cache_sizes.address_index * (1.0 / 1024 / 1024));
+    }
     for (BlockFilterType filter_type : g_enabled_filter_types) {
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   cache_sizes.filter_index * (1.0 / 1024 / 1024),
@@ -2653,6 +2783,14 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         }
     }
 
+    if (args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)) {
+        g_address_index = std::make_unique<AddressIndex>(
+            cache_sizes.address_index, false, fReindex);
+        if (!g_address_index->Start(chainman.ActiveChainstate())) {
+            return false;
+        }
+    }
+
 #if ENABLE_CHRONIK
     if (args.GetBoolArg("-chronik", DEFAULT_CHRONIK)) {
         const bool fReindexChronik =
@@ -2736,14 +2874,36 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         vImportFiles.push_back(fs::PathFromString(strFile));
     }
 
+    if (ShouldJournalMempool(args)) {
+        // Track the transactions added while the mempool is loaded, the
+        // journal itself is only written once loading is done.
+        const CBlockIndex *tip{WITH_LOCK(cs_main, return chainman.ActiveTip())};
+        node.mempool_journal = std::make_unique<MempoolJournal>(
+            *node.mempool, MempoolJournalPath(MempoolPath(args)),
+            tip ? tip->GetBlockHash() : BlockHash{});
+        RegisterValidationInterface(node.mempool_journal.get());
+    } else if (ShouldPersistMempool(args)) {
+        // A journal left over from a previous run would be out of date.
+        std::error_code error_code;
+        fs::remove(MempoolJournalPath(MempoolPath(args)), error_code);
+    }
+
     avalanche::Processor *const avalanche = node.avalanche.get();
-    chainman.m_load_block =
-        std::thread(&util::TraceThread, "loadblk", [=, &chainman, &args] {
+    MempoolJournal *const mempool_journal = node.mempool_journal.get();
+    chainman.m_load_block = std::thread(
+        &util::TraceThread, "loadblk", [=, &chainman, &args] {
             ThreadImport(chainman, avalanche, vImportFiles,
                          ShouldPersistMempool(args) ? MempoolPath(args)
                                                     : fs::path{});
+            if (mempool_journal && !ShutdownRequested()) {
+                SyncWithValidationInterfaceQueue();
+                mempool_journal->Open();
+            }
         });
 
+    chainman.m_blockman.StartBlockWriter();
+    chainman.m_blockman.StartBlockFileCompression();
+
     // Wait for genesis block to be processed
     {
         WAIT_LOCK(g_genesis_wait_mutex, lock);
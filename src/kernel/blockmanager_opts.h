@@ -14,6 +14,7 @@ class CChainParams;
 namespace kernel {
 
 static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
+static constexpr bool DEFAULT_BLOCKCOMPRESSION{false};
 
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
@@ -24,6 +25,7 @@ struct BlockManagerOpts {
     uint64_t prune_target{0};
     bool fast_prune{false};
     bool stop_after_block_import{DEFAULT_STOPAFTERBLOCKIMPORT};
+    bool compress_block_files{DEFAULT_BLOCKCOMPRESSION};
     const fs::path blocks_dir;
 };
 
@@ -22,6 +22,7 @@ class Config;
 static constexpr bool DEFAULT_CHECKPOINTS_ENABLED{true};
 static constexpr auto DEFAULT_MAX_TIP_AGE{24h};
 static constexpr bool DEFAULT_STORE_RECENT_HEADERS_TIME{false};
+static constexpr bool DEFAULT_INCREMENTAL_COINS_FLUSH{false};
 
 namespace kernel {
 
@@ -49,6 +50,9 @@ struct ChainstateManagerOpts {
     DBOptions block_tree_db{};
     DBOptions coins_db{};
     CoinsViewOptions coins_view{};
+    //! Write the coins cache in the background and evict its oldest coins
+    //! rather than writing and emptying it at once.
+    bool incremental_coins_flush{DEFAULT_INCREMENTAL_COINS_FLUSH};
     Notifications &notifications;
 
     //! If set, store and load the last few block headers reception time to
@@ -10,10 +10,23 @@
 #include <logging.h>
 #include <primitives/txid.h>
 #include <serialize.h>
+#include <sync.h>
+#include <tinyformat.h>
 #include <util/check.h>
+#include <util/threadnames.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace kernel {
 CCoinsStats::CCoinsStats(int block_height, const BlockHash &block_hash)
@@ -45,8 +58,9 @@ CDataStream TxOutSer(const COutPoint &outpoint, const Coin &coin) {
 //! It is also possible, though very unlikely, that a change in this
 //! construction could cause a previously invalid (and potentially malicious)
 //! UTXO snapshot to be considered valid.
-static void ApplyHash(HashWriter &ss, const TxId &txid,
-                      const std::map<uint32_t, Coin> &outputs) {
+template <typename Stream>
+static void SerializeOutputs(Stream &ss, const TxId &txid,
+                             const std::map<uint32_t, Coin> &outputs) {
     for (auto it = outputs.begin(); it != outputs.end(); ++it) {
         if (it == outputs.begin()) {
             ss << txid;
@@ -64,8 +78,10 @@ static void ApplyHash(HashWriter &ss, const TxId &txid,
     }
 }
 
-static void ApplyHash(std::nullptr_t, const TxId &txid,
-                      const std::map<uint32_t, Coin> &outputs) {}
+static void ApplyHash(HashWriter &ss, const TxId &txid,
+                      const std::map<uint32_t, Coin> &outputs) {
+    SerializeOutputs(ss, txid, outputs);
+}
 
 static void ApplyHash(MuHash3072 &muhash, const TxId &txid,
                       const std::map<uint32_t, Coin> &outputs) {
@@ -87,39 +103,192 @@ static void ApplyStats(CCoinsStats &stats, const TxId &txid,
     }
 }
 
-//! Calculate statistics about the unspent transaction output set
-template <typename T>
-static bool ComputeUTXOStats(CCoinsView *view, CCoinsStats &stats, T hash_obj,
-                             const std::function<void()> &interruption_point) {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
+namespace {
+//! Maximum number of threads computing the statistics
+constexpr unsigned int MAX_COINSTATS_THREADS{8};
+//! The UTXO set is split into more ranges than threads, so the work stays
+//! balanced when some ranges hold more coins than others.
+constexpr size_t RANGES_PER_THREAD{4};
+//! Size of the chunks of serialized outputs handed over for hashing
+constexpr size_t SERIALIZED_CHUNK_SIZE{1 << 20};
+//! Number of chunks a range can get ahead of the hashing
+constexpr size_t MAX_QUEUED_CHUNKS{8};
 
-    PrepareHash(hash_obj, stats);
+//! Statistics about a range of the UTXO set, computed by a worker thread.
+struct CoinsRange {
+    std::unique_ptr<CCoinsViewCursor> cursor;
+    CCoinsStats stats;
+    MuHash3072 muhash;
+    //! The HASH_SERIALIZED hash has to be computed over the ranges in order,
+    //! so the worker only serializes the outputs. The fields below are
+    //! guarded by CoinsRanges::mutex.
+    std::deque<CDataStream> chunks;
+    bool done{false};
+    bool ok{true};
+};
+
+struct CoinsRanges {
+    std::vector<CoinsRange> ranges;
+    std::atomic<size_t> next_range{0};
+    Mutex mutex;
+    std::condition_variable cv;
+    //! Set under the mutex, so the waiting threads don't miss it
+    std::atomic<bool> interrupted{false};
+};
+} // namespace
+
+template <typename T>
+static bool ComputeRangeStats(CoinsRanges &shared, CoinsRange &range) {
+    CDataStream chunk(SER_DISK, PROTOCOL_VERSION);
+    const auto push_chunk = [&]() -> bool {
+        WAIT_LOCK(shared.mutex, lock);
+        shared.cv.wait(lock, [&]() {
+            return range.chunks.size() < MAX_QUEUED_CHUNKS ||
+                   shared.interrupted;
+        });
+        range.chunks.push_back(std::move(chunk));
+        chunk = CDataStream(SER_DISK, PROTOCOL_VERSION);
+        shared.cv.notify_all();
+        return !shared.interrupted;
+    };
 
+    CCoinsViewCursor &cursor = *range.cursor;
     TxId prevkey;
     std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
-        interruption_point();
+    const auto apply = [&]() -> bool {
+        ApplyStats(range.stats, prevkey, outputs);
+        if constexpr (std::is_same_v<T, HashWriter>) {
+            SerializeOutputs(chunk, prevkey, outputs);
+            if (chunk.size() >= SERIALIZED_CHUNK_SIZE && !push_chunk()) {
+                return false;
+            }
+        } else if constexpr (std::is_same_v<T, MuHash3072>) {
+            ApplyHash(range.muhash, prevkey, outputs);
+        }
+        outputs.clear();
+        return true;
+    };
+    while (cursor.Valid()) {
+        if (shared.interrupted) {
+            return false;
+        }
         COutPoint key;
         Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            if (!outputs.empty() && key.GetTxId() != prevkey) {
-                ApplyStats(stats, prevkey, outputs);
-                ApplyHash(hash_obj, prevkey, outputs);
-                outputs.clear();
+        if (cursor.GetKey(key) && cursor.GetValue(coin)) {
+            if (!outputs.empty() && key.GetTxId() != prevkey && !apply()) {
+                return false;
             }
             prevkey = key.GetTxId();
             outputs[key.GetN()] = std::move(coin);
-            stats.coins_count++;
+            range.stats.coins_count++;
         } else {
             return error("%s: unable to read value", __func__);
         }
-        pcursor->Next();
+        cursor.Next();
+    }
+    if (!outputs.empty() && !apply()) {
+        return false;
+    }
+    if (!chunk.empty()) {
+        return push_chunk();
+    }
+    return true;
+}
+
+//! Calculate statistics about the unspent transaction output set
+//!
+//! The UTXO set is split into ranges that are read on several threads, each
+//! with its own statistics and MuHash, which are combined at the end.
+template <typename T>
+static bool ComputeUTXOStats(CCoinsView *view, CCoinsStats &stats, T hash_obj,
+                             const std::function<void()> &interruption_point) {
+    const unsigned int max_threads{std::clamp(
+        std::thread::hardware_concurrency(), 1u, MAX_COINSTATS_THREADS)};
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors{
+        view->RangeCursors(max_threads * RANGES_PER_THREAD)};
+    assert(!cursors.empty());
+
+    CoinsRanges shared;
+    shared.ranges.resize(cursors.size());
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        shared.ranges[i].cursor = std::move(cursors[i]);
     }
-    if (!outputs.empty()) {
-        ApplyStats(stats, prevkey, outputs);
-        ApplyHash(hash_obj, prevkey, outputs);
+
+    PrepareHash(hash_obj, stats);
+
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < std::min<size_t>(max_threads, shared.ranges.size());
+         ++n) {
+        threads.emplace_back([&shared, n]() {
+            util::ThreadRename(strprintf("coinstats.%i", n));
+            for (size_t i; (i = shared.next_range++) < shared.ranges.size();) {
+                CoinsRange &range = shared.ranges[i];
+                bool ok;
+                try {
+                    ok = ComputeRangeStats<T>(shared, range);
+                } catch (const std::exception &e) {
+                    LogPrintf("Error reading the UTXO set: %s\n", e.what());
+                    ok = false;
+                }
+                LOCK(shared.mutex);
+                range.ok = ok;
+                range.done = true;
+                shared.cv.notify_all();
+            }
+        });
     }
+    const auto stop_threads = [&]() {
+        WITH_LOCK(shared.mutex, shared.interrupted = true);
+        shared.cv.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    };
+
+    try {
+        for (CoinsRange &range : shared.ranges) {
+            while (true) {
+                interruption_point();
+                std::optional<CDataStream> chunk;
+                {
+                    WAIT_LOCK(shared.mutex, lock);
+                    shared.cv.wait_for(
+                        lock, std::chrono::milliseconds{100}, [&]() {
+                            return !range.chunks.empty() || range.done;
+                        });
+                    if (!range.chunks.empty()) {
+                        chunk = std::move(range.chunks.front());
+                        range.chunks.pop_front();
+                        shared.cv.notify_all();
+                    } else if (range.done) {
+                        break;
+                    }
+                }
+                if constexpr (std::is_same_v<T, HashWriter>) {
+                    if (chunk) {
+                        hash_obj.write(MakeByteSpan(*chunk));
+                    }
+                }
+            }
+            if (!range.ok) {
+                stop_threads();
+                return false;
+            }
+
+            if constexpr (std::is_same_v<T, MuHash3072>) {
+                hash_obj *= range.muhash;
+            }
+            stats.nTransactions += range.stats.nTransactions;
+            stats.nTransactionOutputs += range.stats.nTransactionOutputs;
+            stats.nBogoSize += range.stats.nBogoSize;
+            stats.nTotalAmount += range.stats.nTotalAmount;
+            stats.coins_count += range.stats.coins_count;
+        }
+    } catch (...) {
+        stop_threads();
+        throw;
+    }
+    stop_threads();
 
     FinalizeHash(hash_obj, stats);
 
@@ -179,4 +348,35 @@ static void FinalizeHash(MuHash3072 &muhash, CCoinsStats &stats) {
 }
 static void FinalizeHash(std::nullptr_t, CCoinsStats &stats) {}
 
+SerializedCoinsHasher::SerializedCoinsHasher(const BlockHash &block_hash) {
+    // Same as PrepareHash()
+    m_ss << block_hash;
+}
+
+void SerializedCoinsHasher::Add(const COutPoint &outpoint, const Coin &coin) {
+    if (!m_outputs.empty() && outpoint.GetTxId() != m_txid) {
+        // The database orders the txids by their serialized bytes, not as
+        // numbers.
+        const TxId &txid{outpoint.GetTxId()};
+        if (std::lexicographical_compare(txid.begin(), txid.end(),
+                                         m_txid.begin(), m_txid.end())) {
+            m_ordered = false;
+        }
+        ApplyHash(m_ss, m_txid, m_outputs);
+        m_outputs.clear();
+    }
+    m_txid = outpoint.GetTxId();
+    if (!m_outputs.emplace(outpoint.GetN(), coin).second) {
+        m_ordered = false;
+    }
+}
+
+uint256 SerializedCoinsHasher::Finalize() {
+    if (!m_outputs.empty()) {
+        ApplyHash(m_ss, m_txid, m_outputs);
+        m_outputs.clear();
+    }
+    return m_ss.GetHash();
+}
+
 } // namespace kernel
@@ -8,11 +8,15 @@
 #include <chain.h>
 #include <coins.h>
 #include <consensus/amount.h>
+#include <hash.h>
+#include <primitives/txid.h>
 #include <streams.h>
 #include <uint256.h>
 
 #include <cstdint>
 #include <functional>
+#include <map>
+#include <optional>
 
 class CCoinsView;
 namespace node {
@@ -81,6 +85,32 @@ std::optional<CCoinsStats>
 ComputeUTXOStats(CoinStatsHashType hash_type, CCoinsView *view,
                  node::BlockManager &blockman,
                  const std::function<void()> &interruption_point = {});
+
+/**
+ * Computes the CoinStatsHashType::HASH_SERIALIZED hash of a UTXO set from its
+ * coins, passed one at a time in the order of the coins database, so a UTXO
+ * snapshot can be hashed as it is written or read instead of in a separate
+ * pass over the database.
+ */
+class SerializedCoinsHasher {
+public:
+    explicit SerializedCoinsHasher(const BlockHash &block_hash);
+
+    void Add(const COutPoint &outpoint, const Coin &coin);
+
+    //! Whether the coins were added in database order and without duplicates.
+    //! The hash only matches the one of the UTXO set if they were.
+    bool IsOrdered() const { return m_ordered; }
+
+    uint256 Finalize();
+
+private:
+    HashWriter m_ss{};
+    //! Outputs of the transaction being added
+    TxId m_txid;
+    std::map<uint32_t, Coin> m_outputs;
+    bool m_ordered{true};
+};
 } // namespace kernel
 
 #endif // BITCOIN_KERNEL_COINSTATS_H
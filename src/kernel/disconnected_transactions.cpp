@@ -7,6 +7,7 @@
 
 #include <chain.h>
 #include <consensus/consensus.h>
+#include <logging.h>
 #include <primitives/transaction.h>
 #include <reverse_iterator.h>
 #include <sync.h>
@@ -15,6 +16,8 @@
 
 /** Maximum bytes for transactions to store for processing during reorg */
 static const size_t MAX_DISCONNECTED_TX_POOL_SIZE = 20 * DEFAULT_MAX_BLOCK_SIZE;
+/** Number of transactions added back to the mempool at once after a reorg */
+static const size_t REORG_BATCH_SIZE = 1000;
 
 const DisconnectedBlockTransactions::TxInfo *
 DisconnectedBlockTransactions::getTxInfo(const CTransactionRef &tx) const {
@@ -182,44 +185,69 @@ void DisconnectedBlockTransactions::updateMempoolForReorg(
         // mined block that was disconnected.
         // Iterate disconnectpool in reverse, so that we add transactions back
         // to the mempool starting with the earliest transaction that had been
-        // previously seen in a block.
+        // previously seen in a block. The transactions are submitted in
+        // batches, parents always come before their children.
+        std::vector<MempoolLoadTx> batch;
+        batch.reserve(REORG_BATCH_SIZE);
+        const auto submit_batch = [&]() {
+            AssertLockHeld(cs_main);
+            const PackageMempoolAcceptResult result =
+                ReaddTransactionBatch(active_chainstate, pool, batch);
+            for (const MempoolLoadTx &load_tx : batch) {
+                const TxId &txid = load_tx.tx->GetId();
+                const auto it = result.m_tx_results.find(txid);
+                if (it == result.m_tx_results.end() ||
+                    it->second.m_result_type !=
+                        MempoolAcceptResult::ResultType::VALID) {
+                    // ignore validation errors in resurrected transactions
+                    LogPrint(BCLog::MEMPOOLREJ,
+                             "AcceptToMemoryPool: tx %s rejected after reorg "
+                             "(%s)\n",
+                             txid.ToString(),
+                             it == result.m_tx_results.end()
+                                 ? result.m_state.ToString()
+                                 : it->second.m_state.ToString());
+
+                    // tx not accepted: undo mapDelta insertion from below
+                    const auto ptxInfo = getTxInfo(load_tx.tx);
+                    if (ptxInfo && ptxInfo->feeDelta != Amount::zero()) {
+                        pool.mapDeltas.erase(txid);
+                    }
+                } else {
+                    LogPrint(BCLog::MEMPOOL,
+                             "AcceptToMemoryPool: tx %s accepted after "
+                             "reorg\n",
+                             txid.ToString());
+                }
+            }
+            batch.clear();
+        };
+
         for (const CTransactionRef &tx :
              reverse_iterate(queuedTx.get<insertion_order>())) {
             if (tx->IsCoinBase()) {
                 continue;
             }
-            // restore saved PrioritiseTransaction state and nAcceptTime
+            // restore saved PrioritiseTransaction state, nAcceptTime and
+            // height
             const auto ptxInfo = getTxInfo(tx);
-            bool hasFeeDelta = false;
             if (ptxInfo && ptxInfo->feeDelta != Amount::zero()) {
                 // manipulate mapDeltas directly (faster than calling
                 // PrioritiseTransaction)
                 pool.mapDeltas[tx->GetId()] = ptxInfo->feeDelta;
-                hasFeeDelta = true;
             }
-            // ignore validation errors in resurrected transactions
-            auto result = AcceptToMemoryPool(
-                active_chainstate, tx,
-                /*accept_time=*/ptxInfo ? ptxInfo->time.count() : GetTime(),
-                /*bypass_limits=*/true, /*test_accept=*/false,
-                /*heightOverride=*/ptxInfo ? ptxInfo->height : 0);
-            if (result.m_result_type !=
-                MempoolAcceptResult::ResultType::VALID) {
-                LogPrint(
-                    BCLog::MEMPOOLREJ,
-                    "AcceptToMemoryPool: tx %s rejected after reorg (%s)\n",
-                    tx->GetId().ToString(), result.m_state.ToString());
-
-                if (hasFeeDelta) {
-                    // tx not accepted: undo mapDelta insertion from above
-                    pool.mapDeltas.erase(tx->GetId());
-                }
-            } else {
-                LogPrint(BCLog::MEMPOOL,
-                         "AcceptToMemoryPool: tx %s accepted after reorg\n",
-                         tx->GetId().ToString());
+            MempoolLoadTx load_tx{tx,
+                                  ptxInfo ? ptxInfo->time.count() : GetTime()};
+            load_tx.height = ptxInfo ? ptxInfo->height : 0;
+            batch.push_back(std::move(load_tx));
+
+            if (batch.size() >= REORG_BATCH_SIZE) {
+                submit_batch();
             }
         }
+        if (!batch.empty()) {
+            submit_batch();
+        }
     }
 
     queuedTx.clear();
@@ -0,0 +1,393 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <kernel/mempool_journal.h>
+
+#include <chain.h>
+#include <clientversion.h>
+#include <logging.h>
+#include <hash.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <serialize.h>
+#include <streams.h>
+#include <txmempool.h>
+#include <util/fs_helpers.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+using fsbridge::FopenFn;
+
+namespace kernel {
+
+static const uint64_t MEMPOOL_JOURNAL_VERSION = 2;
+
+namespace {
+enum class RecordType : uint8_t {
+    //! A transaction entered the mempool
+    ADD = 0,
+    //! A transaction left the mempool for another reason than being mined
+    REMOVE = 1,
+    //! The transactions of a block were mined
+    BLOCK = 2,
+};
+} // namespace
+
+fs::path MempoolJournalPath(const fs::path &mempool_path) {
+    return mempool_path + ".journal";
+}
+
+fs::path MempoolJournalKeyPath(const fs::path &journal_path) {
+    return journal_path + ".key";
+}
+
+static std::optional<uint256> ReadJournalKey(const fs::path &path,
+                                             FopenFn mockable_fopen_function) {
+    CAutoFile file(mockable_fopen_function(path, "rb"), SER_DISK,
+                   CLIENT_VERSION);
+    if (file.IsNull()) {
+        return std::nullopt;
+    }
+    try {
+        uint256 key;
+        file >> key;
+        return key;
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+}
+
+/**
+ * Tag authenticating the verification data of a transaction. The key is
+ * prepended to the data, the double SHA256 is not subject to length
+ * extension.
+ */
+static uint256 VerificationTag(const uint256 &key, int64_t sig_checks,
+                               const uint256 &coins_hash,
+                               const BlockHash &tip) {
+    HashWriter hasher{};
+    hasher << key << sig_checks << coins_hash << tip;
+    return hasher.GetHash();
+}
+
+std::optional<std::vector<MempoolJournalTx>>
+ReadMempoolJournal(const fs::path &path, FopenFn mockable_fopen_function) {
+    CAutoFile file(mockable_fopen_function(path, "rb"), SER_DISK,
+                   CLIENT_VERSION);
+    if (file.IsNull()) {
+        return std::nullopt;
+    }
+
+    try {
+        uint64_t version;
+        file >> version;
+        if (version != MEMPOOL_JOURNAL_VERSION) {
+            return std::nullopt;
+        }
+    } catch (const std::exception &) {
+        return std::nullopt;
+    }
+
+    // Without the key, no verification data can be trusted.
+    const std::optional<uint256> key{
+        ReadJournalKey(MempoolJournalKeyPath(path), mockable_fopen_function)};
+
+    // Removed transactions leave a null tx behind, so the order of the others
+    // is preserved.
+    std::vector<MempoolJournalTx> txs;
+    std::unordered_map<TxId, size_t, SaltedTxIdHasher> index_by_txid;
+    const auto remove = [&](const TxId &txid) {
+        const auto it = index_by_txid.find(txid);
+        if (it != index_by_txid.end()) {
+            txs[it->second].tx.reset();
+            index_by_txid.erase(it);
+        }
+    };
+
+    try {
+        while (true) {
+            const int type{std::fgetc(file.Get())};
+            if (type == EOF) {
+                break;
+            }
+            switch (RecordType(type)) {
+                case RecordType::ADD: {
+                    MempoolJournalTx jtx;
+                    file >> jtx.tx >> jtx.time >> jtx.fee_delta >>
+                        jtx.sig_checks >> jtx.verified;
+                    if (jtx.verified) {
+                        uint256 tag;
+                        file >> jtx.spent_coins_hash >> jtx.verified_tip >>
+                            tag;
+                        jtx.verified =
+                            key && tag == VerificationTag(*key, jtx.sig_checks,
+                                                          jtx.spent_coins_hash,
+                                                          jtx.verified_tip);
+                    }
+                    // A transaction that is added again, e.g. after a reorg,
+                    // moves to the end.
+                    remove(jtx.tx->GetId());
+                    index_by_txid.emplace(jtx.tx->GetId(), txs.size());
+                    txs.push_back(std::move(jtx));
+                    break;
+                }
+                case RecordType::REMOVE: {
+                    TxId txid;
+                    file >> txid;
+                    remove(txid);
+                    break;
+                }
+                case RecordType::BLOCK: {
+                    std::vector<TxId> txids;
+                    file >> txids;
+                    for (const TxId &txid : txids) {
+                        remove(txid);
+                    }
+                    break;
+                }
+                default:
+                    throw std::ios_base::failure("Unknown record type");
+            }
+        }
+    } catch (const std::exception &e) {
+        // Most likely a record that was being written when the node stopped.
+        LogPrintf("Mempool journal ends with an unreadable record: %s\n",
+                  e.what());
+    }
+
+    txs.erase(std::remove_if(txs.begin(), txs.end(),
+                             [](const MempoolJournalTx &jtx) {
+                                 return jtx.tx == nullptr;
+                             }),
+              txs.end());
+    return txs;
+}
+
+MempoolJournal::MempoolJournal(CTxMemPool &pool, fs::path path,
+                               const BlockHash &tip)
+    : m_pool(pool), m_path(std::move(path)), m_tip(tip) {}
+
+MempoolJournal::~MempoolJournal() {
+    Close();
+}
+
+bool MempoolJournal::Open() {
+    LOCK(m_mutex);
+    return LoadKey() && Rewrite();
+}
+
+bool MempoolJournal::LoadKey() {
+    const fs::path key_path{MempoolJournalKeyPath(m_path)};
+    if (const auto key{ReadJournalKey(key_path, fsbridge::fopen)}) {
+        m_key = *key;
+        return true;
+    }
+
+    GetStrongRandBytes(m_key);
+    const fs::path tmp_path = key_path + ".new";
+    FILE *file{fsbridge::fopen(tmp_path, "wb")};
+    if (!file || fwrite(m_key.data(), 1, m_key.size(), file) != m_key.size() ||
+        !FileCommit(file)) {
+        if (file) {
+            fclose(file);
+        }
+        LogPrintf("Failed to write mempool journal key. Journaling is "
+                  "disabled.\n");
+        return false;
+    }
+    fclose(file);
+    if (!RenameOver(tmp_path, key_path)) {
+        LogPrintf("Failed to write mempool journal key. Journaling is "
+                  "disabled.\n");
+        return false;
+    }
+    return true;
+}
+
+void MempoolJournal::Close() {
+    LOCK(m_mutex);
+    CloseFile();
+}
+
+void MempoolJournal::CloseFile() {
+    if (m_file) {
+        FileCommit(m_file);
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+static void SerializeAdd(std::vector<uint8_t> &record,
+                         const CTxMemPoolEntry &entry,
+                         const CTransactionRef &tx, const uint256 &key,
+                         const uint256 *coins_hash, const BlockHash *tip) {
+    CVectorWriter writer(SER_DISK, CLIENT_VERSION, record, record.size());
+    const int64_t sig_checks{entry.GetSigChecks()};
+    writer << uint8_t(RecordType::ADD) << tx
+           << int64_t(count_seconds(entry.GetTime()))
+           << entry.GetModifiedFee() - entry.GetFee() << sig_checks
+           << bool(coins_hash != nullptr);
+    if (coins_hash) {
+        writer << *coins_hash << *tip
+               << VerificationTag(key, sig_checks, *coins_hash, *tip);
+    }
+}
+
+bool MempoolJournal::Rewrite() {
+    CloseFile();
+
+    const fs::path tmp_path = m_path + ".new";
+    try {
+        std::vector<uint8_t> data;
+        CVectorWriter(SER_DISK, CLIENT_VERSION, data, 0)
+            << MEMPOOL_JOURNAL_VERSION;
+
+        uint64_t num_records{0};
+        {
+            LOCK(m_pool.cs);
+            for (const auto &entry : m_pool.mapTx.get<entry_id>()) {
+                const auto it = m_verified.find(entry->GetTx().GetId());
+                const bool verified = it != m_verified.end();
+                SerializeAdd(data, *entry, entry->GetSharedTx(), m_key,
+                             verified ? &it->second.spent_coins_hash : nullptr,
+                             verified ? &it->second.tip : nullptr);
+                ++num_records;
+            }
+            // Forget about transactions that were removed while the journal
+            // was closed.
+            for (auto it = m_verified.begin(); it != m_verified.end();) {
+                it = m_pool.exists(it->first) ? std::next(it)
+                                              : m_verified.erase(it);
+            }
+        }
+
+        FILE *file{fsbridge::fopen(tmp_path, "wb")};
+        if (!file) {
+            throw std::runtime_error("Open failed");
+        }
+        if (fwrite(data.data(), 1, data.size(), file) != data.size() ||
+            !FileCommit(file)) {
+            fclose(file);
+            throw std::runtime_error("Write failed");
+        }
+        fclose(file);
+        if (!RenameOver(tmp_path, m_path)) {
+            throw std::runtime_error("Rename failed");
+        }
+
+        m_file = fsbridge::fopen(m_path, "ab");
+        if (!m_file) {
+            throw std::runtime_error("Open failed");
+        }
+        m_num_records = num_records;
+    } catch (const std::exception &e) {
+        LogPrintf("Failed to write mempool journal: %s. Journaling is "
+                  "disabled.\n",
+                  e.what());
+        return false;
+    }
+    return true;
+}
+
+void MempoolJournal::Append(const std::vector<uint8_t> &record, bool sync) {
+    if (!m_file) {
+        return;
+    }
+    if (fwrite(record.data(), 1, record.size(), m_file) != record.size() ||
+        fflush(m_file) != 0 || (sync && !FileCommit(m_file))) {
+        LogPrintf("Failed to write mempool journal. Journaling is "
+                  "disabled.\n");
+        fclose(m_file);
+        m_file = nullptr;
+        return;
+    }
+    ++m_num_records;
+
+    // Most records describe transactions that left the mempool already, get
+    // rid of them.
+    if (m_num_records >=
+        std::max<uint64_t>(MIN_RECORDS_BEFORE_REWRITE, 2 * m_pool.size())) {
+        Rewrite();
+    }
+}
+
+void MempoolJournal::TransactionAddedToMempool(
+    const CTransactionRef &tx,
+    std::shared_ptr<const std::vector<Coin>> spent_coins,
+    uint64_t mempool_sequence) {
+    LOCK(m_mutex);
+    const Verification &verification =
+        m_verified
+            .insert_or_assign(tx->GetId(),
+                              Verification{
+                                  GetSpentCoinsHash(*tx, *spent_coins), m_tip})
+            .first->second;
+    if (!m_file) {
+        return;
+    }
+
+    std::vector<uint8_t> record;
+    {
+        LOCK(m_pool.cs);
+        const auto it = m_pool.mapTx.find(tx->GetId());
+        if (it == m_pool.mapTx.end()) {
+            // Already gone, the removal is on its way.
+            return;
+        }
+        SerializeAdd(record, **it, tx, m_key, &verification.spent_coins_hash,
+                     &verification.tip);
+    }
+    Append(record);
+}
+
+void MempoolJournal::TransactionRemovedFromMempool(
+    const CTransactionRef &tx, MemPoolRemovalReason reason,
+    uint64_t mempool_sequence) {
+    LOCK(m_mutex);
+    m_verified.erase(tx->GetId());
+    if (!m_file) {
+        return;
+    }
+
+    std::vector<uint8_t> record;
+    CVectorWriter(SER_DISK, CLIENT_VERSION, record, 0)
+        << uint8_t(RecordType::REMOVE) << tx->GetId();
+    Append(record);
+}
+
+void MempoolJournal::BlockConnected(const std::shared_ptr<const CBlock> &block,
+                                    const CBlockIndex *pindex) {
+    LOCK(m_mutex);
+    m_tip = pindex->GetBlockHash();
+
+    std::vector<TxId> txids;
+    txids.reserve(block->vtx.size());
+    for (const auto &tx : block->vtx) {
+        m_verified.erase(tx->GetId());
+        txids.push_back(tx->GetId());
+    }
+    if (!m_file) {
+        return;
+    }
+
+    std::vector<uint8_t> record;
+    CVectorWriter(SER_DISK, CLIENT_VERSION, record, 0)
+        << uint8_t(RecordType::BLOCK) << txids;
+    Append(record, /*sync=*/true);
+}
+
+void MempoolJournal::BlockDisconnected(
+    const std::shared_ptr<const CBlock> &block, const CBlockIndex *pindex) {
+    LOCK(m_mutex);
+    if (pindex->pprev) {
+        m_tip = pindex->pprev->GetBlockHash();
+    }
+}
+
+} // namespace kernel
@@ -0,0 +1,160 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_KERNEL_MEMPOOL_JOURNAL_H
+#define BITCOIN_KERNEL_MEMPOOL_JOURNAL_H
+
+#include <consensus/amount.h>
+#include <primitives/blockhash.h>
+#include <primitives/transaction.h>
+#include <primitives/txid.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/fs.h>
+#include <util/hasher.h>
+#include <validationinterface.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+class CBlockIndex;
+class CTxMemPool;
+
+namespace kernel {
+
+/** Location of the journal that goes with a mempool dump file. */
+fs::path MempoolJournalPath(const fs::path &mempool_path);
+
+/**
+ * Location of the secret that authenticates the verification data of a
+ * journal, see MempoolJournal.
+ */
+fs::path MempoolJournalKeyPath(const fs::path &journal_path);
+
+/** A mempool transaction as last recorded in the journal. */
+struct MempoolJournalTx {
+    CTransactionRef tx;
+    int64_t time{0};
+    Amount fee_delta{Amount::zero()};
+    int64_t sig_checks{0};
+    //! Whether the transaction scripts were verified when it was journaled,
+    //! and the record of it is authentic
+    bool verified{false};
+    //! See GetSpentCoinsHash()
+    uint256 spent_coins_hash{};
+    //! Chain tip at the time the scripts were verified
+    BlockHash verified_tip;
+};
+
+/**
+ * Replay a mempool journal. Returns the transactions that were still in the
+ * mempool at the end of it, in the order they were added, or std::nullopt if
+ * the journal can't be read. A truncated last record, as left by a crash, is
+ * ignored. The transactions whose verification data doesn't match the journal
+ * key are reported as unverified.
+ */
+std::optional<std::vector<MempoolJournalTx>>
+ReadMempoolJournal(const fs::path &path,
+                   fsbridge::FopenFn mockable_fopen_function = fsbridge::fopen);
+
+/**
+ * Append-only log of the mempool changes, so the mempool can be restored
+ * after an unclean shutdown.
+ *
+ * The journal starts with a snapshot of the mempool and is then fed by the
+ * validation interface notifications: each added transaction gets its
+ * mempool entry data and the hash of the coins its scripts were verified
+ * against, so they don't need to be verified again on load if nothing
+ * changed. Transactions removed from the mempool, either explicitly or because
+ * they were mined, are recorded as well. Every record is flushed to the OS as
+ * it is written, and the file is synced to disk for each block. The journal is
+ * rewritten from the mempool when the removed transactions make up most of it.
+ *
+ * Fee deltas set after a transaction entered the mempool are only recorded
+ * when the journal is rewritten, mempool.dat remains the authoritative source
+ * for them after a clean shutdown.
+ *
+ * The verification data is what lets the transactions skip their script
+ * checks on load, and the spent coins hash only covers public data. Each
+ * record of it is therefore tagged with a hash keyed by a random secret,
+ * which is kept in a separate file and never written to the journal. Someone
+ * who can edit the journal but not read the key file can't make invalid
+ * transactions pass as verified. Anyone who can read the data directory can
+ * still forge the tags, the data directory is trusted like the rest of the
+ * node state.
+ */
+class MempoolJournal final : public CValidationInterface {
+public:
+    MempoolJournal(CTxMemPool &pool, fs::path path, const BlockHash &tip);
+    ~MempoolJournal();
+
+    /**
+     * Write a snapshot of the mempool and start logging the changes to it.
+     * Transactions added to the mempool before the journal is opened are
+     * still tracked so the snapshot can include their verification data.
+     */
+    bool Open() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Sync the journal to disk and stop logging. */
+    void Close() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+protected:
+    void TransactionAddedToMempool(
+        const CTransactionRef &tx,
+        std::shared_ptr<const std::vector<Coin>> spent_coins,
+        uint64_t mempool_sequence) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void TransactionRemovedFromMempool(const CTransactionRef &tx,
+                                       MemPoolRemovalReason reason,
+                                       uint64_t mempool_sequence) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void BlockConnected(const std::shared_ptr<const CBlock> &block,
+                        const CBlockIndex *pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void BlockDisconnected(const std::shared_ptr<const CBlock> &block,
+                           const CBlockIndex *pindex) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct Verification {
+        uint256 spent_coins_hash{};
+        BlockHash tip;
+    };
+
+    //! Minimum number of records before the journal gets rewritten
+    static constexpr uint64_t MIN_RECORDS_BEFORE_REWRITE{10000};
+
+    CTxMemPool &m_pool;
+    const fs::path m_path;
+
+    Mutex m_mutex;
+    //! Secret keying the verification tags, see MempoolJournalKeyPath()
+    uint256 m_key GUARDED_BY(m_mutex);
+    //! Append handle, null until the journal is opened
+    FILE *m_file GUARDED_BY(m_mutex){nullptr};
+    uint64_t m_num_records GUARDED_BY(m_mutex){0};
+    //! Chain tip as of the last processed block notification
+    BlockHash m_tip GUARDED_BY(m_mutex);
+    //! Verification data of the transactions currently in the mempool
+    std::unordered_map<TxId, Verification, SaltedTxIdHasher>
+        m_verified GUARDED_BY(m_mutex);
+
+    /** Read the journal key, or create it if there is none yet. */
+    bool LoadKey() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /** Replace the journal with a snapshot of the mempool. */
+    bool Rewrite() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    /**
+     * Append a serialized record. On failure the journal is closed, so it
+     * can't get out of sync with the mempool.
+     */
+    void Append(const std::vector<uint8_t> &record, bool sync = false)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void CloseFile() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+
+} // namespace kernel
+
+#endif // BITCOIN_KERNEL_MEMPOOL_JOURNAL_H
@@ -6,7 +6,9 @@
 
 #include <clientversion.h>
 #include <consensus/amount.h>
+#include <kernel/mempool_journal.h>
 #include <logging.h>
+#include <policy/packages.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <shutdown.h>
@@ -35,6 +37,8 @@ using fsbridge::FopenFn;
 
 namespace kernel {
 static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+//! Number of transactions submitted at once when loading the mempool
+static const size_t MEMPOOL_LOAD_BATCH_SIZE = 1000;
 
 bool LoadMempool(CTxMemPool &pool, const fs::path &load_path,
                  Chainstate &active_chainstate,
@@ -43,14 +47,6 @@ bool LoadMempool(CTxMemPool &pool, const fs::path &load_path,
         return false;
     }
 
-    FILE *filestr{mockable_fopen_function(load_path, "rb")};
-    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
-    if (file.IsNull()) {
-        LogPrintf(
-            "Failed to open mempool file from disk. Continuing anyway.\n");
-        return false;
-    }
-
     int64_t count = 0;
     int64_t expired = 0;
     int64_t failed = 0;
@@ -58,79 +54,158 @@ bool LoadMempool(CTxMemPool &pool, const fs::path &load_path,
     int64_t unbroadcast = 0;
     auto now = NodeClock::now();
 
-    try {
-        uint64_t version;
-        file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
-            return false;
+    std::vector<std::pair<MempoolLoadTx, Amount>> dat_txs;
+    std::map<TxId, Amount> mapDeltas;
+    std::set<TxId> unbroadcast_txids;
+    bool dat_loaded = false;
+
+    FILE *filestr{mockable_fopen_function(load_path, "rb")};
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        LogPrintf(
+            "Failed to open mempool file from disk. Continuing anyway.\n");
+    } else {
+        try {
+            uint64_t version;
+            file >> version;
+            if (version != MEMPOOL_DUMP_VERSION) {
+                return false;
+            }
+
+            uint64_t num;
+            file >> num;
+            while (num) {
+                --num;
+                CTransactionRef tx;
+                int64_t nTime;
+                int64_t nFeeDelta;
+                file >> tx;
+                file >> nTime;
+                file >> nFeeDelta;
+                dat_txs.emplace_back(MempoolLoadTx{tx, nTime},
+                                     nFeeDelta * SATOSHI);
+            }
+
+            file >> mapDeltas;
+            file >> unbroadcast_txids;
+            dat_loaded = true;
+        } catch (const std::exception &e) {
+            LogPrintf("Failed to deserialize mempool data on disk: %s. "
+                      "Continuing anyway.\n",
+                      e.what());
+        }
+    }
+
+    // The journal, when there is one, is at least as recent as mempool.dat,
+    // but the fee deltas set after a transaction was journaled are only found
+    // in the latter.
+    std::vector<std::pair<MempoolLoadTx, Amount>> load_txs;
+    auto journal_txs =
+        ReadMempoolJournal(MempoolJournalPath(load_path), mockable_fopen_function);
+    if (journal_txs) {
+        std::map<TxId, Amount> dat_deltas;
+        for (const auto &[load_tx, delta] : dat_txs) {
+            dat_deltas.emplace(load_tx.tx->GetId(), delta);
         }
 
-        uint64_t num;
-        file >> num;
-        while (num) {
-            --num;
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            Amount amountdelta = nFeeDelta * SATOSHI;
-            if (amountdelta != Amount::zero()) {
-                pool.PrioritiseTransaction(tx->GetId(), amountdelta);
+        LOCK(cs_main);
+        for (const MempoolJournalTx &jtx : *journal_txs) {
+            MempoolLoadTx load_tx{jtx.tx, jtx.time};
+            if (jtx.verified) {
+                load_tx.verified_tip =
+                    active_chainstate.m_blockman.LookupBlockIndex(
+                        jtx.verified_tip);
+                load_tx.spent_coins_hash = jtx.spent_coins_hash;
+                load_tx.sig_checks = jtx.sig_checks;
             }
-            if (nTime >
-                TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
-                LOCK(cs_main);
-                const auto &accepted =
-                    AcceptToMemoryPool(active_chainstate, tx, nTime,
-                                       /*bypass_limits=*/false,
-                                       /*test_accept=*/false);
-                if (accepted.m_result_type ==
+            const auto it = dat_deltas.find(jtx.tx->GetId());
+            load_txs.emplace_back(std::move(load_tx), it != dat_deltas.end()
+                                                          ? it->second
+                                                          : jtx.fee_delta);
+        }
+        LogPrintf("Replayed %d transactions from the mempool journal\n",
+                  load_txs.size());
+    } else if (dat_loaded) {
+        load_txs = std::move(dat_txs);
+    } else {
+        return false;
+    }
+
+    // Submit the transactions in topological order, the journal doesn't
+    // guarantee it after a reorg.
+    std::vector<CTransactionRef> sorted_txns;
+    std::map<TxId, size_t> index_by_txid;
+    sorted_txns.reserve(load_txs.size());
+    for (size_t i = 0; i < load_txs.size(); ++i) {
+        sorted_txns.push_back(load_txs[i].first.tx);
+        index_by_txid.emplace(load_txs[i].first.tx->GetId(), i);
+    }
+    SortPackageTopologically(sorted_txns);
+
+    std::vector<MempoolLoadTx> batch;
+    batch.reserve(MEMPOOL_LOAD_BATCH_SIZE);
+    const auto submit_batch = [&]() {
+        const PackageMempoolAcceptResult result = WITH_LOCK(
+            cs_main,
+            return LoadMempoolTransactions(active_chainstate, pool, batch));
+        for (const MempoolLoadTx &load_tx : batch) {
+            const auto it = result.m_tx_results.find(load_tx.tx->GetId());
+            if (it != result.m_tx_results.end() &&
+                it->second.m_result_type ==
                     MempoolAcceptResult::ResultType::VALID) {
-                    ++count;
+                ++count;
+            } else {
+                // mempool may contain the transaction already, e.g. from
+                // wallet(s) having loaded it while we were processing
+                // mempool transactions; consider these as valid, instead of
+                // failed, but mark them as 'already there'
+                if (pool.exists(load_tx.tx->GetId())) {
+                    ++already_there;
                 } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (pool.exists(tx->GetId())) {
-                        ++already_there;
-                    } else {
-                        ++failed;
-                    }
+                    ++failed;
                 }
-            } else {
-                ++expired;
             }
+        }
+        batch.clear();
+    };
 
+    for (const CTransactionRef &tx : sorted_txns) {
+        auto &[load_tx, amountdelta] = load_txs[index_by_txid.at(tx->GetId())];
+        if (amountdelta != Amount::zero()) {
+            pool.PrioritiseTransaction(tx->GetId(), amountdelta);
+        }
+        if (load_tx.time >
+            TicksSinceEpoch<std::chrono::seconds>(now - pool.m_expiry)) {
+            batch.push_back(std::move(load_tx));
+        } else {
+            ++expired;
+        }
+
+        if (batch.size() >= MEMPOOL_LOAD_BATCH_SIZE) {
+            submit_batch();
             if (ShutdownRequested()) {
                 return false;
             }
         }
-        std::map<TxId, Amount> mapDeltas;
-        file >> mapDeltas;
+    }
+    if (!batch.empty()) {
+        submit_batch();
+    }
+    if (ShutdownRequested()) {
+        return false;
+    }
 
-        for (const auto &i : mapDeltas) {
-            pool.PrioritiseTransaction(i.first, i.second);
-        }
+    for (const auto &i : mapDeltas) {
+        pool.PrioritiseTransaction(i.first, i.second);
+    }
 
-        std::set<TxId> unbroadcast_txids;
-        file >> unbroadcast_txids;
-        unbroadcast = unbroadcast_txids.size();
-        for (const auto &txid : unbroadcast_txids) {
-            // Ensure transactions were accepted to mempool then add to
-            // unbroadcast set.
-            if (pool.get(txid) != nullptr) {
-                pool.AddUnbroadcastTx(txid);
-            }
+    unbroadcast = unbroadcast_txids.size();
+    for (const auto &txid : unbroadcast_txids) {
+        // Ensure transactions were accepted to mempool then add to
+        // unbroadcast set.
+        if (pool.get(txid) != nullptr) {
+            pool.AddUnbroadcastTx(txid);
         }
-    } catch (const std::exception &e) {
-        LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing "
-                  "anyway.\n",
-                  e.what());
-        return false;
     }
 
     LogPrintf("Imported mempool transactions from disk: %i succeeded, %i "
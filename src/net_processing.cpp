@@ -782,6 +782,8 @@ public:
     void SendPings() override EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void RelayTransaction(const TxId &txid) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
+    void RelayTransactions(Span<const TxId> txids) override
+        EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void RelayProof(const avalanche::ProofId &proofid) override
         EXCLUSIVE_LOCKS_REQUIRED(!m_peer_mutex);
     void SetBestHeight(int height) override { m_best_height = height; };
@@ -3075,6 +3077,10 @@ void PeerManagerImpl::SendPings() {
 }
 
 void PeerManagerImpl::RelayTransaction(const TxId &txid) {
+    RelayTransactions(Span{&txid, 1});
+}
+
+void PeerManagerImpl::RelayTransactions(Span<const TxId> txids) {
     LOCK(m_peer_mutex);
     for (auto &it : m_peer_map) {
         Peer &peer = *it.second;
@@ -3092,8 +3098,10 @@ void PeerManagerImpl::RelayTransaction(const TxId &txid) {
             continue;
         }
 
-        if (!tx_relay->m_tx_inventory_known_filter.contains(txid)) {
-            tx_relay->m_tx_inventory_to_send.insert(txid);
+        for (const TxId &txid : txids) {
+            if (!tx_relay->m_tx_inventory_known_filter.contains(txid)) {
+                tx_relay->m_tx_inventory_to_send.insert(txid);
+            }
         }
     }
 }
@@ -4486,8 +4494,10 @@ void PeerManagerImpl::ProcessGetCFilters(CNode &node, Peer &peer,
         return;
     }
 
-    std::vector<BlockFilter> filters;
-    if (!filter_index->LookupFilterRange(start_height, stop_index, filters)) {
+    // The filters are relayed as stored, without decoding them
+    std::vector<std::vector<uint8_t>> raw_filters;
+    if (!filter_index->LookupRawFilterRange(start_height, stop_index,
+                                            raw_filters)) {
         LogPrint(BCLog::NET,
                  "Failed to find block filter in index: filter_type=%s, "
                  "start_height=%d, stop_hash=%s\n",
@@ -4496,9 +4506,11 @@ void PeerManagerImpl::ProcessGetCFilters(CNode &node, Peer &peer,
         return;
     }
 
-    for (const auto &filter : filters) {
-        CSerializedNetMsg msg = CNetMsgMaker(node.GetCommonVersion())
-                                    .Make(NetMsgType::CFILTER, filter);
+    for (const auto &raw_filter : raw_filters) {
+        CSerializedNetMsg msg =
+            CNetMsgMaker(node.GetCommonVersion())
+                .Make(NetMsgType::CFILTER, filter_type_ser,
+                      Span<const uint8_t>{raw_filter});
         m_connman.PushMessage(&node, std::move(msg));
     }
 }
@@ -4573,27 +4585,19 @@ void PeerManagerImpl::ProcessGetCFCheckPt(CNode &node, Peer &peer,
         return;
     }
 
-    std::vector<uint256> headers(stop_index->nHeight / CFCHECKPT_INTERVAL);
-
-    // Populate headers.
-    const CBlockIndex *block_index = stop_index;
-    for (int i = headers.size() - 1; i >= 0; i--) {
-        int height = (i + 1) * CFCHECKPT_INTERVAL;
-        block_index = block_index->GetAncestor(height);
-
-        if (!filter_index->LookupFilterHeader(block_index, headers[i])) {
-            LogPrint(BCLog::NET,
-                     "Failed to find block filter header in index: "
-                     "filter_type=%s, block_hash=%s\n",
-                     BlockFilterTypeName(filter_type),
-                     block_index->GetBlockHash().ToString());
-            return;
-        }
+    std::shared_ptr<const std::vector<uint8_t>> headers;
+    if (!filter_index->LookupCheckpoints(stop_index, headers)) {
+        LogPrint(BCLog::NET,
+                 "Failed to find block filter checkpoints in index: "
+                 "filter_type=%s, stop_hash=%s\n",
+                 BlockFilterTypeName(filter_type), stop_hash.ToString());
+        return;
     }
 
-    CSerializedNetMsg msg = CNetMsgMaker(node.GetCommonVersion())
-                                .Make(NetMsgType::CFCHECKPT, filter_type_ser,
-                                      stop_index->GetBlockHash(), headers);
+    CSerializedNetMsg msg =
+        CNetMsgMaker(node.GetCommonVersion())
+            .Make(NetMsgType::CFCHECKPT, filter_type_ser,
+                  stop_index->GetBlockHash(), Span<const uint8_t>{*headers});
     m_connman.PushMessage(&node, std::move(msg));
 }
 
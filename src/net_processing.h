@@ -8,6 +8,7 @@
 
 #include <avalanche/avalanche.h>
 #include <net.h>
+#include <span.h>
 #include <sync.h>
 #include <validationinterface.h>
 
@@ -136,6 +137,12 @@ public:
     /** Relay transaction to all peers. */
     virtual void RelayTransaction(const TxId &txid) = 0;
 
+    /**
+     * Relay several transactions to all peers, taking the peer locks only
+     * once. They are announced together with the next trickle.
+     */
+    virtual void RelayTransactions(Span<const TxId> txids) = 0;
+
     /** Relay proof to all peers */
     virtual void RelayProof(const avalanche::ProofId &proofid) = 0;
 
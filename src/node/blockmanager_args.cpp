@@ -41,6 +41,9 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager &args,
     if (auto value{args.GetBoolArg("-stopafterblockimport")}) {
         opts.stop_after_block_import = *value;
     }
+    if (auto value{args.GetBoolArg("-blockcompression")}) {
+        opts.compress_block_files = *value;
+    }
 
     return std::nullopt;
 }
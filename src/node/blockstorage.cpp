@@ -23,9 +23,16 @@
 #include <undo.h>
 #include <util/batchpriority.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
+#include <util/thread.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
 #include <map>
+#include <numeric>
+#include <tuple>
 #include <unordered_map>
 
 namespace node {
@@ -427,11 +434,11 @@ BlockManager::GetFirstStoredBlock(const CBlockIndex &start_block) {
 // sync with what's actually on disk by the time we start downloading, so that
 // pruning works correctly.
 void BlockManager::CleanupBlockRevFiles() const {
-    std::map<std::string, fs::path> mapBlockFiles;
+    std::multimap<std::string, fs::path> mapBlockFiles;
 
-    // Glob all blk?????.dat and rev?????.dat files from the blocks directory.
-    // Remove the rev files immediately and insert the blk file paths into an
-    // ordered map keyed by block file index.
+    // Glob all blk?????.dat, blk?????.dat.zst and rev?????.dat files from the
+    // blocks directory. Remove the rev files immediately and insert the blk
+    // file paths into an ordered map keyed by block file index.
     LogPrintf("Removing unusable blk?????.dat and rev?????.dat files for "
               "-reindex with -prune\n");
     for (const auto &file : fs::directory_iterator{m_opts.blocks_dir}) {
@@ -439,10 +446,13 @@ void BlockManager::CleanupBlockRevFiles() const {
         if (fs::is_regular_file(file) && path.length() == 12 &&
             path.substr(8, 4) == ".dat") {
             if (path.substr(0, 3) == "blk") {
-                mapBlockFiles[path.substr(3, 5)] = file.path();
+                mapBlockFiles.emplace(path.substr(3, 5), file.path());
             } else if (path.substr(0, 3) == "rev") {
                 remove(file.path());
             }
+        } else if (fs::is_regular_file(file) && path.length() == 16 &&
+                   path.substr(0, 3) == "blk" && path.substr(8) == ".dat.zst") {
+            mapBlockFiles.emplace(path.substr(3, 5), file.path());
         }
     }
 
@@ -454,6 +464,10 @@ void BlockManager::CleanupBlockRevFiles() const {
     for (const auto &item : mapBlockFiles) {
         if (atoi(item.first) == contiguousCounter) {
             contiguousCounter++;
+        }
+        // A block file can be there in both the compressed and uncompressed
+        // versions.
+        if (atoi(item.first) < contiguousCounter) {
             continue;
         }
         remove(item.second);
@@ -466,36 +480,244 @@ CBlockFileInfo *BlockManager::GetBlockFileInfo(size_t n) {
     return &m_blockfile_info.at(n);
 }
 
+std::vector<uint8_t> BlockFileWriter::GetBuffer() {
+    LOCK(m_mutex);
+    if (m_free_buffers.empty()) {
+        return {};
+    }
+    std::vector<uint8_t> buffer{std::move(m_free_buffers.back())};
+    m_free_buffers.pop_back();
+    m_free_buffers_size -= buffer.capacity();
+    return buffer;
+}
+
+bool BlockFileWriter::Write(const FlatFilePos &pos, bool undo,
+                            std::vector<uint8_t> data) {
+    WAIT_LOCK(m_mutex, lock);
+    std::vector<PendingWrite> batch;
+    batch.push_back({pos, undo, std::move(data)});
+    if (!m_running) {
+        FinishBatch(batch, WriteBatch(batch));
+        return !m_failed;
+    }
+
+    // A write larger than the whole queue waits for the queue to be empty.
+    const size_t size{batch.front().data.size()};
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return m_queue_size == 0 || m_queue_size + size <= m_max_queue_size;
+    });
+    m_queue_size += size;
+    ++m_num_pending;
+    m_queue.push_back(std::move(batch.front()));
+    m_cv.notify_all();
+    return !m_failed;
+}
+
+void BlockFileWriter::WaitForWrites(const FlatFilePos &pos, bool undo) const {
+    if (m_num_pending == 0) {
+        return;
+    }
+    const auto is_before = [&](const FlatFilePos &write_pos, bool write_undo) {
+        return write_undo == undo && write_pos.nFile == pos.nFile &&
+               write_pos.nPos <= pos.nPos;
+    };
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return std::none_of(m_queue.begin(), m_queue.end(),
+                            [&](const PendingWrite &write) {
+                                return is_before(write.pos, write.undo);
+                            }) &&
+               std::none_of(m_writing.begin(), m_writing.end(),
+                            [&](const auto &write) {
+                                return is_before(write.first, write.second);
+                            });
+    });
+}
+
+bool BlockFileWriter::Flush() {
+    WAIT_LOCK(m_mutex, lock);
+    m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        return m_queue.empty() && m_writing.empty();
+    });
+    for (const auto &[file, undo] : m_unsynced_files) {
+        const fs::path path{
+            (undo ? m_undo_seq : m_block_seq).FileName(FlatFilePos(file, 0))};
+        // The file may have been pruned in the meantime.
+        FILE *fileout{fsbridge::fopen(path, "rb+")};
+        if (fileout) {
+            if (!FileCommit(fileout)) {
+                m_failed = true;
+            }
+            fclose(fileout);
+        }
+    }
+    m_unsynced_files.clear();
+    return !m_failed;
+}
+
+void BlockFileWriter::Start() {
+    LOCK(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_thread = std::thread(&util::TraceThread, "blkwriter",
+                           [this] { ThreadWrite(); });
+}
+
+void BlockFileWriter::Stop() {
+    {
+        LOCK(m_mutex);
+        m_running = false;
+        m_cv.notify_all();
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool BlockFileWriter::WriteBatch(std::vector<PendingWrite> &batch) {
+    std::sort(batch.begin(), batch.end(),
+              [](const PendingWrite &a, const PendingWrite &b) {
+                  return std::make_tuple(a.undo, a.pos.nFile, a.pos.nPos) <
+                         std::make_tuple(b.undo, b.pos.nFile, b.pos.nPos);
+              });
+
+    bool success{true};
+    auto it = batch.begin();
+    while (it != batch.end()) {
+        const bool undo{it->undo};
+        const int file{it->pos.nFile};
+        const auto file_end{
+            std::find_if(it, batch.end(), [&](const PendingWrite &write) {
+                return write.undo != undo || write.pos.nFile != file;
+            })};
+        const unsigned int begin{it->pos.nPos};
+        FILE *fileout{(undo ? m_undo_seq : m_block_seq).Open(it->pos)};
+        if (!fileout) {
+            success = error("%s: Open failed for %s", __func__,
+                            it->pos.ToString());
+            it = file_end;
+            continue;
+        }
+        unsigned int position{begin};
+        for (; it != file_end; ++it) {
+            if (it->pos.nPos != position &&
+                std::fseek(fileout, it->pos.nPos, SEEK_SET)) {
+                success = error("%s: fseek failed for %s", __func__,
+                                it->pos.ToString());
+                break;
+            }
+            if (std::fwrite(it->data.data(), 1, it->data.size(), fileout) !=
+                it->data.size()) {
+                success = error("%s: fwrite failed for %s", __func__,
+                                it->pos.ToString());
+                break;
+            }
+            position = it->pos.nPos + it->data.size();
+        }
+        if (std::fflush(fileout) == 0) {
+            StartFileWriteback(fileout, begin, position - begin);
+        } else {
+            success = error("%s: fflush failed for file %d", __func__, file);
+        }
+        std::fclose(fileout);
+        it = file_end;
+    }
+    return success;
+}
+
+void BlockFileWriter::FinishBatch(std::vector<PendingWrite> &batch,
+                                  bool success) {
+    m_failed |= !success;
+    for (PendingWrite &write : batch) {
+        m_unsynced_files.emplace(write.pos.nFile, write.undo);
+        // Keep the buffers around for the next writes, up to the size of
+        // the queue.
+        if (m_free_buffers_size + write.data.capacity() <=
+            m_max_queue_size) {
+            write.data.clear();
+            m_free_buffers_size += write.data.capacity();
+            m_free_buffers.push_back(std::move(write.data));
+        }
+    }
+}
+
+void BlockFileWriter::ThreadWrite() {
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        m_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return !m_running || !m_queue.empty();
+        });
+        if (m_queue.empty()) {
+            return;
+        }
+
+        std::vector<PendingWrite> batch{
+            std::make_move_iterator(m_queue.begin()),
+            std::make_move_iterator(m_queue.end())};
+        m_queue.clear();
+        for (const PendingWrite &write : batch) {
+            m_writing.emplace_back(write.pos, write.undo);
+        }
+        bool success;
+        {
+            REVERSE_LOCK(lock);
+            success = WriteBatch(batch);
+        }
+        m_writing.clear();
+        for (const PendingWrite &write : batch) {
+            m_queue_size -= write.data.size();
+        }
+        m_num_pending -= batch.size();
+        FinishBatch(batch, success);
+        m_cv.notify_all();
+    }
+}
+
 bool BlockManager::UndoWriteToDisk(
     const CBlockUndo &blockundo, FlatFilePos &pos, const BlockHash &hashBlock,
-    const CMessageHeader::MessageMagic &messageStart) const {
-    // Open history file to append
-    CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull()) {
-        return error("%s: OpenUndoFile failed", __func__);
-    }
+    const CMessageHeader::MessageMagic &messageStart) {
+    std::vector<uint8_t> data{m_block_writer.GetBuffer()};
+    CVectorWriter fileout(SER_DISK, CLIENT_VERSION, data, 0);
 
     // Write index header
     unsigned int nSize = GetSerializeSize(blockundo, fileout.GetVersion());
     fileout << messageStart << nSize;
 
     // Write undo data
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0) {
-        return error("%s: ftell failed", __func__);
-    }
-    pos.nPos = (unsigned int)fileOutPos;
+    const FlatFilePos header_pos{pos};
+    const size_t header_size{data.size()};
+    pos.nPos += header_size;
     fileout << blockundo;
 
-    // calculate & write checksum
+    // calculate & write checksum, from the undo data serialized above
     HashWriter hasher{};
     hasher << hashBlock;
-    hasher << blockundo;
+    hasher.write(MakeByteSpan(data).subspan(header_size));
     fileout << hasher.GetHash();
 
+    if (!m_block_writer.Write(header_pos, /*undo=*/true, std::move(data))) {
+        return error("%s: Write failed", __func__);
+    }
     return true;
 }
 
+/**
+ * Read the undo data of a block and return whether it matches its checksum.
+ */
+template <typename Stream>
+static bool ReadBlockUndo(Stream &filein, const CBlockIndex &index,
+                          CBlockUndo &blockundo) {
+    uint256 hashChecksum;
+    // We need a CHashVerifier as reserializing may lose data
+    CHashVerifier<Stream> verifier(&filein);
+    verifier << index.pprev->GetBlockHash();
+    verifier >> blockundo;
+    filein >> hashChecksum;
+    return hashChecksum == verifier.GetHash();
+}
+
 bool BlockManager::UndoReadFromDisk(CBlockUndo &blockundo,
                                     const CBlockIndex &index) const {
     const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
@@ -504,26 +726,28 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo &blockundo,
         return error("%s: no undo data available", __func__);
     }
 
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("%s: OpenUndoFile failed", __func__);
-    }
-
     // Read block
-    uint256 hashChecksum;
-    // We need a CHashVerifier as reserializing may lose data
-    CHashVerifier<CAutoFile> verifier(&filein);
+    bool checksum_ok;
     try {
-        verifier << index.pprev->GetBlockHash();
-        verifier >> blockundo;
-        filein >> hashChecksum;
+        if (const auto mapping{GetMappedFile(pos, /*undo=*/true)}) {
+            SpanReader filein{SER_DISK, CLIENT_VERSION,
+                              mapping->Data().subspan(pos.nPos)};
+            checksum_ok = ReadBlockUndo(filein, index, blockundo);
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenUndoFile(pos, true), SER_DISK,
+                             CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("%s: OpenUndoFile failed", __func__);
+            }
+            checksum_ok = ReadBlockUndo(filein, index, blockundo);
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s", __func__, e.what());
     }
 
     // Verify checksum
-    if (hashChecksum != verifier.GetHash()) {
+    if (!checksum_ok) {
         return error("%s: Checksum mismatch", __func__);
     }
 
@@ -533,6 +757,8 @@ bool BlockManager::UndoReadFromDisk(CBlockUndo &blockundo,
 void BlockManager::FlushUndoFile(int block_file, bool finalize) {
     FlatFilePos undo_pos_old(block_file,
                              m_blockfile_info[block_file].nUndoSize);
+    // The file may be truncated, everything must be written first.
+    m_block_writer.WaitForWrites(undo_pos_old, /*undo=*/true);
     if (!UndoFileSeq().Flush(undo_pos_old, finalize)) {
         AbortNode("Flushing undo file to disk failed. This is likely the "
                   "result of an I/O error.");
@@ -552,6 +778,13 @@ void BlockManager::FlushBlockFile(bool fFinalize, bool finalize_undo) {
     }
     assert(static_cast<int>(m_blockfile_info.size()) > m_last_blockfile);
 
+    // Write and commit all the queued block and undo data, including the undo
+    // data of older files, before the block index can refer to it.
+    if (!m_block_writer.Flush()) {
+        AbortNode("Writing block or undo data to disk failed. This is likely "
+                  "the result of an I/O error.");
+    }
+
     FlatFilePos block_pos_old(m_last_blockfile,
                               m_blockfile_info[m_last_blockfile].nSize);
     if (!BlockFileSeq().Flush(block_pos_old, fFinalize)) {
@@ -582,8 +815,15 @@ void BlockManager::UnlinkPrunedFiles(
     std::error_code error_code;
     for (const int i : setFilesToPrune) {
         FlatFilePos pos(i, 0);
-        const bool removed_blockfile{
+        const FlatFilePos end_pos(i, std::numeric_limits<unsigned int>::max());
+        m_block_writer.WaitForWrites(end_pos, /*undo=*/false);
+        m_block_writer.WaitForWrites(end_pos, /*undo=*/true);
+        m_block_file_mappings.Erase(i);
+        m_undo_file_mappings.Erase(i);
+        bool removed_blockfile{
             fs::remove(BlockFileSeq().FileName(pos), error_code)};
+        removed_blockfile |=
+            fs::remove(BlockFileSeq().CompressedFileName(pos), error_code);
         const bool removed_undofile{
             fs::remove(UndoFileSeq().FileName(pos), error_code)};
         if (removed_blockfile || removed_undofile) {
@@ -605,18 +845,58 @@ FlatFileSeq BlockManager::UndoFileSeq() const {
 
 FILE *BlockManager::OpenBlockFile(const FlatFilePos &pos,
                                   bool fReadOnly) const {
+    if (fReadOnly) {
+        m_block_writer.WaitForWrites(pos, /*undo=*/false);
+    }
     return BlockFileSeq().Open(pos, fReadOnly);
 }
 
 /** Open an undo file (rev?????.dat) */
 FILE *BlockManager::OpenUndoFile(const FlatFilePos &pos, bool fReadOnly) const {
+    if (fReadOnly) {
+        m_block_writer.WaitForWrites(pos, /*undo=*/true);
+    }
     return UndoFileSeq().Open(pos, fReadOnly);
 }
 
+std::shared_ptr<const MappedFile>
+BlockManager::GetMappedFile(const FlatFilePos &pos, bool undo) const {
+    size_t length;
+    {
+        LOCK(cs_LastBlockFile);
+        if (pos.nFile < 0 || pos.nFile == m_last_blockfile ||
+            size_t(pos.nFile) >= m_blockfile_info.size()) {
+            return nullptr;
+        }
+        // Only map what has been written: the file is truncated to that size
+        // when it is finalized, and it must not shrink under the mapping.
+        const CBlockFileInfo &info{m_blockfile_info[pos.nFile]};
+        length = undo ? info.nUndoSize : info.nSize;
+    }
+    if (pos.nPos >= length) {
+        return nullptr;
+    }
+    // Undo data is still written to the files before the last one.
+    m_block_writer.WaitForWrites(FlatFilePos(pos.nFile, length), undo);
+    auto mapping{(undo ? m_undo_file_mappings : m_block_file_mappings)
+                     .Get(pos.nFile, length)};
+    // The callers read from pos onward, which must be inside the mapping. If
+    // it is not, they read through the file, which reports the error.
+    if (!mapping || pos.nPos >= mapping->Data().size()) {
+        return nullptr;
+    }
+    return mapping;
+}
+
 fs::path BlockManager::GetBlockPosFilename(const FlatFilePos &pos) const {
     return BlockFileSeq().FileName(pos);
 }
 
+bool BlockManager::BlockFileExists(const FlatFilePos &pos) const {
+    return fs::exists(BlockFileSeq().FileName(pos)) ||
+           fs::exists(BlockFileSeq().CompressedFileName(pos));
+}
+
 bool BlockManager::FindBlockPos(FlatFilePos &pos, unsigned int nAddSize,
                                 unsigned int nHeight, CChain &active_chain,
                                 uint64_t nTime, bool fKnown) {
@@ -721,26 +1001,22 @@ bool BlockManager::FindUndoPos(BlockValidationState &state, int nFile,
 
 bool BlockManager::WriteBlockToDisk(
     const CBlock &block, FlatFilePos &pos,
-    const CMessageHeader::MessageMagic &messageStart) const {
-    // Open history file to append
-    CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull()) {
-        return error("WriteBlockToDisk: OpenBlockFile failed");
-    }
+    const CMessageHeader::MessageMagic &messageStart) {
+    std::vector<uint8_t> data{m_block_writer.GetBuffer()};
+    CVectorWriter fileout(SER_DISK, CLIENT_VERSION, data, 0);
 
     // Write index header
     unsigned int nSize = GetSerializeSize(block, fileout.GetVersion());
     fileout << messageStart << nSize;
 
     // Write block
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0) {
-        return error("WriteBlockToDisk: ftell failed");
-    }
-
-    pos.nPos = (unsigned int)fileOutPos;
+    const FlatFilePos header_pos{pos};
+    pos.nPos += data.size();
     fileout << block;
 
+    if (!m_block_writer.Write(header_pos, /*undo=*/false, std::move(data))) {
+        return error("WriteBlockToDisk: Write failed");
+    }
     return true;
 }
 
@@ -785,16 +1061,22 @@ bool BlockManager::ReadBlockFromDisk(CBlock &block,
                                      const FlatFilePos &pos) const {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s",
-                     pos.ToString());
-    }
-
     // Read block
     try {
-        filein >> block;
+        if (const auto mapping{GetMappedFile(pos, /*undo=*/false)}) {
+            SpanReader filein{SER_DISK, CLIENT_VERSION,
+                              mapping->Data().subspan(pos.nPos)};
+            filein >> block;
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK,
+                             CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("ReadBlockFromDisk: OpenBlockFile failed for %s",
+                             pos.ToString());
+            }
+            filein >> block;
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
@@ -826,20 +1108,76 @@ bool BlockManager::ReadBlockFromDisk(CBlock &block,
     return true;
 }
 
+bool BlockManager::ReadRawFromDisk(std::vector<uint8_t> &data,
+                                   const FlatFilePos &pos, bool undo) const {
+    if (pos.IsNull() || pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) {
+        return error("%s: invalid position %s", __func__, pos.ToString());
+    }
+    // The size of the data is written right before it
+    const FlatFilePos size_pos{pos.nFile,
+                               pos.nPos - (unsigned int)sizeof(uint32_t)};
+    const auto read = [&](auto &filein) {
+        uint32_t size;
+        filein >> size;
+        if (size > MAX_BLOCKFILE_SIZE) {
+            throw std::ios_base::failure(strprintf("invalid size %u", size));
+        }
+        data.resize(size);
+        filein.read(MakeWritableByteSpan(data));
+    };
+    try {
+        if (const auto mapping{GetMappedFile(pos, undo)}) {
+            SpanReader filein{SER_DISK, CLIENT_VERSION,
+                              mapping->Data().subspan(size_pos.nPos)};
+            read(filein);
+        } else {
+            CAutoFile filein(undo ? OpenUndoFile(size_pos, true)
+                                  : OpenBlockFile(size_pos, true),
+                             SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("%s: failed to open file for %s", __func__,
+                             pos.ToString());
+            }
+            read(filein);
+        }
+    } catch (const std::exception &e) {
+        return error("%s: I/O error - %s at %s", __func__, e.what(),
+                     pos.ToString());
+    }
+    return true;
+}
+
+bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                                        const FlatFilePos &pos) const {
+    return ReadRawFromDisk(block, pos, /*undo=*/false);
+}
+
+bool BlockManager::ReadRawUndoFromDisk(std::vector<uint8_t> &undo,
+                                       const FlatFilePos &pos) const {
+    return ReadRawFromDisk(undo, pos, /*undo=*/true);
+}
+
 bool BlockManager::ReadBlockHeaderFromDisk(CBlockHeader &header,
                                            const FlatFilePos &pos) const {
     header.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockHeaderFromDisk: OpenBlockFile failed for %s",
-                     pos.ToString());
-    }
-
     // Read header
     try {
-        filein >> header;
+        if (const auto mapping{GetMappedFile(pos, /*undo=*/false)}) {
+            SpanReader filein{SER_DISK, CLIENT_VERSION,
+                              mapping->Data().subspan(pos.nPos)};
+            filein >> header;
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK,
+                             CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error(
+                    "ReadBlockHeaderFromDisk: OpenBlockFile failed for %s",
+                    pos.ToString());
+            }
+            filein >> header;
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
@@ -873,16 +1211,54 @@ bool BlockManager::ReadBlockHeaderFromDisk(CBlockHeader &header,
 
 bool BlockManager::ReadTxFromDisk(CMutableTransaction &tx,
                                   const FlatFilePos &pos) const {
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadTxFromDisk: OpenBlockFile failed for %s",
-                     pos.ToString());
+    // Read tx
+    try {
+        if (const auto mapping{GetMappedFile(pos, /*undo=*/false)}) {
+            SpanReader filein{SER_DISK, CLIENT_VERSION,
+                              mapping->Data().subspan(pos.nPos)};
+            filein >> tx;
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK,
+                             CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("ReadTxFromDisk: OpenBlockFile failed for %s",
+                             pos.ToString());
+            }
+            filein >> tx;
+        }
+    } catch (const std::exception &e) {
+        return error("%s: Deserialize or I/O error - %s at %s", __func__,
+                     e.what(), pos.ToString());
     }
 
-    // Read tx
+    return true;
+}
+
+bool BlockManager::ReadTxFromDisk(CBlockHeader &header, CTransactionRef &tx,
+                                  const FlatFilePos &pos,
+                                  unsigned int tx_offset) const {
     try {
-        filein >> tx;
+        if (const auto mapping{GetMappedFile(pos, /*undo=*/false)}) {
+            SpanReader filein{SER_DISK, CLIENT_VERSION,
+                              mapping->Data().subspan(pos.nPos)};
+            filein >> header;
+            filein.ignore(tx_offset);
+            filein >> tx;
+        } else {
+            // Open history file to read
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK,
+                             CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("ReadTxFromDisk: OpenBlockFile failed for %s",
+                             pos.ToString());
+            }
+            filein >> header;
+            if (fseek(filein.Get(), tx_offset, SEEK_CUR)) {
+                return error("%s: fseek(...) failed", __func__);
+            }
+            filein >> tx;
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
@@ -893,16 +1269,22 @@ bool BlockManager::ReadTxFromDisk(CMutableTransaction &tx,
 
 bool BlockManager::ReadTxUndoFromDisk(CTxUndo &tx_undo,
                                       const FlatFilePos &pos) const {
-    // Open undo file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadTxUndoFromDisk: OpenUndoFile failed for %s",
-                     pos.ToString());
-    }
-
     // Read undo data
     try {
-        filein >> tx_undo;
+        if (const auto mapping{GetMappedFile(pos, /*undo=*/true)}) {
+            SpanReader filein{SER_DISK, CLIENT_VERSION,
+                              mapping->Data().subspan(pos.nPos)};
+            filein >> tx_undo;
+        } else {
+            // Open undo file to read
+            CAutoFile filein(OpenUndoFile(pos, true), SER_DISK,
+                             CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("ReadTxUndoFromDisk: OpenUndoFile failed for %s",
+                             pos.ToString());
+            }
+            filein >> tx_undo;
+        }
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
@@ -911,6 +1293,140 @@ bool BlockManager::ReadTxUndoFromDisk(CTxUndo &tx_undo,
     return true;
 }
 
+template <typename T>
+bool BlockManager::ReadBatchFromDisk(std::vector<T> &items,
+                                     const std::vector<FlatFilePos> &positions,
+                                     bool undo) const {
+    items.assign(positions.size(), T{});
+
+    std::vector<size_t> order(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::make_pair(positions[a].nFile, positions[a].nPos) <
+               std::make_pair(positions[b].nFile, positions[b].nPos);
+    });
+
+    auto it = order.begin();
+    try {
+        while (it != order.end()) {
+            const int file{positions[*it].nFile};
+            const auto file_end{
+                std::find_if(it, order.end(), [&](size_t i) {
+                    return positions[i].nFile != file;
+                })};
+            // A mapping that reaches the last position covers all the others.
+            if (const auto mapping{
+                    GetMappedFile(positions[*std::prev(file_end)], undo)}) {
+                for (; it != file_end; ++it) {
+                    SpanReader filein{SER_DISK, CLIENT_VERSION,
+                                      mapping->Data().subspan(
+                                          positions[*it].nPos)};
+                    filein >> items[*it];
+                }
+                continue;
+            }
+            // Opened at the last position, which waits for everything before
+            // it to be written.
+            const FlatFilePos &last_pos{positions[*std::prev(file_end)]};
+            CAutoFile filein(undo ? OpenUndoFile(last_pos, true)
+                                  : OpenBlockFile(last_pos, true),
+                             SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull()) {
+                return error("%s: Open failed for %s", __func__,
+                             positions[*it].ToString());
+            }
+            for (; it != file_end; ++it) {
+                if (std::fseek(filein.Get(), positions[*it].nPos, SEEK_SET)) {
+                    return error("%s: fseek(...) failed for %s", __func__,
+                                 positions[*it].ToString());
+                }
+                filein >> items[*it];
+            }
+        }
+    } catch (const std::exception &e) {
+        return error("%s: Deserialize or I/O error - %s at %s", __func__,
+                     e.what(), positions[*it].ToString());
+    }
+
+    return true;
+}
+
+bool BlockManager::ReadTxsFromDisk(
+    std::vector<CMutableTransaction> &txs,
+    const std::vector<FlatFilePos> &positions) const {
+    return ReadBatchFromDisk(txs, positions, /*undo=*/false);
+}
+
+bool BlockManager::ReadTxUndosFromDisk(
+    std::vector<CTxUndo> &tx_undos,
+    const std::vector<FlatFilePos> &positions) const {
+    return ReadBatchFromDisk(tx_undos, positions, /*undo=*/true);
+}
+
+bool BlockManager::CompressBlockFile(int file) {
+    const FlatFilePos pos{file, 0};
+    unsigned int size;
+    {
+        LOCK(cs_LastBlockFile);
+        if (file < 0 || file >= m_last_blockfile) {
+            return false;
+        }
+        size = m_blockfile_info[file].nSize;
+    }
+    // Pruned, or compressed already
+    if (size == 0 || !fs::exists(BlockFileSeq().FileName(pos))) {
+        return false;
+    }
+
+    if (!BlockFileSeq().Compress(FlatFilePos(file, size))) {
+        return false;
+    }
+
+    std::error_code error_code;
+    LOCK(cs_LastBlockFile);
+    if (m_blockfile_info[file].nSize == 0) {
+        // The file was pruned while it was being compressed.
+        fs::remove(BlockFileSeq().CompressedFileName(pos), error_code);
+        return false;
+    }
+    m_block_file_mappings.Erase(file);
+    fs::remove(BlockFileSeq().FileName(pos), error_code);
+    LogPrint(BCLog::BLOCKSTORE, "Compressed block file %05u: %u -> %u bytes\n",
+             file, size,
+             fs::file_size(BlockFileSeq().CompressedFileName(pos), error_code));
+    return true;
+}
+
+void BlockManager::ThreadCompressBlockFiles() {
+    int file{0};
+    while (!m_compression_interrupt) {
+        // Reindexing writes to the block files out of order.
+        if (LoadingBlocks() ||
+            file >= WITH_LOCK(cs_LastBlockFile, return m_last_blockfile)) {
+            m_compression_interrupt.sleep_for(std::chrono::seconds{10});
+            continue;
+        }
+        CompressBlockFile(file++);
+    }
+}
+
+void BlockManager::StartBlockFileCompression() {
+    if (!m_opts.compress_block_files || m_compression_thread.joinable()) {
+        return;
+    }
+    m_compression_interrupt.reset();
+    m_compression_thread =
+        std::thread(&util::TraceThread, "blkcompress",
+                    [this] { ThreadCompressBlockFiles(); });
+}
+
+void BlockManager::StopBlockFileCompression() {
+    if (m_compression_thread.joinable()) {
+        m_compression_interrupt();
+        m_compression_thread.join();
+    }
+}
+
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock &block, int nHeight,
                                           CChain &active_chain,
                                           const FlatFilePos *dbp) {
@@ -975,7 +1491,7 @@ void ThreadImport(ChainstateManager &chainman,
             std::multimap<BlockHash, FlatFilePos> blocks_with_unknown_parent;
             while (true) {
                 FlatFilePos pos(nFile, 0);
-                if (!fs::exists(chainman.m_blockman.GetBlockPosFilename(pos))) {
+                if (!chainman.m_blockman.BlockFileExists(pos)) {
                     // No block files left to reindex
                     break;
                 }
@@ -5,16 +5,25 @@
 #ifndef BITCOIN_NODE_BLOCKSTORAGE_H
 #define BITCOIN_NODE_BLOCKSTORAGE_H
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include <set>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <chain.h>
 #include <chainparams.h>
+#include <flatfile.h>
 #include <kernel/blockmanager_opts.h>
 #include <kernel/cs_main.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 #include <sync.h>
+#include <threadinterrupt.h>
 #include <txdb.h>
 #include <util/fs.h>
 
@@ -46,6 +55,10 @@ static constexpr unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
 static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 /** The maximum size of a blk?????.dat file (since 0.8) */
 static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
+/** Maximum number of block files, and of undo files, kept memory mapped */
+static constexpr size_t MAX_MAPPED_BLOCK_FILES{64};
+/** Maximum size of the block and undo data waiting to be written to disk */
+static constexpr size_t MAX_BLOCK_WRITER_QUEUE_SIZE{64 << 20};
 
 /** Size of header written by WriteBlockToDisk before a serialized CBlock */
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE =
@@ -64,6 +77,88 @@ struct PruneLockInfo {
     int height_first{std::numeric_limits<int>::max()};
 };
 
+/**
+ * Writes the serialized blocks and undo data to the block and undo files on a
+ * dedicated thread, so that validation doesn't wait for the disk. Until the
+ * thread is started, or after it is stopped, the data is written right away.
+ *
+ * The writes are queued in the order their positions were allocated, and the
+ * queue is bounded by size. Each batch taken from the queue is written file by
+ * file in position order, which makes for large sequential writes.
+ */
+class BlockFileWriter {
+public:
+    BlockFileWriter(FlatFileSeq block_seq, FlatFileSeq undo_seq,
+                    size_t max_queue_size)
+        : m_block_seq(std::move(block_seq)), m_undo_seq(std::move(undo_seq)),
+          m_max_queue_size(max_queue_size) {}
+    ~BlockFileWriter() { Stop(); }
+
+    /** Get an empty buffer to serialize the data to write into. */
+    std::vector<uint8_t> GetBuffer() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Write @p data at @p pos of the block or undo file. With the thread
+     * running, this only waits for room in the queue. Returns false if this
+     * write, or an earlier one, failed.
+     */
+    bool Write(const FlatFilePos &pos, bool undo, std::vector<uint8_t> data)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait until all the data queued to be written to the file before
+     * @p pos has been written, so that it can be read.
+     */
+    void WaitForWrites(const FlatFilePos &pos, bool undo) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Wait until the queue is empty, and commit the files written to since the
+     * last call to disk. Returns false if anything failed since the start.
+     */
+    bool Flush() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    void Start() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Write what is left in the queue and stop the thread. */
+    void Stop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    struct PendingWrite {
+        FlatFilePos pos;
+        bool undo;
+        std::vector<uint8_t> data;
+    };
+
+    FlatFileSeq m_block_seq;
+    FlatFileSeq m_undo_seq;
+    const size_t m_max_queue_size;
+
+    mutable Mutex m_mutex;
+    mutable std::condition_variable m_cv;
+    std::deque<PendingWrite> m_queue GUARDED_BY(m_mutex);
+    //! Positions of the writes taken from the queue by the thread
+    std::vector<std::pair<FlatFilePos, bool>> m_writing GUARDED_BY(m_mutex);
+    //! Size of the data in the queue and being written
+    size_t m_queue_size GUARDED_BY(m_mutex){0};
+    //! Number of writes in the queue and being written, so that readers
+    //! don't need to take the lock when there are none.
+    std::atomic<size_t> m_num_pending{0};
+    //! Buffers of the completed writes, for reuse
+    std::vector<std::vector<uint8_t>> m_free_buffers GUARDED_BY(m_mutex);
+    size_t m_free_buffers_size GUARDED_BY(m_mutex){0};
+    //! Files written to since the last Flush(), and whether they are undo
+    //! files
+    std::set<std::pair<int, bool>> m_unsynced_files GUARDED_BY(m_mutex);
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_running GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+
+    bool WriteBatch(std::vector<PendingWrite> &batch);
+    void FinishBatch(std::vector<PendingWrite> &batch, bool success)
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void ThreadWrite() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
 /**
  * Maintains a tree of blocks (stored in `m_block_index`) which is consulted
  * to determine where the most-work tip is.
@@ -99,13 +194,15 @@ private:
 
     FILE *OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false) const;
 
-    bool
-    WriteBlockToDisk(const CBlock &block, FlatFilePos &pos,
-                     const CMessageHeader::MessageMagic &messageStart) const;
-    bool
-    UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
-                    const BlockHash &hashBlock,
-                    const CMessageHeader::MessageMagic &messageStart) const;
+    /**
+     * Serialize a block and queue it to be written by the block writer.
+     * @p pos is updated to point at the block data, after its header.
+     */
+    bool WriteBlockToDisk(const CBlock &block, FlatFilePos &pos,
+                          const CMessageHeader::MessageMagic &messageStart);
+    bool UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
+                         const BlockHash &hashBlock,
+                         const CMessageHeader::MessageMagic &messageStart);
 
     /**
      * Calculate the block/rev files to delete based on height specified
@@ -139,7 +236,7 @@ private:
                           uint64_t nPruneAfterHeight, int chain_tip_height,
                           int prune_height, bool is_ibd);
 
-    RecursiveMutex cs_LastBlockFile;
+    mutable RecursiveMutex cs_LastBlockFile;
     std::vector<CBlockFileInfo> m_blockfile_info;
     int m_last_blockfile = 0;
     /**
@@ -169,11 +266,51 @@ private:
 
     const kernel::BlockManagerOpts m_opts;
 
+    //! Read-only mappings of the block and undo files that are no longer
+    //! appended to, so reading from them doesn't need to open the file.
+    mutable FlatFileMappings m_block_file_mappings{BlockFileSeq(),
+                                                   MAX_MAPPED_BLOCK_FILES};
+    mutable FlatFileMappings m_undo_file_mappings{UndoFileSeq(),
+                                                  MAX_MAPPED_BLOCK_FILES};
+
+    //! Writes the block and undo data, see StartBlockWriter()
+    BlockFileWriter m_block_writer{BlockFileSeq(), UndoFileSeq(),
+                                   MAX_BLOCK_WRITER_QUEUE_SIZE};
+
+    /**
+     * Get the mapping of the block or undo file a position points to, or
+     * nullptr if the file is still being written to, can't be mapped or does
+     * not reach the position.
+     */
+    std::shared_ptr<const MappedFile> GetMappedFile(const FlatFilePos &pos,
+                                                    bool undo) const;
+
+    /**
+     * Read the data stored at a position of the block or undo files, as
+     * written after its size.
+     */
+    bool ReadRawFromDisk(std::vector<uint8_t> &data, const FlatFilePos &pos,
+                         bool undo) const;
+
+    /** Read objects of type T at many positions of the block or undo files. */
+    template <typename T>
+    bool ReadBatchFromDisk(std::vector<T> &items,
+                           const std::vector<FlatFilePos> &positions,
+                           bool undo) const;
+
+    //! Background compression of the block files, see
+    //! StartBlockFileCompression()
+    std::thread m_compression_thread;
+    CThreadInterrupt m_compression_interrupt;
+
+    void ThreadCompressBlockFiles() EXCLUSIVE_LOCKS_REQUIRED(!cs_LastBlockFile);
+
 public:
     using Options = kernel::BlockManagerOpts;
 
     explicit BlockManager(Options opts)
         : m_prune_mode{opts.prune_target > 0}, m_opts{std::move(opts)} {};
+    ~BlockManager() { StopBlockFileCompression(); }
 
     std::atomic<bool> m_importing{false};
 
@@ -279,6 +416,9 @@ public:
     /** Translation to a filesystem path. */
     fs::path GetBlockPosFilename(const FlatFilePos &pos) const;
 
+    /** Whether the block file exists, compressed or not. */
+    bool BlockFileExists(const FlatFilePos &pos) const;
+
     /**
      *  Actually unlink the specified files
      */
@@ -293,12 +433,60 @@ public:
                                  const CBlockIndex &index) const;
     bool UndoReadFromDisk(CBlockUndo &blockundo,
                           const CBlockIndex &index) const;
+    /**
+     * Read a serialized block, or the serialized undo data of a block, as
+     * stored on disk. The data is neither deserialized nor checked.
+     */
+    bool ReadRawBlockFromDisk(std::vector<uint8_t> &block,
+                              const FlatFilePos &pos) const;
+    bool ReadRawUndoFromDisk(std::vector<uint8_t> &undo,
+                             const FlatFilePos &pos) const;
 
     /** Functions for disk access for txs */
     bool ReadTxFromDisk(CMutableTransaction &tx, const FlatFilePos &pos) const;
+    /**
+     * Read the header of the block at @p pos and the transaction @p tx_offset
+     * bytes after the end of the header.
+     */
+    bool ReadTxFromDisk(CBlockHeader &header, CTransactionRef &tx,
+                        const FlatFilePos &pos, unsigned int tx_offset) const;
     bool ReadTxUndoFromDisk(CTxUndo &tx, const FlatFilePos &pos) const;
+    /**
+     * Read the transactions (or transaction undo data) at many positions at
+     * once. The positions are visited in file order, so each file is mapped or
+     * opened only once and read front to back. The results are in the order
+     * of @p positions.
+     */
+    bool ReadTxsFromDisk(std::vector<CMutableTransaction> &txs,
+                         const std::vector<FlatFilePos> &positions) const;
+    bool ReadTxUndosFromDisk(std::vector<CTxUndo> &tx_undos,
+                             const std::vector<FlatFilePos> &positions) const;
 
     void CleanupBlockRevFiles() const;
+
+    /**
+     * Replace a block file that is no longer written to by its compressed
+     * version. Reading from the file keeps working as before, only slower.
+     */
+    bool CompressBlockFile(int file)
+        EXCLUSIVE_LOCKS_REQUIRED(!cs_LastBlockFile);
+
+    /**
+     * If enabled with -blockcompression, start compressing the block files
+     * that are no longer written to in the background, oldest first. The
+     * files written from then on are compressed as soon as the next file is
+     * started.
+     */
+    void StartBlockFileCompression();
+    void StopBlockFileCompression();
+
+    /**
+     * Write the blocks and undo data on a dedicated thread from now on, rather
+     * than on the thread that stores them. Reading them, or flushing the
+     * block files, waits for the data to be written.
+     */
+    void StartBlockWriter() { m_block_writer.Start(); }
+    void StopBlockWriter() { m_block_writer.Stop(); }
 };
 
 void ThreadImport(ChainstateManager &chainman,
@@ -5,6 +5,7 @@
 #include <node/caches.h>
 
 #include <common/args.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
 #include <txdb.h>
 
@@ -26,6 +27,11 @@ CacheSizes CalculateCacheSizes(const ArgsManager &args, size_t n_indexes) {
                                       ? MAX_TX_INDEX_CACHE_MB << 20
                                       : 0);
     nTotalCache -= sizes.tx_index;
+    sizes.address_index = std::min(
+        nTotalCache / 8, args.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX)
+                             ? MAX_ADDRESS_INDEX_CACHE_MB << 20
+                             : 0);
+    nTotalCache -= sizes.address_index;
     sizes.filter_index = 0;
 
     if (n_indexes > 0) {
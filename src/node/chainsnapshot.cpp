@@ -0,0 +1,128 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/chainsnapshot.h>
+
+#include <chain.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <utility>
+
+namespace node {
+
+static bool CompareByHash(const CBlockIndex *a, const CBlockIndex *b) {
+    return a->GetBlockHash() < b->GetBlockHash();
+}
+
+ChainSnapshot::ChainSnapshot()
+    : m_shards(NUM_SHARDS, std::make_shared<const Shard>()) {}
+
+ChainSnapshot::ChainSnapshot(const CChain &chain, const ChainSnapshot &prev)
+    : m_height(chain.Height()), m_shards(prev.m_shards) {
+    // Find the last block both chains have in common
+    int fork{std::min(m_height, prev.m_height)};
+    while (fork >= 0 && prev[fork] != chain[fork]) {
+        --fork;
+    }
+
+    // The chunks below the fork are unchanged, the others are rebuilt
+    const size_t num_chunks = (m_height + CHUNK_SIZE) / CHUNK_SIZE;
+    const size_t first_changed = (fork + 1) / CHUNK_SIZE;
+    m_chunks.reserve(num_chunks);
+    m_chunks.insert(m_chunks.end(), prev.m_chunks.begin(),
+                    prev.m_chunks.begin() +
+                        std::min(first_changed, num_chunks));
+    for (size_t i = m_chunks.size(); i < num_chunks; ++i) {
+        const int begin = i * CHUNK_SIZE;
+        const int end = std::min(m_height + 1, begin + CHUNK_SIZE);
+        auto chunk = std::make_shared<Chunk>();
+        chunk->reserve(end - begin);
+        for (int height = begin; height < end; ++height) {
+            chunk->push_back(chain[height]);
+        }
+        m_chunks.push_back(std::move(chunk));
+    }
+
+    // Update the shards of the blocks that left or joined the chain
+    struct ShardChanges {
+        std::vector<const CBlockIndex *> removed;
+        std::vector<const CBlockIndex *> added;
+    };
+    std::map<size_t, ShardChanges> changes;
+    for (int height = fork + 1; height <= prev.m_height; ++height) {
+        const CBlockIndex *pindex = prev[height];
+        changes[GetShardIndex(pindex->GetBlockHash())].removed.push_back(
+            pindex);
+    }
+    for (int height = fork + 1; height <= m_height; ++height) {
+        const CBlockIndex *pindex = chain[height];
+        changes[GetShardIndex(pindex->GetBlockHash())].added.push_back(pindex);
+    }
+    for (auto &[index, shard_changes] : changes) {
+        auto &[removed, added] = shard_changes;
+        const Shard &old_shard = *m_shards[index];
+        std::sort(removed.begin(), removed.end());
+        std::sort(added.begin(), added.end(), CompareByHash);
+
+        Shard kept;
+        kept.reserve(old_shard.size());
+        std::copy_if(old_shard.begin(), old_shard.end(),
+                     std::back_inserter(kept), [&](const CBlockIndex *pindex) {
+                         return !std::binary_search(removed.begin(),
+                                                    removed.end(), pindex);
+                     });
+        auto shard = std::make_shared<Shard>();
+        shard->reserve(kept.size() + added.size());
+        std::merge(kept.begin(), kept.end(), added.begin(), added.end(),
+                   std::back_inserter(*shard), CompareByHash);
+        m_shards[index] = std::move(shard);
+    }
+}
+
+bool ChainSnapshot::Contains(const CBlockIndex *pindex) const {
+    return (*this)[pindex->nHeight] == pindex;
+}
+
+const CBlockIndex *ChainSnapshot::Find(const BlockHash &hash) const {
+    const Shard &shard = *m_shards[GetShardIndex(hash)];
+    auto it = std::lower_bound(
+        shard.begin(), shard.end(), hash,
+        [](const CBlockIndex *pindex, const BlockHash &key) {
+            return pindex->GetBlockHash() < key;
+        });
+    if (it == shard.end() || (*it)->GetBlockHash() != hash) {
+        return nullptr;
+    }
+    return *it;
+}
+
+ChainSnapshotPublisher::ChainSnapshotPublisher()
+    : m_snapshot(ChainSnapshotRef::make().release()) {}
+
+ChainSnapshotPublisher::~ChainSnapshotPublisher() {
+    const ChainSnapshot *last = m_snapshot.exchange(nullptr);
+    ChainSnapshotRef::acquire(last);
+    // Free it now rather than with the next cleanups of this thread
+    RCULock::synchronize();
+}
+
+void ChainSnapshotPublisher::Publish(const CChain &chain) {
+    RCULock lock;
+    // There is a single publisher, so the current snapshot cannot be freed
+    // while the new one is built from it.
+    const ChainSnapshot *next =
+        ChainSnapshotRef::make(chain, *m_snapshot.load()).release();
+    const ChainSnapshot *prev = m_snapshot.exchange(next);
+    // Freed once no reader can be using it anymore
+    ChainSnapshotRef::acquire(prev);
+}
+
+ChainSnapshotRef ChainSnapshotPublisher::Get() const {
+    RCULock lock;
+    return ChainSnapshotRef::copy(m_snapshot.load());
+}
+
+} // namespace node
@@ -0,0 +1,102 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_CHAINSNAPSHOT_H
+#define BITCOIN_NODE_CHAINSNAPSHOT_H
+
+#include <primitives/blockhash.h>
+#include <rcu.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class CBlockIndex;
+class CChain;
+
+namespace node {
+
+/**
+ * Immutable view of a chain: its blocks by height, and a lookup of its blocks
+ * by hash. It is published through RCU so the chain can be queried without
+ * holding cs_main.
+ *
+ * Consecutive snapshots share the parts of the chain that did not change, so
+ * publishing a new snapshot after a tip change only copies a few thousand
+ * entries regardless of the chain height.
+ */
+class ChainSnapshot {
+    IMPLEMENT_RCU_REFCOUNT(uint64_t);
+
+    static constexpr int CHUNK_SIZE{4096};
+    static constexpr size_t NUM_SHARDS{1024};
+
+    //! CHUNK_SIZE consecutive blocks of the chain, the last chunk may be
+    //! shorter
+    using Chunk = std::vector<const CBlockIndex *>;
+    //! The blocks of the chain in a shard, sorted by hash
+    using Shard = std::vector<const CBlockIndex *>;
+
+    int m_height{-1};
+    std::vector<std::shared_ptr<const Chunk>> m_chunks;
+    std::vector<std::shared_ptr<const Shard>> m_shards;
+
+    static size_t GetShardIndex(const BlockHash &hash) {
+        return hash.GetUint64(0) % NUM_SHARDS;
+    }
+
+public:
+    /** Snapshot of an empty chain */
+    ChainSnapshot();
+
+    /**
+     * Snapshot of the chain, sharing its unchanged parts with the previous
+     * snapshot.
+     */
+    ChainSnapshot(const CChain &chain, const ChainSnapshot &prev);
+
+    int Height() const { return m_height; }
+
+    const CBlockIndex *Tip() const { return (*this)[m_height]; }
+
+    const CBlockIndex *operator[](int height) const {
+        if (height < 0 || height > m_height) {
+            return nullptr;
+        }
+        return (*m_chunks[height / CHUNK_SIZE])[height % CHUNK_SIZE];
+    }
+
+    bool Contains(const CBlockIndex *pindex) const;
+
+    /** The block of the chain with this hash, or nullptr if there is none */
+    const CBlockIndex *Find(const BlockHash &hash) const;
+};
+
+using ChainSnapshotRef = RCUPtr<const ChainSnapshot>;
+
+/**
+ * Holds the latest snapshot of a chain. Readers get it without locking, the
+ * snapshots are published by a single thread at a time.
+ */
+class ChainSnapshotPublisher {
+    std::atomic<const ChainSnapshot *> m_snapshot;
+
+public:
+    ChainSnapshotPublisher();
+    ~ChainSnapshotPublisher();
+
+    ChainSnapshotPublisher(const ChainSnapshotPublisher &) = delete;
+    ChainSnapshotPublisher &operator=(const ChainSnapshotPublisher &) = delete;
+
+    /** Replace the snapshot with one of the current state of the chain */
+    void Publish(const CChain &chain);
+
+    ChainSnapshotRef Get() const;
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_CHAINSNAPSHOT_H
@@ -51,6 +51,8 @@ ApplyArgsManOptions(const ArgsManager &args, ChainstateManager::Options &opts) {
     ReadDatabaseArgs(args, opts.block_tree_db);
     ReadDatabaseArgs(args, opts.coins_db);
     ReadCoinsViewArgs(args, opts.coins_view);
+    opts.incremental_coins_flush = args.GetBoolArg(
+        "-incrementalcoinsflush", opts.incremental_coins_flush);
 
     if (auto value{args.GetBoolArg("-persistrecentheaderstime")}) {
         opts.store_recent_headers_time = *value;
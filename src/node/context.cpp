@@ -8,6 +8,7 @@
 #include <avalanche/processor.h>
 #include <banman.h>
 #include <interfaces/chain.h>
+#include <kernel/mempool_journal.h>
 #include <net.h>
 #include <net_processing.h>
 #include <node/kernel_notifications.h>
@@ -26,6 +26,9 @@ class WalletClient;
 namespace avalanche {
 class Processor;
 } // namespace avalanche
+namespace kernel {
+class MempoolJournal;
+} // namespace kernel
 
 namespace node {
 class KernelNotifications;
@@ -44,6 +47,7 @@ struct NodeContext {
     std::unique_ptr<AddrMan> addrman;
     std::unique_ptr<CConnman> connman;
     std::unique_ptr<CTxMemPool> mempool;
+    std::unique_ptr<kernel::MempoolJournal> mempool_journal;
     std::unique_ptr<PeerManager> peerman;
     std::unique_ptr<ChainstateManager> chainman;
     std::unique_ptr<BanMan> banman;
@@ -14,6 +14,11 @@ bool ShouldPersistMempool(const ArgsManager &argsman) {
     return argsman.GetBoolArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL);
 }
 
+bool ShouldJournalMempool(const ArgsManager &argsman) {
+    return ShouldPersistMempool(argsman) &&
+           argsman.GetBoolArg("-mempooljournal", DEFAULT_MEMPOOL_JOURNAL);
+}
+
 fs::path MempoolPath(const ArgsManager &argsman) {
     return argsman.GetDataDirNet() / "mempool.dat";
 }
@@ -16,8 +16,14 @@ namespace node {
  * automatically load the mempool on start and save to disk on shutdown
  */
 static constexpr bool DEFAULT_PERSIST_MEMPOOL{true};
+/**
+ * Default for -mempooljournal, indicating whether the changes to the mempool
+ * should be logged to disk as they happen, so they survive a crash
+ */
+static constexpr bool DEFAULT_MEMPOOL_JOURNAL{false};
 
 bool ShouldPersistMempool(const ArgsManager &argsman);
+bool ShouldJournalMempool(const ArgsManager &argsman);
 fs::path MempoolPath(const ArgsManager &argsman);
 
 } // namespace node
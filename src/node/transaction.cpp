@@ -18,6 +18,7 @@
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <functional>
 #include <future>
 
 namespace node {
@@ -126,6 +127,144 @@ TransactionError BroadcastTransaction(const NodeContext &node,
     return TransactionError::OK;
 }
 
+std::vector<TransactionError>
+BroadcastTransactions(const NodeContext &node,
+                      const std::vector<CTransactionRef> &txs,
+                      std::vector<std::string> &err_strings,
+                      const CFeeRate &max_tx_fee_rate, bool relay,
+                      bool wait_callback) {
+    assert(node.chainman);
+    assert(node.mempool);
+    assert(node.peerman);
+
+    std::vector<TransactionError> errors(txs.size(), TransactionError::OK);
+    err_strings.assign(txs.size(), "");
+
+    std::promise<void> promise;
+    bool callback_set = false;
+    std::vector<TxId> txids_to_relay;
+
+    {
+        LOCK(cs_main);
+        Chainstate &chainstate = node.chainman->ActiveChainstate();
+
+        // Indexes in txs of the transactions still to be submitted.
+        std::vector<size_t> candidates;
+        candidates.reserve(txs.size());
+        CCoinsViewCache &view = chainstate.CoinsTip();
+        for (size_t i = 0; i < txs.size(); ++i) {
+            // If the transaction is already confirmed in the chain, don't do
+            // anything with it.
+            const TxId txid = txs[i]->GetId();
+            bool in_chain = false;
+            for (size_t o = 0; o < txs[i]->vout.size() && !in_chain; o++) {
+                in_chain = !view.AccessCoin(COutPoint(txid, o)).IsSpent();
+            }
+            if (in_chain) {
+                errors[i] = TransactionError::ALREADY_IN_CHAIN;
+            } else {
+                candidates.push_back(i);
+            }
+        }
+
+        const auto candidate_txs = [&]() {
+            std::vector<CTransactionRef> candidate_txs;
+            candidate_txs.reserve(candidates.size());
+            for (const size_t i : candidates) {
+                candidate_txs.push_back(txs[i]);
+            }
+            return candidate_txs;
+        };
+        // Record the outcome of a batch validation, and only keep the
+        // candidates for which keep_candidate returns true.
+        const auto process_results =
+            [&](const PackageMempoolAcceptResult &batch_result,
+                const std::function<bool(size_t,
+                                         const MempoolAcceptResult &)>
+                    &keep_candidate) {
+                std::vector<size_t> kept;
+                for (const size_t i : candidates) {
+                    const auto it =
+                        batch_result.m_tx_results.find(txs[i]->GetId());
+                    if (it == batch_result.m_tx_results.end()) {
+                        errors[i] = TransactionError::MEMPOOL_ERROR;
+                        continue;
+                    }
+                    if (it->second.m_result_type ==
+                        MempoolAcceptResult::ResultType::INVALID) {
+                        errors[i] =
+                            HandleATMPError(it->second.m_state, err_strings[i]);
+                        continue;
+                    }
+                    if (keep_candidate(i, it->second)) {
+                        kept.push_back(i);
+                    }
+                }
+                candidates = std::move(kept);
+            };
+
+        if (max_tx_fee_rate > CFeeRate(Amount::zero())) {
+            // First, check the fees with test_accept. The children of the
+            // transactions rejected here will fail as orphans at submission.
+            process_results(
+                ProcessTransactionBatch(chainstate, *node.mempool,
+                                        candidate_txs(),
+                                        /*test_accept=*/true),
+                [&](size_t i, const MempoolAcceptResult &result) {
+                    if (result.m_result_type ==
+                            MempoolAcceptResult::ResultType::VALID &&
+                        result.m_base_fees.value() >
+                            max_tx_fee_rate.GetFee(
+                                GetVirtualTransactionSize(*txs[i]))) {
+                        errors[i] = TransactionError::MAX_FEE_EXCEEDED;
+                        return false;
+                    }
+                    return true;
+                });
+        }
+
+        // Try to submit the transactions to the mempool.
+        bool any_accepted = false;
+        process_results(
+            ProcessTransactionBatch(chainstate, *node.mempool, candidate_txs(),
+                                    /*test_accept=*/false),
+            [&](size_t i, const MempoolAcceptResult &result) {
+                const TxId txid = txs[i]->GetId();
+                if (result.m_result_type ==
+                    MempoolAcceptResult::ResultType::VALID) {
+                    any_accepted = true;
+                    if (relay) {
+                        // the mempool tracks locally submitted transactions
+                        // to make a best-effort of initial broadcast
+                        node.mempool->AddUnbroadcastTx(txid);
+                    }
+                }
+                txids_to_relay.push_back(txid);
+                return true;
+            });
+
+        if (wait_callback && any_accepted) {
+            // Make sure that the wallet and indexes have been notified of the
+            // transactions before returning, see BroadcastTransaction().
+            CallFunctionInValidationInterfaceQueue(
+                [&promise] { promise.set_value(); });
+            callback_set = true;
+        }
+    } // cs_main
+
+    if (callback_set) {
+        // Wait until Validation Interface clients have been notified of the
+        // transactions entering the mempool.
+        promise.get_future().wait();
+    }
+
+    if (relay) {
+        node.peerman->RelayTransactions(txids_to_relay);
+    }
+
+    return errors;
+}
+
 CTransactionRef GetTransaction(const CBlockIndex *const block_index,
                                const CTxMemPool *const mempool,
                                const TxId &txid, BlockHash &hashBlock,
@@ -9,6 +9,9 @@
 #include <primitives/transaction.h>
 #include <util/error.h>
 
+#include <string>
+#include <vector>
+
 struct BlockHash;
 class CBlockIndex;
 class Config;
@@ -58,6 +61,36 @@ BroadcastTransaction(const NodeContext &node, CTransactionRef tx,
                      std::string &err_string, Amount max_tx_fee, bool relay,
                      bool wait_callback);
 
+/** Maximum number of transactions submitted by a BroadcastTransactions(). */
+static constexpr size_t MAX_BROADCAST_BATCH_SIZE{1000};
+
+/**
+ * Submit a batch of transactions to the mempool and (optionally) relay the
+ * accepted ones to all P2P peers.
+ *
+ * The batch is validated with ProcessTransactionBatch() under a single
+ * cs_main lock, each transaction being accepted or rejected on its own. The
+ * transactions can depend on each other and don't need to be sorted. The
+ * same locking requirements as BroadcastTransaction() apply.
+ *
+ * @param[in]  node reference to node context
+ * @param[in]  txs the transactions to broadcast
+ * @param[out] err_strings filled with one error string (possibly empty) per
+ * transaction, in the order of txs
+ * @param[in]  max_tx_fee_rate reject txs with a fee rate higher than this (if
+ * 0, accept any fee rate)
+ * @param[in]  relay flag if both mempool insertion and p2p relay are requested
+ * @param[in]  wait_callback wait until callbacks have been processed to avoid
+ * stale result due to a sequentially RPC.
+ * @return one error per transaction, in the order of txs
+ */
+[[nodiscard]] std::vector<TransactionError>
+BroadcastTransactions(const NodeContext &node,
+                      const std::vector<CTransactionRef> &txs,
+                      std::vector<std::string> &err_strings,
+                      const CFeeRate &max_tx_fee_rate, bool relay,
+                      bool wait_callback);
+
 /**
  * Return transaction with a given txid.
  * If mempool is provided and block_index is not provided, check it first for
@@ -8,7 +8,10 @@
 #include <primitives/txid.h>
 #include <util/hasher.h>
 
+#include <functional>
 #include <numeric>
+#include <queue>
+#include <unordered_map>
 #include <unordered_set>
 
 bool CheckPackage(const Package &txns, PackageValidationState &state) {
@@ -126,6 +129,55 @@ bool IsChildWithParentsTree(const Package &package) {
         });
 }
 
+void SortPackageTopologically(Package &package) {
+    // Kahn's algorithm, always picking the first transaction (in the original
+    // order) among the ones whose parents are all sorted already.
+    std::unordered_map<TxId, size_t, SaltedTxIdHasher> index_by_txid;
+    for (size_t i = 0; i < package.size(); ++i) {
+        index_by_txid.emplace(package[i]->GetId(), i);
+    }
+
+    std::vector<size_t> num_unsorted_parents(package.size(), 0);
+    std::vector<std::vector<size_t>> children(package.size());
+    for (size_t i = 0; i < package.size(); ++i) {
+        std::unordered_set<size_t> parents;
+        for (const auto &input : package[i]->vin) {
+            const auto it = index_by_txid.find(input.prevout.GetTxId());
+            if (it != index_by_txid.end() && it->second != i &&
+                parents.insert(it->second).second) {
+                children[it->second].push_back(i);
+                ++num_unsorted_parents[i];
+            }
+        }
+    }
+
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>>
+        ready;
+    for (size_t i = 0; i < package.size(); ++i) {
+        if (num_unsorted_parents[i] == 0) {
+            ready.push(i);
+        }
+    }
+
+    Package sorted;
+    sorted.reserve(package.size());
+    while (!ready.empty()) {
+        const size_t i = ready.top();
+        ready.pop();
+        sorted.push_back(package[i]);
+        for (const size_t child : children[i]) {
+            if (--num_unsorted_parents[child] == 0) {
+                ready.push(child);
+            }
+        }
+    }
+
+    // A dependency cycle would require a hash collision, so every transaction
+    // gets sorted.
+    assert(sorted.size() == package.size());
+    package = std::move(sorted);
+}
+
 uint256 GetPackageHash(const Package &package) {
     // Create a vector of the txids.
     std::vector<TxId> txids_copy;
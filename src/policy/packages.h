@@ -67,6 +67,13 @@ bool IsChildWithParents(const Package &package);
  */
 bool IsChildWithParentsTree(const Package &package);
 
+/**
+ * Sort transactions so that parents appear before their children. The
+ * relative order of the transactions is otherwise preserved, so an already
+ * sorted package is left untouched.
+ */
+void SortPackageTopologically(Package &package);
+
 /*
  * Get the hash of these transactions' txids, concatenated in lexicographical
  * order (treating the txids as little endian encoded uint256, smallest to
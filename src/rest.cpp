@@ -8,8 +8,11 @@
 #include <config.h>
 #include <core_io.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
+#include <key_io.h>
 #include <node/blockstorage.h>
+#include <node/chainsnapshot.h>
 #include <node/context.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
@@ -22,6 +25,7 @@
 #include <sync.h>
 #include <txmempool.h>
 #include <util/any.h>
+#include <util/jsonwriter.h>
 #include <validation.h>
 #include <version.h>
 
@@ -35,6 +39,12 @@ using node::NodeContext;
 // Allow a max of 15 outpoints to be queried at once.
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15;
 
+// Maximum number of blocks, and of headers, of a range request
+static const int MAX_REST_BLOCKS_RANGE = 10000;
+static const int MAX_REST_HEADERS_RANGE = 100000;
+// Size of the parts the replies to range requests are sent in
+static const size_t REST_RANGE_CHUNK_SIZE = 1 << 20;
+
 enum class RetFormat {
     UNDEF,
     BINARY,
@@ -73,6 +83,13 @@ static bool RESTERR(HTTPRequest *req, enum HTTPStatusCode status,
     return false;
 }
 
+/** Sink sending a JSON document as the body of a successful reply */
+static JSONWriter::Sink JSONReplySink(HTTPRequest *req) {
+    return [req](std::string &&chunk, bool last) {
+        req->WriteReplyPart(HTTP_OK, std::move(chunk), last);
+    };
+}
+
 /**
  * Get the node context.
  *
@@ -220,16 +237,17 @@ static bool rest_headers(Config &config, const std::any &context,
             return false;
         }
         ChainstateManager &chainman = *maybe_chainman;
-        LOCK(cs_main);
-        CChain &active_chain = chainman.ActiveChain();
-        tip = active_chain.Tip();
-        const CBlockIndex *pindex = chainman.m_blockman.LookupBlockIndex(hash);
-        while (pindex != nullptr && active_chain.Contains(pindex)) {
+        // Only headers of the active chain are returned, so they can all be
+        // found in the snapshot without cs_main
+        const node::ChainSnapshotRef snapshot{chainman.GetChainSnapshot()};
+        tip = snapshot->Tip();
+        const CBlockIndex *pindex = snapshot->Find(hash);
+        while (pindex != nullptr) {
             headers.push_back(pindex);
             if (headers.size() == size_t(count)) {
                 break;
             }
-            pindex = active_chain.Next(pindex);
+            pindex = (*snapshot)[pindex->nHeight + 1];
         }
 
         switch (rf) {
@@ -279,6 +297,195 @@ static bool rest_headers(Config &config, const std::any &context,
     }
 }
 
+/**
+ * Parse a "<start>/<end>" range of heights, both included, of a chain of the
+ * given height.
+ */
+static bool ParseHeightRange(HTTPRequest *req,
+                             const std::vector<std::string> &path,
+                             int chain_height, int max_count, int &start,
+                             int &end) {
+    if (!ParseInt32(path[0], &start) || start < 0 ||
+        !ParseInt32(path[1], &end) || end < start) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid range: " +
+                           SanitizeString(path[0] + "/" + path[1]));
+    }
+    if (int64_t{end} - start >= max_count) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       strprintf("Range too large, max %d heights", max_count));
+    }
+    if (end > chain_height) {
+        return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+    }
+    return true;
+}
+
+static bool rest_headers_range(Config &config, const std::any &context,
+                               HTTPRequest *req,
+                               const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: .bin)");
+    }
+    const std::vector<std::string> path = SplitString(param, '/');
+    if (path.size() != 2) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid range. Use "
+                       "/rest/headers/range/<start>/<end>.bin.");
+    }
+
+    ChainstateManager *maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) {
+        return false;
+    }
+    ChainstateManager &chainman = *maybe_chainman;
+    const node::ChainSnapshotRef snapshot{chainman.GetChainSnapshot()};
+    int start, end;
+    if (!ParseHeightRange(req, path, snapshot->Height(), MAX_REST_HEADERS_RANGE,
+                          start, end)) {
+        return false;
+    }
+
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+    for (int height = start; height <= end; ++height) {
+        ssHeader << (*snapshot)[height]->GetBlockHeader(chainman.m_blockman);
+        if (ssHeader.size() >= REST_RANGE_CHUNK_SIZE) {
+            const bool more{
+                req->WriteReplyPart(HTTP_OK, ssHeader.str(), /*last=*/false)};
+            ssHeader.clear();
+            if (!more) {
+                req->AbortReply();
+                return true;
+            }
+        }
+    }
+    req->WriteReplyPart(HTTP_OK, ssHeader.str(), /*last=*/true);
+    return true;
+}
+
+static bool rest_block_range(Config &config, const std::any &context,
+                             HTTPRequest *req, const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: .bin)");
+    }
+    std::vector<std::string> path = SplitString(param, '/');
+    const bool with_undo{path.size() == 3 && path[0] == "undo"};
+    if (with_undo) {
+        path.erase(path.begin());
+    }
+    if (path.size() != 2) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid range. Use "
+                       "/rest/blocks/range/[undo/]<start>/<end>.bin.");
+    }
+
+    ChainstateManager *maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) {
+        return false;
+    }
+    ChainstateManager &chainman = *maybe_chainman;
+    const node::ChainSnapshotRef snapshot{chainman.GetChainSnapshot()};
+    int start, end;
+    if (!ParseHeightRange(req, path, snapshot->Height(), MAX_REST_BLOCKS_RANGE,
+                          start, end)) {
+        return false;
+    }
+
+    // Locate all the data first, so missing blocks are reported with an error
+    // status rather than in the middle of the reply.
+    std::vector<std::pair<FlatFilePos, FlatFilePos>> positions;
+    positions.reserve(end - start + 1);
+    {
+        LOCK(cs_main);
+        for (int height = start; height <= end; ++height) {
+            const CBlockIndex *pindex = (*snapshot)[height];
+            if (chainman.m_blockman.IsBlockPruned(pindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND,
+                               strprintf("Block at height %d not available "
+                                         "(pruned data)",
+                                         height));
+            }
+            positions.emplace_back(pindex->GetBlockPos(),
+                                   pindex->GetUndoPos());
+        }
+    }
+
+    // The blocks and undo data are sent as stored on disk, without
+    // deserializing them, back to back.
+    std::string chunk;
+    std::vector<uint8_t> data;
+    bool sent{false};
+    // Returns false if the rest of the reply is not needed anymore
+    const auto send_chunk = [&](bool last) {
+        if (!sent) {
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            sent = true;
+        }
+        const bool more{req->WriteReplyPart(HTTP_OK, std::move(chunk), last)};
+        chunk.clear();
+        return more;
+    };
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const auto &[block_pos, undo_pos] = positions[i];
+        if (!chainman.m_blockman.ReadRawBlockFromDisk(data, block_pos)) {
+            if (!sent) {
+                return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR,
+                               strprintf("Failed to read block at height %d",
+                                         start + i));
+            }
+            LogPrintf("%s: failed to read block at height %d, reply "
+                      "truncated\n",
+                      __func__, start + i);
+            req->AbortReply();
+            return true;
+        }
+        chunk.append(data.begin(), data.end());
+        if (with_undo) {
+            if (undo_pos.IsNull()) {
+                // The genesis block has no undo data: an empty CBlockUndo
+                chunk.push_back('\0');
+            } else if (!chainman.m_blockman.ReadRawUndoFromDisk(data,
+                                                                undo_pos)) {
+                if (!sent) {
+                    return RESTERR(
+                        req, HTTP_INTERNAL_SERVER_ERROR,
+                        strprintf("Failed to read undo data at height %d",
+                                  start + i));
+                }
+                LogPrintf("%s: failed to read undo data at height %d, reply "
+                          "truncated\n",
+                          __func__, start + i);
+                req->AbortReply();
+                return true;
+            } else {
+                chunk.append(data.begin(), data.end());
+            }
+        }
+        if (chunk.size() >= REST_RANGE_CHUNK_SIZE &&
+            !send_chunk(/*last=*/false)) {
+            req->AbortReply();
+            return true;
+        }
+    }
+    send_chunk(/*last=*/true);
+    return true;
+}
+
 static bool rest_block(const Config &config, const std::any &context,
                        HTTPRequest *req, const std::string &strURIPart,
                        bool showTxDetails) {
@@ -343,11 +550,11 @@ static bool rest_block(const Config &config, const std::any &context,
         }
 
         case RetFormat::JSON: {
-            UniValue objBlock = blockToJSON(chainman.m_blockman, block, tip,
-                                            pblockindex, showTxDetails);
-            std::string strJSON = objBlock.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            JSONWriter writer{JSONReplySink(req)};
+            blockToJSON(writer, chainman.m_blockman, block, tip, pblockindex,
+                        showTxDetails);
+            writer.Raw("\n").Finish();
             return true;
         }
 
@@ -446,11 +653,10 @@ static bool rest_mempool_contents(Config &config, const std::any &context,
 
     switch (rf) {
         case RetFormat::JSON: {
-            UniValue mempoolObject = MempoolToJSON(*mempool, true);
-
-            std::string strJSON = mempoolObject.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            JSONWriter writer{JSONReplySink(req)};
+            MempoolToJSON(writer, *mempool);
+            writer.Raw("\n").Finish();
             return true;
         }
         default: {
@@ -775,19 +981,18 @@ static bool rest_blockhash_by_height(Config &config, const std::any &context,
                        "Invalid height: " + SanitizeString(height_str));
     }
 
-    CBlockIndex *pblockindex = nullptr;
+    const CBlockIndex *pblockindex = nullptr;
     {
         ChainstateManager *maybe_chainman = GetChainman(context, req);
         if (!maybe_chainman) {
             return false;
         }
-        ChainstateManager &chainman = *maybe_chainman;
-        LOCK(cs_main);
-        const CChain &active_chain = chainman.ActiveChain();
-        if (blockheight > active_chain.Height()) {
+        const node::ChainSnapshotRef snapshot{
+            maybe_chainman->GetChainSnapshot()};
+        if (blockheight > snapshot->Height()) {
             return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
         }
-        pblockindex = active_chain[blockheight];
+        pblockindex = (*snapshot)[blockheight];
     }
     switch (rf) {
         case RetFormat::BINARY: {
@@ -818,6 +1023,100 @@ static bool rest_blockhash_by_height(Config &config, const std::any &context,
     }
 }
 
+enum class AddressQuery { HISTORY, UTXOS };
+
+static bool rest_address(Config &config, HTTPRequest *req,
+                         const std::string &strURIPart, AddressQuery query) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::JSON) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "output format not found (available: json)");
+    }
+    if (!g_address_index) {
+        return RESTERR(req, HTTP_NOT_FOUND,
+                       "Requires addressindex. Start with -addressindex.");
+    }
+
+    // Either <address> or <skip>/<count>/<address>
+    const std::vector<std::string> path = SplitString(param, '/');
+    int32_t skip{0};
+    int32_t count{DEFAULT_ADDRESS_QUERY_COUNT};
+    if (path.size() == 3) {
+        if (!ParseInt32(path[0], &skip) || skip < 0) {
+            return RESTERR(req, HTTP_BAD_REQUEST,
+                           "Invalid skip: " + SanitizeString(path[0]));
+        }
+        if (!ParseInt32(path[1], &count) || count < 1 ||
+            count > MAX_ADDRESS_QUERY_COUNT) {
+            return RESTERR(req, HTTP_BAD_REQUEST,
+                           strprintf("Invalid count: %s (max %d)",
+                                     SanitizeString(path[1]),
+                                     MAX_ADDRESS_QUERY_COUNT));
+        }
+    } else if (path.size() != 1) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid URI format. Expected "
+                       "[<skip>/<count>/]<address>.json");
+    }
+
+    const std::string &address = path.back();
+    const CTxDestination dest =
+        DecodeDestination(address, config.GetChainParams());
+    if (!IsValidDestination(dest)) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid address: " + SanitizeString(address));
+    }
+    const CScript script = GetScriptForDestination(dest);
+
+    if (!g_address_index->BlockUntilSyncedToCurrentChain()) {
+        return RESTERR(req, HTTP_SERVICE_UNAVAILABLE,
+                       "Address index is still syncing");
+    }
+
+    UniValue result;
+    switch (query) {
+        case AddressQuery::HISTORY: {
+            std::vector<AddressHistoryEntry> history;
+            if (!g_address_index->FindHistory(script, skip, count, history)) {
+                return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR,
+                               "Failed to read the address history");
+            }
+            result = AddressHistoryToJSON(history);
+            break;
+        }
+        case AddressQuery::UTXOS: {
+            std::vector<AddressUtxo> utxos;
+            if (!g_address_index->FindUtxos(script, skip, count, utxos)) {
+                return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR,
+                               "Failed to read the address utxos");
+            }
+            result = AddressUtxosToJSON(utxos);
+            break;
+        }
+    }
+
+    req->WriteHeader("Content-Type", "application/json");
+    req->WriteReply(HTTP_OK, result.write() + "\n");
+    return true;
+}
+
+static bool rest_address_history(Config &config, const std::any &context,
+                                 HTTPRequest *req,
+                                 const std::string &strURIPart) {
+    return rest_address(config, req, strURIPart, AddressQuery::HISTORY);
+}
+
+static bool rest_address_utxos(Config &config, const std::any &context,
+                               HTTPRequest *req,
+                               const std::string &strURIPart) {
+    return rest_address(config, req, strURIPart, AddressQuery::UTXOS);
+}
+
 static const struct {
     const char *prefix;
     bool (*handler)(Config &config, const std::any &context, HTTPRequest *req,
@@ -829,9 +1128,13 @@ static const struct {
     {"/rest/chaininfo", rest_chaininfo},
     {"/rest/mempool/info", rest_mempool_info},
     {"/rest/mempool/contents", rest_mempool_contents},
+    {"/rest/headers/range/", rest_headers_range},
     {"/rest/headers/", rest_headers},
+    {"/rest/blocks/range/", rest_block_range},
     {"/rest/getutxos", rest_getutxos},
     {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+    {"/rest/address/history/", rest_address_history},
+    {"/rest/address/utxos/", rest_address_utxos},
 };
 
 void StartREST(const std::any &context) {
@@ -840,7 +1143,11 @@ void StartREST(const std::any &context) {
                                      const std::string &prefix) {
             return up.handler(config, context, req, prefix);
         };
-        RegisterHTTPHandler(up.prefix, false, handler);
+        RegisterHTTPHandler(
+            up.prefix, false, handler,
+            [](HTTPRequest *, const std::string &) {
+                return HTTPWorkClass::REST;
+            });
     }
 }
 
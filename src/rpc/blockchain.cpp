@@ -16,12 +16,16 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <hash.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
+#include <kernel/coinstats.h>
+#include <key_io.h>
 #include <logging/timer.h>
 #include <net.h>
 #include <net_processing.h>
 #include <node/blockstorage.h>
+#include <node/chainsnapshot.h>
 #include <node/coinstats.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
@@ -36,19 +40,28 @@
 #include <undo.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/hasher.h>
+#include <util/jsonwriter.h>
 #include <util/strencodings.h>
+#include <util/threadnames.h>
 #include <util/translation.h>
 #include <validation.h>
 #include <validationinterface.h>
 #include <warnings.h>
 
+#include <algorithm>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdio>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
 
 using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
+using kernel::SerializedCoinsHasher;
 
 using node::BlockManager;
 using node::GetUTXOStats;
@@ -162,13 +175,11 @@ UniValue blockheaderToJSON(const CBlockIndex *tip,
     return result;
 }
 
-UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
-                     const CBlockIndex *tip, const CBlockIndex *blockindex,
-                     bool txDetails) {
-    UniValue result = blockheaderToJSON(tip, blockindex);
-
-    result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
-    UniValue txs(UniValue::VARR);
+/** Call fn with the JSON description of each transaction of the block */
+template <typename Fn>
+static void BlockTxsToJSON(BlockManager &blockman, const CBlock &block,
+                           const CBlockIndex *blockindex, bool txDetails,
+                           Fn &&fn) {
     if (txDetails) {
         CBlockUndo blockUndo;
         const bool is_not_pruned{
@@ -183,18 +194,42 @@ UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
             UniValue objTx(UniValue::VOBJ);
             TxToUniv(*tx, BlockHash(), objTx, true, RPCSerializationFlags(),
                      txundo);
-            txs.push_back(objTx);
+            fn(std::move(objTx));
         }
     } else {
         for (const CTransactionRef &tx : block.vtx) {
-            txs.push_back(tx->GetId().GetHex());
+            fn(UniValue(tx->GetId().GetHex()));
         }
     }
+}
+
+UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
+                     const CBlockIndex *tip, const CBlockIndex *blockindex,
+                     bool txDetails) {
+    UniValue result = blockheaderToJSON(tip, blockindex);
+
+    result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
+    UniValue txs(UniValue::VARR);
+    BlockTxsToJSON(blockman, block, blockindex, txDetails,
+                   [&](UniValue &&tx) { txs.push_back(std::move(tx)); });
     result.pushKV("tx", txs);
 
     return result;
 }
 
+void blockToJSON(JSONWriter &writer, BlockManager &blockman,
+                 const CBlock &block, const CBlockIndex *tip,
+                 const CBlockIndex *blockindex, bool txDetails) {
+    writer.BeginObject()
+        .Pairs(blockheaderToJSON(tip, blockindex))
+        .Pair("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION))
+        .Key("tx")
+        .BeginArray();
+    BlockTxsToJSON(blockman, block, blockindex, txDetails,
+                   [&](UniValue &&tx) { writer.Value(tx); });
+    writer.EndArray().EndObject();
+}
+
 static RPCHelpMan getblockcount() {
     return RPCHelpMan{
         "getblockcount",
@@ -207,8 +242,7 @@ static RPCHelpMan getblockcount() {
         [&](const RPCHelpMan &self, const Config &config,
             const JSONRPCRequest &request) -> UniValue {
             ChainstateManager &chainman = EnsureAnyChainman(request.context);
-            LOCK(cs_main);
-            return chainman.ActiveHeight();
+            return chainman.GetChainSnapshot()->Height();
         },
     };
 }
@@ -225,8 +259,7 @@ static RPCHelpMan getbestblockhash() {
         [&](const RPCHelpMan &self, const Config &config,
             const JSONRPCRequest &request) -> UniValue {
             ChainstateManager &chainman = EnsureAnyChainman(request.context);
-            LOCK(cs_main);
-            return chainman.ActiveTip()->GetBlockHash().GetHex();
+            return chainman.GetChainSnapshot()->Tip()->GetBlockHash().GetHex();
         },
     };
 }
@@ -522,16 +555,15 @@ static RPCHelpMan getblockhash() {
         [&](const RPCHelpMan &self, const Config &config,
             const JSONRPCRequest &request) -> UniValue {
             ChainstateManager &chainman = EnsureAnyChainman(request.context);
-            LOCK(cs_main);
-            const CChain &active_chain = chainman.ActiveChain();
+            const node::ChainSnapshotRef snapshot{chainman.GetChainSnapshot()};
 
             int nHeight = request.params[0].getInt<int>();
-            if (nHeight < 0 || nHeight > active_chain.Height()) {
+            if (nHeight < 0 || nHeight > snapshot->Height()) {
                 throw JSONRPCError(RPC_INVALID_PARAMETER,
                                    "Block height out of range");
             }
 
-            const CBlockIndex *pblockindex = active_chain[nHeight];
+            const CBlockIndex *pblockindex = (*snapshot)[nHeight];
             return pblockindex->GetBlockHash().GetHex();
         },
     };
@@ -606,26 +638,25 @@ static RPCHelpMan getblockheader() {
                 fVerbose = request.params[1].get_bool();
             }
 
-            const CBlockIndex *pblockindex;
-            const CBlockIndex *tip;
-            {
-                ChainstateManager &chainman =
-                    EnsureAnyChainman(request.context);
-                LOCK(cs_main);
-                pblockindex = chainman.m_blockman.LookupBlockIndex(hash);
-                tip = chainman.ActiveTip();
-
-                if (!pblockindex) {
-                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY,
-                                       "Block not found");
-                }
+            ChainstateManager &chainman = EnsureAnyChainman(request.context);
+            const node::ChainSnapshotRef snapshot{chainman.GetChainSnapshot()};
+            const CBlockIndex *tip = snapshot->Tip();
+            // Only the blocks of the active chain can be found without cs_main
+            const CBlockIndex *pblockindex = snapshot->Find(hash);
+            if (!pblockindex) {
+                pblockindex = WITH_LOCK(
+                    cs_main, return chainman.m_blockman.LookupBlockIndex(hash));
+            }
+            if (!pblockindex) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY,
+                                   "Block not found");
+            }
 
-                if (!fVerbose) {
-                    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-                    ssBlock << pblockindex->GetBlockHeader(chainman.m_blockman);
-                    std::string strHex = HexStr(ssBlock);
-                    return strHex;
-                }
+            if (!fVerbose) {
+                CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+                ssBlock << pblockindex->GetBlockHeader(chainman.m_blockman);
+                std::string strHex = HexStr(ssBlock);
+                return strHex;
             }
 
             return blockheaderToJSON(tip, pblockindex);
@@ -2192,38 +2223,199 @@ static RPCHelpMan getblockstats() {
 }
 
 namespace {
-//! Search for a given set of pubkey scripts
-static bool FindScriptPubKey(std::atomic<int> &scan_progress,
-                             const std::atomic<bool> &should_abort,
-                             int64_t &count, CCoinsViewCursor *cursor,
-                             const std::set<CScript> &needles,
-                             std::map<COutPoint, Coin> &out_results,
-                             std::function<void()> &interruption_point) {
-    scan_progress = 0;
-    count = 0;
-    while (cursor->Valid()) {
+//! Maximum number of threads scanning the UTXO set
+constexpr unsigned int MAX_SCAN_THREADS{8};
+//! The UTXO set is split into more ranges than threads, so the work stays
+//! balanced when some ranges hold more coins than others.
+constexpr size_t SCAN_RANGES_PER_THREAD{4};
+//! Progress of a range, in 1/65536 of its share of the txid space
+constexpr uint32_t SCAN_RANGE_DONE{0x10000};
+
+//! The scripts to look for, mapped to the index of the signing provider their
+//! descriptor was expanded with. Only the scripts found are inferred back to
+//! a descriptor.
+using ScanNeedles = std::unordered_map<CScript, size_t, SaltedSipHasher>;
+
+struct ScanRanges {
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    std::vector<std::atomic<uint32_t>> progress;
+    std::atomic<size_t> next_range{0};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> failed{false};
+    Mutex mutex;
+    std::condition_variable cv;
+    size_t running_threads GUARDED_BY(mutex){0};
+    //! Outputs found by the ranges and not yet reported by the calling thread
+    std::vector<std::pair<COutPoint, Coin>> results GUARDED_BY(mutex);
+
+    explicit ScanRanges(std::vector<std::unique_ptr<CCoinsViewCursor>> &&c)
+        : cursors(std::move(c)), progress(cursors.size()) {}
+
+    //! Estimate of the progress of the whole scan, in percent. The ranges
+    //! split the txid space evenly, and the txids are evenly distributed.
+    int GetProgress() const {
+        uint64_t total{0};
+        for (const auto &range_progress : progress) {
+            total += range_progress;
+        }
+        return int(total * 100.0 / (SCAN_RANGE_DONE * progress.size()) + 0.5);
+    }
+};
+
+//! Search a range of the UTXO set for a given set of pubkey scripts
+static bool ScanRange(ScanRanges &shared, size_t index,
+                      const std::atomic<bool> &should_abort,
+                      std::atomic<int64_t> &count, std::atomic<int64_t> &found,
+                      const ScanNeedles &needles) {
+    CCoinsViewCursor &cursor = *shared.cursors[index];
+    const auto txid_position = [](const TxId &txid) -> uint32_t {
+        return 0x100 * *txid.begin() + *(txid.begin() + 1);
+    };
+
+    std::vector<std::pair<COutPoint, Coin>> results;
+    const auto publish_results = [&]() {
+        LOCK(shared.mutex);
+        found += results.size();
+        shared.results.insert(shared.results.end(),
+                              std::make_move_iterator(results.begin()),
+                              std::make_move_iterator(results.end()));
+        results.clear();
+    };
+
+    std::optional<uint32_t> begin;
+    int64_t range_count{0};
+    while (cursor.Valid()) {
         COutPoint key;
         Coin coin;
-        if (!cursor->GetKey(key) || !cursor->GetValue(coin)) {
+        if (!cursor.GetKey(key) || !cursor.GetValue(coin)) {
+            publish_results();
             return false;
         }
-        if (++count % 8192 == 0) {
-            interruption_point();
-            if (should_abort) {
+        if (!begin) {
+            begin = txid_position(key.GetTxId());
+        }
+        if (++range_count % 256 == 0) {
+            count += 256;
+            if (shared.stop || should_abort) {
                 // allow to abort the scan via the abort reference
+                publish_results();
                 return false;
             }
+            const uint64_t scanned{txid_position(key.GetTxId()) - *begin};
+            shared.progress[index] = std::min<uint64_t>(
+                scanned * shared.progress.size(), SCAN_RANGE_DONE - 1);
+        }
+        const auto it = needles.find(coin.GetTxOut().scriptPubKey);
+        if (it != needles.end()) {
+            results.emplace_back(key, std::move(coin));
+        }
+        cursor.Next();
+    }
+    count += range_count % 256;
+    shared.progress[index] = SCAN_RANGE_DONE;
+    publish_results();
+    return true;
+}
+
+//! Called by FindScriptPubKey() with the outputs found as the ranges complete
+using ScanResultsCallback =
+    std::function<void(const std::vector<std::pair<COutPoint, Coin>> &)>;
+
+//! Search for a given set of pubkey scripts. The UTXO set is split into
+//! ranges scanned on several threads, while the calling thread reports the
+//! progress and handles the interruptions. The outputs found are added to
+//! out_results and passed to on_results as each range completes.
+static bool FindScriptPubKey(std::atomic<int> &scan_progress,
+                             const std::atomic<bool> &should_abort,
+                             std::atomic<int64_t> &count,
+                             std::atomic<int64_t> &found,
+                             std::vector<std::unique_ptr<CCoinsViewCursor>>
+                                 &&cursors,
+                             const ScanNeedles &needles,
+                             std::map<COutPoint, Coin> &out_results,
+                             const ScanResultsCallback &on_results,
+                             std::function<void()> &interruption_point) {
+    scan_progress = 0;
+    count = 0;
+    found = 0;
+    if (cursors.empty()) {
+        return false;
+    }
+    ScanRanges shared(std::move(cursors));
+
+    const size_t num_threads{
+        std::min<size_t>(std::clamp(std::thread::hardware_concurrency(), 1u,
+                                    MAX_SCAN_THREADS),
+                         shared.cursors.size())};
+    std::vector<std::thread> threads;
+    WITH_LOCK(shared.mutex, shared.running_threads = num_threads);
+    for (size_t n = 0; n < num_threads; ++n) {
+        threads.emplace_back([&, n]() {
+            util::ThreadRename(strprintf("scantxoutset.%i", n));
+            for (size_t i; !shared.stop &&
+                           (i = shared.next_range++) < shared.cursors.size();) {
+                bool ok;
+                try {
+                    ok = ScanRange(shared, i, should_abort, count, found,
+                                   needles);
+                } catch (const std::exception &e) {
+                    LogPrintf("Error reading the UTXO set: %s\n", e.what());
+                    ok = false;
+                }
+                if (!ok) {
+                    shared.failed = true;
+                    shared.stop = true;
+                }
+            }
+            LOCK(shared.mutex);
+            --shared.running_threads;
+            shared.cv.notify_all();
+        });
+    }
+    const auto stop_threads = [&]() {
+        shared.stop = true;
+        for (std::thread &thread : threads) {
+            thread.join();
         }
-        if (count % 256 == 0) {
-            // update progress reference every 256 item
-            const TxId &txid = key.GetTxId();
-            uint32_t high = 0x100 * *txid.begin() + *(txid.begin() + 1);
-            scan_progress = int(high * 100.0 / 65536.0 + 0.5);
+    };
+    // Report the outputs found since the last call, outside of the lock
+    const auto report_results = [&]() {
+        std::vector<std::pair<COutPoint, Coin>> results;
+        WITH_LOCK(shared.mutex, results.swap(shared.results));
+        if (results.empty()) {
+            return;
         }
-        if (needles.count(coin.GetTxOut().scriptPubKey)) {
-            out_results.emplace(key, coin);
+        on_results(results);
+        out_results.insert(std::make_move_iterator(results.begin()),
+                           std::make_move_iterator(results.end()));
+    };
+
+    try {
+        while (true) {
+            bool done;
+            {
+                WAIT_LOCK(shared.mutex, lock);
+                done = shared.cv.wait_for(
+                    lock, std::chrono::milliseconds{100}, [&]() {
+                        AssertLockHeld(shared.mutex);
+                        return shared.running_threads == 0;
+                    });
+            }
+            report_results();
+            if (done) {
+                break;
+            }
+            interruption_point();
+            scan_progress = shared.GetProgress();
         }
-        cursor->Next();
+    } catch (...) {
+        stop_threads();
+        throw;
+    }
+    stop_threads();
+
+    if (shared.failed) {
+        return false;
     }
     scan_progress = 100;
     return true;
@@ -2232,8 +2424,18 @@ static bool FindScriptPubKey(std::atomic<int> &scan_progress,
 
 /** RAII object to prevent concurrency issue when scanning the txout set */
 static std::atomic<int> g_scan_progress;
+static std::atomic<int64_t> g_scan_txouts;
+static std::atomic<int64_t> g_scan_found;
 static std::atomic<bool> g_scan_in_progress;
 static std::atomic<bool> g_should_abort_scan;
+static GlobalMutex g_scan_results_mutex;
+//! Outputs found by a range of the UTXO set scan, as they are replied
+using ScanUnspents = std::vector<std::pair<COutPoint, UniValue>>;
+//! Outputs found so far by the scan in progress, for the status action. The
+//! ranges are shared with the status calls reading them, so that they can be
+//! copied to the reply outside of the lock.
+static std::vector<std::shared_ptr<const ScanUnspents>>
+    g_scan_unspents GUARDED_BY(g_scan_results_mutex);
 class CoinsViewScanReserver {
 private:
     bool m_could_reserve;
@@ -2252,6 +2454,8 @@ public:
 
     ~CoinsViewScanReserver() {
         if (m_could_reserve) {
+            // Also when the scan threw, the next one starts from scratch
+            WITH_LOCK(g_scan_results_mutex, g_scan_unspents.clear());
             g_scan_in_progress = false;
         }
     }
@@ -2328,6 +2532,20 @@ static RPCHelpMan scantxoutset() {
                 "",
                 {
                     {RPCResult::Type::NUM, "progress", "The scan progress"},
+                    {RPCResult::Type::NUM, "txouts",
+                     "The number of unspent transaction outputs scanned so "
+                     "far"},
+                    {RPCResult::Type::NUM, "found",
+                     "The number of matching unspent transaction outputs "
+                     "found so far"},
+                    {RPCResult::Type::ARR,
+                     "unspents",
+                     "The matching unspent transaction outputs found so "
+                     "far, in no particular order. The UTXO set is scanned "
+                     "in several ranges, and the outputs of a range are "
+                     "added once it is complete. Same format as the "
+                     "unspents of the start action",
+                     {{RPCResult::Type::ELISION, "", ""}}},
                 }},
             RPCResult{
                 "When action=='start'",
@@ -2384,6 +2602,17 @@ static RPCHelpMan scantxoutset() {
                     return NullUniValue;
                 }
                 result.pushKV("progress", g_scan_progress.load());
+                result.pushKV("txouts", g_scan_txouts.load());
+                result.pushKV("found", g_scan_found.load());
+                const auto found_ranges{
+                    WITH_LOCK(g_scan_results_mutex, return g_scan_unspents)};
+                UniValue unspents(UniValue::VARR);
+                for (const auto &range : found_ranges) {
+                    for (const auto &[outpoint, unspent] : *range) {
+                        unspents.push_back(unspent);
+                    }
+                }
+                result.pushKV("unspents", std::move(unspents));
                 return result;
             } else if (request.params[0].get_str() == "abort") {
                 CoinsViewScanReserver reserver;
@@ -2408,33 +2637,62 @@ static RPCHelpMan scantxoutset() {
                                        "the start action");
                 }
 
-                std::set<CScript> needles;
-                std::map<CScript, std::string> descriptors;
+                ScanNeedles needles;
+                std::vector<FlatSigningProvider> providers;
                 Amount total_in = Amount::zero();
 
                 // loop through the scan objects
                 for (const UniValue &scanobject :
                      request.params[1].get_array().getValues()) {
-                    FlatSigningProvider provider;
+                    FlatSigningProvider &provider = providers.emplace_back();
                     auto scripts =
                         EvalDescriptorStringOrObject(scanobject, provider);
+                    needles.reserve(needles.size() + scripts.size());
                     for (CScript &script : scripts) {
-                        std::string inferred =
-                            InferDescriptor(script, provider)->ToString();
-                        needles.emplace(script);
-                        descriptors.emplace(std::move(script),
-                                            std::move(inferred));
+                        needles.emplace(std::move(script),
+                                        providers.size() - 1);
                     }
                 }
 
+                const auto to_unspent = [&](const COutPoint &outpoint,
+                                            const Coin &coin) {
+                    const CTxOut &txo = coin.GetTxOut();
+                    UniValue unspent(UniValue::VOBJ);
+                    unspent.pushKV("txid", outpoint.GetTxId().GetHex());
+                    unspent.pushKV("vout", int32_t(outpoint.GetN()));
+                    unspent.pushKV("scriptPubKey", HexStr(txo.scriptPubKey));
+                    unspent.pushKV(
+                        "desc",
+                        InferDescriptor(txo.scriptPubKey,
+                                        providers[needles.at(txo.scriptPubKey)])
+                            ->ToString());
+                    unspent.pushKV("amount", txo.nValue);
+                    unspent.pushKV("coinbase", coin.IsCoinBase());
+                    unspent.pushKV("height", int32_t(coin.GetHeight()));
+                    return unspent;
+                };
+
                 // Scan the unspent transaction output set for inputs
                 UniValue unspents(UniValue::VARR);
                 std::vector<CTxOut> input_txos;
                 std::map<COutPoint, Coin> coins;
                 g_should_abort_scan = false;
                 g_scan_progress = 0;
-                int64_t count = 0;
-                std::unique_ptr<CCoinsViewCursor> pcursor;
+                // The outputs are made available to the status action as
+                // they are found, the reply lists them in outpoint order.
+                const ScanResultsCallback on_results =
+                    [&](const std::vector<std::pair<COutPoint, Coin>>
+                            &results) {
+                        auto found_unspents{std::make_shared<ScanUnspents>()};
+                        found_unspents->reserve(results.size());
+                        for (const auto &[outpoint, coin] : results) {
+                            found_unspents->emplace_back(
+                                outpoint, to_unspent(outpoint, coin));
+                        }
+                        LOCK(g_scan_results_mutex);
+                        g_scan_unspents.push_back(std::move(found_unspents));
+                    };
+                std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
                 const CBlockIndex *tip;
                 NodeContext &node = EnsureAnyNodeContext(request.context);
                 {
@@ -2442,37 +2700,47 @@ static RPCHelpMan scantxoutset() {
                     LOCK(cs_main);
                     Chainstate &active_chainstate = chainman.ActiveChainstate();
                     active_chainstate.ForceFlushStateToDisk();
-                    pcursor = CHECK_NONFATAL(std::unique_ptr<CCoinsViewCursor>(
-                        active_chainstate.CoinsDB().Cursor()));
+                    const unsigned int max_threads{
+                        std::clamp(std::thread::hardware_concurrency(), 1u,
+                                   MAX_SCAN_THREADS)};
+                    cursors = active_chainstate.CoinsDB().RangeCursors(
+                        max_threads * SCAN_RANGES_PER_THREAD);
+                    CHECK_NONFATAL(!cursors.empty());
                     tip = CHECK_NONFATAL(active_chainstate.m_chain.Tip());
                 }
                 bool res = FindScriptPubKey(
-                    g_scan_progress, g_should_abort_scan, count, pcursor.get(),
-                    needles, coins, node.rpc_interruption_point);
+                    g_scan_progress, g_should_abort_scan, g_scan_txouts,
+                    g_scan_found, std::move(cursors), needles, coins,
+                    on_results, node.rpc_interruption_point);
                 result.pushKV("success", res);
-                result.pushKV("txouts", count);
+                result.pushKV("txouts", g_scan_txouts.load());
                 result.pushKV("height", tip->nHeight);
                 result.pushKV("bestblock", tip->GetBlockHash().GetHex());
 
-                for (const auto &it : coins) {
-                    const COutPoint &outpoint = it.first;
-                    const Coin &coin = it.second;
+                for (const auto &[outpoint, coin] : coins) {
                     const CTxOut &txo = coin.GetTxOut();
                     input_txos.push_back(txo);
                     total_in += txo.nValue;
-
-                    UniValue unspent(UniValue::VOBJ);
-                    unspent.pushKV("txid", outpoint.GetTxId().GetHex());
-                    unspent.pushKV("vout", int32_t(outpoint.GetN()));
-                    unspent.pushKV("scriptPubKey", HexStr(txo.scriptPubKey));
-                    unspent.pushKV("desc", descriptors[txo.scriptPubKey]);
-                    unspent.pushKV("amount", txo.nValue);
-                    unspent.pushKV("coinbase", coin.IsCoinBase());
-                    unspent.pushKV("height", int32_t(coin.GetHeight()));
-
-                    unspents.push_back(unspent);
                 }
-                result.pushKV("unspents", unspents);
+                // Reuse the entries built for the status action
+                std::vector<std::shared_ptr<const ScanUnspents>> found_ranges;
+                WITH_LOCK(g_scan_results_mutex,
+                          found_ranges.swap(g_scan_unspents));
+                std::vector<const std::pair<COutPoint, UniValue> *> sorted;
+                sorted.reserve(coins.size());
+                for (const auto &range : found_ranges) {
+                    for (const auto &found : *range) {
+                        sorted.push_back(&found);
+                    }
+                }
+                std::sort(sorted.begin(), sorted.end(),
+                          [](const auto *a, const auto *b) {
+                              return a->first < b->first;
+                          });
+                for (const auto *found : sorted) {
+                    unspents.push_back(found->second);
+                }
+                result.pushKV("unspents", std::move(unspents));
                 result.pushKV("total_amount", total_in);
             } else {
                 throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid command");
@@ -2578,6 +2846,179 @@ static RPCHelpMan getblockfilter() {
     };
 }
 
+UniValue AddressHistoryToJSON(const std::vector<AddressHistoryEntry> &history) {
+    UniValue result(UniValue::VARR);
+    for (const AddressHistoryEntry &entry : history) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", entry.tx->GetId().GetHex());
+        obj.pushKV("height", entry.height);
+        obj.pushKV("blockhash", entry.block_hash.GetHex());
+        result.push_back(std::move(obj));
+    }
+    return result;
+}
+
+UniValue AddressUtxosToJSON(const std::vector<AddressUtxo> &utxos) {
+    UniValue result(UniValue::VARR);
+    for (const AddressUtxo &utxo : utxos) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", utxo.outpoint.GetTxId().GetHex());
+        obj.pushKV("vout", int32_t(utxo.outpoint.GetN()));
+        obj.pushKV("amount", utxo.amount);
+        obj.pushKV("height", utxo.height);
+        result.push_back(std::move(obj));
+    }
+    return result;
+}
+
+/**
+ * Parse the address and the paging arguments of the address index RPCs, and
+ * wait for the index to catch up with the chain.
+ */
+static CScript ParseAddressIndexQuery(const JSONRPCRequest &request,
+                                      const CChainParams &chainparams,
+                                      size_t &skip, size_t &count) {
+    if (!g_address_index) {
+        throw JSONRPCError(RPC_MISC_ERROR,
+                           "Requires addressindex. Start with -addressindex.");
+    }
+
+    const CTxDestination dest =
+        DecodeDestination(request.params[0].get_str(), chainparams);
+    if (!IsValidDestination(dest)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+
+    const int skip_param{
+        request.params[1].isNull() ? 0 : request.params[1].getInt<int>()};
+    if (skip_param < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative skip");
+    }
+    const int count_param{request.params[2].isNull()
+                              ? DEFAULT_ADDRESS_QUERY_COUNT
+                              : request.params[2].getInt<int>()};
+    if (count_param < 1 || count_param > MAX_ADDRESS_QUERY_COUNT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER,
+                           strprintf("count must be between 1 and %d",
+                                     MAX_ADDRESS_QUERY_COUNT));
+    }
+    skip = skip_param;
+    count = count_param;
+
+    if (!g_address_index->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(
+            RPC_INTERNAL_ERROR,
+            strprintf("Unable to get data because addressindex is still "
+                      "syncing. Current height: %d",
+                      g_address_index->GetSummary().best_block_height));
+    }
+    return GetScriptForDestination(dest);
+}
+
+static RPCHelpMan getaddresshistory() {
+    return RPCHelpMan{
+        "getaddresshistory",
+        "Returns the transactions sending to or spending from an address, in "
+        "chain order.\n"
+        "Requires -addressindex. Mempool transactions are not included.\n",
+        {
+            {"address", RPCArg::Type::STR, RPCArg::Optional::NO,
+             "The address to look up"},
+            {"skip", RPCArg::Type::NUM, RPCArg::Default{0},
+             "Number of transactions to skip"},
+            {"count", RPCArg::Type::NUM,
+             RPCArg::Default{DEFAULT_ADDRESS_QUERY_COUNT},
+             strprintf("Maximum number of transactions to return, up to %d",
+                       MAX_ADDRESS_QUERY_COUNT)},
+        },
+        RPCResult{RPCResult::Type::ARR,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::OBJ,
+                       "",
+                       "",
+                       {
+                           {RPCResult::Type::STR_HEX, "txid",
+                            "The transaction id"},
+                           {RPCResult::Type::NUM, "height",
+                            "The height of the block of the transaction"},
+                           {RPCResult::Type::STR_HEX, "blockhash",
+                            "The hash of the block of the transaction"},
+                       }},
+                  }},
+        RPCExamples{
+            HelpExampleCli("getaddresshistory", "\"myaddress\"") +
+            HelpExampleCli("getaddresshistory", "\"myaddress\" 100 50") +
+            HelpExampleRpc("getaddresshistory", "\"myaddress\"")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            size_t skip, count;
+            const CScript script = ParseAddressIndexQuery(
+                request, config.GetChainParams(), skip, count);
+
+            std::vector<AddressHistoryEntry> history;
+            if (!g_address_index->FindHistory(script, skip, count, history)) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR,
+                                   "Failed to read the address history");
+            }
+            return AddressHistoryToJSON(history);
+        },
+    };
+}
+
+static RPCHelpMan getaddressutxos() {
+    const auto &ticker = Currency::get().ticker;
+    return RPCHelpMan{
+        "getaddressutxos",
+        "Returns the unspent outputs paying to an address, ordered by "
+        "outpoint.\n"
+        "Requires -addressindex. Mempool transactions are not included.\n",
+        {
+            {"address", RPCArg::Type::STR, RPCArg::Optional::NO,
+             "The address to look up"},
+            {"skip", RPCArg::Type::NUM, RPCArg::Default{0},
+             "Number of outputs to skip"},
+            {"count", RPCArg::Type::NUM,
+             RPCArg::Default{DEFAULT_ADDRESS_QUERY_COUNT},
+             strprintf("Maximum number of outputs to return, up to %d",
+                       MAX_ADDRESS_QUERY_COUNT)},
+        },
+        RPCResult{RPCResult::Type::ARR,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::OBJ,
+                       "",
+                       "",
+                       {
+                           {RPCResult::Type::STR_HEX, "txid",
+                            "The transaction id"},
+                           {RPCResult::Type::NUM, "vout", "The output number"},
+                           {RPCResult::Type::STR_AMOUNT, "amount",
+                            "The output amount in " + ticker},
+                           {RPCResult::Type::NUM, "height",
+                            "The height of the block of the output"},
+                       }},
+                  }},
+        RPCExamples{HelpExampleCli("getaddressutxos", "\"myaddress\"") +
+                    HelpExampleRpc("getaddressutxos", "\"myaddress\"")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            size_t skip, count;
+            const CScript script = ParseAddressIndexQuery(
+                request, config.GetChainParams(), skip, count);
+
+            std::vector<AddressUtxo> utxos;
+            if (!g_address_index->FindUtxos(script, skip, count, utxos)) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR,
+                                   "Failed to read the address utxos");
+            }
+            return AddressUtxosToJSON(utxos);
+        },
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2646,15 +3087,13 @@ UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
                             AutoFile &afile, const fs::path &path,
                             const fs::path &temppath) {
     std::unique_ptr<CCoinsViewCursor> pcursor;
-    std::optional<CCoinsStats> maybe_stats;
     const CBlockIndex *tip;
 
     {
         // We need to lock cs_main to ensure that the coinsdb isn't
         // written to between (i) flushing coins cache to disk
-        // (coinsdb), (ii) getting stats based upon the coinsdb, and
-        // (iii) constructing a cursor to the coinsdb for use below this
-        // block.
+        // (coinsdb) and (ii) constructing a cursor to the coinsdb for use
+        // below this block.
         //
         // Cursors returned by leveldb iterate over snapshots, so the
         // contents of the pcursor will not be affected by simultaneous
@@ -2667,17 +3106,10 @@ UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
 
         chainstate.ForceFlushStateToDisk();
 
-        maybe_stats = GetUTXOStats(&chainstate.CoinsDB(), chainstate.m_blockman,
-                                   CoinStatsHashType::HASH_SERIALIZED,
-                                   node.rpc_interruption_point);
-        if (!maybe_stats) {
-            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
-        }
-
         pcursor =
             std::unique_ptr<CCoinsViewCursor>(chainstate.CoinsDB().Cursor());
-        tip = CHECK_NONFATAL(
-            chainstate.m_blockman.LookupBlockIndex(maybe_stats->hashBlock));
+        tip = CHECK_NONFATAL(chainstate.m_blockman.LookupBlockIndex(
+            chainstate.CoinsDB().GetBestBlock()));
     }
 
     LOG_TIME_SECONDS(
@@ -2685,7 +3117,10 @@ UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
                   tip->nHeight, tip->GetBlockHash().ToString(),
                   fs::PathToString(path), fs::PathToString(temppath)));
 
-    SnapshotMetadata metadata{tip->GetBlockHash(), maybe_stats->coins_count,
+    // The coins are hashed as they are written, rather than in a separate
+    // pass over the database beforehand. The coins count is not known until
+    // the end, so the metadata is written again once it is.
+    SnapshotMetadata metadata{tip->GetBlockHash(), 0,
                               uint64_t(tip->GetChainTxCount())};
 
     afile << metadata;
@@ -2693,34 +3128,141 @@ UniValue CreateUTXOSnapshot(NodeContext &node, Chainstate &chainstate,
     COutPoint key;
     Coin coin;
     unsigned int iter{0};
+    SerializedCoinsHasher hasher{tip->GetBlockHash()};
 
     while (pcursor->Valid()) {
         if (iter % 5000 == 0) {
             node.rpc_interruption_point();
         }
         ++iter;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            afile << key;
-            afile << coin;
+        if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
         }
+        afile << key;
+        afile << coin;
+        hasher.Add(key, coin);
+        ++metadata.m_coins_count;
 
         pcursor->Next();
     }
 
+    if (std::fseek(afile.Get(), 0, SEEK_SET) != 0) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to write UTXO snapshot");
+    }
+    afile << metadata;
+    const uint256 txoutset_hash{hasher.Finalize()};
+
     afile.fclose();
 
     UniValue result(UniValue::VOBJ);
-    result.pushKV("coins_written", maybe_stats->coins_count);
+    result.pushKV("coins_written", metadata.m_coins_count);
     result.pushKV("base_hash", tip->GetBlockHash().ToString());
     result.pushKV("base_height", tip->nHeight);
     result.pushKV("path", path.u8string());
-    result.pushKV("txoutset_hash", maybe_stats->hashSerialized.ToString());
+    result.pushKV("txoutset_hash", txoutset_hash.ToString());
     // Cast required because univalue doesn't have serialization specified for
     // `unsigned int`, nChainTx's type.
     result.pushKV("nchaintx", uint64_t{tip->nChainTx});
     return result;
 }
 
+/**
+ * Load a UTXO set written by dumptxoutset into a new, snapshot-based chainstate.
+ *
+ * @see SnapshotMetadata
+ */
+static RPCHelpMan loadtxoutset() {
+    return RPCHelpMan{
+        "loadtxoutset",
+        "Load the serialized UTXO set from disk.\n"
+        "The snapshot is loaded into a second chainstate, which then becomes "
+        "the active one and syncs to the tip of the chain. Its contents are "
+        "checked against the assumeutxo hash of the snapshot base block, "
+        "which must be known to this software version and in the headers "
+        "chain.\n"
+        "The original chainstate keeps validating the blocks up to the "
+        "snapshot base as they become available.\n",
+        {
+            {"path", RPCArg::Type::STR, RPCArg::Optional::NO,
+             "path to the snapshot file. If relative, will be prefixed by "
+             "datadir."},
+        },
+        RPCResult{RPCResult::Type::OBJ,
+                  "",
+                  "",
+                  {
+                      {RPCResult::Type::NUM, "coins_loaded",
+                       "the number of coins loaded from the snapshot"},
+                      {RPCResult::Type::STR_HEX, "tip_hash",
+                       "the hash of the base of the snapshot"},
+                      {RPCResult::Type::NUM, "base_height",
+                       "the height of the base of the snapshot"},
+                      {RPCResult::Type::STR, "path",
+                       "the absolute path that the snapshot was loaded from"},
+                  }},
+        RPCExamples{HelpExampleCli("loadtxoutset", "utxo.dat")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const ArgsManager &args{EnsureAnyArgsman(request.context)};
+            ChainstateManager &chainman = EnsureAnyChainman(request.context);
+            const fs::path path = fsbridge::AbsPathJoin(
+                args.GetDataDirNet(), fs::u8path(request.params[0].get_str()));
+
+            FILE *file{fsbridge::fopen(path, "rb")};
+            AutoFile afile{file};
+            if (afile.IsNull()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   "Couldn't open file " + path.u8string() +
+                                       " for reading.");
+            }
+
+            SnapshotMetadata metadata;
+            try {
+                afile >> metadata;
+            } catch (const std::ios_base::failure &e) {
+                throw JSONRPCError(
+                    RPC_DESERIALIZATION_ERROR,
+                    strprintf("Unable to parse metadata: %s", e.what()));
+            }
+
+            const CBlockIndex *snapshot_start_block{
+                WITH_LOCK(::cs_main, return chainman.m_blockman.LookupBlockIndex(
+                                         metadata.m_base_blockhash))};
+            if (!snapshot_start_block) {
+                throw JSONRPCError(
+                    RPC_INTERNAL_ERROR,
+                    strprintf("The base block header (%s) must appear in the "
+                              "headers chain. Make sure all headers are "
+                              "syncing, and call this RPC again.",
+                              metadata.m_base_blockhash.ToString()));
+            }
+            if (!ExpectedAssumeutxo(snapshot_start_block->nHeight,
+                                    chainman.GetParams())) {
+                throw JSONRPCError(
+                    RPC_INVALID_PARAMETER,
+                    strprintf("No assumeutxo data for the snapshot base block "
+                              "at height %d",
+                              snapshot_start_block->nHeight));
+            }
+
+            if (!chainman.ActivateSnapshot(afile, metadata,
+                                           /*in_memory=*/false)) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR,
+                                   "Unable to load UTXO snapshot " +
+                                       path.u8string());
+            }
+
+            UniValue result(UniValue::VOBJ);
+            result.pushKV("coins_loaded", metadata.m_coins_count);
+            result.pushKV("tip_hash",
+                          snapshot_start_block->GetBlockHash().ToString());
+            result.pushKV("base_height", snapshot_start_block->nHeight);
+            result.pushKV("path", path.u8string());
+            return result;
+        },
+    };
+}
+
 void RegisterBlockchainRPCCommands(CRPCTable &t) {
     // clang-format off
     static const CRPCCommand commands[] = {
@@ -2744,6 +3286,8 @@ void RegisterBlockchainRPCCommands(CRPCTable &t) {
         { "blockchain",         preciousblock,                     },
         { "blockchain",         scantxoutset,                      },
         { "blockchain",         getblockfilter,                    },
+        { "blockchain",         getaddresshistory,                 },
+        { "blockchain",         getaddressutxos,                   },
 
         /* Not shown in help */
         { "hidden",             invalidateblock,                   },
@@ -2751,6 +3295,7 @@ void RegisterBlockchainRPCCommands(CRPCTable &t) {
         { "hidden",             reconsiderblock,                   },
         { "hidden",             syncwithvalidationinterfacequeue,  },
         { "hidden",             dumptxoutset,                      },
+        { "hidden",             loadtxoutset,                      },
         { "hidden",             unparkblock,                       },
         { "hidden",             waitfornewblock,                   },
         { "hidden",             waitforblock,                      },
@@ -13,10 +13,14 @@
 #include <univalue.h>
 
 #include <any>
+#include <vector>
 
+struct AddressHistoryEntry;
+struct AddressUtxo;
 class CBlock;
 class CBlockIndex;
 class Chainstate;
+class JSONWriter;
 class RPCHelpMan;
 namespace node {
 struct NodeContext;
@@ -40,11 +44,28 @@ UniValue blockToJSON(node::BlockManager &blockman, const CBlock &block,
                      const CBlockIndex *tip, const CBlockIndex *blockindex,
                      bool txDetails = false) LOCKS_EXCLUDED(cs_main);
 
+/**
+ * Write the same description as blockToJSON, without building it as a whole:
+ * only one transaction description is in memory at a time.
+ */
+void blockToJSON(JSONWriter &writer, node::BlockManager &blockman,
+                 const CBlock &block, const CBlockIndex *tip,
+                 const CBlockIndex *blockindex, bool txDetails = false)
+    LOCKS_EXCLUDED(cs_main);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex *tip,
                            const CBlockIndex *blockindex)
     LOCKS_EXCLUDED(cs_main);
 
+/** Default and maximum number of entries returned by an address lookup */
+static constexpr int DEFAULT_ADDRESS_QUERY_COUNT{1000};
+static constexpr int MAX_ADDRESS_QUERY_COUNT{10000};
+
+/** Address index lookup results to JSON */
+UniValue AddressHistoryToJSON(const std::vector<AddressHistoryEntry> &history);
+UniValue AddressUtxosToJSON(const std::vector<AddressUtxo> &utxos);
+
 /**
  * Helper to create UTXO snapshots given a chainstate and a file handle.
  * @return a UniValue map containing metadata about the snapshot.
@@ -72,6 +72,10 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"sendmany", 4, "subtractfeefrom"},
     {"deriveaddresses", 1, "range"},
     {"scantxoutset", 1, "scanobjects"},
+    {"getaddresshistory", 1, "skip"},
+    {"getaddresshistory", 2, "count"},
+    {"getaddressutxos", 1, "skip"},
+    {"getaddressutxos", 2, "count"},
     {"addmultisigaddress", 0, "nrequired"},
     {"addmultisigaddress", 1, "keys"},
     {"createmultisig", 0, "nrequired"},
@@ -99,6 +103,8 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     {"signrawtransactionwithkey", 2, "prevtxs"},
     {"signrawtransactionwithwallet", 1, "prevtxs"},
     {"sendrawtransaction", 1, "maxfeerate"},
+    {"sendrawtransactions", 0, "hexstrings"},
+    {"sendrawtransactions", 1, "maxfeerate"},
     {"submitpackage", 0, "package"},
     {"testmempoolaccept", 0, "rawtxs"},
     {"testmempoolaccept", 1, "maxfeerate"},
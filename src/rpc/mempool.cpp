@@ -18,6 +18,7 @@
 #include <txmempool.h>
 #include <univalue.h>
 #include <util/fs.h>
+#include <util/jsonwriter.h>
 #include <util/moneystr.h>
 #include <validation.h>
 #include <validationinterface.h>
@@ -25,6 +26,7 @@
 using kernel::DumpMempool;
 
 using node::DEFAULT_MAX_RAW_TX_FEE_RATE;
+using node::MAX_BROADCAST_BATCH_SIZE;
 using node::MempoolPath;
 using node::NodeContext;
 using node::ShouldPersistMempool;
@@ -97,6 +99,128 @@ static RPCHelpMan sendrawtransaction() {
     };
 }
 
+static RPCHelpMan sendrawtransactions() {
+    return RPCHelpMan{
+        "sendrawtransactions",
+        "Submits a batch of raw transactions (serialized, hex-encoded) to "
+        "local node and network.\n"
+        "\nEach transaction is accepted or rejected on its own, as with "
+        "sendrawtransaction, but the whole batch is validated at once which is "
+        "much faster for large numbers of transactions. The transactions can "
+        "depend on each other and don't need to be sorted. When several "
+        "transactions spend the same coin, only the first one is considered.\n"
+        "\nThe maximum number of transactions allowed is " +
+            ToString(MAX_BROADCAST_BATCH_SIZE) +
+            ".\n"
+            "\nSee sendrawtransaction call.\n",
+        {
+            {
+                "hexstrings",
+                RPCArg::Type::ARR,
+                RPCArg::Optional::NO,
+                "An array of hex strings of raw transactions.",
+                {
+                    {"hexstring", RPCArg::Type::STR_HEX,
+                     RPCArg::Optional::OMITTED, ""},
+                },
+            },
+            {"maxfeerate", RPCArg::Type::AMOUNT,
+             RPCArg::Default{
+                 FormatMoney(DEFAULT_MAX_RAW_TX_FEE_RATE.GetFeePerK())},
+             "Reject transactions whose fee rate is higher than the specified "
+             "value, expressed in " +
+                 Currency::get().ticker +
+                 "/kB\nSet to 0 to accept any fee rate.\n"},
+        },
+        RPCResult{
+            RPCResult::Type::ARR,
+            "",
+            "The result for each raw transaction in the input array, in the "
+            "same order.",
+            {
+                {RPCResult::Type::OBJ,
+                 "",
+                 "",
+                 {
+                     {RPCResult::Type::STR_HEX, "txid",
+                      "The transaction hash in hex"},
+                     {RPCResult::Type::BOOL, "accepted",
+                      "Whether the transaction is in the mempool and has been "
+                      "broadcast"},
+                     {RPCResult::Type::NUM, "error-code", /*optional=*/true,
+                      "The error code sendrawtransaction would have returned "
+                      "(only present when 'accepted' is false)"},
+                     {RPCResult::Type::STR, "error", /*optional=*/true,
+                      "The error message (only present when 'accepted' is "
+                      "false)"},
+                 }},
+            }},
+        RPCExamples{
+            "\nSend two signed transactions\n" +
+            HelpExampleCli("sendrawtransactions",
+                           R"('["signedhex1", "signedhex2"]')") +
+            "\nAs a JSON-RPC call\n" +
+            HelpExampleRpc("sendrawtransactions",
+                           "[\"signedhex1\", \"signedhex2\"]")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            const UniValue raw_transactions = request.params[0].get_array();
+            if (raw_transactions.size() < 1 ||
+                raw_transactions.size() > MAX_BROADCAST_BATCH_SIZE) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER,
+                                   "Array must contain between 1 and " +
+                                       ToString(MAX_BROADCAST_BATCH_SIZE) +
+                                       " transactions.");
+            }
+
+            std::vector<CTransactionRef> txns;
+            txns.reserve(raw_transactions.size());
+            for (const auto &rawtx : raw_transactions.getValues()) {
+                CMutableTransaction mtx;
+                if (!DecodeHexTx(mtx, rawtx.get_str())) {
+                    throw JSONRPCError(RPC_DESERIALIZATION_ERROR,
+                                       "TX decode failed: " + rawtx.get_str());
+                }
+                txns.emplace_back(MakeTransactionRef(std::move(mtx)));
+            }
+
+            const CFeeRate max_raw_tx_fee_rate =
+                request.params[1].isNull()
+                    ? DEFAULT_MAX_RAW_TX_FEE_RATE
+                    : CFeeRate(AmountFromValue(request.params[1]));
+
+            std::vector<std::string> err_strings;
+            AssertLockNotHeld(cs_main);
+            NodeContext &node = EnsureAnyNodeContext(request.context);
+            const std::vector<TransactionError> errors = BroadcastTransactions(
+                node, txns, err_strings, max_raw_tx_fee_rate, /*relay=*/true,
+                /*wait_callback=*/true);
+
+            // Block to make sure wallet/indexers sync before returning
+            SyncWithValidationInterfaceQueue();
+
+            UniValue rpc_result(UniValue::VARR);
+            for (size_t i = 0; i < txns.size(); ++i) {
+                UniValue result_inner(UniValue::VOBJ);
+                result_inner.pushKV("txid", txns[i]->GetId().GetHex());
+                result_inner.pushKV("accepted",
+                                    errors[i] == TransactionError::OK);
+                if (errors[i] != TransactionError::OK) {
+                    result_inner.pushKV(
+                        "error-code",
+                        int64_t{RPCErrorFromTransactionError(errors[i])});
+                    result_inner.pushKV(
+                        "error", err_strings[i].empty()
+                                     ? TransactionErrorString(errors[i]).original
+                                     : err_strings[i]);
+                }
+                rpc_result.push_back(result_inner);
+            }
+            return rpc_result;
+        },
+    };
+}
+
 static RPCHelpMan testmempoolaccept() {
     const auto ticker = Currency::get().ticker;
     return RPCHelpMan{
@@ -392,6 +516,17 @@ static void entryToJSON(const CTxMemPool &pool, UniValue &info,
     info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetId()));
 }
 
+void MempoolToJSON(JSONWriter &writer, const CTxMemPool &pool) {
+    LOCK(pool.cs);
+    writer.BeginObject();
+    for (const CTxMemPoolEntryRef &e : pool.mapTx) {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(pool, info, e);
+        writer.Pair(e->GetTx().GetId().ToString(), info);
+    }
+    writer.EndObject();
+}
+
 UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose,
                        bool include_mempool_sequence) {
     if (verbose) {
@@ -1004,6 +1139,7 @@ void RegisterMempoolRPCCommands(CRPCTable &t) {
         // category     actor (function)
         // --------     ----------------
         {"rawtransactions", sendrawtransaction},
+        {"rawtransactions", sendrawtransactions},
         {"rawtransactions", testmempoolaccept},
         {"blockchain", getmempoolancestors},
         {"blockchain", getmempooldescendants},
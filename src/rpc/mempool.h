@@ -6,6 +6,7 @@
 #define BITCOIN_RPC_MEMPOOL_H
 
 class CTxMemPool;
+class JSONWriter;
 class UniValue;
 
 /** Mempool information to JSON */
@@ -15,4 +16,10 @@ UniValue MempoolInfoToJSON(const CTxMemPool &pool);
 UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose = false,
                        bool include_mempool_sequence = false);
 
+/**
+ * Write the verbose mempool description, one entry at a time rather than
+ * building it as a whole.
+ */
+void MempoolToJSON(JSONWriter &writer, const CTxMemPool &pool);
+
 #endif // BITCOIN_RPC_MEMPOOL_H
@@ -7,6 +7,7 @@
 #include <config.h>
 #include <consensus/amount.h>
 #include <httpserver.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
 #include <index/coinstatsindex.h>
 #include <index/txindex.h>
@@ -865,6 +866,11 @@ static RPCHelpMan getindexinfo() {
                                              index_name));
             }
 
+            if (g_address_index) {
+                result.pushKVs(SummaryToJSON(g_address_index->GetSummary(),
+                                             index_name));
+            }
+
             ForEachBlockFilterIndex([&result, &index_name](
                                         const BlockFilterIndex &index) {
                 result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
@@ -8,6 +8,7 @@
 
 #include <common/args.h>
 #include <config.h>
+#include <httpserver.h>
 #include <logging.h>
 #include <rpc/util.h>
 #include <shutdown.h>
@@ -18,8 +19,11 @@
 
 #include <boost/signals2/signal.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -277,6 +281,43 @@ static RPCHelpMan getrpcinfo() {
                        }},
                       {RPCResult::Type::STR, "logpath",
                        "The complete file path to the debug log"},
+                      {RPCResult::Type::ARR,
+                       "work_queues",
+                       "The work queues of the HTTP server, one per class "
+                       "of requests",
+                       {
+                           {RPCResult::Type::OBJ,
+                            "",
+                            "",
+                            {
+                                {RPCResult::Type::STR, "name",
+                                 "The class of requests (rpc, rpc_heavy or "
+                                 "rest)"},
+                                {RPCResult::Type::NUM, "threads",
+                                 "The number of worker threads"},
+                                {RPCResult::Type::NUM, "depth",
+                                 "The number of queued requests"},
+                                {RPCResult::Type::NUM, "max_depth",
+                                 "The depth above which requests are "
+                                 "rejected"},
+                                {RPCResult::Type::NUM, "active",
+                                 "The number of requests being handled"},
+                                {RPCResult::Type::NUM, "processed",
+                                 "The number of requests handled"},
+                                {RPCResult::Type::NUM, "rejected",
+                                 "The number of requests rejected because "
+                                 "the queue was full"},
+                                {RPCResult::Type::NUM, "mean_wait",
+                                 "The mean time the requests waited in the "
+                                 "queue, in microseconds"},
+                                {RPCResult::Type::NUM, "max_wait",
+                                 "The longest time a request waited in the "
+                                 "queue, in microseconds"},
+                                {RPCResult::Type::NUM, "mean_duration",
+                                 "The mean time taken to handle the "
+                                 "requests, in microseconds"},
+                            }},
+                       }},
                   }},
         RPCExamples{HelpExampleCli("getrpcinfo", "") +
                     HelpExampleRpc("getrpcinfo", "")},
@@ -302,6 +343,28 @@ static RPCHelpMan getrpcinfo() {
             UniValue log_path(UniValue::VSTR, path);
             result.pushKV("logpath", log_path);
 
+            UniValue work_queues(UniValue::VARR);
+            for (const HTTPWorkQueueInfo &info : GetHTTPWorkQueueInfo()) {
+                const auto mean = [&](std::chrono::microseconds total) {
+                    return info.processed ? int64_t(total.count() /
+                                                    info.processed)
+                                          : int64_t{0};
+                };
+                UniValue entry(UniValue::VOBJ);
+                entry.pushKV("name", info.name);
+                entry.pushKV("threads", info.threads);
+                entry.pushKV("depth", uint64_t(info.depth));
+                entry.pushKV("max_depth", uint64_t(info.max_depth));
+                entry.pushKV("active", uint64_t(info.active));
+                entry.pushKV("processed", info.processed);
+                entry.pushKV("rejected", info.rejected);
+                entry.pushKV("mean_wait", mean(info.total_wait));
+                entry.pushKV("max_wait", int64_t{info.max_wait.count()});
+                entry.pushKV("mean_duration", mean(info.total_duration));
+                work_queues.push_back(entry);
+            }
+            result.pushKV("work_queues", work_queues);
+
             return result;
         }};
 }
@@ -432,11 +495,66 @@ static UniValue JSONRPCExecOne(const Config &config, RPCServer &rpcServer,
     return rpc_result;
 }
 
+namespace {
+/** State of a batch request, shared by the threads executing it */
+struct RPCBatch {
+    RPCBatch(const Config &config_in, RPCServer &rpc_server_in,
+             const JSONRPCRequest &jreq_in, const UniValue &requests_in)
+        : config(config_in), rpcServer(rpc_server_in), jreq(jreq_in),
+          requests(requests_in), replies(requests_in.size()) {}
+
+    const Config &config;
+    RPCServer &rpcServer;
+    const JSONRPCRequest jreq;
+    //! Only accessed while some requests are not started yet
+    const UniValue &requests;
+    std::vector<UniValue> replies;
+    //! Index of the next request to start
+    std::atomic<size_t> next{0};
+
+    Mutex mutex;
+    std::condition_variable cond;
+    size_t num_done GUARDED_BY(mutex){0};
+
+    /** Execute requests until they are all started */
+    void Run() EXCLUSIVE_LOCKS_REQUIRED(!mutex) {
+        for (size_t i = next++; i < replies.size(); i = next++) {
+            replies[i] = JSONRPCExecOne(config, rpcServer, jreq, requests[i]);
+            LOCK(mutex);
+            if (++num_done == replies.size()) {
+                cond.notify_all();
+            }
+        }
+    }
+};
+} // namespace
+
 std::string JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
-                             const JSONRPCRequest &jreq, const UniValue &vReq) {
+                             const JSONRPCRequest &jreq, const UniValue &vReq,
+                             const RPCTaskScheduler &schedule,
+                             size_t max_parallelism) {
+    // Helpers may only get to run after the batch is done, so they share the
+    // ownership of its state.
+    auto batch{std::make_shared<RPCBatch>(config, rpcServer, jreq, vReq)};
+    if (schedule) {
+        const size_t parallelism{std::min(max_parallelism, vReq.size())};
+        for (size_t i = 1; i < parallelism; ++i) {
+            if (!schedule([batch]() { batch->Run(); })) {
+                break;
+            }
+        }
+    }
+    batch->Run();
+    {
+        WAIT_LOCK(batch->mutex, lock);
+        batch->cond.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(batch->mutex) {
+            return batch->num_done == batch->replies.size();
+        });
+    }
+
     UniValue ret(UniValue::VARR);
-    for (size_t i = 0; i < vReq.size(); i++) {
-        ret.push_back(JSONRPCExecOne(config, rpcServer, jreq, vReq[i]));
+    for (UniValue &reply : batch->replies) {
+        ret.push_back(std::move(reply));
     }
 
     return ret.write() + "\n";
@@ -244,8 +244,23 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
+
+/**
+ * Runs a task on another thread. Returns false if the task could not be
+ * scheduled, in which case it is never run.
+ */
+using RPCTaskScheduler = std::function<bool(std::function<void()>)>;
+
+/**
+ * Execute a batch of requests and return the serialized replies, in the order
+ * of the requests. Up to max_parallelism requests are executed at the same
+ * time: the calling thread executes requests itself and uses schedule to get
+ * help from other threads.
+ */
 std::string JSONRPCExecBatch(const Config &config, RPCServer &rpcServer,
-                             const JSONRPCRequest &req, const UniValue &vReq);
+                             const JSONRPCRequest &req, const UniValue &vReq,
+                             const RPCTaskScheduler &schedule = {},
+                             size_t max_parallelism = 1);
 
 /**
  * Retrieves any serialization flags requested in command line argument
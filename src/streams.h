@@ -141,7 +141,7 @@ public:
     SpanReader(int type, int version, Span<const uint8_t> data)
         : m_type(type), m_version(version), m_data(data) {}
 
-    template <typename T> SpanReader &operator>>(T &obj) {
+    template <typename T> SpanReader &operator>>(T &&obj) {
         // Unserialize from this stream
         ::Unserialize(*this, obj);
         return (*this);
@@ -165,6 +165,13 @@ public:
         memcpy(dst.data(), m_data.data(), dst.size());
         m_data = m_data.subspan(dst.size());
     }
+
+    void ignore(size_t n) {
+        if (n > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_data = m_data.subspan(n);
+    }
 };
 
 /**
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+
+#include <chain.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <script/standard.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+static void WaitForSync(AddressIndex &index) {
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_initial_sync, TestChain100Setup) {
+    AddressIndex address_index(1 << 20, true);
+    const CScript coinbase_script =
+        GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+
+    std::vector<AddressHistoryEntry> history;
+    std::vector<AddressUtxo> utxos;
+    BOOST_CHECK(address_index.FindHistory(coinbase_script, 0, 1000, history));
+    BOOST_CHECK(history.empty());
+
+    BOOST_REQUIRE(address_index.Start(m_node.chainman->ActiveChainstate()));
+    WaitForSync(address_index);
+
+    // Each block of the setup chain pays its coinbase to the script
+    BOOST_REQUIRE(address_index.FindHistory(coinbase_script, 0, 1000, history));
+    BOOST_REQUIRE_EQUAL(history.size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < history.size(); ++i) {
+        BOOST_CHECK_EQUAL(history[i].height, int(i) + 1);
+        BOOST_CHECK(history[i].tx->GetId() == m_coinbase_txns[i]->GetId());
+        BOOST_CHECK(history[i].block_hash ==
+                    WITH_LOCK(cs_main, return m_node.chainman->ActiveChain()
+                                           [i + 1]
+                                               ->GetBlockHash()));
+    }
+    BOOST_REQUIRE(address_index.FindUtxos(coinbase_script, 0, 1000, utxos));
+    BOOST_CHECK_EQUAL(utxos.size(), m_coinbase_txns.size());
+    for (const AddressUtxo &utxo : utxos) {
+        BOOST_CHECK(utxo.amount > Amount::zero());
+    }
+
+    // Paging
+    history.clear();
+    BOOST_REQUIRE(address_index.FindHistory(coinbase_script, 10, 5, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 5U);
+    BOOST_CHECK_EQUAL(history.front().height, 11);
+    BOOST_CHECK_EQUAL(history.back().height, 15);
+
+    // Spend a coinbase to a new script, in a block paying to the same script
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript dest_script =
+        GetScriptForDestination(PKHash(key.GetPubKey()));
+    const CMutableTransaction spend = CreateValidMempoolTransaction(
+        m_coinbase_txns[0], 0, 1, coinbaseKey, dest_script, COIN,
+        /*submit=*/false);
+    const CBlock block = CreateAndProcessBlock({spend}, dest_script);
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+
+    history.clear();
+    BOOST_REQUIRE(address_index.FindHistory(coinbase_script, 0, 1000, history));
+    BOOST_REQUIRE_EQUAL(history.size(), m_coinbase_txns.size() + 1);
+    BOOST_CHECK(history.back().tx->GetId() == spend.GetId());
+    utxos.clear();
+    BOOST_REQUIRE(address_index.FindUtxos(coinbase_script, 0, 1000, utxos));
+    BOOST_CHECK_EQUAL(utxos.size(), m_coinbase_txns.size() - 1);
+    for (const AddressUtxo &utxo : utxos) {
+        BOOST_CHECK(utxo.outpoint.GetTxId() != m_coinbase_txns[0]->GetId());
+    }
+
+    // Both transactions of the block are in a single history entry
+    history.clear();
+    BOOST_REQUIRE(address_index.FindHistory(dest_script, 0, 1000, history));
+    BOOST_REQUIRE_EQUAL(history.size(), 2U);
+    BOOST_CHECK(history[0].tx->GetId() == block.vtx[0]->GetId());
+    BOOST_CHECK(history[1].tx->GetId() == spend.GetId());
+    BOOST_CHECK_EQUAL(history[1].height, 101);
+    utxos.clear();
+    BOOST_REQUIRE(address_index.FindUtxos(dest_script, 0, 1000, utxos));
+    BOOST_CHECK_EQUAL(utxos.size(), 2U);
+
+    // Reorg the block out, the spent coinbase is restored
+    {
+        BlockValidationState state;
+        CBlockIndex *tip =
+            WITH_LOCK(cs_main, return m_node.chainman->ActiveTip());
+        BOOST_REQUIRE(
+            m_node.chainman->ActiveChainstate().InvalidateBlock(state, tip));
+    }
+    CreateAndProcessBlock({}, CScript() << OP_TRUE);
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+
+    history.clear();
+    BOOST_REQUIRE(address_index.FindHistory(dest_script, 0, 1000, history));
+    BOOST_CHECK(history.empty());
+    utxos.clear();
+    BOOST_REQUIRE(address_index.FindUtxos(dest_script, 0, 1000, utxos));
+    BOOST_CHECK(utxos.empty());
+    history.clear();
+    BOOST_REQUIRE(address_index.FindHistory(coinbase_script, 0, 1000, history));
+    BOOST_CHECK_EQUAL(history.size(), m_coinbase_txns.size());
+    utxos.clear();
+    BOOST_REQUIRE(address_index.FindUtxos(coinbase_script, 0, 1000, utxos));
+    BOOST_CHECK_EQUAL(utxos.size(), m_coinbase_txns.size());
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    address_index.Stop();
+
+    // Let scheduler events finish running to avoid accessing any memory related
+    // to the index after it is destructed
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,10 +10,12 @@
 #include <node/miner.h>
 #include <pow/pow.h>
 #include <script/standard.h>
+#include <streams.h>
 #include <test/util/blockfilter.h>
 #include <test/util/mining.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
+#include <version.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -46,16 +48,20 @@ static bool CheckFilterLookups(BlockFilterIndex &filter_index,
     BlockFilter filter;
     uint256 filter_header;
     std::vector<BlockFilter> filters;
+    std::vector<std::vector<uint8_t>> raw_filters;
     std::vector<uint256> filter_hashes;
 
     BOOST_CHECK(filter_index.LookupFilter(block_index, filter));
     BOOST_CHECK(filter_index.LookupFilterHeader(block_index, filter_header));
     BOOST_CHECK(filter_index.LookupFilterRange(block_index->nHeight,
                                                block_index, filters));
+    BOOST_CHECK(filter_index.LookupRawFilterRange(block_index->nHeight,
+                                                  block_index, raw_filters));
     BOOST_CHECK(filter_index.LookupFilterHashRange(block_index->nHeight,
                                                    block_index, filter_hashes));
 
     BOOST_CHECK_EQUAL(filters.size(), 1U);
+    BOOST_CHECK_EQUAL(raw_filters.size(), 1U);
     BOOST_CHECK_EQUAL(filter_hashes.size(), 1U);
 
     BOOST_CHECK_EQUAL(filter.GetHash(), expected_filter.GetHash());
@@ -64,6 +70,12 @@ static bool CheckFilterLookups(BlockFilterIndex &filter_index,
     BOOST_CHECK_EQUAL(filters[0].GetHash(), expected_filter.GetHash());
     BOOST_CHECK_EQUAL(filter_hashes[0], expected_filter.GetHash());
 
+    // The raw filter is the serialized filter, without the type
+    CDataStream expected_raw(SER_NETWORK, PROTOCOL_VERSION);
+    expected_raw << expected_filter.GetBlockHash()
+                 << expected_filter.GetEncodedFilter();
+    BOOST_CHECK(MakeByteSpan(raw_filters[0]) == MakeByteSpan(expected_raw));
+
     filters.clear();
     filter_hashes.clear();
     last_header = filter_header;
@@ -307,6 +319,70 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync,
     filter_index.Stop();
 }
 
+static void CheckRangeLookups(const BlockFilterIndex &filter_index,
+                              const CBlockIndex *tip) {
+    std::vector<BlockFilter> filters;
+    std::vector<std::vector<uint8_t>> raw_filters;
+    std::vector<uint256> filter_hashes;
+    for (int start_height : {0, tip->nHeight - 20, tip->nHeight}) {
+        BOOST_CHECK(filter_index.LookupFilterRange(start_height, tip, filters));
+        BOOST_CHECK(
+            filter_index.LookupRawFilterRange(start_height, tip, raw_filters));
+        BOOST_CHECK(
+            filter_index.LookupFilterHashRange(start_height, tip, filter_hashes));
+        const size_t count = tip->nHeight - start_height + 1;
+        BOOST_REQUIRE_EQUAL(filters.size(), count);
+        BOOST_REQUIRE_EQUAL(raw_filters.size(), count);
+        BOOST_REQUIRE_EQUAL(filter_hashes.size(), count);
+        for (size_t i = 0; i < count; ++i) {
+            CDataStream expected_raw(SER_NETWORK, PROTOCOL_VERSION);
+            expected_raw << filters[i].GetBlockHash()
+                         << filters[i].GetEncodedFilter();
+            BOOST_CHECK(MakeByteSpan(raw_filters[i]) ==
+                        MakeByteSpan(expected_raw));
+            BOOST_CHECK_EQUAL(filter_hashes[i], filters[i].GetHash());
+            BOOST_CHECK(filters[i].GetBlockHash() ==
+                        tip->GetAncestor(start_height + i)->GetBlockHash());
+        }
+
+        uint256 header;
+        BOOST_CHECK(filter_index.LookupFilterHeader(tip, header));
+    }
+
+    // No checkpoint below CFCHECKPT_INTERVAL
+    std::shared_ptr<const std::vector<uint8_t>> checkpoints;
+    BOOST_CHECK(filter_index.LookupCheckpoints(tip, checkpoints));
+    BOOST_REQUIRE(checkpoints);
+    BOOST_CHECK_EQUAL(checkpoints->size(), 1U);
+    BOOST_CHECK_EQUAL((*checkpoints)[0], 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_cache, TestChain100Setup) {
+    // Only the most recent blocks are cached, the older ones are read from
+    // the database.
+    gArgs.ForceSetArg("-blockfiltercache", "10");
+    const CBlockIndex *tip =
+        WITH_LOCK(cs_main, return m_node.chainman->ActiveTip());
+    for (int restart = 0; restart < 2; ++restart) {
+        // The second time, the cache is loaded from the database
+        BlockFilterIndex filter_index(BlockFilterType::BASIC, 1 << 20,
+                                      /*f_memory=*/false,
+                                      /*f_wipe=*/restart == 0);
+        BOOST_REQUIRE(filter_index.Start(m_node.chainman->ActiveChainstate()));
+        constexpr int64_t timeout_ms = 30 * 1000;
+        int64_t time_start = GetTimeMillis();
+        while (!filter_index.BlockUntilSyncedToCurrentChain()) {
+            BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+            UninterruptibleSleep(std::chrono::milliseconds{100});
+        }
+        CheckRangeLookups(filter_index, tip);
+
+        filter_index.Interrupt();
+        filter_index.Stop();
+    }
+    gArgs.ClearForcedArg("-blockfiltercache");
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup) {
     BlockFilterIndex *filter_index;
 
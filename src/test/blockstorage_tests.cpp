@@ -4,6 +4,7 @@
 
 #include <chainparams.h>
 #include <config.h>
+#include <flatfile.h>
 #include <node/blockstorage.h>
 #include <undo.h>
 #include <validation.h>
@@ -96,6 +97,80 @@ BOOST_AUTO_TEST_CASE(read_tx_data_from_disk) {
                     {Coin(CTxOut(50 * COIN, CScript() << OP_1), 101, true)});
 }
 
+BOOST_AUTO_TEST_CASE(read_txs_from_disk) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+
+    // Read the coinbase txs in reverse order, the results must be in the
+    // requested order.
+    std::vector<CTransactionRef> expected;
+    std::vector<FlatFilePos> positions;
+    auto active_tip =
+        WITH_LOCK(chainman.GetMutex(), return chainman.ActiveTip());
+    for (int32_t height = 99; height >= 0; --height) {
+        CBlockIndex *pindex = active_tip->GetAncestor(height);
+        CBlock block;
+        BOOST_CHECK(chainman.m_blockman.ReadBlockFromDisk(block, *pindex));
+        expected.push_back(block.vtx[0]);
+        positions.push_back(WITH_LOCK(
+            cs_main, return FlatFilePos(pindex->nFile, pindex->nDataPos + 81)));
+    }
+    // Positions can be repeated
+    expected.push_back(expected[0]);
+    positions.push_back(positions[0]);
+
+    std::vector<CMutableTransaction> txs;
+    BOOST_CHECK(chainman.m_blockman.ReadTxsFromDisk(txs, positions));
+    BOOST_REQUIRE_EQUAL(txs.size(), expected.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        BOOST_CHECK_EQUAL(txs[i].GetId(), expected[i]->GetId());
+    }
+
+    std::vector<CTxUndo> tx_undos;
+    BOOST_CHECK(chainman.m_blockman.ReadTxUndosFromDisk(tx_undos, {}));
+    BOOST_CHECK(tx_undos.empty());
+
+    // A single bad position fails the whole batch
+    positions.emplace_back(0, 0x7fffffff);
+    BOOST_CHECK(!chainman.m_blockman.ReadTxsFromDisk(txs, positions));
+    BOOST_CHECK(!chainman.m_blockman.ReadTxUndosFromDisk(
+        tx_undos, {FlatFilePos(0x7fffffff, 0)}));
+}
+
+BOOST_AUTO_TEST_CASE(read_raw_block_data_from_disk) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    const BlockManager &blockman = chainman.m_blockman;
+
+    auto active_tip =
+        WITH_LOCK(chainman.GetMutex(), return chainman.ActiveTip());
+    for (int32_t height = 0; height <= active_tip->nHeight; ++height) {
+        const CBlockIndex *pindex = active_tip->GetAncestor(height);
+        const auto [block_pos, undo_pos] = WITH_LOCK(
+            cs_main,
+            return std::make_pair(pindex->GetBlockPos(), pindex->GetUndoPos()));
+
+        // The raw data is the serialization of the block and undo data
+        CBlock block;
+        BOOST_CHECK(blockman.ReadBlockFromDisk(block, *pindex));
+        std::vector<uint8_t> raw;
+        BOOST_CHECK(blockman.ReadRawBlockFromDisk(raw, block_pos));
+        CDataStream expected(SER_DISK, CLIENT_VERSION);
+        expected << block;
+        BOOST_CHECK_EQUAL(HexStr(raw), HexStr(expected));
+
+        if (height == 0) {
+            // The genesis block has no undo data
+            BOOST_CHECK(!blockman.ReadRawUndoFromDisk(raw, undo_pos));
+            continue;
+        }
+        CBlockUndo blockundo;
+        BOOST_CHECK(blockman.UndoReadFromDisk(blockundo, *pindex));
+        BOOST_CHECK(blockman.ReadRawUndoFromDisk(raw, undo_pos));
+        expected.clear();
+        expected << blockundo;
+        BOOST_CHECK_EQUAL(HexStr(raw), HexStr(expected));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(read_tx_data_from_disk_bad) {
     CMutableTransaction tx;
     CTxUndo txundo;
@@ -110,4 +185,74 @@ BOOST_AUTO_TEST_CASE(read_tx_data_from_disk_bad) {
         txundo, FlatFilePos(0, 0x7fffffff)));
 }
 
+BOOST_AUTO_TEST_CASE(block_writer) {
+    const fs::path dir{m_args.GetDataDirBase() / "block_writer"};
+    FlatFileSeq block_seq{dir, "blk", 0x1000};
+    FlatFileSeq undo_seq{dir, "rev", 0x1000};
+    node::BlockFileWriter writer{block_seq, undo_seq, /*max_queue_size=*/100};
+
+    const auto check_file = [&](FlatFileSeq &seq, const FlatFilePos &pos,
+                                const std::vector<uint8_t> &expected) {
+        std::vector<uint8_t> data(expected.size());
+        FILE *file{seq.Open(pos, /*read_only=*/true)};
+        BOOST_REQUIRE(file);
+        BOOST_CHECK_EQUAL(fread(data.data(), 1, data.size(), file),
+                          data.size());
+        fclose(file);
+        BOOST_CHECK(data == expected);
+    };
+
+    // Without the thread, the data is written right away
+    BOOST_CHECK(writer.Write(FlatFilePos(0, 0), /*undo=*/false, {1, 2, 3}));
+    check_file(block_seq, FlatFilePos(0, 0), {1, 2, 3});
+
+    writer.Start();
+    // Out of order, interleaved, and larger than the queue
+    BOOST_CHECK(writer.Write(FlatFilePos(0, 13), /*undo=*/false,
+                             std::vector<uint8_t>(150, 7)));
+    BOOST_CHECK(writer.Write(FlatFilePos(1, 0), /*undo=*/true, {4, 5}));
+    std::vector<uint8_t> buffer{writer.GetBuffer()};
+    buffer.assign(10, 6);
+    BOOST_CHECK(writer.Write(FlatFilePos(0, 3), /*undo=*/false, buffer));
+    writer.WaitForWrites(FlatFilePos(0, 163), /*undo=*/false);
+    check_file(block_seq, FlatFilePos(0, 3), buffer);
+    check_file(block_seq, FlatFilePos(0, 13), std::vector<uint8_t>(150, 7));
+    BOOST_CHECK(writer.Flush());
+    check_file(undo_seq, FlatFilePos(1, 0), {4, 5});
+
+    // The queue is written before the thread stops
+    BOOST_CHECK(writer.Write(FlatFilePos(1, 2), /*undo=*/true, {8}));
+    writer.Stop();
+    check_file(undo_seq, FlatFilePos(1, 0), {4, 5, 8});
+
+    // A failed write is reported from then on
+    fs::create_directories(block_seq.FileName(FlatFilePos(2, 0)));
+    BOOST_CHECK(!writer.Write(FlatFilePos(2, 0), /*undo=*/false, {9}));
+    BOOST_CHECK(!writer.Write(FlatFilePos(0, 163), /*undo=*/false, {9}));
+    BOOST_CHECK(!writer.Flush());
+}
+
+BOOST_AUTO_TEST_CASE(read_blocks_while_written) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    chainman.m_blockman.StartBlockWriter();
+
+    // The blocks and their undo data can be read as soon as they are
+    // connected, whether they were written already or not.
+    for (int i = 0; i < 20; ++i) {
+        const CBlock expected{CreateAndProcessBlock(
+            {}, CScript() << OP_TRUE, &chainman.ActiveChainstate())};
+        const CBlockIndex *tip{
+            WITH_LOCK(chainman.GetMutex(), return chainman.ActiveTip())};
+        BOOST_CHECK_EQUAL(tip->GetBlockHash(), expected.GetHash());
+        CBlock block;
+        BOOST_CHECK(chainman.m_blockman.ReadBlockFromDisk(block, *tip));
+        BOOST_CHECK_EQUAL(block.GetHash(), expected.GetHash());
+        CBlockUndo blockundo;
+        BOOST_CHECK(chainman.m_blockman.UndoReadFromDisk(blockundo, *tip));
+    }
+
+    chainman.ActiveChainstate().ForceFlushStateToDisk();
+    chainman.m_blockman.StopBlockWriter();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/chainsnapshot.h>
+
+#include <chain.h>
+
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <deque>
+#include <vector>
+
+using node::ChainSnapshot;
+using node::ChainSnapshotPublisher;
+using node::ChainSnapshotRef;
+
+namespace {
+struct TestBlocks {
+    // Deques so the pointers remain valid as blocks are added
+    std::deque<BlockHash> hashes;
+    std::deque<CBlockIndex> blocks;
+
+    CBlockIndex *Add(CBlockIndex *pprev) {
+        hashes.emplace_back(InsecureRand256());
+        CBlockIndex &block = blocks.emplace_back();
+        block.nHeight = pprev ? pprev->nHeight + 1 : 0;
+        block.pprev = pprev;
+        block.phashBlock = &hashes.back();
+        block.BuildSkip();
+        return &block;
+    }
+
+    CBlockIndex *Extend(CBlockIndex *pprev, int count) {
+        for (int i = 0; i < count; ++i) {
+            pprev = Add(pprev);
+        }
+        return pprev;
+    }
+};
+} // namespace
+
+static void CheckSnapshot(const ChainSnapshot &snapshot, const CChain &chain) {
+    BOOST_CHECK_EQUAL(snapshot.Height(), chain.Height());
+    BOOST_CHECK(snapshot.Tip() == chain.Tip());
+    BOOST_CHECK(snapshot[-1] == nullptr);
+    BOOST_CHECK(snapshot[chain.Height() + 1] == nullptr);
+    for (int height = 0; height <= chain.Height(); ++height) {
+        const CBlockIndex *pindex = chain[height];
+        BOOST_CHECK(snapshot[height] == pindex);
+        BOOST_CHECK(snapshot.Contains(pindex));
+        BOOST_CHECK(snapshot.Find(pindex->GetBlockHash()) == pindex);
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(chainsnapshot_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(follows_the_chain) {
+    TestBlocks blocks;
+    CChain chain;
+    ChainSnapshotPublisher publisher;
+
+    const ChainSnapshotRef empty{publisher.Get()};
+    BOOST_CHECK_EQUAL(empty->Height(), -1);
+    BOOST_CHECK(empty->Tip() == nullptr);
+    BOOST_CHECK(empty->Find(BlockHash(InsecureRand256())) == nullptr);
+
+    // Span several chunks, then append blocks one at a time
+    CBlockIndex *tip = blocks.Extend(nullptr, 3 * 4096 - 10);
+    chain.SetTip(*tip);
+    publisher.Publish(chain);
+    CheckSnapshot(*publisher.Get(), chain);
+    for (int i = 0; i < 20; ++i) {
+        tip = blocks.Add(tip);
+        chain.SetTip(*tip);
+        publisher.Publish(chain);
+        BOOST_CHECK(publisher.Get()->Tip() == tip);
+    }
+    CheckSnapshot(*publisher.Get(), chain);
+    const ChainSnapshotRef before_reorg{publisher.Get()};
+
+    // Reorg to a longer chain forking before the last chunk boundary
+    CBlockIndex *fork_point = chain[2 * 4096 - 5];
+    CBlockIndex *old_tip = tip;
+    tip = blocks.Extend(fork_point, 4096 + 100);
+    chain.SetTip(*tip);
+    publisher.Publish(chain);
+    const ChainSnapshotRef after_reorg{publisher.Get()};
+    CheckSnapshot(*after_reorg, chain);
+
+    // The blocks that left the chain are not found anymore
+    for (const CBlockIndex *pindex = old_tip; pindex != fork_point;
+         pindex = pindex->pprev) {
+        BOOST_CHECK(!after_reorg->Contains(pindex));
+        BOOST_CHECK(after_reorg->Find(pindex->GetBlockHash()) == nullptr);
+        // But the previous snapshot is unchanged
+        BOOST_CHECK(before_reorg->Contains(pindex));
+        BOOST_CHECK(before_reorg->Find(pindex->GetBlockHash()) == pindex);
+    }
+    BOOST_CHECK(before_reorg->Tip() == old_tip);
+
+    // Rewind to a shorter chain, then to an empty one
+    tip = chain[100];
+    chain.SetTip(*tip);
+    publisher.Publish(chain);
+    CheckSnapshot(*publisher.Get(), chain);
+    BOOST_CHECK(publisher.Get()->Find(fork_point->GetBlockHash()) == nullptr);
+
+    chain.SetTip(*blocks.Extend(tip, 1));
+    publisher.Publish(chain);
+    CheckSnapshot(*publisher.Get(), chain);
+
+    publisher.Publish(CChain{});
+    BOOST_CHECK_EQUAL(publisher.Get()->Height(), -1);
+    BOOST_CHECK(publisher.Get()->Find(tip->GetBlockHash()) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1171,6 +1171,190 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(coin_prefetch) {
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+
+    const COutPoint outpoint(TxId{InsecureRand256()}, 0);
+    Coin coin = MakeCoin();
+    const Coin expected = coin;
+    cache.PrefetchCoin(outpoint, std::move(coin));
+    cache.SelfTest();
+
+    // The prefetched coin is not dirty, it is not written back to the base.
+    auto it = cache.map().find(outpoint);
+    BOOST_CHECK(it != cache.map().end());
+    BOOST_CHECK_EQUAL(it->second.flags, 0);
+    BOOST_CHECK(it->second.coin == expected);
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!base.HaveCoin(outpoint));
+
+    // An existing entry is left alone, even a spent one. The coin is not
+    // FRESH so spending it leaves an entry behind.
+    cache.AddCoin(outpoint, MakeCoin(), /*possible_overwrite=*/true);
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    cache.PrefetchCoin(outpoint, MakeCoin());
+    cache.SelfTest();
+    BOOST_CHECK(!cache.HaveCoin(outpoint));
+}
+
+BOOST_AUTO_TEST_CASE(coins_evict_cold) {
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+
+    const auto add_coin = [&](uint32_t height) {
+        COutPoint outpoint(TxId{InsecureRand256()}, 0);
+        CScript scriptPubKey;
+        scriptPubKey.assign(uint32_t{56}, 1);
+        cache.AddCoin(outpoint,
+                      Coin(CTxOut(InsecureRandMoneyAmount(), scriptPubKey),
+                           height, /*IsCoinbase=*/false),
+                      /*possible_overwrite=*/false);
+        return outpoint;
+    };
+    const COutPoint oldest = add_coin(0);
+    const COutPoint older = add_coin(5000);
+    const COutPoint recent = add_coin(100000);
+    cache.SetBestBlock(BlockHash{InsecureRand256()});
+    BOOST_CHECK(cache.Sync());
+    // Modified coins can't be evicted, however old they are.
+    const COutPoint modified = add_coin(0);
+
+    cache.EvictColdCoins(cache.LiveMemoryUsage());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 4U);
+
+    cache.EvictColdCoins(cache.LiveMemoryUsage() - 1);
+    cache.SelfTest();
+    BOOST_CHECK(!cache.HaveCoinInCache(oldest));
+    BOOST_CHECK(cache.HaveCoinInCache(older));
+    BOOST_CHECK(cache.HaveCoinInCache(recent));
+    BOOST_CHECK(cache.HaveCoinInCache(modified));
+
+    cache.EvictColdCoins(0);
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 1U);
+    BOOST_CHECK(cache.HaveCoinInCache(modified));
+    // The evicted coins are still available from the base.
+    BOOST_CHECK(cache.HaveCoin(recent));
+}
+
+BOOST_AUTO_TEST_CASE(coins_write_behind) {
+    CCoinsViewDB db{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewWriteBehind writer(&db, /*background=*/true);
+    CCoinsViewCacheTest cache(&writer);
+
+    const COutPoint outpoint(TxId{InsecureRand256()}, 0);
+    const BlockHash block1{InsecureRand256()};
+    cache.AddCoin(outpoint, MakeCoin(), /*possible_overwrite=*/false);
+    cache.SetBestBlock(block1);
+    BOOST_CHECK(cache.Sync());
+
+    // The coin is visible before it is written.
+    BOOST_CHECK(writer.HaveCoin(outpoint));
+    BOOST_CHECK(writer.GetBestBlock() == block1);
+    BOOST_CHECK(writer.DynamicMemoryUsage() > 0);
+
+    BlockHash written;
+    BOOST_CHECK(writer.Complete(/*wait=*/true, &written));
+    BOOST_CHECK(written == block1);
+    BOOST_CHECK(!writer.IsWriting());
+    BOOST_CHECK_EQUAL(writer.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(db.HaveCoin(outpoint));
+    BOOST_CHECK(db.GetBestBlock() == block1);
+
+    // Spent coins are erased from the database.
+    const BlockHash block2{InsecureRand256()};
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    cache.SetBestBlock(block2);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!writer.HaveCoin(outpoint));
+    BOOST_CHECK(writer.Complete(/*wait=*/true));
+    BOOST_CHECK(!db.HaveCoin(outpoint));
+    BOOST_CHECK(db.GetBestBlock() == block2);
+}
+
+BOOST_AUTO_TEST_CASE(coins_write_through) {
+    CCoinsViewDB db{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewWriteBehind writer(&db, /*background=*/false);
+    CCoinsViewCacheTest cache(&writer);
+
+    // Without background writes, the coins are written before BatchWrite()
+    // returns and no copy of them is kept.
+    const COutPoint outpoint(TxId{InsecureRand256()}, 0);
+    const BlockHash block{InsecureRand256()};
+    cache.AddCoin(outpoint, MakeCoin(), /*possible_overwrite=*/false);
+    cache.SetBestBlock(block);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!writer.IsWriting());
+    BOOST_CHECK_EQUAL(writer.DynamicMemoryUsage(), 0U);
+    BOOST_CHECK(db.HaveCoin(outpoint));
+    BOOST_CHECK(db.GetBestBlock() == block);
+
+    BlockHash written;
+    BOOST_CHECK(writer.Complete(/*wait=*/true, &written));
+    BOOST_CHECK(written.IsNull());
+}
+
+static std::vector<COutPoint> ReadCursorKeys(CCoinsViewCursor &cursor) {
+    std::vector<COutPoint> keys;
+    for (; cursor.Valid(); cursor.Next()) {
+        COutPoint key;
+        BOOST_CHECK(cursor.GetKey(key));
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+BOOST_AUTO_TEST_CASE(coins_range_cursors) {
+    CCoinsViewDB db{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+    CCoinsViewCacheTest cache(&db);
+    for (int i = 0; i < 200; ++i) {
+        const TxId txid{InsecureRand256()};
+        for (uint32_t n = 0; n < 3; ++n) {
+            cache.AddCoin(COutPoint(txid, n), MakeCoin(),
+                          /*possible_overwrite=*/false);
+        }
+    }
+    cache.SetBestBlock(BlockHash{InsecureRand256()});
+    BOOST_CHECK(cache.Flush());
+
+    const std::vector<COutPoint> all_keys{
+        ReadCursorKeys(*std::unique_ptr<CCoinsViewCursor>(db.Cursor()))};
+    BOOST_CHECK_EQUAL(all_keys.size(), 600U);
+
+    // The ranges cover all the coins, in order, and don't split transactions.
+    for (size_t count : {1, 3, 7, 256, 1000}) {
+        const auto cursors{db.RangeCursors(count)};
+        BOOST_CHECK_EQUAL(cursors.size(), std::min<size_t>(count, 256));
+        std::vector<COutPoint> keys;
+        for (const auto &cursor : cursors) {
+            BOOST_CHECK(cursor->GetBestBlock() == db.GetBestBlock());
+            const std::vector<COutPoint> range_keys{ReadCursorKeys(*cursor)};
+            if (!keys.empty() && !range_keys.empty()) {
+                BOOST_CHECK(keys.back().GetTxId() !=
+                            range_keys.front().GetTxId());
+            }
+            keys.insert(keys.end(), range_keys.begin(), range_keys.end());
+        }
+        BOOST_CHECK(keys == all_keys);
+    }
+
+    // The cursors all see the database as it was when they were created.
+    const auto cursors{db.RangeCursors(4)};
+    cache.AddCoin(COutPoint(TxId{InsecureRand256()}, 0), MakeCoin(),
+                  /*possible_overwrite=*/false);
+    BOOST_CHECK(cache.Flush());
+    size_t num_keys{0};
+    for (const auto &cursor : cursors) {
+        num_keys += ReadCursorKeys(*cursor).size();
+    }
+    BOOST_CHECK_EQUAL(num_keys, all_keys.size());
+}
+
 BOOST_AUTO_TEST_CASE(coins_resource_is_used) {
     CCoinsMapMemoryResource resource;
     PoolResourceTester::CheckAllDataAccountedFor(resource);
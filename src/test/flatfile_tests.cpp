@@ -2,12 +2,17 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <flatfile.h>
 
 #include <clientversion.h>
 #include <common/args.h>
 #include <streams.h>
 
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -125,4 +130,98 @@ BOOST_AUTO_TEST_CASE(flatfile_flush) {
     BOOST_CHECK_EQUAL(fs::file_size(seq.FileName(FlatFilePos(0, 1))), 1U);
 }
 
+#ifndef WIN32
+BOOST_AUTO_TEST_CASE(flatfile_mappings) {
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+    const std::string data{"flatfile mappings"};
+    for (int file = 0; file < 3; ++file) {
+        AutoFile{seq.Open(FlatFilePos(file, 0))}.write(MakeByteSpan(data));
+    }
+    const auto as_string = [](const std::shared_ptr<const MappedFile> &m) {
+        return std::string(m->Data().begin(), m->Data().end());
+    };
+
+    FlatFileMappings mappings(seq, /*max_mappings=*/2);
+    BOOST_CHECK(!mappings.Get(3, 10));
+
+    const auto mapping0{mappings.Get(0, 8)};
+    BOOST_REQUIRE(mapping0);
+    BOOST_CHECK_EQUAL(as_string(mapping0), "flatfile");
+    // A long enough mapping is reused, a shorter one is replaced.
+    BOOST_CHECK(mappings.Get(0, 4) == mapping0);
+    const auto mapping0_long{mappings.Get(0, 100)};
+    BOOST_REQUIRE(mapping0_long);
+    BOOST_CHECK(mapping0_long != mapping0);
+    // The mapping doesn't go past the end of the file, which is not mapped
+    // again for the same length.
+    BOOST_CHECK_EQUAL(as_string(mapping0_long), data);
+    BOOST_CHECK(mappings.Get(0, 100) == mapping0_long);
+
+    // The least recently used mapping is evicted, but stays valid.
+    const auto mapping1{mappings.Get(1, 8)};
+    BOOST_CHECK(mappings.Get(0, 8) == mapping0_long);
+    const auto mapping2{mappings.Get(2, 8)};
+    BOOST_REQUIRE(mapping1 && mapping2);
+    BOOST_CHECK(mappings.Get(0, 8) == mapping0_long);
+    BOOST_CHECK(mappings.Get(1, 8) != mapping1);
+    BOOST_CHECK_EQUAL(as_string(mapping1), "flatfile");
+
+    mappings.Erase(0);
+    BOOST_CHECK(mappings.Get(0, 8) != mapping0_long);
+}
+#endif
+
+#ifdef ENABLE_ZSTD
+BOOST_AUTO_TEST_CASE(flatfile_compression) {
+    const auto data_dir = m_args.GetDataDirBase();
+    FlatFileSeq seq(data_dir, "a", 100);
+    // Several compressed chunks, partly compressible
+    std::vector<uint8_t> data{g_insecure_rand_ctx.randbytes(300000)};
+    data.resize(1000000, 'x');
+    AutoFile{seq.Open(FlatFilePos(0, 0))}.write(MakeByteSpan(data));
+    const FlatFilePos end(0, data.size());
+
+    BOOST_CHECK_EQUAL(seq.CompressedFileName(end), data_dir / "a00000.dat.zst");
+    BOOST_REQUIRE(seq.Compress(end));
+    BOOST_CHECK(fs::file_size(seq.CompressedFileName(end)) < 400000);
+    fs::remove(seq.FileName(end));
+
+    // The compressed file can't be written to, and it is final already.
+    BOOST_CHECK(!seq.Open(FlatFilePos(0, 0)));
+    BOOST_CHECK(seq.Flush(end, /*finalize=*/true));
+    BOOST_CHECK(!fs::exists(seq.FileName(end)));
+
+    // It reads as the original file, from any position.
+    for (const unsigned int pos : {0, 262143, 500000, 999990, 100}) {
+        AutoFile file{seq.Open(FlatFilePos(0, pos), true)};
+        BOOST_REQUIRE(!file.IsNull());
+        std::vector<uint8_t> read(std::min<size_t>(300000, data.size() - pos));
+        file.read(MakeWritableByteSpan(read));
+        BOOST_CHECK(std::equal(read.begin(), read.end(), data.begin() + pos));
+        BOOST_CHECK_EQUAL(std::ftell(file.Get()), long(pos + read.size()));
+    }
+
+    AutoFile file{seq.Open(FlatFilePos(0, 0), true)};
+    uint8_t byte;
+    BOOST_CHECK_EQUAL(std::fseek(file.Get(), 700000, SEEK_SET), 0);
+    BOOST_CHECK_EQUAL(std::fseek(file.Get(), -400000, SEEK_CUR), 0);
+    file >> byte;
+    BOOST_CHECK_EQUAL(byte, data[300000]);
+    BOOST_CHECK_EQUAL(std::fseek(file.Get(), -1, SEEK_END), 0);
+    file >> byte;
+    BOOST_CHECK_EQUAL(byte, 'x');
+    BOOST_CHECK_THROW(file >> byte, std::ios_base::failure);
+
+    // A corrupted file can't be opened.
+    {
+        AutoFile corrupted{
+            fsbridge::fopen(seq.CompressedFileName(end), "rb+")};
+        BOOST_REQUIRE_EQUAL(std::fseek(corrupted.Get(), -1, SEEK_END), 0);
+        corrupted << uint8_t{0xff};
+    }
+    BOOST_CHECK(!seq.Open(FlatFilePos(0, 0), true));
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/jsonwriter.h>
+
+#include <test/util/setup_common.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(jsonwriter_tests, BasicTestingSetup)
+
+static UniValue SampleValue() {
+    UniValue value;
+    BOOST_REQUIRE(value.read(R"({"a": 1, "b\"\\": [true, false, null, -2.5],
+                               "c": {}, "d": [], "e": {"f": ["g\u0001\n"]},
+                               "h": [[1, [2]], {"i": {"j": "k"}}]})"));
+    return value;
+}
+
+BOOST_AUTO_TEST_CASE(same_output_as_univalue) {
+    const UniValue value{SampleValue()};
+    const std::string expected{value.write()};
+
+    for (size_t chunk_size : {1, 2, 7, 1000}) {
+        std::vector<std::string> chunks;
+        bool finished{false};
+        JSONWriter writer{
+            [&](std::string &&chunk, bool last) {
+                BOOST_CHECK(!finished);
+                finished = last;
+                chunks.push_back(std::move(chunk));
+            },
+            chunk_size};
+        writer.Value(value).Raw("\n");
+        BOOST_CHECK(!finished);
+        writer.Finish();
+        BOOST_CHECK(finished);
+
+        std::string output;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            // Only the last chunk may be shorter than the chunk size
+            if (i + 1 < chunks.size()) {
+                BOOST_CHECK_GE(chunks[i].size(), chunk_size);
+            }
+            output += chunks[i];
+        }
+        BOOST_CHECK_EQUAL(output, expected + "\n");
+        if (chunk_size == 1000) {
+            BOOST_CHECK_EQUAL(chunks.size(), 1U);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(incremental_construction) {
+    const UniValue value{SampleValue()};
+
+    std::string output;
+    JSONWriter writer{[&](std::string &&chunk, bool last) { output += chunk; },
+                      /*chunk_size=*/3};
+    writer.BeginObject()
+        .Pair("a", 1)
+        .Key("b\"\\")
+        .BeginArray()
+        .Value(true)
+        .Value(false)
+        .Value(NullUniValue)
+        .Value(value["b\"\\"][3])
+        .EndArray()
+        .Key("c")
+        .BeginObject()
+        .EndObject()
+        .Pair("d", UniValue(UniValue::VARR))
+        .Key("e")
+        .BeginObject()
+        .Pairs(value["e"])
+        .EndObject()
+        .Key("h")
+        .BeginArray()
+        .Value(value["h"][0])
+        .BeginObject()
+        .Key("i")
+        .BeginObject()
+        .Pair("j", "k")
+        .EndObject()
+        .EndObject()
+        .EndArray()
+        .EndObject()
+        .Finish();
+    BOOST_CHECK_EQUAL(output, value.write());
+
+    // Unbalanced documents are rejected
+    JSONWriter unbalanced{[](std::string &&, bool) {}};
+    unbalanced.BeginArray();
+    BOOST_CHECK_THROW(unbalanced.Key("a"), NonFatalCheckError);
+    BOOST_CHECK_THROW(unbalanced.Finish(), NonFatalCheckError);
+    unbalanced.EndArray();
+    BOOST_CHECK_THROW(unbalanced.EndArray(), NonFatalCheckError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
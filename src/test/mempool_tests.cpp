@@ -11,6 +11,7 @@
 #include <reverse_iterator.h>
 #include <util/time.h>
 
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
@@ -581,6 +582,85 @@ BOOST_AUTO_TEST_CASE(CompareTxMemPoolEntryByModifiedFeeRateTest) {
     checkOrdering(entryB, entryA);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolIndexChurnTest) {
+    CTxMemPool &pool = *Assert(m_node.mempool);
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Use more entries than a slab holds, with few distinct times and
+    // feerates so the buckets get shared.
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 600; ++i) {
+        txs.push_back(make_tx(/* output_values */ {(i + 1) * COIN}));
+        pool.addUnchecked(
+            entry.Fee(int64_t(InsecureRandRange(10)) * 100 * SATOSHI)
+                .Time(InsecureRandRange(20))
+                .FromTx(txs.back()));
+    }
+    BOOST_CHECK_EQUAL(pool.mapTx.size(), txs.size());
+    const size_t full_index_usage = pool.mapTx.DynamicMemoryUsage();
+
+    // Reorder some of them in the feerate index.
+    for (int i = 0; i < 50; ++i) {
+        pool.PrioritiseTransaction(
+            txs[InsecureRandRange(txs.size())]->GetId(),
+            (int64_t(InsecureRandRange(2000)) - 1000) * SATOSHI);
+    }
+
+    // Remove a random half of the entries.
+    const size_t usage = pool.DynamicMemoryUsage();
+    std::vector<bool> removed(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        if (InsecureRandBool()) {
+            pool.removeRecursive(*txs[i], REMOVAL_REASON_DUMMY);
+            removed[i] = true;
+        }
+    }
+    BOOST_CHECK_LT(pool.DynamicMemoryUsage(), usage);
+
+    for (size_t i = 0; i < txs.size(); ++i) {
+        BOOST_CHECK_EQUAL(pool.exists(txs[i]->GetId()), !removed[i]);
+    }
+    const size_t remaining = pool.mapTx.size();
+    BOOST_CHECK_EQUAL(remaining,
+                      std::count(removed.begin(), removed.end(), false));
+
+    // Every view contains all the entries, in order.
+    auto checkView = [&](const auto &view, auto &&ordered) {
+        size_t count = 0;
+        for (auto it = view.begin(); it != view.end(); ++it, ++count) {
+            if (count > 0) {
+                BOOST_CHECK(ordered(*std::prev(it), *it));
+            }
+        }
+        BOOST_CHECK_EQUAL(count, remaining);
+        BOOST_CHECK(view.rbegin() == std::make_reverse_iterator(view.end()));
+    };
+    checkView(pool.mapTx.get<entry_id>(), [](const auto &a, const auto &b) {
+        return a->GetEntryId() < b->GetEntryId();
+    });
+    checkView(pool.mapTx.get<entry_time>(), [](const auto &a, const auto &b) {
+        return a->GetTime() < b->GetTime() ||
+               (a->GetTime() == b->GetTime() &&
+                a->GetEntryId() < b->GetEntryId());
+    });
+    checkView(pool.mapTx.get<modified_feerate>(),
+              CompareTxMemPoolEntryByModifiedFeeRate());
+
+    // Once the entries are gone, the index releases its unused slabs and
+    // shrinks its hash table.
+    for (const CTransactionRef &tx : txs) {
+        pool.removeRecursive(*tx, REMOVAL_REASON_DUMMY);
+    }
+    BOOST_CHECK(pool.mapTx.empty());
+    BOOST_CHECK_LT(pool.mapTx.DynamicMemoryUsage(), full_index_usage / 2);
+
+    pool.clear();
+    BOOST_CHECK(pool.mapTx.empty());
+    BOOST_CHECK(pool.mapTx.get<modified_feerate>().begin() ==
+                pool.mapTx.get<modified_feerate>().end());
+}
+
 BOOST_AUTO_TEST_CASE(remove_for_finalized_block) {
     CTxMemPool &pool = *Assert(m_node.mempool);
     TestMemPoolEntryHelper entry;
@@ -19,6 +19,7 @@
 #include <univalue.h>
 
 #include <any>
+#include <thread>
 
 static UniValue JSON(std::string_view json) {
     UniValue value;
@@ -747,4 +748,64 @@ BOOST_AUTO_TEST_CASE(help_example) {
                    HelpExampleRpcNamed("foo", {{"arg", "true"}}));
 }
 
+BOOST_AUTO_TEST_CASE(rpc_batch) {
+    if (RPCIsInWarmup(nullptr)) {
+        SetRPCWarmupFinished();
+    }
+    GlobalConfig config;
+    RPCServer rpc_server;
+    JSONRPCRequest jreq;
+    jreq.context = &m_node;
+
+    UniValue requests(UniValue::VARR);
+    for (int i = 0; i < 50; ++i) {
+        requests.push_back(JSON(strprintf(
+            R"({"method": "%s", "params": [%d], "id": %d})",
+            i % 10 == 3 ? "unknownmethod" : "echo", i, i)));
+    }
+    requests.push_back(JSON("[]"));
+
+    const std::string sequential{
+        JSONRPCExecBatch(config, rpc_server, jreq, requests)};
+    const UniValue replies{JSON(sequential)};
+    BOOST_REQUIRE_EQUAL(replies.size(), requests.size());
+    for (int i = 0; i < 50; ++i) {
+        BOOST_CHECK_EQUAL(replies[i]["id"].getInt<int>(), i);
+        if (i % 10 == 3) {
+            BOOST_CHECK_EQUAL(replies[i]["error"]["code"].getInt<int>(),
+                              RPC_METHOD_NOT_FOUND);
+        } else {
+            BOOST_CHECK(replies[i]["error"].isNull());
+            BOOST_CHECK_EQUAL(replies[i]["result"][0].getInt<int>(), i);
+        }
+    }
+    BOOST_CHECK_EQUAL(replies[50]["error"]["code"].getInt<int>(),
+                      RPC_INVALID_REQUEST);
+
+    // Executing the requests on several threads gives the same replies in
+    // the same order, whether the helper threads get to run or not.
+    std::vector<std::thread> threads;
+    int num_scheduled{0};
+    auto schedule = [&](std::function<void()> task) {
+        if (++num_scheduled % 2 == 0) {
+            return false;
+        }
+        threads.emplace_back(std::move(task));
+        return true;
+    };
+    for (size_t parallelism : {1, 2, 4, 100}) {
+        BOOST_CHECK_EQUAL(JSONRPCExecBatch(config, rpc_server, jreq, requests,
+                                           schedule, parallelism),
+                          sequential);
+    }
+    BOOST_CHECK_EQUAL(num_scheduled, 4);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(
+        JSONRPCExecBatch(config, rpc_server, jreq, UniValue(UniValue::VARR),
+                         schedule, 4),
+        "[]\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
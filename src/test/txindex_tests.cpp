@@ -5,7 +5,9 @@
 #include <index/txindex.h>
 
 #include <chainparams.h>
+#include <common/args.h>
 #include <script/standard.h>
+#include <util/string.h>
 #include <util/time.h>
 #include <validation.h>
 
@@ -80,4 +82,36 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup) {
     SyncWithValidationInterfaceQueue();
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_sync_threads, TestChain100Setup) {
+    for (int threads : {1, MAX_INDEX_SYNC_THREADS}) {
+        gArgs.ForceSetArg("-indexsyncthreads", ToString(threads));
+        TxIndex txindex(1 << 20, true);
+        BOOST_REQUIRE(txindex.Start(m_node.chainman->ActiveChainstate()));
+
+        constexpr int64_t timeout_ms = 10 * 1000;
+        int64_t time_start = GetTimeMillis();
+        while (!txindex.BlockUntilSyncedToCurrentChain()) {
+            BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+            UninterruptibleSleep(std::chrono::milliseconds{100});
+        }
+
+        // Blocks prepared out of order are written in chain order
+        CTransactionRef tx_disk;
+        BlockHash block_hash;
+        for (const auto &txn : m_coinbase_txns) {
+            BOOST_REQUIRE(txindex.FindTx(txn->GetId(), block_hash, tx_disk));
+            BOOST_CHECK(tx_disk->GetId() == txn->GetId());
+            LOCK(cs_main);
+            const CBlockIndex *pindex =
+                m_node.chainman->m_blockman.LookupBlockIndex(block_hash);
+            BOOST_REQUIRE(pindex);
+            BOOST_CHECK(m_node.chainman->ActiveChain().Contains(pindex));
+        }
+
+        txindex.Stop();
+        SyncWithValidationInterfaceQueue();
+    }
+    gArgs.ClearForcedArg("-indexsyncthreads");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -273,6 +273,69 @@ BOOST_FIXTURE_TEST_CASE(package_validation_tests, TestChain100Setup) {
     BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize);
 }
 
+BOOST_FIXTURE_TEST_CASE(package_parallel_script_checks, TestChain100Setup) {
+    // Mine blocks to mature coinbases.
+    mineBlocks(5);
+    LOCK(cs_main);
+    unsigned int initialPoolSize = m_node.mempool->size();
+
+    // Independent transactions, which get their scripts checked in a single
+    // batch on the script check queue.
+    CKey dest_key;
+    dest_key.MakeNewKey(true);
+    CScript dest_script = GetScriptForDestination(PKHash(dest_key.GetPubKey()));
+    Package package_independent;
+    for (size_t i{0}; i < 5; ++i) {
+        auto mtx = CreateValidMempoolTransaction(
+            /*input_transaction=*/m_coinbase_txns[i], /*input_vout=*/0,
+            /*input_height=*/0, /*input_signing_key=*/coinbaseKey,
+            /*output_destination=*/dest_script,
+            /*output_amount=*/Amount(49 * COIN), /*submit=*/false);
+        package_independent.emplace_back(MakeTransactionRef(mtx));
+    }
+
+    const auto result_valid =
+        ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool,
+                          package_independent, /*test_accept=*/true);
+    if (auto err_valid{CheckPackageMempoolAcceptResult(
+            package_independent, result_valid, /*expect_valid=*/true,
+            nullptr)}) {
+        BOOST_ERROR(err_valid.value());
+    } else {
+        for (const auto &tx : package_independent) {
+            auto it = result_valid.m_tx_results.find(tx->GetId());
+            BOOST_CHECK_EQUAL(it->second.m_vsize.value(),
+                              GetVirtualTransactionSize(*tx));
+        }
+    }
+
+    // Break the script of one of the transactions in the middle of the batch:
+    // the failure must be attributed to that transaction.
+    CMutableTransaction mtx_invalid{*package_independent[2]};
+    mtx_invalid.vin[0].scriptSig << OP_FALSE;
+    CTransactionRef tx_invalid = MakeTransactionRef(mtx_invalid);
+    Package package_one_invalid{package_independent};
+    package_one_invalid[2] = tx_invalid;
+
+    const auto result_invalid =
+        ProcessNewPackage(m_node.chainman->ActiveChainstate(), *m_node.mempool,
+                          package_one_invalid, /*test_accept=*/true);
+    BOOST_CHECK_EQUAL(result_invalid.m_state.GetResult(),
+                      PackageValidationResult::PCKG_TX);
+    BOOST_CHECK_EQUAL(result_invalid.m_tx_results.size(), 1);
+    auto it_invalid = result_invalid.m_tx_results.find(tx_invalid->GetId());
+    BOOST_CHECK(it_invalid != result_invalid.m_tx_results.end());
+    BOOST_CHECK_EQUAL(it_invalid->second.m_state.GetResult(),
+                      TxValidationResult::TX_CONSENSUS);
+    BOOST_CHECK_EQUAL(
+        it_invalid->second.m_state.GetRejectReason(),
+        "mandatory-script-verify-flag-failed (Script evaluated without error "
+        "but finished with a false/empty top stack element)");
+
+    // Check that mempool size hasn't changed.
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), initialPoolSize);
+}
+
 BOOST_FIXTURE_TEST_CASE(noncontextual_package_tests, TestChain100Setup) {
     // The signatures won't be verified so we can just use a placeholder
     CKey placeholder_key;
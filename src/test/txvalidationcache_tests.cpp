@@ -104,6 +104,41 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, TestChain100Setup) {
     BOOST_CHECK_EQUAL(m_node.mempool->size(), 0U);
 }
 
+BOOST_FIXTURE_TEST_CASE(tx_mempool_reorg, TestChain100Setup) {
+    // A transaction that leaves the mempool in a block is added back when the
+    // block gets disconnected, in front of its children that stayed in the
+    // mempool.
+    const CScript scriptPubKey = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+    const CMutableTransaction parent = CreateValidMempoolTransaction(
+        m_coinbase_txns[0], /*input_vout=*/0, /*input_height=*/0, coinbaseKey,
+        scriptPubKey, /*output_amount=*/Amount(49 * COIN));
+    const CMutableTransaction child = CreateValidMempoolTransaction(
+        MakeTransactionRef(parent), /*input_vout=*/0, /*input_height=*/101,
+        coinbaseKey, scriptPubKey, /*output_amount=*/Amount(48 * COIN));
+    const TxId parent_txid = CTransaction(parent).GetId();
+    const TxId child_txid = CTransaction(child).GetId();
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 2U);
+
+    const CBlock block = CreateAndProcessBlock({parent}, scriptPubKey);
+    const CBlockIndex *tip =
+        WITH_LOCK(cs_main, return m_node.chainman->ActiveTip());
+    BOOST_CHECK_EQUAL(tip->GetBlockHash(), block.GetHash());
+    BOOST_CHECK(!m_node.mempool->exists(parent_txid));
+    BOOST_CHECK(m_node.mempool->exists(child_txid));
+
+    BlockValidationState state;
+    BOOST_CHECK(m_node.chainman->ActiveChainstate().InvalidateBlock(
+        state, const_cast<CBlockIndex *>(tip)));
+    BOOST_CHECK_EQUAL(m_node.mempool->size(), 2U);
+    BOOST_CHECK(m_node.mempool->exists(parent_txid));
+    BOOST_CHECK(m_node.mempool->exists(child_txid));
+    LOCK2(cs_main, m_node.mempool->cs);
+    const auto child_it = m_node.mempool->mapTx.find(child_txid);
+    BOOST_CHECK_EQUAL((*child_it)->GetMemPoolParentsConst().size(), 1U);
+    m_node.mempool->check(m_node.chainman->ActiveChainstate().CoinsTip(),
+                          m_node.chainman->ActiveHeight() + 1);
+}
+
 static inline bool
 CheckInputScripts(const CTransaction &tx, TxValidationState &state,
                   const CCoinsViewCache &view, const uint32_t flags,
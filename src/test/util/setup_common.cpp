@@ -224,6 +224,7 @@ ChainTestingSetup::ChainTestingSetup(
     constexpr int script_check_threads = 2;
     StartScriptCheckWorkerThreads(script_check_threads);
     StartPowCheckWorkerThreads(script_check_threads);
+    StartCoinPrefetchWorkerThreads(script_check_threads);
 }
 
 ChainTestingSetup::~ChainTestingSetup() {
@@ -232,6 +233,7 @@ ChainTestingSetup::~ChainTestingSetup() {
     }
     StopScriptCheckWorkerThreads();
     StopPowCheckWorkerThreads();
+    StopCoinPrefetchWorkerThreads();
     GetMainSignals().FlushBackgroundCallbacks();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
     m_node.connman.reset();
@@ -303,6 +303,96 @@ BOOST_AUTO_TEST_CASE(avalanche_finalization_bad_state) {
     BOOST_CHECK(activeChainstate.IsBlockAvalancheFinalized(pindex->pprev));
 }
 
+/**
+ * Test that the scripts of the blocks connected in a single step during IBD are
+ * verified together, and that an invalid script in the middle of such a step
+ * only leaves the blocks below it connected.
+ */
+BOOST_AUTO_TEST_CASE(deferred_script_checks) {
+    GlobalConfig config;
+    const CChainParams &chainParams = config.GetChainParams();
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+
+    bool ignored;
+    BOOST_REQUIRE(chainman.ProcessNewBlock(
+        std::make_shared<CBlock>(chainParams.GenesisBlock()),
+        /*force_processing=*/true, /*min_pow_checked=*/true,
+        /*new_block=*/&ignored));
+    BOOST_REQUIRE(chainman.ActiveChainstate().IsInitialBlockDownload());
+
+    // Spend the P2SH(OP_TRUE) coinbase output of a block
+    auto SpendingBlock = [&](const BlockHash &prev_hash,
+                             const CBlock &funding, const CScript &redeem) {
+        auto pblock = Block(config, prev_hash);
+        CMutableTransaction mtx;
+        mtx.vin.push_back(CTxIn(COutPoint(funding.vtx[0]->GetId(), 1),
+                                CScript() << ToByteVector(redeem)));
+        const CTxOut &funding_out{funding.vtx[0]->vout[1]};
+        mtx.vout.push_back(CTxOut(funding_out.nValue - 1000 * SATOSHI,
+                                  funding_out.scriptPubKey));
+        // Pad the transaction to the minimum size
+        mtx.vout.push_back(CTxOut(
+            Amount::zero(), CScript() << OP_RETURN << std::vector<uint8_t>(40)));
+        pblock->vtx.push_back(MakeTransactionRef(mtx));
+        return std::shared_ptr<const CBlock>{
+            FinalizeBlock(chainParams.GetConsensus(), pblock)};
+    };
+
+    // Mine a chain in which the coinbase of the first block is validly spent
+    // once it is mature, immediately followed by a block that spends the
+    // coinbase of the second block with a script that does not match.
+    std::vector<std::shared_ptr<const CBlock>> blocks;
+    BlockHash prev_hash{chainParams.GenesisBlock().GetHash()};
+    for (int i = 0; i < REGTEST_COINBASE_MATURITY; ++i) {
+        blocks.push_back(GoodBlock(config, prev_hash));
+        prev_hash = blocks.back()->GetHash();
+    }
+    blocks.push_back(
+        SpendingBlock(prev_hash, *blocks[0], CScript() << OP_TRUE));
+    const BlockHash last_valid_hash{blocks.back()->GetHash()};
+    blocks.push_back(
+        SpendingBlock(last_valid_hash, *blocks[1], CScript() << OP_FALSE));
+    const BlockHash invalid_hash{blocks.back()->GetHash()};
+    prev_hash = invalid_hash;
+    for (int i = 0; i < 3; ++i) {
+        blocks.push_back(GoodBlock(config, prev_hash));
+        prev_hash = blocks.back()->GetHash();
+    }
+
+    std::vector<CBlockHeader> headers;
+    for (const auto &block : blocks) {
+        headers.push_back(block->GetBlockHeader());
+    }
+    BlockValidationState state;
+    BOOST_REQUIRE(chainman.ProcessNewBlockHeaders(
+        headers, /*min_pow_checked=*/true, state));
+
+    // Hold back the first block so the whole chain is connected at once
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+        BOOST_CHECK(chainman.ProcessNewBlock(*it, /*force_processing=*/true,
+                                             /*min_pow_checked=*/true,
+                                             /*new_block=*/&ignored));
+    }
+
+    LOCK(cs_main);
+    const CBlockIndex *tip{chainman.ActiveTip()};
+    BOOST_CHECK_EQUAL(tip->GetBlockHash(), last_valid_hash);
+    for (const CBlockIndex *pindex = tip; pindex->pprev;
+         pindex = pindex->pprev) {
+        BOOST_CHECK(pindex->IsValid(BlockValidity::SCRIPTS));
+    }
+    const CBlockIndex *invalid{
+        chainman.m_blockman.LookupBlockIndex(invalid_hash)};
+    BOOST_CHECK(invalid->nStatus.hasFailed());
+    BOOST_CHECK(!invalid->IsValid(BlockValidity::SCRIPTS));
+
+    // The lock-free view of the chain followed it
+    const node::ChainSnapshotRef snapshot{chainman.GetChainSnapshot()};
+    BOOST_CHECK(snapshot->Tip() == tip);
+    BOOST_CHECK(snapshot->Find(last_valid_hash) == tip);
+    BOOST_CHECK(snapshot->Find(invalid_hash) == nullptr);
+}
+
 /**
  * Test that mempool updates happen atomically with reorgs.
  *
@@ -5,6 +5,7 @@
 #include <chainparams.h>
 #include <config.h>
 #include <consensus/validation.h>
+#include <kernel/coinstats.h>
 #include <kernel/disconnected_transactions.h>
 #include <node/chainstatemanager_args.h>
 #include <node/kernel_notifications.h>
@@ -429,6 +430,52 @@ BOOST_FIXTURE_TEST_CASE(chainstatemanager_activate_snapshot,
     this->SetupSnapshot();
 }
 
+//! Test that the snapshot hash computed while streaming the coins matches the
+//! one computed from the database, and that unordered coins are detected.
+BOOST_FIXTURE_TEST_CASE(serialized_coins_hasher, TestChain100Setup) {
+    Chainstate &chainstate = m_node.chainman->ActiveChainstate();
+    std::vector<std::pair<COutPoint, Coin>> coins;
+    std::unique_ptr<CCoinsViewCursor> cursor;
+    BlockHash best_block;
+    {
+        LOCK(::cs_main);
+        chainstate.ForceFlushStateToDisk();
+        cursor.reset(chainstate.CoinsDB().Cursor());
+        best_block = chainstate.CoinsDB().GetBestBlock();
+    }
+    for (; cursor->Valid(); cursor->Next()) {
+        COutPoint outpoint;
+        Coin coin;
+        BOOST_REQUIRE(cursor->GetKey(outpoint) && cursor->GetValue(coin));
+        coins.emplace_back(outpoint, std::move(coin));
+    }
+    BOOST_REQUIRE(coins.size() > 1);
+
+    const auto stats = kernel::ComputeUTXOStats(
+        kernel::CoinStatsHashType::HASH_SERIALIZED,
+        WITH_LOCK(::cs_main, return &chainstate.CoinsDB()),
+        chainstate.m_blockman, [] {});
+    BOOST_REQUIRE(stats);
+
+    kernel::SerializedCoinsHasher hasher{best_block};
+    for (const auto &[outpoint, coin] : coins) {
+        hasher.Add(outpoint, coin);
+    }
+    BOOST_CHECK(hasher.IsOrdered());
+    BOOST_CHECK_EQUAL(hasher.Finalize(), stats->hashSerialized);
+
+    kernel::SerializedCoinsHasher reversed_hasher{best_block};
+    for (auto it = coins.rbegin(); it != coins.rend(); ++it) {
+        reversed_hasher.Add(it->first, it->second);
+    }
+    BOOST_CHECK(!reversed_hasher.IsOrdered());
+
+    kernel::SerializedCoinsHasher duplicate_hasher{best_block};
+    duplicate_hasher.Add(coins[0].first, coins[0].second);
+    duplicate_hasher.Add(coins[0].first, coins[0].second);
+    BOOST_CHECK(!duplicate_hasher.IsOrdered());
+}
+
 //! Test LoadBlockIndex behavior when multiple chainstates are in use.
 //!
 //! - First, verfiy that setBlockIndexCandidates is as expected when using a
@@ -12,11 +12,14 @@
 #include <pow/pow.h>
 #include <random.h>
 #include <shutdown.h>
+#include <util/thread.h>
 #include <util/translation.h>
 #include <util/vector.h>
 #include <version.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <exception>
 #include <memory>
 
 static constexpr uint8_t DB_COIN{'C'};
@@ -181,6 +184,106 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
     return ret;
 }
 
+CCoinsViewWriteBehind::CCoinsViewWriteBehind(CCoinsView *view,
+                                             bool background)
+    : CCoinsViewBacked(view), m_background(background) {}
+
+CCoinsViewWriteBehind::~CCoinsViewWriteBehind() {
+    Complete(/*wait=*/true);
+}
+
+bool CCoinsViewWriteBehind::GetCoin(const COutPoint &outpoint,
+                                    Coin &coin) const {
+    if (m_coins) {
+        const auto it = m_coins->find(outpoint);
+        if (it != m_coins->end()) {
+            coin = it->second.coin;
+            return !coin.IsSpent();
+        }
+    }
+    return base->GetCoin(outpoint, coin);
+}
+
+bool CCoinsViewWriteBehind::HaveCoin(const COutPoint &outpoint) const {
+    if (m_coins) {
+        const auto it = m_coins->find(outpoint);
+        if (it != m_coins->end()) {
+            return !it->second.coin.IsSpent();
+        }
+    }
+    return base->HaveCoin(outpoint);
+}
+
+BlockHash CCoinsViewWriteBehind::GetBestBlock() const {
+    return m_coins ? m_block : base->GetBestBlock();
+}
+
+bool CCoinsViewWriteBehind::BatchWrite(CCoinsMap &mapCoins,
+                                       const BlockHash &hashBlock,
+                                       bool erase) {
+    if (!Complete(/*wait=*/true)) {
+        return false;
+    }
+    if (!m_background) {
+        return base->BatchWrite(mapCoins, hashBlock, erase);
+    }
+
+    m_resource = std::make_unique<CCoinsMapMemoryResource>();
+    m_coins = std::make_unique<CCoinsMap>(0, SaltedOutpointHasher{},
+                                          CCoinsMap::key_equal{},
+                                          m_resource.get());
+    m_coins_usage = 0;
+    for (auto it = mapCoins.begin(); it != mapCoins.end();
+         it = erase ? mapCoins.erase(it) : std::next(it)) {
+        if (!(it->second.flags & CCoinsCacheEntry::DIRTY)) {
+            continue;
+        }
+        Coin coin = erase ? std::move(it->second.coin) : it->second.coin;
+        m_coins_usage += coin.DynamicMemoryUsage();
+        m_coins->emplace(std::piecewise_construct,
+                         std::forward_as_tuple(it->first),
+                         std::forward_as_tuple(std::move(coin),
+                                               CCoinsCacheEntry::DIRTY));
+    }
+    m_block = hashBlock;
+
+    m_done = false;
+    m_thread = std::thread(&util::TraceThread, "coinswrite", [this] {
+        try {
+            if (!base->BatchWrite(*m_coins, m_block, /*erase=*/false)) {
+                m_ok = false;
+            }
+        } catch (const std::exception &e) {
+            LogPrintf("Error writing to the coins database: %s\n", e.what());
+            m_ok = false;
+        }
+        m_done = true;
+    });
+    return true;
+}
+
+bool CCoinsViewWriteBehind::Complete(bool wait, BlockHash *written_block) {
+    if (m_thread.joinable()) {
+        if (!wait && !m_done) {
+            return m_ok;
+        }
+        m_thread.join();
+    }
+    if (m_coins) {
+        if (written_block) {
+            *written_block = m_block;
+        }
+        m_coins.reset();
+        m_resource.reset();
+        m_coins_usage = 0;
+    }
+    return m_ok;
+}
+
+size_t CCoinsViewWriteBehind::DynamicMemoryUsage() const {
+    return m_coins ? memusage::DynamicUsage(*m_coins) + m_coins_usage : 0;
+}
+
 size_t CCoinsViewDB::EstimateSize() const {
     return m_db->EstimateSize(DB_COIN, uint8_t(DB_COIN + 1));
 }
@@ -215,17 +318,33 @@ CCoinsViewCursor *CCoinsViewDB::Cursor() const {
      */
     i->pcursor->Seek(DB_COIN);
     // Cache key of first record
-    if (i->pcursor->Valid()) {
-        CoinEntry entry(&i->keyTmp.second);
-        i->pcursor->GetKey(entry);
-        i->keyTmp.first = entry.key;
-    } else {
-        // Make sure Valid() and GetKey() return false
-        i->keyTmp.first = 0;
-    }
+    i->CacheKey();
     return i;
 }
 
+std::vector<std::unique_ptr<CCoinsViewCursor>>
+CCoinsViewDB::RangeCursors(size_t count) const {
+    count = std::clamp<size_t>(count, 1, 256);
+    std::vector<std::unique_ptr<CDBIterator>> iterators{
+        const_cast<CDBWrapper &>(*m_db).NewIterators(count)};
+    const BlockHash best_block{GetBestBlock()};
+
+    std::vector<std::unique_ptr<CCoinsViewCursor>> cursors;
+    cursors.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned int begin_prefix = 256 * i / count;
+        auto cursor = std::unique_ptr<CCoinsViewDBCursor>(
+            new CCoinsViewDBCursor(iterators[i].release(), best_block,
+                                   256 * (i + 1) / count));
+        uint256 begin_txid;
+        *begin_txid.begin() = begin_prefix;
+        cursor->pcursor->Seek(std::make_pair(DB_COIN, begin_txid));
+        cursor->CacheKey();
+        cursors.push_back(std::move(cursor));
+    }
+    return cursors;
+}
+
 bool CCoinsViewDBCursor::GetKey(COutPoint &key) const {
     // Return cached key
     if (keyTmp.first == DB_COIN) {
@@ -249,8 +368,14 @@ bool CCoinsViewDBCursor::Valid() const {
 
 void CCoinsViewDBCursor::Next() {
     pcursor->Next();
+    CacheKey();
+}
+
+void CCoinsViewDBCursor::CacheKey() {
     CoinEntry entry(&keyTmp.second);
-    if (!pcursor->Valid() || !pcursor->GetKey(entry)) {
+    if (!pcursor->Valid() || !pcursor->GetKey(entry) ||
+        (entry.key == DB_COIN &&
+         *keyTmp.second.GetTxId().begin() >= m_end_prefix)) {
         // Invalidate cached key after last record so that Valid() and GetKey()
         // return false
         keyTmp.first = 0;
@@ -14,12 +14,14 @@
 #include <util/fs.h>
 #include <util/result.h>
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -47,6 +49,9 @@ static constexpr int64_t MAX_BLOCK_DB_CACHE_MB = 2;
 // a meaningful difference:
 // https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
 static constexpr int64_t MAX_TX_INDEX_CACHE_MB = 1024;
+//! Max memory allocated to address index DB specific cache, if -addressindex
+//! (MiB). It writes an entry per script of each block while syncing.
+static constexpr int64_t MAX_ADDRESS_INDEX_CACHE_MB = 1024;
 //! Max memory allocated to all block filter index caches combined in MiB.
 static constexpr int64_t MAX_FILTER_INDEX_CACHE_MB = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
@@ -78,6 +83,9 @@ public:
     bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                     bool erase = true) override;
     CCoinsViewCursor *Cursor() const override;
+    //! The coins are split into ranges of the first byte of their txid.
+    std::vector<std::unique_ptr<CCoinsViewCursor>>
+    RangeCursors(size_t count) const override;
 
     //! Attempt to update from an older database format.
     //! Returns whether an error occurred.
@@ -92,6 +100,59 @@ public:
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
 };
 
+/**
+ * CCoinsView that writes the coins handed to BatchWrite() to its base view on a
+ * background thread, so the coins cache can be written out without stalling
+ * validation. The coins are served from memory until they are written, so the
+ * views above see the new state right away.
+ *
+ * Only one write is in flight at a time, BatchWrite() waits for the previous
+ * one to complete. The caller must not run BatchWrite() or Complete()
+ * concurrently with the lookups, which may run concurrently with each other
+ * and with the background write.
+ *
+ * Unless background writes are enabled, BatchWrite() passes the coins through
+ * to the base view synchronously, without copying them.
+ */
+class CCoinsViewWriteBehind final : public CCoinsViewBacked {
+public:
+    CCoinsViewWriteBehind(CCoinsView *view, bool background);
+    ~CCoinsViewWriteBehind();
+
+    bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    bool HaveCoin(const COutPoint &outpoint) const override;
+    BlockHash GetBestBlock() const override;
+    bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
+                    bool erase = true) override;
+
+    /**
+     * Release the coins of the last write once it completed, waiting for it if
+     * requested. Returns false if any write failed.
+     *
+     * @param[out] written_block  Set to the best block of the write, if it was
+     *                            released by this call.
+     */
+    bool Complete(bool wait, BlockHash *written_block = nullptr);
+
+    //! Whether some coins are still waiting to be written.
+    bool IsWriting() const { return m_thread.joinable() && !m_done; }
+
+    size_t DynamicMemoryUsage() const;
+
+private:
+    const bool m_background;
+
+    std::unique_ptr<CCoinsMapMemoryResource> m_resource;
+    //! Coins of the last write, null once released
+    std::unique_ptr<CCoinsMap> m_coins;
+    size_t m_coins_usage{0};
+    BlockHash m_block;
+
+    std::thread m_thread;
+    std::atomic<bool> m_done{true};
+    std::atomic<bool> m_ok{true};
+};
+
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
 class CCoinsViewDBCursor : public CCoinsViewCursor {
 public:
@@ -105,10 +166,19 @@ public:
     void Next() override;
 
 private:
-    CCoinsViewDBCursor(CDBIterator *pcursorIn, const BlockHash &hashBlockIn)
-        : CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn) {}
+    CCoinsViewDBCursor(CDBIterator *pcursorIn, const BlockHash &hashBlockIn,
+                       unsigned int end_prefix = 256)
+        : CCoinsViewCursor(hashBlockIn), pcursor(pcursorIn),
+          m_end_prefix(end_prefix) {}
     std::unique_ptr<CDBIterator> pcursor;
     std::pair<char, COutPoint> keyTmp;
+    //! The iteration stops at the first txid starting with this byte, 256 to
+    //! iterate until the last coin.
+    const unsigned int m_end_prefix;
+
+    //! Cache the key of the current record, or invalidate the cursor if
+    //! there is no coin left in its range.
+    void CacheKey();
 
     friend class CCoinsViewDB;
 };
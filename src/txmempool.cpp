@@ -646,12 +646,8 @@ void CCoinsViewMemPool::Reset() {
 
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
-    // Estimate the overhead of mapTx to be 12 pointers + an allocation, as no
-    // exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) +
-                                 12 * sizeof(void *)) *
-               mapTx.size() +
-           memusage::DynamicUsage(mapNextTx) +
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry)) * mapTx.size() +
+           mapTx.DynamicMemoryUsage() + memusage::DynamicUsage(mapNextTx) +
            memusage::DynamicUsage(mapDeltas) + cachedInnerUsage;
 }
 
@@ -680,8 +676,7 @@ void CTxMemPool::RemoveStaged(const setEntries &stage,
 
 int CTxMemPool::Expire(std::chrono::seconds time) {
     AssertLockHeld(cs);
-    indexed_transaction_set::index<entry_time>::type::iterator it =
-        mapTx.get<entry_time>().begin();
+    auto it = mapTx.get<entry_time>().begin();
     setEntries toremove;
     while (it != mapTx.get<entry_time>().end() && (*it)->GetTime() < time) {
         toremove.insert(mapTx.project<0>(it));
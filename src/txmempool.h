@@ -18,15 +18,11 @@
 #include <radix.h>
 #include <sync.h>
 #include <txconflicting.h>
+#include <txmempoolindex.h>
 #include <txorphanage.h>
 #include <uint256radixkey.h>
 #include <util/hasher.h>
 
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/sequenced_index.hpp>
-#include <boost/multi_index_container.hpp>
-
 #include <atomic>
 #include <map>
 #include <memory>
@@ -69,27 +65,12 @@ struct MemPoolEntryRadixTreeAdapter {
     }
 };
 
-// used by the entry_time index
-struct CompareTxMemPoolEntryByEntryTime {
-    bool operator()(const CTxMemPoolEntryRef &a,
-                    const CTxMemPoolEntryRef &b) const {
-        return a->GetTime() < b->GetTime();
-    }
-};
-
-// used by the entry_id index
-struct CompareTxMemPoolEntryByEntryId {
-    bool operator()(const CTxMemPoolEntryRef &a,
-                    const CTxMemPoolEntryRef &b) const {
-        return a->GetEntryId() < b->GetEntryId();
-    }
-};
-
 /**
  * \class CompareTxMemPoolEntryByModifiedFeeRate
  *
  *  Sort by feerate of entry (modfee/vsize) in descending order.
- *  This is used by the block assembler (mining).
+ *  This is the order of the modified_feerate index, which is used by the block
+ *  assembler (mining).
  */
 struct CompareTxMemPoolEntryByModifiedFeeRate {
     // Used in tests
@@ -119,11 +100,6 @@ struct CompareTxMemPoolEntryByModifiedFeeRate {
     }
 };
 
-// Multi_index tag names
-struct entry_time {};
-struct modified_feerate {};
-struct entry_id {};
-
 /**
  * Information about a mempool transaction.
  */
@@ -179,8 +155,9 @@ const std::string RemovalReasonToString(const MemPoolRemovalReason &r) noexcept;
  *
  * CTxMemPool::mapTx, and CTxMemPoolEntry bookkeeping:
  *
- * mapTx is a boost::multi_index that sorts the mempool on 3 criteria:
+ * mapTx is a TxMemPoolIndex that sorts the mempool on 4 criteria:
  * - transaction hash
+ * - modified feerate
  * - time in mempool
  * - entry id (this is a topological index)
  *
@@ -254,28 +231,7 @@ public:
     // public only for testing
     static const int ROLLING_FEE_HALFLIFE = 60 * 60 * 12;
 
-    typedef boost::multi_index_container<
-        CTxMemPoolEntryRef,
-        boost::multi_index::indexed_by<
-            // indexed by txid
-            boost::multi_index::hashed_unique<mempoolentry_txid,
-                                              SaltedTxIdHasher>,
-            // sorted by fee rate
-            boost::multi_index::ordered_non_unique<
-                boost::multi_index::tag<modified_feerate>,
-                boost::multi_index::identity<CTxMemPoolEntryRef>,
-                CompareTxMemPoolEntryByModifiedFeeRate>,
-            // sorted by entry time
-            boost::multi_index::ordered_non_unique<
-                boost::multi_index::tag<entry_time>,
-                boost::multi_index::identity<CTxMemPoolEntryRef>,
-                CompareTxMemPoolEntryByEntryTime>,
-            // sorted topologically (insertion order)
-            boost::multi_index::ordered_unique<
-                boost::multi_index::tag<entry_id>,
-                boost::multi_index::identity<CTxMemPoolEntryRef>,
-                CompareTxMemPoolEntryByEntryId>>>
-        indexed_transaction_set;
+    typedef TxMemPoolIndex indexed_transaction_set;
 
     /**
      * This mutex needs to be locked when accessing `mapTx` or other members
@@ -307,7 +263,7 @@ public:
     mutable RecursiveMutex cs;
     indexed_transaction_set mapTx GUARDED_BY(cs);
 
-    using txiter = indexed_transaction_set::nth_index<0>::type::const_iterator;
+    using txiter = indexed_transaction_set::const_iterator;
     typedef std::set<txiter, CompareIteratorById> setEntries;
     typedef std::set<txiter, CompareIteratorByRevEntryId> setRevTopoEntries;
 
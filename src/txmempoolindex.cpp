@@ -0,0 +1,287 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txmempoolindex.h>
+
+#include <memusage.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <cassert>
+
+TxMemPoolIndex::TxMemPoolIndex()
+    : m_views{View<ENTRY_ID>(&m_head), View<ENTRY_TIME>(&m_head),
+              View<MODIFIED_FEERATE>(&m_head)} {
+    for (size_t link = 0; link < NUM_LINKS; ++link) {
+        m_head.prev[link] = m_head.next[link] = &m_head;
+    }
+}
+
+TxMemPoolIndex::~TxMemPoolIndex() = default;
+
+TxMemPoolIndex::Node *TxMemPoolIndex::AllocateNode() {
+    if (!m_free) {
+        auto &slab = m_slabs.emplace_back(std::make_unique<Slab>());
+        slab->pos = m_slabs.size() - 1;
+        for (Node &node : slab->nodes) {
+            node.slab = slab.get();
+            node.prev[ENTRY_ID] = nullptr;
+            node.next[ENTRY_ID] = m_free;
+            if (m_free) {
+                m_free->prev[ENTRY_ID] = &node;
+            }
+            m_free = &node;
+        }
+        m_num_free += SLAB_SIZE;
+    }
+
+    Node *node = m_free;
+    m_free = node->next[ENTRY_ID];
+    if (m_free) {
+        m_free->prev[ENTRY_ID] = nullptr;
+    }
+    --m_num_free;
+    ++node->slab->used;
+    return node;
+}
+
+void TxMemPoolIndex::FreeNode(Node *node) {
+    // Release the entry now rather than when the node gets reused.
+    node->entry = CTxMemPoolEntryRef();
+    node->prev[ENTRY_ID] = nullptr;
+    node->next[ENTRY_ID] = m_free;
+    if (m_free) {
+        m_free->prev[ENTRY_ID] = node;
+    }
+    m_free = node;
+    ++m_num_free;
+
+    // Release the slab once it is empty, unless the other slabs have less
+    // than half a slab of spare nodes, so that entries coming and going
+    // around a slab boundary do not allocate and free a slab each time.
+    Slab *slab = node->slab;
+    if (--slab->used == 0 && m_num_free >= SLAB_SIZE + SLAB_SIZE / 2) {
+        ReleaseSlab(slab);
+    }
+}
+
+void TxMemPoolIndex::ReleaseSlab(Slab *slab) {
+    for (Node &node : slab->nodes) {
+        Node *prev = node.prev[ENTRY_ID];
+        Node *next = node.next[ENTRY_ID];
+        if (prev) {
+            prev->next[ENTRY_ID] = next;
+        } else {
+            m_free = next;
+        }
+        if (next) {
+            next->prev[ENTRY_ID] = prev;
+        }
+    }
+    m_num_free -= SLAB_SIZE;
+
+    const size_t pos = slab->pos;
+    std::swap(m_slabs[pos], m_slabs.back());
+    m_slabs[pos]->pos = pos;
+    m_slabs.pop_back();
+}
+
+size_t TxMemPoolIndex::FindSlot(const TxId &txid, size_t hash) const {
+    // The table is never full, so this always ends on a match or a free slot.
+    const size_t mask = m_table.size() - 1;
+    for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+        const Slot &slot = m_table[pos];
+        if (!slot.node || (slot.hash == hash &&
+                           slot.node->entry->GetTx().GetId() == txid)) {
+            return pos;
+        }
+    }
+}
+
+void TxMemPoolIndex::InsertSlot(Node *node, size_t hash) {
+    const size_t mask = m_table.size() - 1;
+    size_t pos = hash & mask;
+    while (m_table[pos].node) {
+        pos = (pos + 1) & mask;
+    }
+    m_table[pos] = Slot{hash, node};
+}
+
+void TxMemPoolIndex::EraseSlot(size_t pos) {
+    // Backward shift deletion: move the following entries of the probe
+    // sequence into the hole unless their home slot lies after the hole, so no
+    // tombstone is needed.
+    const size_t mask = m_table.size() - 1;
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask; m_table[next].node;
+         next = (next + 1) & mask) {
+        const size_t home = m_table[next].hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            m_table[hole] = m_table[next];
+            hole = next;
+        }
+    }
+    m_table[hole] = Slot{};
+}
+
+void TxMemPoolIndex::Rehash(size_t capacity) {
+    std::vector<Slot> old_table(capacity);
+    std::swap(old_table, m_table);
+    for (const Slot &slot : old_table) {
+        if (slot.node) {
+            InsertSlot(slot.node, slot.hash);
+        }
+    }
+}
+
+void TxMemPoolIndex::LinkAfter(size_t link, Node *pos, Node *node) {
+    node->prev[link] = pos;
+    node->next[link] = pos->next[link];
+    pos->next[link]->prev[link] = node;
+    pos->next[link] = node;
+}
+
+void TxMemPoolIndex::Unlink(size_t link, Node *node) {
+    node->prev[link]->next[link] = node->next[link];
+    node->next[link]->prev[link] = node->prev[link];
+}
+
+void TxMemPoolIndex::LinkTime(Node *node) {
+    // Entries with the same time are kept in insertion order.
+    node->time_key = count_seconds(node->entry->GetTime());
+    auto it = m_time_buckets.lower_bound(node->time_key);
+    if (it != m_time_buckets.end() && it->first == node->time_key) {
+        LinkAfter(ENTRY_TIME, it->second, node);
+        it->second = node;
+        return;
+    }
+
+    // Start a new bucket right after the last node of the previous one.
+    Node *pos = it == m_time_buckets.begin() ? &m_head : std::prev(it)->second;
+    LinkAfter(ENTRY_TIME, pos, node);
+    m_time_buckets.emplace_hint(it, node->time_key, node);
+}
+
+void TxMemPoolIndex::UnlinkTime(Node *node) {
+    auto it = m_time_buckets.find(node->time_key);
+    assert(it != m_time_buckets.end());
+    if (it->second == node) {
+        Node *prev = node->prev[ENTRY_TIME];
+        if (prev != &m_head && prev->time_key == node->time_key) {
+            it->second = prev;
+        } else {
+            m_time_buckets.erase(it);
+        }
+    }
+    Unlink(ENTRY_TIME, node);
+}
+
+void TxMemPoolIndex::LinkFeeRate(Node *node) {
+    node->feerate_key = node->entry->GetModifiedFeeRate().GetFeePerK();
+    auto bucket = m_feerate_buckets.try_emplace(node->feerate_key).first;
+    // New entries have the highest entry id, the hint makes their insertion
+    // constant time.
+    auto it = bucket->second.emplace_hint(bucket->second.end(),
+                                          node->entry->GetEntryId(), node);
+
+    // Link the node after its predecessor in the bucket, or after the last
+    // node of the previous bucket.
+    Node *pos;
+    if (it != bucket->second.begin()) {
+        pos = std::prev(it)->second;
+    } else if (bucket != m_feerate_buckets.begin()) {
+        pos = std::prev(bucket)->second.rbegin()->second;
+    } else {
+        pos = &m_head;
+    }
+    LinkAfter(MODIFIED_FEERATE, pos, node);
+}
+
+void TxMemPoolIndex::UnlinkFeeRate(Node *node) {
+    auto bucket = m_feerate_buckets.find(node->feerate_key);
+    assert(bucket != m_feerate_buckets.end());
+    bucket->second.erase(node->entry->GetEntryId());
+    if (bucket->second.empty()) {
+        m_feerate_buckets.erase(bucket);
+    }
+    Unlink(MODIFIED_FEERATE, node);
+}
+
+TxMemPoolIndex::const_iterator
+TxMemPoolIndex::find(const TxId &txid) const {
+    if (m_table.empty()) {
+        return end();
+    }
+
+    const Slot &slot = m_table[FindSlot(txid, m_hasher(txid))];
+    return slot.node ? const_iterator(slot.node) : end();
+}
+
+std::pair<TxMemPoolIndex::const_iterator, bool>
+TxMemPoolIndex::insert(const CTxMemPoolEntryRef &entry) {
+    // Keep the load factor under 3/4.
+    if ((m_size + 1) * 4 > m_table.size() * 3) {
+        Rehash(std::max<size_t>(16, m_table.size() * 2));
+    }
+
+    const TxId &txid = entry->GetTx().GetId();
+    const size_t hash = m_hasher(txid);
+    const size_t pos = FindSlot(txid, hash);
+    if (m_table[pos].node) {
+        return {const_iterator(m_table[pos].node), false};
+    }
+
+    Node *node = AllocateNode();
+    node->entry = entry;
+    m_table[pos] = Slot{hash, node};
+    ++m_size;
+
+    LinkAfter(ENTRY_ID, m_head.prev[ENTRY_ID], node);
+    LinkTime(node);
+    LinkFeeRate(node);
+
+    return {const_iterator(node), true};
+}
+
+void TxMemPoolIndex::erase(const_iterator it) {
+    Node *node = const_cast<Node *>(it.node);
+
+    const TxId &txid = node->entry->GetTx().GetId();
+    const size_t pos = FindSlot(txid, m_hasher(txid));
+    assert(m_table[pos].node == node);
+    EraseSlot(pos);
+    --m_size;
+    // Halve the table when its load drops under 1/8. It is then at 1/4, far
+    // enough from both thresholds not to be resized back and forth.
+    if (m_table.size() > 16 && m_size * 8 < m_table.size()) {
+        Rehash(m_table.size() / 2);
+    }
+
+    Unlink(ENTRY_ID, node);
+    UnlinkTime(node);
+    UnlinkFeeRate(node);
+
+    FreeNode(node);
+}
+
+void TxMemPoolIndex::clear() {
+    m_time_buckets.clear();
+    m_feerate_buckets.clear();
+    std::vector<Slot>().swap(m_table);
+    m_free = nullptr;
+    m_num_free = 0;
+    m_slabs.clear();
+    m_size = 0;
+    for (size_t link = 0; link < NUM_LINKS; ++link) {
+        m_head.prev[link] = m_head.next[link] = &m_head;
+    }
+}
+
+size_t TxMemPoolIndex::DynamicMemoryUsage() const {
+    return m_slabs.size() * memusage::MallocUsage(sizeof(Slab)) +
+           memusage::DynamicUsage(m_slabs) + memusage::DynamicUsage(m_table) +
+           memusage::DynamicUsage(m_time_buckets) +
+           memusage::DynamicUsage(m_feerate_buckets) +
+           m_size * memusage::IncrementalDynamicUsage(FeeRateBucket{});
+}
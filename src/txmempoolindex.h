@@ -0,0 +1,269 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXMEMPOOLINDEX_H
+#define BITCOIN_TXMEMPOOLINDEX_H
+
+#include <consensus/amount.h>
+#include <kernel/mempool_entry.h>
+#include <primitives/txid.h>
+#include <util/hasher.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Index tag names
+struct entry_time {};
+struct modified_feerate {};
+struct entry_id {};
+
+/**
+ * Purpose-built index of the mempool entries.
+ *
+ * Entries live in nodes carved out of fixed size slabs, so their addresses
+ * (and thus iterators) are stable for as long as they are in the index. Every
+ * node is threaded on three intrusive doubly-linked lists:
+ * - entry_id: topological (insertion) order, new entries always go last;
+ * - entry_time: ascending entry time, entries with the same time are kept in
+ *   insertion order;
+ * - modified_feerate: descending modified feerate, ties are broken by entry id
+ *   (see CompareTxMemPoolEntryByModifiedFeeRate).
+ *
+ * The two sorted lists are cut into buckets (one per distinct time and one per
+ * distinct feerate), and only the bucket boundaries are kept in an ordered map,
+ * so an insertion does not need to rebalance a tree of all the entries. New
+ * entries always go at the end of their bucket. An entry whose feerate is
+ * modified can land anywhere in its new bucket though, so the feerate buckets
+ * also map the entry ids of their entries to their nodes. Entries are
+ * appended to these maps with an end hint, which takes constant time.
+ * Lookups by txid go through an open addressing hash table with linear
+ * probing.
+ *
+ * The interface mirrors the subset of boost::multi_index used by CTxMemPool.
+ */
+class TxMemPoolIndex {
+    enum Link : size_t {
+        ENTRY_ID = 0,
+        ENTRY_TIME,
+        MODIFIED_FEERATE,
+        NUM_LINKS,
+    };
+
+    struct Slab;
+
+    struct Node {
+        CTxMemPoolEntryRef entry;
+        Slab *slab{nullptr};
+        Node *prev[NUM_LINKS]{};
+        Node *next[NUM_LINKS]{};
+        //! Bucket keys the node was linked with. They are cached because the
+        //! entry can be modified while it is in the index.
+        int64_t time_key{0};
+        Amount feerate_key{Amount::zero()};
+    };
+
+    template <typename Tag> struct TagLink;
+
+public:
+    template <size_t L> class Iterator {
+        const Node *node{nullptr};
+
+        explicit Iterator(const Node *n) : node(n) {}
+        friend class TxMemPoolIndex;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = CTxMemPoolEntryRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const CTxMemPoolEntryRef *;
+        using reference = const CTxMemPoolEntryRef &;
+
+        Iterator() = default;
+
+        reference operator*() const { return node->entry; }
+        pointer operator->() const { return &node->entry; }
+
+        Iterator &operator++() {
+            node = node->next[L];
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator ret = *this;
+            ++*this;
+            return ret;
+        }
+        Iterator &operator--() {
+            node = node->prev[L];
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator ret = *this;
+            --*this;
+            return ret;
+        }
+
+        friend bool operator==(const Iterator &a, const Iterator &b) {
+            return a.node == b.node;
+        }
+        friend bool operator!=(const Iterator &a, const Iterator &b) {
+            return a.node != b.node;
+        }
+    };
+
+    /** Ordered view of the entries along one of the lists. */
+    template <size_t L> class View {
+        const Node *head;
+
+        explicit View(const Node *h) : head(h) {}
+        friend class TxMemPoolIndex;
+
+    public:
+        using iterator = Iterator<L>;
+        using const_iterator = Iterator<L>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = reverse_iterator;
+
+        iterator begin() const { return iterator(head->next[L]); }
+        iterator end() const { return iterator(head); }
+        reverse_iterator rbegin() const { return reverse_iterator(end()); }
+        reverse_iterator rend() const { return reverse_iterator(begin()); }
+    };
+
+    using const_iterator = Iterator<ENTRY_ID>;
+    using iterator = const_iterator;
+
+    /** Same spelling as boost::multi_index for the view type of a tag. */
+    template <typename Tag> struct index {
+        using type = View<TagLink<Tag>::value>;
+    };
+
+    TxMemPoolIndex();
+    ~TxMemPoolIndex();
+
+    TxMemPoolIndex(const TxMemPoolIndex &) = delete;
+    TxMemPoolIndex &operator=(const TxMemPoolIndex &) = delete;
+
+    /** Iterating the index itself goes in topological (entry id) order. */
+    const_iterator begin() const { return const_iterator(m_head.next[0]); }
+    const_iterator end() const { return const_iterator(&m_head); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const_iterator find(const TxId &txid) const;
+    size_t count(const TxId &txid) const { return find(txid) != end(); }
+
+    /**
+     * Add an entry. Returns an iterator to the entry with the same txid and
+     * false if there is one already.
+     */
+    std::pair<const_iterator, bool> insert(const CTxMemPoolEntryRef &entry);
+    void erase(const_iterator it);
+    void clear();
+
+    /**
+     * Apply f to the entry and reposition it in the modified_feerate order.
+     * The txid, entry id and entry time must not be changed by f.
+     */
+    template <typename F> bool modify(const_iterator it, F f) {
+        Node *node = const_cast<Node *>(it.node);
+        UnlinkFeeRate(node);
+        f(node->entry);
+        LinkFeeRate(node);
+        return true;
+    }
+
+    template <typename Tag> const typename index<Tag>::type &get() const {
+        return std::get<TagLink<Tag>::value>(m_views);
+    }
+
+    /** Convert an iterator of any of the views into an iterator by txid. */
+    template <int N, size_t L>
+    const_iterator project(const Iterator<L> &it) const {
+        static_assert(N == 0, "Only the primary index can be projected to");
+        return const_iterator(it.node);
+    }
+
+    /**
+     * Memory allocated by the index: all the slabs and the whole hash table,
+     * plus the bucket maps. The slabs and the table are released when their
+     * occupancy drops, so the usage follows the number of entries.
+     */
+    size_t DynamicMemoryUsage() const;
+
+private:
+    struct Slot {
+        size_t hash{0};
+        Node *node{nullptr};
+    };
+
+    //! Number of nodes allocated at once
+    static constexpr size_t SLAB_SIZE{256};
+
+    struct Slab {
+        Node nodes[SLAB_SIZE];
+        //! Number of nodes in use
+        size_t used{0};
+        //! Position in m_slabs
+        size_t pos{0};
+    };
+
+    //! Sentinel node for all the lists
+    Node m_head;
+    size_t m_size{0};
+
+    std::vector<std::unique_ptr<Slab>> m_slabs;
+    //! Unused nodes, doubly-linked through their ENTRY_ID pointers so that the
+    //! nodes of a slab can be taken out when it is released
+    Node *m_free{nullptr};
+    size_t m_num_free{0};
+
+    std::vector<Slot> m_table;
+    SaltedTxIdHasher m_hasher;
+
+    //! Last node of each time bucket, in list order
+    std::map<int64_t, Node *> m_time_buckets;
+    //! Nodes of each feerate bucket by entry id, in list order
+    using FeeRateBucket = std::map<uint64_t, Node *>;
+    std::map<Amount, FeeRateBucket, std::greater<Amount>> m_feerate_buckets;
+
+    const std::tuple<View<ENTRY_ID>, View<ENTRY_TIME>, View<MODIFIED_FEERATE>>
+        m_views;
+
+    Node *AllocateNode();
+    void FreeNode(Node *node);
+    void ReleaseSlab(Slab *slab);
+
+    size_t FindSlot(const TxId &txid, size_t hash) const;
+    void InsertSlot(Node *node, size_t hash);
+    void EraseSlot(size_t pos);
+    void Rehash(size_t capacity);
+
+    static void LinkAfter(size_t link, Node *pos, Node *node);
+    static void Unlink(size_t link, Node *node);
+
+    void LinkTime(Node *node);
+    void UnlinkTime(Node *node);
+    void LinkFeeRate(Node *node);
+    void UnlinkFeeRate(Node *node);
+};
+
+template <> struct TxMemPoolIndex::TagLink<entry_id> {
+    static constexpr size_t value = ENTRY_ID;
+};
+template <> struct TxMemPoolIndex::TagLink<entry_time> {
+    static constexpr size_t value = ENTRY_TIME;
+};
+template <> struct TxMemPoolIndex::TagLink<modified_feerate> {
+    static constexpr size_t value = MODIFIED_FEERATE;
+};
+
+#endif // BITCOIN_TXMEMPOOLINDEX_H
@@ -255,6 +255,13 @@ void AllocateFileRange(FILE *file, unsigned int offset, unsigned int length) {
 #endif
 }
 
+void StartFileWriteback(FILE *file, unsigned int offset, unsigned int length) {
+#ifdef HAVE_SYNC_FILE_RANGE
+    // Advisory as well, a later FileCommit() still waits for the data.
+    sync_file_range(fileno(file), offset, length, SYNC_FILE_RANGE_WRITE);
+#endif
+}
+
 #ifdef WIN32
 fs::path GetSpecialFolderPath(int nFolder, bool fCreate) {
     WCHAR pszPath[MAX_PATH] = L"";
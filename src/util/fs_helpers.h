@@ -28,6 +28,11 @@ void DirectoryCommit(const fs::path &dirname);
 bool TruncateFile(FILE *file, unsigned int length);
 int RaiseFileDescriptorLimit(int nMinFD);
 void AllocateFileRange(FILE *file, unsigned int offset, unsigned int length);
+/**
+ * Start writing a range of a file that was flushed with fflush() back to disk,
+ * without waiting for it to complete. This makes a later FileCommit() cheaper.
+ */
+void StartFileWriteback(FILE *file, unsigned int offset, unsigned int length);
 [[nodiscard]] bool RenameOver(fs::path src, fs::path dest);
 bool LockDirectory(const fs::path &directory, const std::string lockfile_name,
                    bool probe_only = false);
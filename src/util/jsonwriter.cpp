@@ -0,0 +1,174 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/jsonwriter.h>
+
+#include <util/check.h>
+
+#include <univalue.h>
+#include <univalue_escapes.h>
+
+#include <cstdint>
+#include <utility>
+
+JSONWriter::JSONWriter(Sink sink, size_t chunk_size)
+    : m_sink(std::move(sink)), m_chunk_size(chunk_size) {
+    m_buffer.reserve(m_chunk_size);
+}
+
+void JSONWriter::Separate() {
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (m_empty.empty()) {
+        return;
+    }
+    if (!m_empty.back()) {
+        m_buffer.push_back(',');
+    }
+    m_empty.back() = false;
+}
+
+void JSONWriter::Escape(std::string_view str) {
+    for (const char ch : str) {
+        const char *const esc = escapes[uint8_t(ch)];
+        if (esc) {
+            m_buffer.append(esc);
+        } else {
+            m_buffer.push_back(ch);
+        }
+    }
+}
+
+void JSONWriter::MaybeFlush() {
+    if (m_buffer.size() < m_chunk_size) {
+        return;
+    }
+    std::string chunk;
+    chunk.reserve(m_chunk_size);
+    std::swap(chunk, m_buffer);
+    m_sink(std::move(chunk), /*last=*/false);
+}
+
+JSONWriter &JSONWriter::BeginObject() {
+    Separate();
+    m_buffer.push_back('{');
+    m_empty.push_back(true);
+    m_is_object.push_back(true);
+    return *this;
+}
+
+JSONWriter &JSONWriter::EndObject() {
+    CHECK_NONFATAL(!m_empty.empty() && m_is_object.back() && !m_after_key);
+    m_empty.pop_back();
+    m_is_object.pop_back();
+    m_buffer.push_back('}');
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter &JSONWriter::BeginArray() {
+    Separate();
+    m_buffer.push_back('[');
+    m_empty.push_back(true);
+    m_is_object.push_back(false);
+    return *this;
+}
+
+JSONWriter &JSONWriter::EndArray() {
+    CHECK_NONFATAL(!m_empty.empty() && !m_is_object.back() && !m_after_key);
+    m_empty.pop_back();
+    m_is_object.pop_back();
+    m_buffer.push_back(']');
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter &JSONWriter::Key(std::string_view key) {
+    CHECK_NONFATAL(!m_empty.empty() && m_is_object.back() && !m_after_key);
+    Separate();
+    m_buffer.push_back('"');
+    Escape(key);
+    m_buffer.append("\":");
+    m_after_key = true;
+    return *this;
+}
+
+void JSONWriter::WriteAny(const UniValue &value) {
+    switch (value.getType()) {
+        case UniValue::VNULL:
+            m_buffer.append("null");
+            break;
+        case UniValue::VOBJ: {
+            m_buffer.push_back('{');
+            const std::vector<std::string> &keys = value.getKeys();
+            const std::vector<UniValue> &values = value.getValues();
+            for (size_t i = 0; i < keys.size(); ++i) {
+                if (i) {
+                    m_buffer.push_back(',');
+                }
+                m_buffer.push_back('"');
+                Escape(keys[i]);
+                m_buffer.append("\":");
+                WriteAny(values[i]);
+                MaybeFlush();
+            }
+            m_buffer.push_back('}');
+            break;
+        }
+        case UniValue::VARR: {
+            m_buffer.push_back('[');
+            const std::vector<UniValue> &values = value.getValues();
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (i) {
+                    m_buffer.push_back(',');
+                }
+                WriteAny(values[i]);
+                MaybeFlush();
+            }
+            m_buffer.push_back(']');
+            break;
+        }
+        case UniValue::VSTR:
+            m_buffer.push_back('"');
+            Escape(value.get_str());
+            m_buffer.push_back('"');
+            break;
+        case UniValue::VNUM:
+            m_buffer.append(value.getValStr());
+            break;
+        case UniValue::VBOOL:
+            m_buffer.append(value.get_bool() ? "true" : "false");
+            break;
+    }
+}
+
+JSONWriter &JSONWriter::Value(const UniValue &value) {
+    Separate();
+    WriteAny(value);
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter &JSONWriter::Pairs(const UniValue &object) {
+    const std::vector<std::string> &keys = object.getKeys();
+    const std::vector<UniValue> &values = object.getValues();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        Pair(keys[i], values[i]);
+    }
+    return *this;
+}
+
+JSONWriter &JSONWriter::Raw(std::string_view text) {
+    m_buffer.append(text);
+    MaybeFlush();
+    return *this;
+}
+
+void JSONWriter::Finish() {
+    CHECK_NONFATAL(m_empty.empty() && !m_after_key);
+    m_sink(std::move(m_buffer), /*last=*/true);
+    m_buffer.clear();
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_JSONWRITER_H
+#define BITCOIN_UTIL_JSONWRITER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class UniValue;
+
+/**
+ * Streaming JSON encoder.
+ *
+ * The document is handed to a sink in chunks of about chunk_size bytes as it
+ * is written, so a large document never has to be held in memory as a whole,
+ * neither as a UniValue tree nor as a string. Parts of the document that are
+ * small enough can still be built as UniValue and written with Value().
+ *
+ * The output is identical to the one of UniValue::write() without
+ * indentation.
+ */
+class JSONWriter {
+public:
+    /**
+     * Receives the chunks of the document, in order. last is set for the
+     * final chunk, which may be empty.
+     */
+    using Sink = std::function<void(std::string &&chunk, bool last)>;
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE{256 << 10};
+
+    explicit JSONWriter(Sink sink, size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    JSONWriter(const JSONWriter &) = delete;
+    JSONWriter &operator=(const JSONWriter &) = delete;
+
+    JSONWriter &BeginObject();
+    JSONWriter &EndObject();
+    JSONWriter &BeginArray();
+    JSONWriter &EndArray();
+
+    /** Write the key of the next value of the current object */
+    JSONWriter &Key(std::string_view key);
+
+    /** Write a value, as an array element or after a key */
+    JSONWriter &Value(const UniValue &value);
+
+    JSONWriter &Pair(std::string_view key, const UniValue &value) {
+        return Key(key).Value(value);
+    }
+
+    /** Write all the pairs of an object value into the current object */
+    JSONWriter &Pairs(const UniValue &object);
+
+    /** Write text outside of the document, e.g. a line terminator */
+    JSONWriter &Raw(std::string_view text);
+
+    /**
+     * Hand the remainder of the document to the sink as the last chunk. The
+     * writer must not be used anymore afterwards.
+     */
+    void Finish();
+
+private:
+    Sink m_sink;
+    const size_t m_chunk_size;
+    std::string m_buffer;
+    //! For each open object or array, whether it has no element yet
+    std::vector<bool> m_empty;
+    //! For each open object or array, whether it is an object
+    std::vector<bool> m_is_object;
+    //! Whether a key was written and its value is expected next
+    bool m_after_key{false};
+
+    /** Write the separator expected before the next key or value */
+    void Separate();
+    void Escape(std::string_view str);
+    void WriteAny(const UniValue &value);
+    void MaybeFlush();
+};
+
+#endif // BITCOIN_UTIL_JSONWRITER_H
@@ -52,6 +52,7 @@
 #include <script/sigcache.h>
 #include <script/sigops.h>
 #include <shutdown.h>
+#include <span.h>
 #include <tinyformat.h>
 #include <txdb.h>
 #include <txmempool.h>
@@ -72,6 +73,7 @@
 #include <cassert>
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <numeric>
 #include <optional>
 #include <string>
@@ -83,6 +85,7 @@
 using kernel::CCoinsStats;
 using kernel::CoinStatsHashType;
 using kernel::ComputeUTXOStats;
+using kernel::SerializedCoinsHasher;
 using kernel::LoadMempool;
 using kernel::Notifications;
 
@@ -290,6 +293,83 @@ static bool CheckInputsFromMempoolAndCache(
                              /*scriptCacheStore=*/true, txdata, nSigChecksOut);
 }
 
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
+namespace {
+// Leverage RAII to run a functor at scope end
+template <typename Func> struct Defer {
+    Func func;
+    Defer(Func &&f) : func(std::move(f)) {}
+    ~Defer() { func(); }
+};
+} // namespace
+
+/**
+ * The script checks of consecutive blocks, which run on the script check
+ * threads while the next blocks are connected rather than being waited for at
+ * the end of each block. Small blocks don't keep all the threads busy on their
+ * own.
+ */
+class DeferredScriptChecks {
+public:
+    //! The sigcheck limiters the checks of a block refer to
+    struct Limiters {
+        CheckInputsLimiter block;
+        std::vector<TxSigCheckLimiter> txs;
+
+        Limiters(int64_t max_block_sigchecks, size_t num_txs)
+            : block(max_block_sigchecks), txs(num_txs) {}
+    };
+
+    explicit DeferredScriptChecks(const CBlockIndex *start) : m_start(start) {}
+
+    /** The tip the blocks are connected on top of. */
+    const CBlockIndex *Start() const { return m_start; }
+
+    /** The blocks whose checks were all added. */
+    const std::vector<CBlockIndex *> &Blocks() const { return m_blocks; }
+
+    /** Keep a block alive until its checks, which refer to it, are done. */
+    void Hold(std::shared_ptr<const CBlock> block) {
+        m_held_blocks.push_back(std::move(block));
+    }
+
+    Limiters &AddLimiters(int64_t max_block_sigchecks, size_t num_txs) {
+        return m_limiters.emplace_back(max_block_sigchecks, num_txs);
+    }
+
+    void Add(std::vector<CScriptCheck> &&checks) {
+        m_control.Add(std::move(checks));
+    }
+
+    void AddBlock(CBlockIndex *pindex) { m_blocks.push_back(pindex); }
+
+    /**
+     * Hold back a validation interface notification about the blocks until
+     * their checks are known to have succeeded.
+     */
+    void Notify(std::function<void()> notification) {
+        m_notifications.push_back(std::move(notification));
+    }
+
+    std::vector<std::function<void()>> TakeNotifications() {
+        return std::move(m_notifications);
+    }
+
+    /** Wait for all the checks, and return whether they all succeeded. */
+    bool Wait() { return m_control.Wait(); }
+
+private:
+    const CBlockIndex *const m_start;
+    std::vector<CBlockIndex *> m_blocks;
+    std::vector<std::function<void()>> m_notifications;
+    std::vector<std::shared_ptr<const CBlock>> m_held_blocks;
+    //! A deque, so that the checks can keep pointers to the limiters
+    std::deque<Limiters> m_limiters;
+    //! Last, so that the checks are done before the above is destroyed
+    CCheckQueueControl<CScriptCheck> m_control{&scriptcheckqueue};
+};
+
 namespace {
 
 class MemPoolAccept {
@@ -382,6 +462,48 @@ public:
             };
         }
 
+        /**
+         * Parameters for a batch of transactions that are accepted or rejected
+         * individually, see AcceptTransactionBatch().
+         */
+        static ATMPArgs BatchAccept(const Config &config, int64_t accept_time,
+                                    std::vector<COutPoint> &coins_to_uncache,
+                                    bool test_accept) {
+            return ATMPArgs{
+                config,
+                accept_time,
+                /*bypass_limits=*/false,
+                coins_to_uncache,
+                test_accept,
+                /*height_override=*/0,
+                // LimitMempoolSize once the whole batch has been submitted
+                /*package_submission=*/true,
+                // each transaction pays for itself
+                /*package_feerates=*/false,
+            };
+        }
+
+        /**
+         * Parameters for transactions added back to the mempool after a
+         * reorg, see ReaddTransactionBatch().
+         */
+        static ATMPArgs ReorgBatchAccept(const Config &config,
+                                         int64_t accept_time,
+                                         std::vector<COutPoint> &coins_to_uncache) {
+            return ATMPArgs{
+                config,
+                accept_time,
+                /*bypass_limits=*/true,
+                coins_to_uncache,
+                /*test_accept=*/false,
+                // set per transaction
+                /*height_override=*/0,
+                // the caller limits the mempool size
+                /*package_submission=*/true,
+                /*package_feerates=*/false,
+            };
+        }
+
         /** Parameters for a single transaction within a package. */
         static ATMPArgs SingleInPackageAccept(const ATMPArgs &package_args) {
             return ATMPArgs{
@@ -456,6 +578,27 @@ public:
                                              ATMPArgs &args)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    /**
+     * Batch acceptance. Unlike packages, each transaction is accepted or
+     * rejected on its own merits, as if it was submitted individually in
+     * order, but all the script checks of the batch run in parallel and the
+     * mempool is only trimmed once at the end. Transactions must be sorted
+     * topologically. A transaction spending the same coin as an earlier
+     * transaction of the batch is rejected.
+     */
+    PackageMempoolAcceptResult
+    AcceptTransactionBatch(const std::vector<CTransactionRef> &txns,
+                           ATMPArgs &args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    /**
+     * Batch acceptance of transactions reloaded from disk. The transactions
+     * keep their entry time and the scripts that were already verified
+     * against the same coins are not run again.
+     */
+    PackageMempoolAcceptResult
+    ReloadTransactionBatch(const std::vector<MempoolLoadTx> &txs,
+                           ATMPArgs &args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 private:
     // All the intermediate state that gets passed between the various levels
     // of checking a given transaction.
@@ -510,8 +653,43 @@ private:
         // ConsensusScriptChecks
         const uint32_t m_next_block_script_verify_flags;
         int m_sig_checks_standard;
+
+        /**
+         * Lock points calculated in PreChecks(), stored in the mempool entry
+         * once it is constructed by PolicyFeeChecks().
+         */
+        LockPoints m_lock_points;
+
+        /**
+         * Accounts for the sigchecks consumed by the policy script checks.
+         * When these checks are executed on the script check queue, this is
+         * where m_sig_checks_standard is recovered from.
+         */
+        TxSigCheckLimiter m_sig_checks_limiter;
+
+        /**
+         * Set when the transaction was in the mempool or in a block before,
+         * see LoadMempoolTransactions() and ReaddTransactionBatch().
+         */
+        const MempoolLoadTx *m_reload{nullptr};
+        /**
+         * Whether the scripts of the transaction are known to pass both the
+         * policy and the consensus checks for the coins it spends, because it
+         * was reloaded from disk with its verification data, so they don't
+         * need to be run again.
+         */
+        bool m_scripts_verified{false};
     };
 
+    uint32_t GetPolicyScriptFlags(const ATMPArgs &args,
+                                  const Workspace &ws) const;
+
+    // Common implementation of AcceptTransactionBatch() and
+    // ReloadTransactionBatch(), the workspaces hold distinct transactions.
+    PackageMempoolAcceptResult
+    AcceptWorkspaceBatch(std::vector<Workspace> &workspaces, ATMPArgs &args)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
     // Run the policy checks on a given transaction, excluding any script
     // checks. Looks up inputs, calculates feerate, considers replacement,
     // evaluates package limits, etc. As this function can be invoked for "free"
@@ -520,10 +698,30 @@ private:
     bool PreChecks(ATMPArgs &args, Workspace &ws)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
+    // Run the script checks of the workspaces using our policy flags. The
+    // checks of every transaction are pushed at once onto the script check
+    // queue so that independent transactions and inputs are verified in
+    // parallel. Workspaces with an invalid state (i.e. that failed PreChecks())
+    // are skipped, the others get m_sig_checks_standard filled in, unless they
+    // have m_scripts_verified set. Returns false if any of the transactions
+    // failed, in which case the state of every failing workspace is filled in.
+    // cs_main and the mempool lock stay held while the checks run: the callers
+    // hold cs_main, and the coins the checks were built from must not change
+    // until the transactions are added.
+    bool PolicyScriptChecks(const ATMPArgs &args, Span<Workspace> workspaces)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
+    // Construct the mempool entry, which requires the sigchecks count from
+    // PolicyScriptChecks(), and check the transaction feerate against the
+    // minimum relay and mempool feerates.
+    bool PolicyFeeChecks(const ATMPArgs &args, Workspace &ws)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
     // Re-run the script checks, using consensus flags, and try to cache the
     // result in the scriptcache. This should be done after
     // PolicyScriptChecks(). This requires that all inputs either be in our
-    // utxo set or in the mempool.
+    // utxo set or in the mempool. Workspaces with m_scripts_verified set are
+    // not checked again.
     bool ConsensusScriptChecks(const ATMPArgs &args, Workspace &ws)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
 
@@ -586,15 +784,11 @@ private:
 bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
     AssertLockHeld(cs_main);
     AssertLockHeld(m_pool.cs);
-    const CTransactionRef &ptx = ws.m_ptx;
     const CTransaction &tx = *ws.m_ptx;
     const TxId &txid = ws.m_ptx->GetId();
 
     // Copy/alias what we need out of args
-    const int64_t nAcceptTime = args.m_accept_time;
-    const bool bypass_limits = args.m_bypass_limits;
     std::vector<COutPoint> &coins_to_uncache = args.m_coins_to_uncache;
-    const unsigned int heightOverride = args.m_heightOverride;
 
     // Alias what we need out of ws
     TxValidationState &state = ws.m_state;
@@ -709,6 +903,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
         return state.Invalid(TxValidationResult::TX_PREMATURE_SPEND,
                              "non-BIP68-final");
     }
+    ws.m_lock_points = *lock_points;
 
     // The mempool holds txs for the next block, so pass height+1 to
     // CheckTxInputs
@@ -730,27 +925,116 @@ bool MemPoolAccept::PreChecks(ATMPArgs &args, Workspace &ws) {
     ws.m_modified_fees = ws.m_base_fees;
     m_pool.ApplyDelta(txid, ws.m_modified_fees);
 
-    unsigned int nSize = tx.GetTotalSize();
+    ws.m_precomputed_txdata = PrecomputedTransactionData{tx};
+
+    return true;
+}
+
+uint32_t MemPoolAccept::GetPolicyScriptFlags(const ATMPArgs &args,
+                                             const Workspace &ws) const {
+    const bool legacy_script_rules = IsLegacyScriptRulesEnabled(
+        args.m_config.GetChainParams().GetConsensus());
+    return ws.m_next_block_script_verify_flags |
+           (legacy_script_rules ? STANDARD_SCRIPT_VERIFY_FLAGS_LEGACY
+                                : STANDARD_SCRIPT_VERIFY_FLAGS);
+}
+
+bool MemPoolAccept::PolicyScriptChecks(const ATMPArgs &args,
+                                       Span<Workspace> workspaces) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
 
     // Validate input scripts against standard script flags.
-    uint32_t scriptVerifyFlags = ws.m_next_block_script_verify_flags;
-    if (IsLegacyScriptRulesEnabled(
-            args.m_config.GetChainParams().GetConsensus())) {
-        scriptVerifyFlags |= STANDARD_SCRIPT_VERIFY_FLAGS_LEGACY;
-    } else {
-        scriptVerifyFlags |= STANDARD_SCRIPT_VERIFY_FLAGS;
+    const auto policy_flags = [&](const Workspace &ws) {
+        return GetPolicyScriptFlags(args, ws);
+    };
+
+    // Workspaces that already failed, e.g. in PreChecks(), are skipped.
+    std::vector<Workspace *> pending;
+    pending.reserve(workspaces.size());
+    for (Workspace &ws : workspaces) {
+        if (!ws.m_state.IsValid()) {
+            continue;
+        }
+        if (ws.m_scripts_verified) {
+            ws.m_sig_checks_standard = ws.m_reload->sig_checks;
+            continue;
+        }
+        pending.push_back(&ws);
     }
-    ws.m_precomputed_txdata = PrecomputedTransactionData{tx};
-    if (!CheckInputScripts(tx, state, m_view, scriptVerifyFlags, true, false,
-                           ws.m_precomputed_txdata, ws.m_sig_checks_standard)) {
-        // State filled in by CheckInputScripts
-        return false;
+
+    bool all_ok = true;
+    {
+        // The checks only hold copies of the spent outputs and references to
+        // the transactions, so they can run on the worker threads while we
+        // wait. This is safe because the queue is otherwise only used by
+        // ConnectBlock(), which also requires cs_main.
+        CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+        for (Workspace *ws : pending) {
+            ws->m_sig_checks_limiter = TxSigCheckLimiter();
+            std::vector<CScriptCheck> checks;
+            int nSigChecksCached;
+            if (!CheckInputScripts(
+                    *ws->m_ptx, ws->m_state, m_view, policy_flags(*ws),
+                    /*sigCacheStore=*/true, /*scriptCacheStore=*/false,
+                    ws->m_precomputed_txdata, nSigChecksCached,
+                    ws->m_sig_checks_limiter, nullptr, &checks)) {
+                all_ok = false;
+                break;
+            }
+            control.Add(std::move(checks));
+        }
+        all_ok = control.Wait() && all_ok;
     }
 
+    if (all_ok) {
+        for (Workspace *ws : pending) {
+            ws->m_sig_checks_standard = ws->m_sig_checks_limiter.consumed();
+        }
+        return true;
+    }
+
+    // Something failed. The queue only reports an aggregated result, so rerun
+    // the checks serially to figure out which transactions are at fault and
+    // why. The scripts that succeeded are now in the signature cache, so this
+    // is cheap for all but the failing inputs.
+    bool all_passed = true;
+    for (Workspace *ws : pending) {
+        ws->m_state = TxValidationState{};
+        if (!CheckInputScripts(*ws->m_ptx, ws->m_state, m_view,
+                               policy_flags(*ws), /*sigCacheStore=*/true,
+                               /*scriptCacheStore=*/false,
+                               ws->m_precomputed_txdata,
+                               ws->m_sig_checks_standard)) {
+            // State filled in by CheckInputScripts
+            all_passed = false;
+        }
+    }
+
+    return all_passed;
+}
+
+bool MemPoolAccept::PolicyFeeChecks(const ATMPArgs &args, Workspace &ws) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    // Copy/alias what we need out of args
+    const int64_t nAcceptTime =
+        ws.m_reload ? ws.m_reload->time : args.m_accept_time;
+    const bool bypass_limits = args.m_bypass_limits;
+    const unsigned int heightOverride = ws.m_reload && ws.m_reload->height
+                                            ? ws.m_reload->height
+                                            : args.m_heightOverride;
+
+    // Alias what we need out of ws
+    TxValidationState &state = ws.m_state;
+
+    unsigned int nSize = ws.m_ptx->GetTotalSize();
+
     ws.m_entry = std::make_unique<CTxMemPoolEntry>(
-        ptx, ws.m_base_fees, nAcceptTime,
+        ws.m_ptx, ws.m_base_fees, nAcceptTime,
         heightOverride ? heightOverride : m_active_chainstate.m_chain.Height(),
-        ws.m_sig_checks_standard, lock_points.value());
+        ws.m_sig_checks_standard, ws.m_lock_points);
 
     ws.m_vsize = ws.m_entry->GetTxVirtualSize();
 
@@ -789,6 +1073,15 @@ bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs &args, Workspace &ws) {
     const TxId &txid = tx.GetId();
     TxValidationState &state = ws.m_state;
 
+    if (ws.m_scripts_verified) {
+        // The scripts were verified under the same next block flags, cache
+        // the result as the check below would have.
+        AddKeyInScriptCache(
+            ScriptCacheKey(tx, ws.m_next_block_script_verify_flags),
+            ws.m_sig_checks_standard);
+        return true;
+    }
+
     // Check again against the next block's script verification flags
     // to cache our script execution flags.
     //
@@ -823,6 +1116,7 @@ bool MemPoolAccept::ConsensusScriptChecks(const ATMPArgs &args, Workspace &ws) {
             "standard and consensus flags in %s",
             __func__, txid.ToString());
     }
+
     return true;
 }
 
@@ -970,7 +1264,8 @@ MemPoolAccept::AcceptSingleTransaction(const CTransactionRef &ptx,
     // Perform the inexpensive checks first and avoid hashing and signature
     // verification unless those checks pass, to mitigate CPU exhaustion
     // denial-of-service attacks.
-    if (!PreChecks(args, ws)) {
+    if (!PreChecks(args, ws) || !PolicyScriptChecks(args, Span{&ws, 1}) ||
+        !PolicyFeeChecks(args, ws)) {
         if (ws.m_state.GetResult() ==
             TxValidationResult::TX_PACKAGE_RECONSIDERABLE) {
             // Failed for fee reasons. Provide the effective feerate and which
@@ -1075,6 +1370,31 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptMultipleTransactions(
         // Make the coins created by this transaction available for subsequent
         // transactions in the package to spend.
         m_viewmempool.PackageAddTransaction(ws.m_ptx);
+    }
+
+    // All the transactions passed PreChecks, verify their scripts in one go so
+    // the work is spread over the script check threads.
+    if (!PolicyScriptChecks(args, workspaces)) {
+        package_state.Invalid(PackageValidationResult::PCKG_TX,
+                              "transaction failed");
+        const auto failed_ws =
+            std::find_if(workspaces.cbegin(), workspaces.cend(),
+                         [](const auto &ws) { return ws.m_state.IsInvalid(); });
+        assert(failed_ws != workspaces.cend());
+        results.emplace(failed_ws->m_ptx->GetId(),
+                        MempoolAcceptResult::Failure(failed_ws->m_state));
+        return PackageMempoolAcceptResult(package_state, std::move(results));
+    }
+
+    for (Workspace &ws : workspaces) {
+        if (!PolicyFeeChecks(args, ws)) {
+            package_state.Invalid(PackageValidationResult::PCKG_TX,
+                                  "transaction failed");
+            results.emplace(ws.m_ptx->GetId(),
+                            MempoolAcceptResult::Failure(ws.m_state));
+            return PackageMempoolAcceptResult(package_state,
+                                              std::move(results));
+        }
         valid_txids.push_back(ws.m_ptx->GetId());
     }
 
@@ -1428,6 +1748,212 @@ PackageMempoolAcceptResult MemPoolAccept::AcceptPackage(const Package &package,
     return PackageMempoolAcceptResult(package_state_final,
                                       std::move(results_final));
 }
+
+PackageMempoolAcceptResult
+MemPoolAccept::AcceptTransactionBatch(const std::vector<CTransactionRef> &txns,
+                                      ATMPArgs &args) {
+    AssertLockHeld(cs_main);
+
+    const uint32_t next_block_script_verify_flags = GetNextBlockScriptFlags(
+        m_active_chainstate.m_chain.Tip(), m_active_chainstate.m_chainman);
+    std::vector<Workspace> workspaces{};
+    workspaces.reserve(txns.size());
+    std::unordered_set<TxId, SaltedTxIdHasher> batch_txids;
+    for (const auto &tx : txns) {
+        // Duplicated transactions share the result of the first occurrence.
+        if (batch_txids.insert(tx->GetId()).second) {
+            workspaces.emplace_back(tx, next_block_script_verify_flags);
+        }
+    }
+
+    return AcceptWorkspaceBatch(workspaces, args);
+}
+
+PackageMempoolAcceptResult
+MemPoolAccept::ReloadTransactionBatch(const std::vector<MempoolLoadTx> &txs,
+                                      ATMPArgs &args) {
+    AssertLockHeld(cs_main);
+
+    const uint32_t next_block_script_verify_flags = GetNextBlockScriptFlags(
+        m_active_chainstate.m_chain.Tip(), m_active_chainstate.m_chainman);
+    std::vector<Workspace> workspaces{};
+    workspaces.reserve(txs.size());
+    std::unordered_set<TxId, SaltedTxIdHasher> batch_txids;
+    for (const MempoolLoadTx &load_tx : txs) {
+        if (batch_txids.insert(load_tx.tx->GetId()).second) {
+            workspaces.emplace_back(load_tx.tx, next_block_script_verify_flags)
+                .m_reload = &load_tx;
+        }
+    }
+
+    return AcceptWorkspaceBatch(workspaces, args);
+}
+
+PackageMempoolAcceptResult
+MemPoolAccept::AcceptWorkspaceBatch(std::vector<Workspace> &workspaces,
+                                    ATMPArgs &args) {
+    AssertLockHeld(cs_main);
+
+    PackageValidationState batch_state;
+    std::map<TxId, MempoolAcceptResult> results;
+
+    LOCK(m_pool.cs);
+
+    // Transactions that are not going to make it to the mempool, so their
+    // descendants in the batch can be rejected too.
+    std::unordered_set<TxId, SaltedTxIdHasher> rejected_txids;
+    const auto reject = [&](Workspace &ws) {
+        rejected_txids.insert(ws.m_ptx->GetId());
+        results.emplace(ws.m_ptx->GetId(),
+                        MempoolAcceptResult::Failure(ws.m_state));
+        batch_state.Invalid(PackageValidationResult::PCKG_TX,
+                            "transaction failed");
+    };
+    const auto has_rejected_parent = [&](const Workspace &ws) {
+        return std::any_of(ws.m_ptx->vin.cbegin(), ws.m_ptx->vin.cend(),
+                           [&](const CTxIn &txin) {
+                               return rejected_txids.count(
+                                          txin.prevout.GetTxId()) > 0;
+                           });
+    };
+
+    // Run the cheap checks on every transaction first. The coins created by
+    // the transactions that pass are made available to their descendants.
+    std::unordered_set<COutPoint, SaltedOutpointHasher> batch_spent_coins;
+    for (Workspace &ws : workspaces) {
+        const TxId &txid = ws.m_ptx->GetId();
+        if (auto iter = m_pool.GetIter(txid)) {
+            // Already in the mempool, no need to revalidate.
+            results.emplace(txid, MempoolAcceptResult::MempoolTx(
+                                      (*iter.value())->GetTxSize(),
+                                      (*iter.value())->GetFee()));
+            ws.m_state.Invalid(TxValidationResult::TX_DUPLICATE,
+                               "txn-already-in-mempool");
+            continue;
+        }
+
+        if (std::any_of(ws.m_ptx->vin.cbegin(), ws.m_ptx->vin.cend(),
+                        [&](const CTxIn &txin) {
+                            return batch_spent_coins.count(txin.prevout) > 0;
+                        })) {
+            ws.m_state.Invalid(TxValidationResult::TX_CONFLICT,
+                               "conflict-in-batch");
+            reject(ws);
+            continue;
+        }
+
+        if (!PreChecks(args, ws)) {
+            reject(ws);
+            continue;
+        }
+
+        // The coins are in m_view after PreChecks().
+        if (ws.m_reload && ws.m_reload->verified_tip) {
+            ws.m_scripts_verified =
+                GetNextBlockScriptFlags(ws.m_reload->verified_tip,
+                                        m_active_chainstate.m_chainman) ==
+                    ws.m_next_block_script_verify_flags &&
+                ws.m_reload->spent_coins_hash ==
+                    GetSpentCoinsHash(*ws.m_ptx,
+                                      getSpentCoins(ws.m_ptx, m_view));
+        }
+
+        m_viewmempool.PackageAddTransaction(ws.m_ptx);
+        for (const CTxIn &txin : ws.m_ptx->vin) {
+            batch_spent_coins.insert(txin.prevout);
+        }
+    }
+
+    // Verify the scripts of all the remaining transactions in one go.
+    PolicyScriptChecks(args, workspaces);
+
+    // A transaction is only valid if all its parents from the batch are, just
+    // like an orphan would be rejected if submitted individually.
+    for (Workspace &ws : workspaces) {
+        if (ws.m_state.IsValid() && has_rejected_parent(ws)) {
+            ws.m_state.Invalid(TxValidationResult::TX_MISSING_INPUTS,
+                               "bad-txns-inputs-missingorspent");
+        }
+        if (ws.m_state.IsValid()) {
+            PolicyFeeChecks(args, ws);
+        }
+        if (ws.m_state.IsInvalid() && results.count(ws.m_ptx->GetId()) == 0) {
+            reject(ws);
+        }
+    }
+
+    std::vector<Workspace *> accepted;
+    for (Workspace &ws : workspaces) {
+        if (ws.m_state.IsValid()) {
+            accepted.push_back(&ws);
+        }
+    }
+
+    if (args.m_test_accept) {
+        for (Workspace *ws : accepted) {
+            results.emplace(
+                ws->m_ptx->GetId(),
+                MempoolAcceptResult::Success(
+                    ws->m_vsize, ws->m_base_fees,
+                    CFeeRate{ws->m_modified_fees,
+                             static_cast<uint32_t>(ws->m_vsize)},
+                    {ws->m_ptx->GetId()}));
+        }
+        return PackageMempoolAcceptResult(batch_state, std::move(results));
+    }
+
+    // Submit in topological order so that the parents are in the mempool when
+    // ConsensusScriptChecks() looks up the coins of their children.
+    for (Workspace *ws : accepted) {
+        const TxId &txid = ws->m_ptx->GetId();
+        if (has_rejected_parent(*ws)) {
+            ws->m_state.Invalid(TxValidationResult::TX_MISSING_INPUTS,
+                                "bad-txns-inputs-missingorspent");
+            reject(*ws);
+            continue;
+        }
+        // Since PolicyScriptChecks() passed, these should never fail.
+        if (!ConsensusScriptChecks(args, *ws) || !Finalize(args, *ws)) {
+            reject(*ws);
+            continue;
+        }
+        GetMainSignals().TransactionAddedToMempool(
+            ws->m_ptx,
+            std::make_shared<const std::vector<Coin>>(
+                getSpentCoins(ws->m_ptx, m_view)),
+            m_pool.GetAndIncrementSequence());
+        results.emplace(txid, MempoolAcceptResult::Success(
+                                  ws->m_vsize, ws->m_base_fees,
+                                  CFeeRate{ws->m_modified_fees,
+                                           static_cast<uint32_t>(ws->m_vsize)},
+                                  {txid}));
+    }
+
+    // Make sure we haven't exceeded max mempool size. Some of the transactions
+    // of the batch may be evicted. When the limits are bypassed (e.g. while
+    // re-adding the transactions of disconnected blocks) the caller trims the
+    // mempool once it is done, so that a parent is not evicted before a later
+    // batch re-adds its children.
+    if (!args.m_bypass_limits) {
+        m_pool.LimitSize(m_active_chainstate.CoinsTip());
+
+        for (Workspace *ws : accepted) {
+            const TxId &txid = ws->m_ptx->GetId();
+            if (rejected_txids.count(txid) == 0 && !m_pool.exists(txid)) {
+                batch_state.Invalid(PackageValidationResult::PCKG_TX,
+                                    "transaction failed");
+                TxValidationState mempool_full_state;
+                mempool_full_state.Invalid(
+                    TxValidationResult::TX_MEMPOOL_POLICY, "mempool full");
+                results.erase(txid);
+                results.emplace(
+                    txid, MempoolAcceptResult::Failure(mempool_full_state));
+            }
+        }
+    }
+
+    return PackageMempoolAcceptResult(batch_state, std::move(results));
+}
 } // namespace
 
 MempoolAcceptResult AcceptToMemoryPool(Chainstate &active_chainstate,
@@ -1504,6 +2030,150 @@ PackageMempoolAcceptResult ProcessNewPackage(Chainstate &active_chainstate,
     return result;
 }
 
+/**
+ * Uncache the coins that were only fetched for transactions of a batch that
+ * didn't make it to the mempool.
+ */
+static void
+UncacheRejectedCoins(Chainstate &active_chainstate,
+                     const std::vector<CTransactionRef> &txns,
+                     const PackageMempoolAcceptResult &result,
+                     const std::vector<COutPoint> &coins_to_uncache,
+                     bool test_accept) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    AssertLockHeld(cs_main);
+
+    std::unordered_set<COutPoint, SaltedOutpointHasher> uncache_candidates;
+    for (const auto &tx : txns) {
+        const auto it = result.m_tx_results.find(tx->GetId());
+        if (test_accept || it == result.m_tx_results.end() ||
+            it->second.m_result_type == MempoolAcceptResult::ResultType::INVALID) {
+            for (const CTxIn &txin : tx->vin) {
+                uncache_candidates.insert(txin.prevout);
+            }
+        }
+    }
+    for (const COutPoint &outpoint : coins_to_uncache) {
+        if (uncache_candidates.count(outpoint) > 0) {
+            active_chainstate.CoinsTip().Uncache(outpoint);
+        }
+    }
+}
+
+/**
+ * Uncache the coins of the rejected transactions of a batch, and make sure the
+ * caches are within limits.
+ */
+static void
+FinalizeTransactionBatch(Chainstate &active_chainstate, CTxMemPool &pool,
+                         const std::vector<CTransactionRef> &txns,
+                         const PackageMempoolAcceptResult &result,
+                         const std::vector<COutPoint> &coins_to_uncache,
+                         bool test_accept) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+    AssertLockHeld(cs_main);
+
+    UncacheRejectedCoins(active_chainstate, txns, result, coins_to_uncache,
+                         test_accept);
+
+    pool.check(active_chainstate.CoinsTip(),
+               active_chainstate.m_chain.Height() + 1);
+
+    // Ensure the coins cache is still within limits.
+    BlockValidationState state_dummy;
+    active_chainstate.FlushStateToDisk(state_dummy, FlushStateMode::PERIODIC);
+}
+
+PackageMempoolAcceptResult
+ProcessTransactionBatch(Chainstate &active_chainstate, CTxMemPool &pool,
+                        const std::vector<CTransactionRef> &txns,
+                        bool test_accept) {
+    AssertLockHeld(cs_main);
+    assert(std::all_of(txns.cbegin(), txns.cend(),
+                       [](const auto &tx) { return tx != nullptr; }));
+
+    std::vector<CTransactionRef> sorted_txns{txns};
+    SortPackageTopologically(sorted_txns);
+
+    std::vector<COutPoint> coins_to_uncache;
+    auto args = MemPoolAccept::ATMPArgs::BatchAccept(
+        active_chainstate.m_chainman.GetConfig(), GetTime(), coins_to_uncache,
+        test_accept);
+    const PackageMempoolAcceptResult result =
+        MemPoolAccept(pool, active_chainstate)
+            .AcceptTransactionBatch(sorted_txns, args);
+
+    FinalizeTransactionBatch(active_chainstate, pool, sorted_txns, result,
+                             coins_to_uncache, test_accept);
+    return result;
+}
+
+uint256 GetSpentCoinsHash(const CTransaction &tx,
+                          const std::vector<Coin> &spent_coins) {
+    HashWriter hasher{};
+    hasher << tx.GetId();
+    for (const Coin &coin : spent_coins) {
+        hasher << coin;
+    }
+    return hasher.GetHash();
+}
+
+PackageMempoolAcceptResult
+LoadMempoolTransactions(Chainstate &active_chainstate, CTxMemPool &pool,
+                        const std::vector<MempoolLoadTx> &txs) {
+    AssertLockHeld(cs_main);
+
+    std::vector<CTransactionRef> sorted_txns;
+    sorted_txns.reserve(txs.size());
+    std::unordered_map<TxId, const MempoolLoadTx *, SaltedTxIdHasher>
+        load_txs_by_id;
+    for (const MempoolLoadTx &load_tx : txs) {
+        assert(load_tx.tx != nullptr);
+        if (load_txs_by_id.emplace(load_tx.tx->GetId(), &load_tx).second) {
+            sorted_txns.push_back(load_tx.tx);
+        }
+    }
+    SortPackageTopologically(sorted_txns);
+
+    std::vector<MempoolLoadTx> sorted_load_txs;
+    sorted_load_txs.reserve(sorted_txns.size());
+    for (const auto &tx : sorted_txns) {
+        sorted_load_txs.push_back(*load_txs_by_id.at(tx->GetId()));
+    }
+
+    std::vector<COutPoint> coins_to_uncache;
+    auto args = MemPoolAccept::ATMPArgs::BatchAccept(
+        active_chainstate.m_chainman.GetConfig(), GetTime(), coins_to_uncache,
+        /*test_accept=*/false);
+    const PackageMempoolAcceptResult result =
+        MemPoolAccept(pool, active_chainstate)
+            .ReloadTransactionBatch(sorted_load_txs, args);
+
+    FinalizeTransactionBatch(active_chainstate, pool, sorted_txns, result,
+                             coins_to_uncache, /*test_accept=*/false);
+    return result;
+}
+
+PackageMempoolAcceptResult
+ReaddTransactionBatch(Chainstate &active_chainstate, CTxMemPool &pool,
+                      const std::vector<MempoolLoadTx> &txs) {
+    AssertLockHeld(cs_main);
+
+    std::vector<COutPoint> coins_to_uncache;
+    auto args = MemPoolAccept::ATMPArgs::ReorgBatchAccept(
+        active_chainstate.m_chainman.GetConfig(), GetTime(), coins_to_uncache);
+    const PackageMempoolAcceptResult result =
+        MemPoolAccept(pool, active_chainstate)
+            .ReloadTransactionBatch(txs, args);
+
+    std::vector<CTransactionRef> txns;
+    txns.reserve(txs.size());
+    for (const MempoolLoadTx &load_tx : txs) {
+        txns.push_back(load_tx.tx);
+    }
+    UncacheRejectedCoins(active_chainstate, txns, result, coins_to_uncache,
+                         /*test_accept=*/false);
+    return result;
+}
+
 Amount GetBlockSubsidy(int nHeight, const Consensus::Params &consensusParams,
                        uint256 prevHash) {
     int halvings = nHeight / consensusParams.nSubsidyHalvingInterval;
@@ -1546,9 +2216,11 @@ Amount GetBlockSubsidy(int nHeight, const Consensus::Params &consensusParams,
     }
 }
 
-CoinsViews::CoinsViews(DBParams db_params, CoinsViewOptions options)
+CoinsViews::CoinsViews(DBParams db_params, CoinsViewOptions options,
+                       bool background_writes)
     : m_dbview{std::move(db_params), std::move(options)},
-      m_catcherview(&m_dbview) {}
+      m_writeview(&m_dbview, background_writes),
+      m_catcherview(&m_writeview) {}
 
 void CoinsViews::InitCache() {
     AssertLockHeld(::cs_main);
@@ -1574,7 +2246,8 @@ void Chainstate::InitCoinsDB(size_t cache_size_bytes, bool in_memory,
                  .wipe_data = should_wipe,
                  .obfuscate = true,
                  .options = m_chainman.m_options.coins_db},
-        m_chainman.m_options.coins_view);
+        m_chainman.m_options.coins_view,
+        m_chainman.m_options.incremental_coins_flush);
 }
 
 void Chainstate::InitCoinsCache(size_t cache_size_bytes) {
@@ -2030,8 +2703,6 @@ public:
     }
 };
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
-
 void StartScriptCheckWorkerThreads(int threads_num) {
     scriptcheckqueue.StartWorkerThreads(threads_num);
 }
@@ -2050,6 +2721,45 @@ void StopPowCheckWorkerThreads() {
     powcheckqueue.StopWorkerThreads();
 }
 
+/**
+ * Read a coin spent by a block from the coins database ahead of
+ * ConnectBlock() needing it. Reading the database is thread safe, the coin is
+ * only added to the coins cache by the validation thread.
+ */
+class CCoinPrefetch {
+private:
+    const CCoinsView *m_db;
+    const COutPoint *m_outpoint;
+    Coin *m_coin;
+
+public:
+    CCoinPrefetch(const CCoinsView &db, const COutPoint &outpoint, Coin &coin)
+        : m_db(&db), m_outpoint(&outpoint), m_coin(&coin) {}
+
+    bool operator()() {
+        try {
+            if (!m_db->GetCoin(*m_outpoint, *m_coin)) {
+                m_coin->Clear();
+            }
+        } catch (const std::exception &) {
+            // Leave it to the validation thread to run into the error again
+            // and handle it.
+            m_coin->Clear();
+        }
+        return true;
+    }
+};
+
+static CCheckQueue<CCoinPrefetch> coinprefetchqueue(16);
+
+void StartCoinPrefetchWorkerThreads(int threads_num) {
+    coinprefetchqueue.StartWorkerThreads(threads_num);
+}
+
+void StopCoinPrefetchWorkerThreads() {
+    coinprefetchqueue.StopWorkerThreads();
+}
+
 // Returns the script flags which should be checked for the block after
 // the given block.
 static uint32_t GetNextBlockScriptFlags(const CBlockIndex *pindex,
@@ -2144,7 +2854,7 @@ static int64_t nBlocksTotal = 0;
 bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
                               CBlockIndex *pindex, CCoinsViewCache &view,
                               BlockValidationOptions options, Amount *blockFees,
-                              bool fJustCheck) {
+                              bool fJustCheck, DeferredScriptChecks *deferred) {
     AssertLockHeld(cs_main);
     assert(pindex);
 
@@ -2156,6 +2866,42 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
     const CChainParams &params{m_chainman.GetParams()};
     const Consensus::Params &consensusParams = params.GetConsensus();
 
+    // Start reading the coins spent by the block that are missing from the
+    // cache on the prefetch threads, so the database lookups are done in
+    // parallel while the block is being checked rather than one at a time when
+    // the inputs are resolved. The merkle root was checked when the block was
+    // accepted, so its transactions can be trusted to be the ones committed
+    // to.
+    std::vector<std::pair<COutPoint, Coin>> prefetched_coins;
+    CCheckQueueControl<CCoinPrefetch> prefetch_control(
+        fJustCheck ? nullptr : &coinprefetchqueue);
+    if (!fJustCheck) {
+        std::unordered_set<TxId, SaltedTxIdHasher> block_txids;
+        block_txids.reserve(block.vtx.size());
+        for (const auto &ptx : block.vtx) {
+            block_txids.insert(ptx->GetId());
+        }
+        for (const auto &ptx : block.vtx) {
+            if (ptx->IsCoinBase()) {
+                continue;
+            }
+            for (const CTxIn &in : ptx->vin) {
+                if (block_txids.count(in.prevout.GetTxId()) == 0 &&
+                    !CoinsTip().HaveCoinInCache(in.prevout)) {
+                    prefetched_coins.emplace_back(in.prevout, Coin());
+                }
+            }
+        }
+
+        std::vector<CCoinPrefetch> prefetches;
+        prefetches.reserve(prefetched_coins.size());
+        for (auto &[outpoint, coin] : prefetched_coins) {
+            prefetches.emplace_back(m_coins_views->m_writeview, outpoint,
+                                    coin);
+        }
+        prefetch_control.Add(std::move(prefetches));
+    }
+
     // Check it again in case a previous version let a bad block in
     // NOTE: We don't currently (re-)invoke ContextualCheckBlock() or
     // ContextualCheckBlockHeader() here. This means that if we add a new
@@ -2350,16 +3096,35 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
     // inputs) is per-input atomic and validation in each thread stops very
     // quickly after the limit is exceeded, so an adversary cannot cause us to
     // exceed the limit by much at all.
-    CheckInputsLimiter nSigChecksBlockLimiter(nMaxBlockSigChecks);
-
-    std::vector<TxSigCheckLimiter> nSigChecksTxLimiters;
-    nSigChecksTxLimiters.resize(block.vtx.size() - 1);
+    // The deferred checks outlive this function, and so must the limiters.
+    if (fJustCheck || !fScriptChecks) {
+        deferred = nullptr;
+    }
+    std::optional<DeferredScriptChecks::Limiters> local_limiters;
+    DeferredScriptChecks::Limiters &limiters{
+        deferred
+            ? deferred->AddLimiters(nMaxBlockSigChecks, block.vtx.size() - 1)
+            : local_limiters.emplace(nMaxBlockSigChecks,
+                                     block.vtx.size() - 1)};
+    CheckInputsLimiter &nSigChecksBlockLimiter{limiters.block};
+    std::vector<TxSigCheckLimiter> &nSigChecksTxLimiters{limiters.txs};
 
     CBlockUndo blockundo;
     blockundo.vtxundo.resize(block.vtx.size() - 1);
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks ? &scriptcheckqueue
-                                                           : nullptr);
+    CCheckQueueControl<CScriptCheck> control(
+        fScriptChecks && !deferred ? &scriptcheckqueue : nullptr);
+
+    // Warm the coins cache with the prefetched coins. They are not dirty, so
+    // they are dropped like any other cache entry if the block is invalid.
+    if (!fJustCheck) {
+        prefetch_control.Wait();
+        for (auto &[outpoint, coin] : prefetched_coins) {
+            if (!coin.IsSpent()) {
+                CoinsTip().PrefetchCoin(outpoint, std::move(coin));
+            }
+        }
+    }
 
     // Add all outputs
     try {
@@ -2476,7 +3241,11 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
                 tx.GetId().ToString(), state.ToString());
         }
 
-        control.Add(std::move(vChecks));
+        if (deferred) {
+            deferred->Add(std::move(vChecks));
+        } else {
+            control.Add(std::move(vChecks));
+        }
 
         // Note: this must execute in the same iteration as CheckTxInputs (not
         // in a separate loop) in order to detect double spends. However,
@@ -2534,7 +3303,9 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
         return false;
     }
 
-    if (!pindex->IsValid(BlockValidity::SCRIPTS)) {
+    if (deferred) {
+        deferred->AddBlock(pindex);
+    } else if (!pindex->IsValid(BlockValidity::SCRIPTS)) {
         pindex->RaiseValidity(BlockValidity::SCRIPTS);
         m_blockman.m_dirty_blockindex.insert(pindex);
     }
@@ -2568,7 +3339,13 @@ Chainstate::GetCoinsCacheSizeState(size_t max_coins_cache_size_bytes,
                                    size_t max_mempool_size_bytes) {
     AssertLockHeld(::cs_main);
     int64_t nMempoolUsage = m_mempool ? m_mempool->DynamicMemoryUsage() : 0;
-    int64_t cacheSize = CoinsTip().DynamicMemoryUsage();
+    // The memory freed by the evicted coins is reused by the cache, and the
+    // coins being written in the background are still in memory.
+    int64_t cacheSize =
+        m_chainman.m_options.incremental_coins_flush
+            ? CoinsTip().LiveMemoryUsage() +
+                  m_coins_views->m_writeview.DynamicMemoryUsage()
+            : CoinsTip().DynamicMemoryUsage();
     int64_t nTotalSpace =
         max_coins_cache_size_bytes +
         std::max<int64_t>(int64_t(max_mempool_size_bytes) - nMempoolUsage, 0);
@@ -2593,13 +3370,24 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
                                   FlushStateMode mode, int nManualPruneHeight) {
     LOCK(cs_main);
     assert(this->CanFlushToDisk());
+    if (m_script_checks_pending) {
+        // Flushed once the checks are done, see FinishDeferredScriptChecks()
+        return true;
+    }
     std::set<int> setFilesToPrune;
     bool full_flush_completed = false;
+    // Best block of a background write of the coins cache that completed
+    BlockHash written_block;
 
     const size_t coins_count = CoinsTip().GetCacheSize();
     const size_t coins_mem_usage = CoinsTip().DynamicMemoryUsage();
 
     try {
+        if (!m_coins_views->m_writeview.Complete(/*wait=*/false,
+                                                 &written_block)) {
+            return AbortNode(state, "Failed to write to coin database");
+        }
+
         {
             bool fFlushForPrune = false;
             bool fDoFullFlush = false;
@@ -2687,8 +3475,42 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
             // Combine all conditions that result in a full cache flush.
             fDoFullFlush = (mode == FlushStateMode::ALWAYS) || fCacheLarge ||
                            fCacheCritical || fPeriodicFlush || fFlushForPrune;
+            // With -incrementalcoinsflush, the cache is written in the
+            // background instead, whenever it grew by an eighth of its size
+            // since it was last written. Only the complete writes required
+            // before shutting down or pruning block files are waited for.
+            const bool incremental{
+                m_chainman.m_options.incremental_coins_flush};
+            bool fBackgroundWrite = false;
+            if (incremental && mode != FlushStateMode::ALWAYS &&
+                !fFlushForPrune) {
+                const bool fCacheGrown =
+                    (mode == FlushStateMode::IF_NEEDED ||
+                     mode == FlushStateMode::PERIODIC) &&
+                    CoinsTip().LiveMemoryUsage() >
+                        m_coins_usage_after_write +
+                            m_coinstip_cache_size_bytes / 8;
+                fBackgroundWrite = fDoFullFlush || fCacheGrown;
+                fDoFullFlush = false;
+                // Let the previous write complete, unless we're out of
+                // memory.
+                if (m_coins_views->m_writeview.IsWriting() && !fCacheCritical) {
+                    fBackgroundWrite = false;
+                }
+            }
+            // Unmodified coins are kept in the cache after it is written with
+            // -incrementalcoinsflush, evict the oldest ones to make room for
+            // the next blocks.
+            const auto evict_cold_coins = [&]() EXCLUSIVE_LOCKS_REQUIRED(
+                                              ::cs_main) {
+                const size_t target{(3 * m_coinstip_cache_size_bytes) / 4};
+                const size_t writing{
+                    m_coins_views->m_writeview.DynamicMemoryUsage()};
+                CoinsTip().EvictColdCoins(target - std::min(target, writing));
+                m_coins_usage_after_write = CoinsTip().LiveMemoryUsage();
+            };
             // Write blocks and block index to disk.
-            if (fDoFullFlush || fPeriodicWrite) {
+            if (fDoFullFlush || fPeriodicWrite || fBackgroundWrite) {
                 // Ensure we can write block index
                 if (!CheckDiskSpace(gArgs.GetBlocksDirPath())) {
                     return AbortNode(state, "Disk space is too low!",
@@ -2746,12 +3568,38 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
 
                 // Flush the chainstate (which may refer to block index
                 // entries).
-                if (!CoinsTip().Flush()) {
+                const bool keep_cache{incremental &&
+                                      mode != FlushStateMode::ALWAYS};
+                if (!(keep_cache ? CoinsTip().Sync() : CoinsTip().Flush()) ||
+                    !m_coins_views->m_writeview.Complete(/*wait=*/true)) {
                     return AbortNode(state, "Failed to write to coin database");
                 }
+                if (keep_cache) {
+                    evict_cold_coins();
+                }
                 m_last_flush = nNow;
                 full_flush_completed = true;
             }
+            if (fBackgroundWrite && !CoinsTip().GetBestBlock().IsNull()) {
+                LOG_TIME_MILLIS_WITH_CATEGORY(
+                    strprintf("start writing coins cache to disk (%d coins, "
+                              "%.2fkB)",
+                              coins_count, coins_mem_usage / 1000),
+                    BCLog::BENCH);
+
+                if (!CheckDiskSpace(gArgs.GetDataDirNet(),
+                                    48 * 2 * 2 * CoinsTip().GetCacheSize())) {
+                    return AbortNode(state, "Disk space is too low!",
+                                     _("Disk space is too low!"));
+                }
+
+                // This waits for the previous write, if any.
+                if (!CoinsTip().Sync()) {
+                    return AbortNode(state, "Failed to write to coin database");
+                }
+                evict_cold_coins();
+                m_last_flush = nNow;
+            }
 
             TRACE5(utxocache, flush,
                    // in microseconds (µs)
@@ -2762,6 +3610,12 @@ bool Chainstate::FlushStateToDisk(BlockValidationState &state,
         if (full_flush_completed) {
             // Update best block in wallet (so we can detect restored wallets).
             GetMainSignals().ChainStateFlushed(m_chain.GetLocator());
+        } else if (!written_block.IsNull()) {
+            const CBlockIndex *pindex{
+                m_blockman.LookupBlockIndex(written_block)};
+            if (pindex && m_chain.Contains(pindex)) {
+                GetMainSignals().ChainStateFlushed(GetLocator(pindex));
+            }
         }
     } catch (const std::runtime_error &e) {
         return AbortNode(state, std::string("System error while flushing: ") +
@@ -2828,7 +3682,9 @@ void Chainstate::UpdateTip(const CBlockIndex *pindexNew) {
         m_mempool->AddTransactionsUpdated(1);
     }
 
-    {
+    // The blocks whose script checks are pending are published once the
+    // checks succeeded, see FinishDeferredScriptChecks().
+    if (!m_script_checks_pending) {
         LOCK(g_best_block_mutex);
         g_best_block = pindexNew;
         g_best_block_cv.notify_all();
@@ -2929,8 +3785,11 @@ bool Chainstate::DisconnectTip(BlockValidationState &state,
 
     UpdateTip(pindexDelete->pprev);
     // Let wallets know transactions went from 1-confirmed to
-    // 0-confirmed or conflicted:
-    GetMainSignals().BlockDisconnected(pblock, pindexDelete);
+    // 0-confirmed or conflicted. The blocks rolled back because their
+    // deferred script checks failed were never announced as connected.
+    if (!m_script_checks_pending) {
+        GetMainSignals().BlockDisconnected(pblock, pindexDelete);
+    }
     return true;
 }
 
@@ -2949,7 +3808,8 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
                             CBlockIndex *pindexNew,
                             const std::shared_ptr<const CBlock> &pblock,
                             DisconnectedBlockTransactions &disconnectpool,
-                            const avalanche::Processor *const avalanche) {
+                            const avalanche::Processor *const avalanche,
+                            DeferredScriptChecks *deferred) {
     AssertLockHeld(cs_main);
     if (m_mempool) {
         AssertLockHeld(m_mempool->cs);
@@ -2972,6 +3832,9 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
     }
 
     const CBlock &blockConnecting = *pthisBlock;
+    if (deferred) {
+        deferred->Hold(pthisBlock);
+    }
 
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros();
@@ -2984,8 +3847,14 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
         CCoinsViewCache view(&CoinsTip());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view,
                                BlockValidationOptions(m_chainman.GetConfig()),
-                               &blockFees);
-        GetMainSignals().BlockChecked(blockConnecting, state);
+                               &blockFees, /*fJustCheck=*/false, deferred);
+        if (deferred) {
+            deferred->Notify([block = pthisBlock, state]() {
+                GetMainSignals().BlockChecked(*block, state);
+            });
+        } else {
+            GetMainSignals().BlockChecked(blockConnecting, state);
+        }
         if (!rv) {
             if (state.IsInvalid()) {
                 InvalidBlockFound(pindexNew, state);
@@ -3142,7 +4011,13 @@ bool Chainstate::ConnectTip(BlockValidationState &state,
         m_chainman.MaybeCompleteSnapshotValidation();
     }
 
-    GetMainSignals().BlockConnected(pthisBlock, pindexNew);
+    if (deferred) {
+        deferred->Notify([block = pthisBlock, pindexNew]() {
+            GetMainSignals().BlockConnected(block, pindexNew);
+        });
+    } else {
+        GetMainSignals().BlockConnected(pthisBlock, pindexNew);
+    }
     return true;
 }
 
@@ -3376,6 +4251,14 @@ bool Chainstate::ActivateBestChainStep(
         fBlocksDisconnected = true;
     }
 
+    // During IBD, connect the blocks without waiting for the script checks of
+    // each one, so that the checks of several small blocks keep the script
+    // check threads busy. The background chainstate is excluded, as it checks
+    // the UTXO set when it reaches the snapshot.
+    bool defer_script_checks{IsInitialBlockDownload() &&
+                             this == &m_chainman.ActiveChainstate()};
+    bool retrying{false};
+
     // Build list of new blocks to connect.
     std::vector<CBlockIndex *> vpindexToConnect;
     bool fContinue = true;
@@ -3394,6 +4277,27 @@ bool Chainstate::ActivateBestChainStep(
 
         nHeight = nTargetHeight;
 
+        std::optional<DeferredScriptChecks> deferred;
+        // Don't leave the flushes disabled if connecting the blocks throws.
+        Defer clear_pending([&]() NO_THREAD_SAFETY_ANALYSIS {
+            m_script_checks_pending = false;
+        });
+        if (defer_script_checks && vpindexToConnect.size() > 1) {
+            deferred.emplace(m_chain.Tip());
+            m_script_checks_pending = true;
+        }
+        // If the deferred checks fail, the blocks are disconnected and are
+        // connected again the usual way, which finds the invalid one. They are
+        // connected without returning in between, so the next step does not
+        // defer their checks again.
+        const auto retry_without_deferring = [&]() {
+            nHeight = m_chain.Height();
+            defer_script_checks = false;
+            retrying = true;
+            fBlocksDisconnected = true;
+        };
+        bool checks_ok;
+
         // Connect new blocks.
         for (CBlockIndex *pindexConnect : reverse_iterate(vpindexToConnect)) {
             BlockPolicyValidationState blockPolicyState;
@@ -3401,7 +4305,21 @@ bool Chainstate::ActivateBestChainStep(
                             pindexConnect == pindexMostWork
                                 ? pblock
                                 : std::shared_ptr<const CBlock>(),
-                            disconnectpool, avalanche)) {
+                            disconnectpool, avalanche,
+                            deferred ? &*deferred : nullptr)) {
+                // The blocks connected before must be checked first.
+                BlockValidationState deferred_state;
+                if (!FinishDeferredScriptChecks(deferred_state, deferred,
+                                                disconnectpool, checks_ok)) {
+                    state = deferred_state;
+                    return false;
+                }
+                if (!checks_ok) {
+                    state = BlockValidationState();
+                    retry_without_deferring();
+                    break;
+                }
+
                 if (state.IsInvalid()) {
                     // The block violates a consensus rule.
                     if (state.GetResult() !=
@@ -3430,8 +4348,9 @@ bool Chainstate::ActivateBestChainStep(
                 return false;
             } else {
                 PruneBlockIndexCandidates();
-                if (!pindexOldTip ||
-                    m_chain.Tip()->nChainWork > pindexOldTip->nChainWork) {
+                if (!deferred && !retrying &&
+                    (!pindexOldTip ||
+                     m_chain.Tip()->nChainWork > pindexOldTip->nChainWork)) {
                     // We're in a better position than we were. Return
                     // temporarily to release the lock.
                     fContinue = false;
@@ -3439,6 +4358,19 @@ bool Chainstate::ActivateBestChainStep(
                 }
             }
         }
+
+        if (deferred) {
+            if (!FinishDeferredScriptChecks(state, deferred, disconnectpool,
+                                            checks_ok)) {
+                return false;
+            }
+            if (!checks_ok) {
+                retry_without_deferring();
+            } else if (!pindexOldTip ||
+                       m_chain.Tip()->nChainWork > pindexOldTip->nChainWork) {
+                fContinue = false;
+            }
+        }
     }
 
     if (m_mempool) {
@@ -3466,6 +4398,66 @@ bool Chainstate::ActivateBestChainStep(
     return true;
 }
 
+bool Chainstate::FinishDeferredScriptChecks(
+    BlockValidationState &state, std::optional<DeferredScriptChecks> &deferred,
+    DisconnectedBlockTransactions &disconnectpool, bool &checks_ok) {
+    AssertLockHeld(cs_main);
+    checks_ok = true;
+    if (!deferred) {
+        return true;
+    }
+
+    checks_ok = deferred->Wait();
+    const CBlockIndex *const start{deferred->Start()};
+    if (checks_ok) {
+        for (CBlockIndex *pindex : deferred->Blocks()) {
+            if (!pindex->IsValid(BlockValidity::SCRIPTS)) {
+                pindex->RaiseValidity(BlockValidity::SCRIPTS);
+                m_blockman.m_dirty_blockindex.insert(pindex);
+            }
+        }
+    }
+    std::vector<std::function<void()>> notifications{
+        deferred->TakeNotifications()};
+    deferred.reset();
+
+    if (!checks_ok) {
+        LogPrintf("Script checks of the blocks after %s failed, connecting "
+                  "them one at a time\n",
+                  start->GetBlockHash().ToString());
+        if (m_mempool && m_chain.Tip() != start) {
+            // Keep the mempool topologically ordered, as when reorganizing
+            disconnectpool.importMempool(*m_mempool);
+        }
+        while (m_chain.Tip() != start) {
+            if (!DisconnectTip(state, &disconnectpool)) {
+                m_script_checks_pending = false;
+                return AbortNode(
+                    state, "Failed to disconnect block; see debug.log for "
+                           "details");
+            }
+            // The blocks were pruned from the candidates as the batch was
+            // connected, see InvalidateBlock().
+            setBlockIndexCandidates.insert(m_chain.Tip());
+        }
+    }
+
+    m_script_checks_pending = false;
+    if (checks_ok) {
+        // Publish the blocks now that they are known to be valid
+        {
+            LOCK(g_best_block_mutex);
+            g_best_block = m_chain.Tip();
+            g_best_block_cv.notify_all();
+        }
+        for (const auto &notify : notifications) {
+            notify();
+        }
+    }
+    // Catch up on the flushes that were skipped in the meantime
+    return FlushStateToDisk(state, FlushStateMode::IF_NEEDED);
+}
+
 static SynchronizationState GetSynchronizationState(bool init) {
     if (!init) {
         return SynchronizationState::POST_INIT;
@@ -3580,13 +4572,21 @@ bool Chainstate::ActivateBestChain(BlockValidationState &state,
 
                 bool fInvalidFound = false;
                 std::shared_ptr<const CBlock> nullBlockPtr;
-                if (!ActivateBestChainStep(
-                        state, pindexMostWork,
-                        pblock && pblock->GetHash() ==
-                                      pindexMostWork->GetBlockHash()
-                            ? pblock
-                            : nullBlockPtr,
-                        fInvalidFound, avalanche)) {
+                const bool step_ok{ActivateBestChainStep(
+                    state, pindexMostWork,
+                    pblock && pblock->GetHash() ==
+                                  pindexMostWork->GetBlockHash()
+                        ? pblock
+                        : nullBlockPtr,
+                    fInvalidFound, avalanche)};
+                // Publish the chain once the step is over, so that the
+                // lockless readers never see the intermediate tips of a
+                // reorganization or the blocks of a batch whose script checks
+                // may still be rolled back.
+                if (this == m_chainman.m_active_chainstate) {
+                    m_chainman.PublishChainSnapshot();
+                }
+                if (!step_ok) {
                     // A system error occurred
                     return false;
                 }
@@ -3740,15 +4740,6 @@ bool Chainstate::PreciousBlock(BlockValidationState &state, CBlockIndex *pindex,
     return ActivateBestChain(state, /*pblock=*/nullptr, avalanche);
 }
 
-namespace {
-// Leverage RAII to run a functor at scope end
-template <typename Func> struct Defer {
-    Func func;
-    Defer(Func &&f) : func(std::move(f)) {}
-    ~Defer() { func(); }
-};
-} // namespace
-
 bool Chainstate::UnwindBlock(BlockValidationState &state, CBlockIndex *pindex,
                              bool invalidate) {
     // Genesis block can't be invalidated or parked
@@ -3814,6 +4805,10 @@ bool Chainstate::UnwindBlock(BlockValidationState &state, CBlockIndex *pindex,
         // as m_mempool can be null. We keep the runtime analysis though.
         Defer deferred([&]() NO_THREAD_SAFETY_ANALYSIS {
             AssertLockHeld(cs_main);
+            // Publish the chain once all the blocks are disconnected
+            if (disconnected > 0 && this == m_chainman.m_active_chainstate) {
+                m_chainman.PublishChainSnapshot();
+            }
             if (m_mempool && !disconnectpool.isEmpty()) {
                 AssertLockHeld(m_mempool->cs);
                 // DisconnectTip will add transactions to disconnectpool.
@@ -5078,6 +6073,9 @@ bool Chainstate::LoadChainTip() {
         return false;
     }
     m_chain.SetTip(*pindex);
+    if (this == m_chainman.m_active_chainstate) {
+        m_chainman.PublishChainSnapshot();
+    }
     PruneBlockIndexCandidates();
 
     tip = m_chain.Tip();
@@ -6285,6 +7283,11 @@ bool Chainstate::ResizeCoinsCaches(size_t coinstip_size, size_t coinsdb_size) {
     size_t old_coinstip_size = m_coinstip_cache_size_bytes;
     m_coinstip_cache_size_bytes = coinstip_size;
     m_coinsdb_cache_size_bytes = coinsdb_size;
+    // The database is reopened, let the background write complete first.
+    if (!m_coins_views->m_writeview.Complete(/*wait=*/true)) {
+        BlockValidationState state;
+        return AbortNode(state, "Failed to write to coin database");
+    }
     CoinsDB().ResizeCache(coinsdb_size);
 
     LogPrintf("[%s] resized coinsdb cache to %.1f MiB\n", this->ToString(),
@@ -6520,6 +7523,7 @@ bool ChainstateManager::ActivateSnapshot(AutoFile &coins_file,
         assert(chaintip_loaded);
 
         m_active_chainstate = m_snapshot_chainstate.get();
+        PublishChainSnapshot();
 
         LogPrintf("[snapshot] successfully activated snapshot %s\n",
                   base_blockhash.ToString());
@@ -6532,7 +7536,7 @@ bool ChainstateManager::ActivateSnapshot(AutoFile &coins_file,
     return true;
 }
 
-static void FlushSnapshotToDisk(CCoinsViewCache &coins_cache,
+static bool FlushSnapshotToDisk(CCoinsViewCache &coins_cache,
                                 bool snapshot_loaded) {
     LOG_TIME_MILLIS_WITH_CATEGORY_MSG_ONCE(
         strprintf("%s (%.2f MB)",
@@ -6541,7 +7545,7 @@ static void FlushSnapshotToDisk(CCoinsViewCache &coins_cache,
                   coins_cache.DynamicMemoryUsage() / (1000 * 1000)),
         BCLog::LogFlags::ALL);
 
-    coins_cache.Flush();
+    return coins_cache.Flush();
 }
 
 struct StopHashingException : public std::exception {
@@ -6595,6 +7599,17 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
     const uint64_t coins_count = metadata.m_coins_count;
     uint64_t coins_left = metadata.m_coins_count;
 
+    // The coins are written to disk by the snapshot chainstate coins writer
+    // in the background. Hand them over whenever the cache holds half of its
+    // budget, so the next half can be read while the previous one is written.
+    const size_t flush_usage{
+        WITH_LOCK(::cs_main,
+                  return snapshot_chainstate.m_coinstip_cache_size_bytes) /
+        2};
+    // The snapshot is hashed as it is read so the database doesn't need to be
+    // read back, which is only possible if it is in database order.
+    SerializedCoinsHasher hasher{base_blockhash};
+
     LogPrintf("[snapshot] loading coins from snapshot %s\n",
               base_blockhash.ToString());
     int64_t coins_processed{0};
@@ -6618,6 +7633,7 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
                 coins_count - coins_left);
             return false;
         }
+        hasher.Add(outpoint, coin);
         coins_cache.EmplaceCoinInternalDANGER(std::move(outpoint),
                                               std::move(coin));
 
@@ -6641,10 +7657,7 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
                 return false;
             }
 
-            const auto snapshot_cache_state = WITH_LOCK(
-                ::cs_main, return snapshot_chainstate.GetCoinsCacheSizeState());
-
-            if (snapshot_cache_state >= CoinsCacheSizeState::CRITICAL) {
+            if (coins_cache.DynamicMemoryUsage() >= flush_usage) {
                 // This is a hack - we don't know what the actual best block is,
                 // but that doesn't matter for the purposes of flushing the
                 // cache here. We'll set this to its correct value
@@ -6653,7 +7666,11 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
 
                 // No need to acquire cs_main since this chainstate isn't being
                 // used yet.
-                FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/false);
+                if (!FlushSnapshotToDisk(coins_cache,
+                                         /*snapshot_loaded=*/false)) {
+                    LogPrintf("[snapshot] failed to write coins to disk\n");
+                    return false;
+                }
             }
         }
     }
@@ -6684,36 +7701,48 @@ bool ChainstateManager::PopulateAndValidateSnapshot(
               base_blockhash.ToString());
 
     // No need to acquire cs_main since this chainstate isn't being used yet.
-    FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/true);
+    // As above, okay to immediately release cs_main here since no other context
+    // knows about the snapshot_chainstate.
+    if (!FlushSnapshotToDisk(coins_cache, /*snapshot_loaded=*/true) ||
+        !WITH_LOCK(::cs_main, return snapshot_chainstate.CoinsWriter().Complete(
+                                  /*wait=*/true))) {
+        LogPrintf("[snapshot] failed to write coins to disk\n");
+        return false;
+    }
 
     assert(coins_cache.GetBestBlock() == base_blockhash);
 
-    // As above, okay to immediately release cs_main here since no other context
-    // knows about the snapshot_chainstate.
-    CCoinsViewDB *snapshot_coinsdb =
-        WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
+    uint256 hash_serialized;
+    if (hasher.IsOrdered()) {
+        hash_serialized = hasher.Finalize();
+    } else {
+        // The coins were not grouped the way the hash expects, hash them from
+        // the database instead.
+        CCoinsViewDB *snapshot_coinsdb =
+            WITH_LOCK(::cs_main, return &snapshot_chainstate.CoinsDB());
 
-    std::optional<CCoinsStats> maybe_stats;
+        std::optional<CCoinsStats> maybe_stats;
 
-    try {
-        maybe_stats = ComputeUTXOStats(CoinStatsHashType::HASH_SERIALIZED,
-                                       snapshot_coinsdb, m_blockman,
-                                       SnapshotUTXOHashBreakpoint);
-    } catch (StopHashingException const &) {
-        return false;
-    }
-    if (!maybe_stats.has_value()) {
-        LogPrintf("[snapshot] failed to generate coins stats\n");
-        return false;
+        try {
+            maybe_stats = ComputeUTXOStats(CoinStatsHashType::HASH_SERIALIZED,
+                                           snapshot_coinsdb, m_blockman,
+                                           SnapshotUTXOHashBreakpoint);
+        } catch (StopHashingException const &) {
+            return false;
+        }
+        if (!maybe_stats.has_value()) {
+            LogPrintf("[snapshot] failed to generate coins stats\n");
+            return false;
+        }
+        hash_serialized = maybe_stats->hashSerialized;
     }
 
     // Assert that the deserialized chainstate contents match the expected
     // assumeutxo value.
-    if (AssumeutxoHash{maybe_stats->hashSerialized} !=
-        au_data.hash_serialized) {
+    if (AssumeutxoHash{hash_serialized} != au_data.hash_serialized) {
         LogPrintf("[snapshot] bad snapshot content hash: expected %s, got %s\n",
                   au_data.hash_serialized.ToString(),
-                  maybe_stats->hashSerialized.ToString());
+                  hash_serialized.ToString());
         return false;
     }
 
@@ -6828,6 +7857,7 @@ SnapshotCompletionResult ChainstateManager::MaybeCompleteSnapshotValidation(
                   "and stopping node\n");
 
         m_active_chainstate = m_ibd_chainstate.get();
+        PublishChainSnapshot();
         m_snapshot_chainstate->m_disabled = true;
         assert(!this->IsUsable(m_snapshot_chainstate.get()));
         assert(this->IsUsable(m_ibd_chainstate.get()));
@@ -6973,6 +8003,13 @@ void ChainstateManager::ResetChainstates() {
     m_ibd_chainstate.reset();
     m_snapshot_chainstate.reset();
     m_active_chainstate = nullptr;
+    PublishChainSnapshot();
+}
+
+void ChainstateManager::PublishChainSnapshot() {
+    AssertLockHeld(::cs_main);
+    m_chain_snapshot.Publish(m_active_chainstate ? m_active_chainstate->m_chain
+                                                 : CChain{});
 }
 
 /**
@@ -7030,6 +8067,7 @@ ChainstateManager::ActivateExistingSnapshot(CTxMemPool *mempool,
     LogPrintf("[snapshot] switching active chainstate to %s\n",
               m_snapshot_chainstate->ToString());
     m_active_chainstate = m_snapshot_chainstate.get();
+    PublishChainSnapshot();
     return *m_snapshot_chainstate;
 }
 
@@ -27,6 +27,7 @@
 #include <kernel/chainstatemanager_opts.h>
 #include <kernel/cs_main.h>
 #include <node/blockstorage.h>
+#include <node/chainsnapshot.h>
 #include <policy/packages.h>
 #include <script/script_error.h>
 #include <script/script_metrics.h>
@@ -57,6 +58,7 @@ class CChainParams;
 class Chainstate;
 class ChainstateManager;
 class CScriptCheck;
+class DeferredScriptChecks;
 class CTxMemPool;
 class CTxUndo;
 class DisconnectedBlockTransactions;
@@ -159,12 +161,14 @@ public:
  */
 void StartScriptCheckWorkerThreads(int threads_num);
 void StartPowCheckWorkerThreads(int threads_num);
+void StartCoinPrefetchWorkerThreads(int threads_num);
 
 /**
  * Stop all of the script checking worker threads
  */
 void StopScriptCheckWorkerThreads();
 void StopPowCheckWorkerThreads();
+void StopCoinPrefetchWorkerThreads();
 
 Amount GetBlockSubsidy(int nHeight, const Consensus::Params &consensusParams,
                        uint256 prevHash);
@@ -379,6 +383,83 @@ ProcessNewPackage(Chainstate &active_chainstate, CTxMemPool &pool,
                   const Package &txns, bool test_accept)
     EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Validate (and maybe submit) a batch of transactions to the mempool. Each
+ * transaction is accepted or rejected individually, as if submitted one at a
+ * time, but the batch is validated under a single lock and its script checks
+ * run in parallel. The batch is sorted topologically, so parents don't need
+ * to come before their children.
+ *
+ * @param[in]    txns            Transactions to validate, possibly
+ *                               interdependent. Only the first of several
+ *                               transactions spending the same coin is
+ *                               considered.
+ * @param[in]    test_accept     When true, run validation checks but don't
+ *                               submit to mempool.
+ * @returns a PackageMempoolAcceptResult which includes a MempoolAcceptResult
+ *     for each distinct transaction. The package state is invalid if any
+ *     transaction was rejected.
+ */
+PackageMempoolAcceptResult
+ProcessTransactionBatch(Chainstate &active_chainstate, CTxMemPool &pool,
+                        const std::vector<CTransactionRef> &txns,
+                        bool test_accept) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/**
+ * A transaction that was in the mempool before a restart, or that is added
+ * back to it after a reorg.
+ */
+struct MempoolLoadTx {
+    CTransactionRef tx;
+    //! Time the transaction entered the mempool
+    int64_t time;
+    //! Chain height the transaction entered the mempool at, 0 for the current
+    //! one
+    unsigned height{0};
+    /**
+     * When the scripts of the transaction are known to be valid, the chain tip
+     * they were verified at, the hash of the transaction and the coins they
+     * were verified against (see GetSpentCoinsHash()) and the resulting
+     * sigchecks count. If the script flags, the transaction and the coins are
+     * still the same, the scripts are not run again.
+     */
+    const CBlockIndex *verified_tip{nullptr};
+    uint256 spent_coins_hash{};
+    int64_t sig_checks{0};
+};
+
+/**
+ * Add back a batch of transactions that left the mempool in a reorg, see
+ * DisconnectedBlockTransactions::updateMempoolForReorg(). The transactions
+ * must be in topological order. They are not subject to the mempool limits and
+ * keep their original entry time and height. The policy script checks of the
+ * batch run in parallel, the consensus checks of the transactions that were in
+ * the mempool before are found in the script cache.
+ */
+PackageMempoolAcceptResult
+ReaddTransactionBatch(Chainstate &active_chainstate, CTxMemPool &pool,
+                      const std::vector<MempoolLoadTx> &txs)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/**
+ * Hash committing to a transaction and to the coins it spends, in input order.
+ * The transaction is committed to through its txid, so that a record whose
+ * transaction got altered no longer matches. The hash is not keyed, whoever
+ * stores it must authenticate it, see kernel::MempoolJournal.
+ */
+uint256 GetSpentCoinsHash(const CTransaction &tx,
+                          const std::vector<Coin> &spent_coins);
+
+/**
+ * Reload a batch of transactions into the mempool, see
+ * kernel::LoadMempool(). This works like ProcessTransactionBatch(), but the
+ * transactions keep their original entry time.
+ */
+PackageMempoolAcceptResult
+LoadMempoolTransactions(Chainstate &active_chainstate, CTxMemPool &pool,
+                        const std::vector<MempoolLoadTx> &txs)
+    EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 /**
  * Simple class for regulating resource usage during CheckInputScripts (and
  * CScriptCheck), atomic so as to be compatible with parallel validation.
@@ -411,6 +492,13 @@ public:
         return *this;
     }
 
+    /**
+     * Number of sigchecks consumed so far. This is how the total is retrieved
+     * when the checks are executed on the script check queue. Meaningless for
+     * a limiter obtained from getDisabled().
+     */
+    int64_t consumed() const { return MAX_TX_SIGCHECKS - remaining.load(); }
+
     static TxSigCheckLimiter getDisabled() {
         TxSigCheckLimiter txLimiter;
         // Historically, there has not been a transaction with more than 20k sig
@@ -655,6 +743,10 @@ public:
     //! database on disk. All unspent coins reside in this store.
     CCoinsViewDB m_dbview GUARDED_BY(cs_main);
 
+    //! This view writes the coins flushed from the cache to the leveldb
+    //! instance, in the background if the cache is written incrementally.
+    CCoinsViewWriteBehind m_writeview GUARDED_BY(cs_main);
+
     //! This view wraps access to the leveldb instance and handles read errors
     //! gracefully.
     CCoinsViewErrorCatcher m_catcherview GUARDED_BY(cs_main);
@@ -663,15 +755,17 @@ public:
     //! memory as can fit per the dbcache setting.
     std::unique_ptr<CCoinsViewCache> m_cacheview GUARDED_BY(cs_main);
 
-    //! This constructor initializes CCoinsViewDB and CCoinsViewErrorCatcher
-    //! instances, but it *does not* create a CCoinsViewCache instance by
+    //! This constructor initializes CCoinsViewDB, CCoinsViewWriteBehind and
+    //! CCoinsViewErrorCatcher instances, but it *does not* create a CCoinsViewCache instance by
     //! default. This is done separately because the presence of the cache has
     //! implications on whether or not we're allowed to flush the cache's state
     //! to disk, which should not be done until the health of the database is
     //! verified.
     //!
-    //! All arguments forwarded onto CCoinsViewDB.
-    CoinsViews(DBParams db_params, CoinsViewOptions options);
+    //! The database arguments are forwarded onto CCoinsViewDB. The coins are
+    //! only written in the background with -incrementalcoinsflush.
+    CoinsViews(DBParams db_params, CoinsViewOptions options,
+               bool background_writes);
 
     //! Initialize the CCoinsViewCache member.
     void InitCache() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
@@ -769,6 +863,13 @@ protected:
     CBlockIndex const *m_best_fork_tip = nullptr;
     CBlockIndex const *m_best_fork_base = nullptr;
 
+    /**
+     * Whether blocks were connected without waiting for their script checks.
+     * Until the checks complete, the chainstate is not flushed to disk and
+     * the blocks are not announced, as they may still turn out to be invalid.
+     */
+    bool m_script_checks_pending GUARDED_BY(::cs_main){false};
+
 public:
     //! Reference to a BlockManager instance which itself is shared across all
     //! Chainstate instances.
@@ -846,6 +947,13 @@ public:
         return Assert(m_coins_views)->m_dbview;
     }
 
+    //! @returns A reference to the view that writes the coins cache to the
+    //!     UTXO set database in the background.
+    CCoinsViewWriteBehind &CoinsWriter() EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+        AssertLockHeld(::cs_main);
+        return Assert(m_coins_views)->m_writeview;
+    }
+
     //! @returns A pointer to the mempool.
     CTxMemPool *GetMempool() { return m_mempool; }
 
@@ -977,10 +1085,16 @@ public:
                                      const CBlockIndex *pindex,
                                      CCoinsViewCache &view)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /**
+     * If @p deferred is set, the script checks of the block are added to it
+     * instead of being waited for, and the block is not marked as
+     * BlockValidity::SCRIPTS. The caller is responsible for that.
+     */
     bool ConnectBlock(const CBlock &block, BlockValidationState &state,
                       CBlockIndex *pindex, CCoinsViewCache &view,
                       BlockValidationOptions options,
-                      Amount *blockFees = nullptr, bool fJustCheck = false)
+                      Amount *blockFees = nullptr, bool fJustCheck = false,
+                      DeferredScriptChecks *deferred = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     // Apply the effects of a block disconnection on the UTXO set.
@@ -1118,9 +1232,21 @@ private:
                     CBlockIndex *pindexNew,
                     const std::shared_ptr<const CBlock> &pblock,
                     DisconnectedBlockTransactions &disconnectpool,
-                    const avalanche::Processor *const avalanche = nullptr)
+                    const avalanche::Processor *const avalanche = nullptr,
+                    DeferredScriptChecks *deferred = nullptr)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs,
                                  !cs_avalancheFinalizedBlockIndex);
+    /**
+     * Wait for the script checks of the blocks connected with @p deferred,
+     * and reset it. If any check failed, @p checks_ok is set to false and the
+     * blocks are disconnected again, so that they can be connected one at a
+     * time to find the invalid one. Returns false on a system error.
+     */
+    bool FinishDeferredScriptChecks(
+        BlockValidationState &state,
+        std::optional<DeferredScriptChecks> &deferred,
+        DisconnectedBlockTransactions &disconnectpool, bool &checks_ok)
+        EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_mempool->cs);
     void InvalidBlockFound(CBlockIndex *pindex,
                            const BlockValidationState &state)
         EXCLUSIVE_LOCKS_REQUIRED(cs_main, !cs_avalancheFinalizedBlockIndex);
@@ -1160,6 +1286,9 @@ private:
 
     std::chrono::microseconds m_last_write{0};
     std::chrono::microseconds m_last_flush{0};
+    //! Memory usage of the coins cache after it was last written, with
+    //! -incrementalcoinsflush
+    size_t m_coins_usage_after_write{0};
 
     /**
      * In case of an invalid snapshot, rename the coins leveldb directory so
@@ -1263,6 +1392,9 @@ private:
     CBlockIndex *m_best_invalid GUARDED_BY(::cs_main){nullptr};
     CBlockIndex *m_best_parked GUARDED_BY(::cs_main){nullptr};
 
+    //! Published under cs_main, read without it.
+    node::ChainSnapshotPublisher m_chain_snapshot;
+
     //! Internal helper for ActivateSnapshot().
     [[nodiscard]] bool
     PopulateAndValidateSnapshot(Chainstate &snapshot_chainstate,
@@ -1439,6 +1571,19 @@ public:
         return ActiveChain().Tip();
     }
 
+    /**
+     * Snapshot of the active chain, for read-only queries that do not need
+     * to hold cs_main. It is published again once the active chain is done
+     * changing, i.e. after a reorganization or a batch of blocks is complete,
+     * so it never exposes the intermediate tips.
+     */
+    node::ChainSnapshotRef GetChainSnapshot() const {
+        return m_chain_snapshot.Get();
+    }
+
+    /** Publish a new snapshot of the active chain */
+    void PublishChainSnapshot() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+
     node::BlockMap &BlockIndex() EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
         return m_blockman.m_block_index;
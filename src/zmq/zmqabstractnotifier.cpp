@@ -4,20 +4,64 @@
 
 #include <zmq/zmqabstractnotifier.h>
 
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <rpc/server.h>
+#include <streams.h>
+#include <version.h>
+
 #include <cassert>
 
+const std::vector<uint8_t> *CZMQNotifiedBlock::Serialized() const {
+    if (m_serialized) {
+        return &*m_serialized;
+    }
+    if (m_read_failed) {
+        return nullptr;
+    }
+
+    std::shared_ptr<const CBlock> block{m_block};
+    if (!block) {
+        auto read_block = std::make_shared<CBlock>();
+        if (!m_get_block_by_index(*read_block, m_index)) {
+            m_read_failed = true;
+            return nullptr;
+        }
+        block = std::move(read_block);
+    }
+
+    m_serialized.emplace();
+    CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(),
+                  *m_serialized, 0, *block);
+    return &*m_serialized;
+}
+
+const std::vector<uint8_t> &CZMQNotifiedTransaction::Serialized() const {
+    if (!m_serialized) {
+        m_serialized.emplace();
+        CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(),
+                      *m_serialized, 0, m_tx);
+    }
+    return *m_serialized;
+}
+
 const int CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM;
 
 CZMQAbstractNotifier::~CZMQAbstractNotifier() {
     assert(!psocket);
 }
 
-bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/) {
+bool CZMQAbstractNotifier::NotifyBlock(const CZMQNotifiedBlock & /*block*/) {
     return true;
 }
 
 bool CZMQAbstractNotifier::NotifyTransaction(
-    const CTransaction & /*transaction*/) {
+    const CZMQNotifiedTransaction & /*transaction*/) {
+    return true;
+}
+
+bool CZMQAbstractNotifier::Flush(
+    std::chrono::steady_clock::time_point /*now*/) {
     return true;
 }
 
@@ -5,10 +5,15 @@
 #ifndef BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 #define BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
+class CBlock;
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
@@ -16,6 +21,50 @@ class CZMQAbstractNotifier;
 using CZMQNotifierFactory =
     std::function<std::unique_ptr<CZMQAbstractNotifier>()>;
 
+/**
+ * A block being notified. The block is taken from memory when available,
+ * otherwise it is read from disk on first use, and it is serialized at most
+ * once for all the notifiers.
+ */
+class CZMQNotifiedBlock {
+public:
+    using GetBlockByIndex = std::function<bool(CBlock &, const CBlockIndex &)>;
+
+    CZMQNotifiedBlock(const CBlockIndex &index,
+                      std::shared_ptr<const CBlock> block,
+                      const GetBlockByIndex &get_block_by_index)
+        : m_index(index), m_block(std::move(block)),
+          m_get_block_by_index(get_block_by_index) {}
+
+    const CBlockIndex &Index() const { return m_index; }
+
+    /** The serialized block, or nullptr if it cannot be read from disk */
+    const std::vector<uint8_t> *Serialized() const;
+
+private:
+    const CBlockIndex &m_index;
+    const std::shared_ptr<const CBlock> m_block;
+    const GetBlockByIndex &m_get_block_by_index;
+    mutable bool m_read_failed{false};
+    mutable std::optional<std::vector<uint8_t>> m_serialized;
+};
+
+/**
+ * A transaction being notified, serialized at most once for all the
+ * notifiers.
+ */
+class CZMQNotifiedTransaction {
+public:
+    explicit CZMQNotifiedTransaction(const CTransaction &tx) : m_tx(tx) {}
+
+    const CTransaction &Get() const { return m_tx; }
+    const std::vector<uint8_t> &Serialized() const;
+
+private:
+    const CTransaction &m_tx;
+    mutable std::optional<std::vector<uint8_t>> m_serialized;
+};
+
 class CZMQAbstractNotifier {
 public:
     static const int DEFAULT_ZMQ_SNDHWM{1000};
@@ -47,7 +96,7 @@ public:
     virtual void Shutdown() = 0;
 
     // Notifies of ConnectTip result, i.e., new active tip only
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    virtual bool NotifyBlock(const CZMQNotifiedBlock &block);
     // Notifies of every block connection
     virtual bool NotifyBlockConnect(const CBlockIndex *pindex);
     // Notifies of every block disconnection
@@ -59,7 +108,9 @@ public:
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction,
                                           uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
-    virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyTransaction(const CZMQNotifiedTransaction &transaction);
+    // Called periodically for the notifiers that delay their messages
+    virtual bool Flush(std::chrono::steady_clock::time_point now);
 
 protected:
     void *psocket;
@@ -11,8 +11,13 @@
 #include <common/args.h>
 #include <logging.h>
 #include <primitives/block.h>
+#include <util/thread.h>
 
-CZMQNotificationInterface::CZMQNotificationInterface() : pcontext(nullptr) {}
+#include <algorithm>
+
+CZMQNotificationInterface::CZMQNotificationInterface(
+    std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index)
+    : m_get_block_by_index(std::move(get_block_by_index)), pcontext(nullptr) {}
 
 CZMQNotificationInterface::~CZMQNotificationInterface() {
     Shutdown();
@@ -20,6 +25,7 @@ CZMQNotificationInterface::~CZMQNotificationInterface() {
 
 std::list<const CZMQAbstractNotifier *>
 CZMQNotificationInterface::GetActiveNotifiers() const {
+    LOCK(m_mutex);
     std::list<const CZMQAbstractNotifier *> result;
     for (const auto &n : notifiers) {
         result.push_back(n.get());
@@ -35,12 +41,21 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(
     factories["pubhashtx"] =
         CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] =
-        [&get_block_by_index]() -> std::unique_ptr<CZMQAbstractNotifier> {
-        return std::make_unique<CZMQPublishRawBlockNotifier>(
-            get_block_by_index);
-    };
+        CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] =
         CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    const size_t batch_size{static_cast<size_t>(std::max<int64_t>(
+        1, gArgs.GetIntArg(
+               "-zmqpubrawtxbatchsize",
+               CZMQPublishRawTransactionBatchNotifier::DEFAULT_BATCH_SIZE)))};
+    const std::chrono::milliseconds batch_delay{std::max<int64_t>(
+        1, gArgs.GetIntArg("-zmqpubrawtxbatchdelay",
+                           CZMQPublishRawTransactionBatchNotifier::
+                               DEFAULT_MAX_DELAY.count()))};
+    factories["pubrawtxbatch"] = [batch_size, batch_delay]() {
+        return std::make_unique<CZMQPublishRawTransactionBatchNotifier>(
+            batch_size, batch_delay);
+    };
     factories["pubsequence"] =
         CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
 
@@ -60,9 +75,17 @@ std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(
     }
 
     if (!notifiers.empty()) {
+        const bool has_batches{gArgs.IsArgSet("-zmqpubrawtxbatch")};
         std::unique_ptr<CZMQNotificationInterface> notificationInterface(
-            new CZMQNotificationInterface());
-        notificationInterface->notifiers = std::move(notifiers);
+            new CZMQNotificationInterface(std::move(get_block_by_index)));
+        WITH_LOCK(notificationInterface->m_mutex,
+                  notificationInterface->notifiers = std::move(notifiers));
+        if (has_batches) {
+            // Check the pending batches often enough to send them close to
+            // their deadline
+            notificationInterface->m_flush_interval =
+                std::max(batch_delay / 4, std::chrono::milliseconds{1});
+        }
 
         if (notificationInterface->Initialize()) {
             return notificationInterface;
@@ -79,6 +102,7 @@ bool CZMQNotificationInterface::Initialize() {
     LogPrint(BCLog::ZMQ, "zmq: version %d.%d.%d\n", major, minor, patch);
 
     LogPrint(BCLog::ZMQ, "zmq: Initialize notification interface\n");
+    LOCK(m_mutex);
     assert(!pcontext);
 
     pcontext = zmq_ctx_new();
@@ -99,12 +123,25 @@ bool CZMQNotificationInterface::Initialize() {
         }
     }
 
+    if (m_flush_interval.count() > 0) {
+        m_flush_thread = std::thread(&util::TraceThread, "zmqflush",
+                                     [this] { ThreadFlush(); });
+    }
+
     return true;
 }
 
 // Called during shutdown sequence
 void CZMQNotificationInterface::Shutdown() {
     LogPrint(BCLog::ZMQ, "zmq: Shutdown notification interface\n");
+    m_flush_interrupt();
+    if (m_flush_thread.joinable()) {
+        m_flush_thread.join();
+    }
+
+    LOCK(m_mutex);
+    m_last_connected_block.reset();
+    m_last_connected_index = nullptr;
     if (pcontext) {
         for (auto &notifier : notifiers) {
             LogPrint(BCLog::ZMQ, "zmq: Shutdown notifier %s at %s\n",
@@ -136,17 +173,40 @@ void TryForEachAndRemoveFailed(
 
 } // anonymous namespace
 
+void CZMQNotificationInterface::ThreadFlush() {
+    while (m_flush_interrupt.sleep_for(m_flush_interval)) {
+        const auto now = std::chrono::steady_clock::now();
+        LOCK(m_mutex);
+        TryForEachAndRemoveFailed(notifiers,
+                                  [now](CZMQAbstractNotifier *notifier) {
+                                      return notifier->Flush(now);
+                                  });
+    }
+}
+
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew,
                                                 const CBlockIndex *pindexFork,
                                                 bool fInitialDownload) {
+    LOCK(m_mutex);
+    // The new tip is normally the block connected last, in which case it is
+    // published from memory
+    std::shared_ptr<const CBlock> pblock;
+    if (m_last_connected_index == pindexNew) {
+        pblock = std::move(m_last_connected_block);
+    }
+    m_last_connected_block.reset();
+    m_last_connected_index = nullptr;
+
     // In IBD or blocks were disconnected without any new ones
     if (fInitialDownload || pindexNew == pindexFork) {
         return;
     }
 
+    const CZMQNotifiedBlock block{*pindexNew, std::move(pblock),
+                                  m_get_block_by_index};
     TryForEachAndRemoveFailed(notifiers,
-                              [pindexNew](CZMQAbstractNotifier *notifier) {
-                                  return notifier->NotifyBlock(pindexNew);
+                              [&block](CZMQAbstractNotifier *notifier) {
+                                  return notifier->NotifyBlock(block);
                               });
 }
 
@@ -154,10 +214,12 @@ void CZMQNotificationInterface::TransactionAddedToMempool(
     const CTransactionRef &ptx, std::shared_ptr<const std::vector<Coin>>,
     uint64_t mempool_sequence) {
     const CTransaction &tx = *ptx;
+    const CZMQNotifiedTransaction notified_tx{tx};
 
+    LOCK(m_mutex);
     TryForEachAndRemoveFailed(
-        notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier *notifier) {
-            return notifier->NotifyTransaction(tx) &&
+        notifiers, [&](CZMQAbstractNotifier *notifier) {
+            return notifier->NotifyTransaction(notified_tx) &&
                    notifier->NotifyTransactionAcceptance(tx, mempool_sequence);
         });
 }
@@ -168,6 +230,7 @@ void CZMQNotificationInterface::TransactionRemovedFromMempool(
     // Called for all non-block inclusion reasons
     const CTransaction &tx = *ptx;
 
+    LOCK(m_mutex);
     TryForEachAndRemoveFailed(
         notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier *notifier) {
             return notifier->NotifyTransactionRemoval(tx, mempool_sequence);
@@ -177,8 +240,12 @@ void CZMQNotificationInterface::TransactionRemovedFromMempool(
 void CZMQNotificationInterface::BlockConnected(
     const std::shared_ptr<const CBlock> &pblock,
     const CBlockIndex *pindexConnected) {
+    LOCK(m_mutex);
+    m_last_connected_block = pblock;
+    m_last_connected_index = pindexConnected;
+
     for (const CTransactionRef &ptx : pblock->vtx) {
-        const CTransaction &tx = *ptx;
+        const CZMQNotifiedTransaction tx{*ptx};
         TryForEachAndRemoveFailed(notifiers,
                                   [&tx](CZMQAbstractNotifier *notifier) {
                                       return notifier->NotifyTransaction(tx);
@@ -195,8 +262,9 @@ void CZMQNotificationInterface::BlockConnected(
 void CZMQNotificationInterface::BlockDisconnected(
     const std::shared_ptr<const CBlock> &pblock,
     const CBlockIndex *pindexDisconnected) {
+    LOCK(m_mutex);
     for (const CTransactionRef &ptx : pblock->vtx) {
-        const CTransaction &tx = *ptx;
+        const CZMQNotifiedTransaction tx{*ptx};
         TryForEachAndRemoveFailed(notifiers,
                                   [&tx](CZMQAbstractNotifier *notifier) {
                                       return notifier->NotifyTransaction(tx);
@@ -5,11 +5,15 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include <sync.h>
+#include <threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <chrono>
 #include <functional>
 #include <list>
 #include <memory>
+#include <thread>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
@@ -18,14 +22,15 @@ class CZMQNotificationInterface final : public CValidationInterface {
 public:
     virtual ~CZMQNotificationInterface();
 
-    std::list<const CZMQAbstractNotifier *> GetActiveNotifiers() const;
+    std::list<const CZMQAbstractNotifier *> GetActiveNotifiers() const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
 
     static std::unique_ptr<CZMQNotificationInterface> Create(
         std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index);
 
 protected:
-    bool Initialize();
-    void Shutdown();
+    bool Initialize() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Shutdown() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
 
     // CValidationInterface
     void TransactionAddedToMempool(const CTransactionRef &tx,
@@ -43,10 +48,30 @@ protected:
                          bool fInitialDownload) override;
 
 private:
-    CZMQNotificationInterface();
+    CZMQNotificationInterface(
+        std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index);
+
+    void ThreadFlush() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    const std::function<bool(CBlock &, const CBlockIndex &)>
+        m_get_block_by_index;
+
+    //! Serializes the notifications with the flushes of the delayed ones
+    mutable Mutex m_mutex;
+    void *pcontext GUARDED_BY(m_mutex);
+    std::list<std::unique_ptr<CZMQAbstractNotifier>>
+        notifiers GUARDED_BY(m_mutex);
+
+    //! The last block connected, so a new tip can be published without
+    //! reading it back from disk
+    std::shared_ptr<const CBlock>
+        m_last_connected_block GUARDED_BY(m_mutex);
+    const CBlockIndex *m_last_connected_index GUARDED_BY(m_mutex){nullptr};
 
-    void *pcontext;
-    std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+    //! Interval of the flushes, zero if no notifier delays its messages
+    std::chrono::milliseconds m_flush_interval{0};
+    std::thread m_flush_thread;
+    CThreadInterrupt m_flush_interrupt;
 };
 
 extern std::unique_ptr<CZMQNotificationInterface> g_zmq_notification_interface;
@@ -31,6 +31,7 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX = "hashtx";
 static const char *MSG_RAWBLOCK = "rawblock";
 static const char *MSG_RAWTX = "rawtx";
+static const char *MSG_RAWTXBATCH = "rawtxbatch";
 static const char *MSG_SEQUENCE = "sequence";
 
 // Internal function to send multipart message
@@ -73,6 +74,26 @@ static int zmq_send_multipart(void *sock, const void *data, size_t size, ...) {
     return 0;
 }
 
+// Internal function to send one part of a multipart message
+static bool zmq_send_part(void *sock, const void *data, size_t size,
+                          bool more) {
+    zmq_msg_t msg;
+    if (zmq_msg_init_size(&msg, size) != 0) {
+        zmqError("Unable to initialize ZMQ msg");
+        return false;
+    }
+    if (size) {
+        memcpy(zmq_msg_data(&msg), data, size);
+    }
+    if (zmq_msg_send(&msg, sock, more ? ZMQ_SNDMORE : 0) == -1) {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return false;
+    }
+    zmq_msg_close(&msg);
+    return true;
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext) {
     assert(!psocket);
 
@@ -184,8 +205,33 @@ bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command,
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
-    BlockHash hash = pindex->GetBlockHash();
+bool CZMQAbstractPublishNotifier::SendZmqMessage(
+    const char *command, const std::vector<std::vector<uint8_t>> &data) {
+    assert(psocket);
+
+    // Once the first part is sent, the others are queued along with it
+    uint8_t msgseq[sizeof(uint32_t)];
+    WriteLE32(msgseq, nSequence);
+    if (!zmq_send_part(psocket, command, strlen(command), /*more=*/true)) {
+        return false;
+    }
+    for (const std::vector<uint8_t> &part : data) {
+        if (!zmq_send_part(psocket, part.data(), part.size(),
+                           /*more=*/true)) {
+            return false;
+        }
+    }
+    if (!zmq_send_part(psocket, msgseq, sizeof(msgseq), /*more=*/false)) {
+        return false;
+    }
+
+    nSequence++;
+
+    return true;
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CZMQNotifiedBlock &block) {
+    BlockHash hash = block.Index().GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s to %s\n", hash.GetHex(),
              this->address);
     uint8_t data[32];
@@ -196,8 +242,8 @@ bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
 }
 
 bool CZMQPublishHashTransactionNotifier::NotifyTransaction(
-    const CTransaction &transaction) {
-    TxId txid = transaction.GetId();
+    const CZMQNotifiedTransaction &transaction) {
+    TxId txid = transaction.Get().GetId();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashtx %s to %s\n", txid.GetHex(),
              this->address);
     uint8_t data[32];
@@ -207,30 +253,54 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(
     return SendZmqMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CZMQNotifiedBlock &block) {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n",
-             pindex->GetBlockHash().GetHex(), this->address);
+             block.Index().GetBlockHash().GetHex(), this->address);
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    CBlock block;
-    if (!m_get_block_by_index(block, *pindex)) {
+    const std::vector<uint8_t> *data = block.Serialized();
+    if (!data) {
         zmqError("Can't read block from disk");
         return false;
     }
 
-    ss << block;
-
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendZmqMessage(MSG_RAWBLOCK, data->data(), data->size());
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(
-    const CTransaction &transaction) {
-    TxId txid = transaction.GetId();
+    const CZMQNotifiedTransaction &transaction) {
+    TxId txid = transaction.Get().GetId();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s to %s\n", txid.GetHex(),
              this->address);
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    const std::vector<uint8_t> &data = transaction.Serialized();
+    return SendZmqMessage(MSG_RAWTX, data.data(), data.size());
+}
+
+bool CZMQPublishRawTransactionBatchNotifier::SendPending() {
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawtxbatch of %u transactions to %s\n",
+             m_pending.size(), this->address);
+    const bool sent = SendZmqMessage(MSG_RAWTXBATCH, m_pending);
+    m_pending.clear();
+    return sent;
+}
+
+bool CZMQPublishRawTransactionBatchNotifier::NotifyTransaction(
+    const CZMQNotifiedTransaction &transaction) {
+    if (m_pending.empty()) {
+        m_first_pending_time = std::chrono::steady_clock::now();
+    }
+    m_pending.push_back(transaction.Serialized());
+    if (m_pending.size() < m_batch_size) {
+        return true;
+    }
+    return SendPending();
+}
+
+bool CZMQPublishRawTransactionBatchNotifier::Flush(
+    std::chrono::steady_clock::time_point now) {
+    if (m_pending.empty() || now - m_first_pending_time < m_max_delay) {
+        return true;
+    }
+    return SendPending();
 }
 
 // TODO: Dedup this code to take label char, log string
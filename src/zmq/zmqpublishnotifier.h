@@ -7,10 +7,10 @@
 
 #include <zmq/zmqabstractnotifier.h>
 
-#include <functional>
-
-class CBlock;
-class CBlockIndex;
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier {
 private:
@@ -26,35 +26,67 @@ public:
     */
     bool SendZmqMessage(const char *command, const void *data, size_t size);
 
+    /* send zmq multipart message with several data parts
+       parts:
+          * command
+          * data, one part per entry
+          * message sequence number
+    */
+    bool SendZmqMessage(const char *command,
+                        const std::vector<std::vector<uint8_t>> &data);
+
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
 };
 
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CZMQNotifiedBlock &block) override;
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier {
 public:
-    bool NotifyTransaction(const CTransaction &transaction) override;
+    bool
+    NotifyTransaction(const CZMQNotifiedTransaction &transaction) override;
 };
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier {
-private:
-    const std::function<bool(CBlock &, const CBlockIndex &)>
-        m_get_block_by_index;
-
 public:
-    CZMQPublishRawBlockNotifier(
-        std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index)
-        : m_get_block_by_index{std::move(get_block_by_index)} {}
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CZMQNotifiedBlock &block) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier {
 public:
-    bool NotifyTransaction(const CTransaction &transaction) override;
+    bool
+    NotifyTransaction(const CZMQNotifiedTransaction &transaction) override;
+};
+
+/**
+ * Publishes the raw transactions in batches, one multipart message holding up
+ * to batch_size transactions. A batch is sent once it is full or once its
+ * first transaction has waited for max_delay.
+ */
+class CZMQPublishRawTransactionBatchNotifier
+    : public CZMQAbstractPublishNotifier {
+private:
+    const size_t m_batch_size;
+    const std::chrono::milliseconds m_max_delay;
+    std::vector<std::vector<uint8_t>> m_pending;
+    std::chrono::steady_clock::time_point m_first_pending_time;
+
+    bool SendPending();
+
+public:
+    static const size_t DEFAULT_BATCH_SIZE{100};
+    static constexpr std::chrono::milliseconds DEFAULT_MAX_DELAY{100};
+
+    CZMQPublishRawTransactionBatchNotifier(size_t batch_size,
+                                           std::chrono::milliseconds max_delay)
+        : m_batch_size(batch_size), m_max_delay(max_delay) {}
+
+    bool
+    NotifyTransaction(const CZMQNotifiedTransaction &transaction) override;
+    bool Flush(std::chrono::steady_clock::time_point now) override;
 };
 
 class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier {
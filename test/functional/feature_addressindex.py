@@ -0,0 +1,147 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the address index.
+
+Test the getaddresshistory and getaddressutxos RPCs and the matching
+/rest/address/history/ and /rest/address/utxos/ routes, including their
+paging and how they follow a reorg.
+"""
+import http.client
+import json
+import urllib.parse
+from decimal import Decimal
+
+from test_framework.address import (
+    ADDRESS_ECREG_P2SH_OP_TRUE,
+    ADDRESS_ECREG_UNSPENDABLE,
+)
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+from test_framework.wallet import MiniWallet
+
+
+class AddressIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+        self.extra_args = [["-addressindex", "-rest"]]
+
+    def rest_request(self, uri, status=200):
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request("GET", f"/rest{uri}")
+        resp = conn.getresponse()
+        assert_equal(resp.status, status)
+        body = resp.read().decode("utf-8")
+        if status != 200:
+            return body
+        return json.loads(body, parse_float=Decimal)
+
+    def run_test(self):
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+        address = ADDRESS_ECREG_P2SH_OP_TRUE
+
+        self.log.info("Index the coinbases paying to the address")
+        coinbase_blocks = self.generate(wallet, 2)
+        self.generatetoaddress(node, COINBASE_MATURITY, ADDRESS_ECREG_UNSPENDABLE)
+        coinbases = [node.getblock(h)["tx"][0] for h in coinbase_blocks]
+        history = node.getaddresshistory(address)
+        assert_equal(
+            history,
+            [
+                {"txid": coinbases[0], "height": 1, "blockhash": coinbase_blocks[0]},
+                {"txid": coinbases[1], "height": 2, "blockhash": coinbase_blocks[1]},
+            ],
+        )
+        utxos = node.getaddressutxos(address)
+        assert_equal(
+            sorted(u["txid"] for u in utxos),
+            sorted(coinbases),
+        )
+        for utxo in utxos:
+            assert_equal(utxo["vout"], 0)
+            assert_equal(
+                utxo["amount"], node.gettxout(utxo["txid"], utxo["vout"])["value"]
+            )
+
+        self.log.info("A transaction spending from and paying to the address")
+        tx = wallet.send_self_transfer(from_node=node)
+        spent_txid = node.getrawtransaction(tx["txid"], True)["vin"][0]["txid"]
+        block = self.generatetoaddress(node, 1, ADDRESS_ECREG_UNSPENDABLE)[0]
+        height = node.getblockcount()
+        history = node.getaddresshistory(address)
+        assert_equal(len(history), 3)
+        assert_equal(
+            history[2], {"txid": tx["txid"], "height": height, "blockhash": block}
+        )
+        utxos = node.getaddressutxos(address)
+        unspent_coinbase = [txid for txid in coinbases if txid != spent_txid]
+        assert_equal(
+            sorted(u["txid"] for u in utxos),
+            sorted(unspent_coinbase + [tx["txid"]]),
+        )
+
+        self.log.info("Page through the history and the unspent outputs")
+        assert_equal(node.getaddresshistory(address, 1, 1), history[1:2])
+        assert_equal(node.getaddresshistory(address, 3), [])
+        assert_equal(node.getaddressutxos(address, 1, 1), utxos[1:2])
+        if self.is_cli_compiled():
+            # The paging arguments are converted to numbers
+            assert_equal(node.cli.getaddresshistory(address, 1, 2), history[1:3])
+            assert_equal(node.cli.getaddressutxos(address, 0, 1), utxos[0:1])
+
+        self.log.info("Query the index over REST")
+        assert_equal(self.rest_request(f"/address/history/{address}.json"), history)
+        assert_equal(
+            self.rest_request(f"/address/history/1/1/{address}.json"), history[1:2]
+        )
+        assert_equal(self.rest_request(f"/address/utxos/{address}.json"), utxos)
+        assert_equal(
+            self.rest_request(f"/address/utxos/1/1/{address}.json"), utxos[1:2]
+        )
+        self.rest_request(f"/address/utxos/-1/1/{address}.json", status=400)
+        self.rest_request(f"/address/utxos/0/10001/{address}.json", status=400)
+        self.rest_request("/address/history/notanaddress.json", status=400)
+        self.rest_request(f"/address/history/{address}.bin", status=404)
+
+        self.log.info("Check the RPC errors")
+        assert_raises_rpc_error(
+            -5, "Invalid address", node.getaddresshistory, "notanaddress"
+        )
+        assert_raises_rpc_error(-8, "Negative skip", node.getaddressutxos, address, -1)
+        assert_raises_rpc_error(
+            -8,
+            "count must be between 1 and 10000",
+            node.getaddresshistory,
+            address,
+            0,
+            0,
+        )
+
+        self.log.info("The index follows a reorg")
+        node.invalidateblock(block)
+        assert_equal(node.getaddresshistory(address), history[:2])
+        assert_equal(
+            sorted(u["txid"] for u in node.getaddressutxos(address)),
+            sorted(coinbases),
+        )
+        node.reconsiderblock(block)
+        assert_equal(node.getaddresshistory(address), history)
+        assert_equal(node.getaddressutxos(address), utxos)
+
+        self.log.info("The RPCs and routes require -addressindex")
+        self.restart_node(0, extra_args=["-rest"])
+        assert_raises_rpc_error(
+            -1,
+            "Requires addressindex. Start with -addressindex.",
+            node.getaddresshistory,
+            address,
+        )
+        self.rest_request(f"/address/utxos/{address}.json", status=404)
+
+
+if __name__ == "__main__":
+    AddressIndexTest().main()
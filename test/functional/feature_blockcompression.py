@@ -0,0 +1,71 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the compression of the block files with -blockcompression.
+
+The block files that are no longer written to are replaced by compressed
+versions in the background. The blocks must be read from them as before,
+including when reindexing, and pruning must remove them.
+"""
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+
+class BlockCompressionTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        # Small block files, so a few of them get filled up quickly
+        self.extra_args = [["-fastprune", "-blockcompression"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_zstd()
+
+    def blk_path(self, file, compressed=False):
+        return os.path.join(
+            self.nodes[0].chain_path,
+            "blocks",
+            f"blk{file:05}.dat" + (".zst" if compressed else ""),
+        )
+
+    def get_blocks(self):
+        node = self.nodes[0]
+        return [
+            node.getblock(node.getblockhash(height), 0)
+            for height in range(node.getblockcount() + 1)
+        ]
+
+    def run_test(self):
+        node = self.nodes[0]
+        for _ in range(4):
+            self.generate(node, 200)
+        blocks = self.get_blocks()
+        assert os.path.exists(self.blk_path(2))
+
+        self.log.info("The full block files get compressed")
+        self.wait_until(
+            lambda: all(os.path.exists(self.blk_path(i, True)) for i in range(2))
+        )
+        self.wait_until(lambda: not os.path.exists(self.blk_path(1)))
+        assert not os.path.exists(self.blk_path(0))
+        # The file that is being written to is left alone
+        assert os.path.exists(self.blk_path(2))
+        assert not os.path.exists(self.blk_path(2, True))
+        assert_equal(self.get_blocks(), blocks)
+
+        self.log.info("The compressed block files can be reindexed")
+        self.restart_node(0, extra_args=["-fastprune", "-reindex"])
+        self.wait_until(lambda: node.getblockcount() == 800)
+        assert_equal(self.get_blocks(), blocks)
+
+        self.log.info("Pruning removes the compressed block files")
+        self.restart_node(0, extra_args=["-fastprune", "-prune=1"])
+        node.pruneblockchain(400)
+        assert not os.path.exists(self.blk_path(0, True))
+        assert os.path.exists(self.blk_path(1, True))
+
+
+if __name__ == "__main__":
+    BlockCompressionTest().main()
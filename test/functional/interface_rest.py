@@ -12,7 +12,12 @@ from io import BytesIO
 from struct import pack, unpack
 
 from test_framework.blocktools import COINBASE_MATURITY
-from test_framework.messages import BLOCK_HEADER_SIZE
+from test_framework.messages import (
+    BLOCK_HEADER_SIZE,
+    XEC,
+    CBlock,
+    deser_compact_size,
+)
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
     assert_equal,
@@ -39,6 +44,43 @@ def filter_output_indices_by_value(vouts, value):
             yield vout["n"]
 
 
+def deser_varint(f):
+    """Read a VARINT as used by the undo data"""
+    n = 0
+    while True:
+        ch = f.read(1)[0]
+        n = (n << 7) | (ch & 0x7F)
+        if not ch & 0x80:
+            return n
+        n += 1
+
+
+def compress_amount(n):
+    """Compress an amount as the undo data does, see compressor.cpp"""
+    if n == 0:
+        return 0
+    e = 0
+    while n % 10 == 0 and e < 9:
+        n //= 10
+        e += 1
+    if e < 9:
+        d = n % 10
+        n //= 10
+        return 1 + (n * 9 + d - 1) * 10 + e
+    return 1 + (n - 1) * 10 + 9
+
+
+def deser_compressed_script(f):
+    """Read a compressed script, except for the P2PK ones"""
+    size = deser_varint(f)
+    if size == 0:
+        return b"\x76\xa9\x14" + f.read(20) + b"\x88\xac"
+    if size == 1:
+        return b"\xa9\x14" + f.read(20) + b"\x87"
+    assert size >= 6
+    return f.read(size - 6)
+
+
 class RESTTest(BitcoinTestFramework):
     def set_test_params(self):
         self.setup_clean_chain = True
@@ -388,6 +430,107 @@ class RESTTest(BitcoinTestFramework):
         # Now we should have 5 header objects
         assert_equal(len(json_obj), 5)
 
+        self.log.info("Test the /blocks/range and /headers/range URIs")
+        self.sync_all()
+        tip_height = self.nodes[0].getblockcount()
+        start = tip_height - 4
+        hashes = [
+            self.nodes[0].getblockhash(h) for h in range(start, tip_height + 1)
+        ]
+        blocks = self.test_rest_request(
+            f"/blocks/range/{start}/{tip_height}",
+            req_type=ReqType.BIN,
+            ret_type=RetType.BYTES,
+        )
+        assert_equal(
+            blocks,
+            b"".join(bytes.fromhex(self.nodes[0].getblock(h, 0)) for h in hashes),
+        )
+        headers = self.test_rest_request(
+            f"/headers/range/{start}/{tip_height}",
+            req_type=ReqType.BIN,
+            ret_type=RetType.BYTES,
+        )
+        assert_equal(
+            headers,
+            b"".join(
+                bytes.fromhex(self.nodes[0].getblockheader(h, False)) for h in hashes
+            ),
+        )
+
+        # Each block is followed by its undo data. The first blocks only have
+        # a coinbase transaction, so their undo data is empty.
+        blocks = self.test_rest_request(
+            "/blocks/range/undo/0/1", req_type=ReqType.BIN, ret_type=RetType.BYTES
+        )
+        assert_equal(
+            blocks,
+            b"".join(
+                bytes.fromhex(self.nodes[0].getblock(self.nodes[0].getblockhash(h), 0))
+                + b"\x00"
+                for h in range(2)
+            ),
+        )
+
+        # The block that spends the coinbase of node 0 has some undo data
+        height = self.nodes[0].getblock(bb_hash)["height"]
+        f = BytesIO(
+            self.test_rest_request(
+                f"/blocks/range/undo/{height - 1}/{height}",
+                req_type=ReqType.BIN,
+                ret_type=RetType.BYTES,
+            )
+        )
+        parent = CBlock()
+        parent.deserialize(f)
+        parent.rehash()
+        assert_equal(parent.hash, self.nodes[0].getblockhash(height - 1))
+        assert_equal(f.read(1), b"\x00")
+        block = CBlock()
+        block.deserialize(f)
+        block.rehash()
+        assert_equal(block.hash, bb_hash)
+        assert_equal(len(block.vtx), 2)
+        assert_equal(block.vtx[1].rehash(), txid)
+        # One CTxUndo for the non coinbase transaction, with one spent coin
+        assert_equal(deser_compact_size(f), 1)
+        assert_equal(deser_compact_size(f), 1)
+        spent_block = self.nodes[0].getblock(self.nodes[0].getblockhash(1), 2)
+        spent_coinbase = spent_block["tx"][0]
+        assert_equal(spent_coinbase["txid"], spent[0])
+        spent_out = spent_coinbase["vout"][spent[1]]
+        # Height and coinbase flag, then the legacy version
+        assert_equal(deser_varint(f), 1 * 2 + 1)
+        assert_equal(deser_varint(f), 0)
+        assert_equal(deser_varint(f), compress_amount(int(spent_out["value"] * XEC)))
+        assert_equal(
+            deser_compressed_script(f).hex(), spent_out["scriptPubKey"]["hex"]
+        )
+        assert_equal(f.read(), b"")
+
+        self.test_rest_request(
+            f"/blocks/range/0/{tip_height + 1}",
+            req_type=ReqType.BIN,
+            status=404,
+            ret_type=RetType.OBJ,
+        )
+        for uri in [
+            f"/blocks/range/{start}/{start - 1}",
+            "/blocks/range/-1/0",
+            "/blocks/range/0/10000",
+            "/blocks/range/notundo/0/1",
+            "/headers/range/0",
+        ]:
+            self.test_rest_request(
+                uri, req_type=ReqType.BIN, status=400, ret_type=RetType.OBJ
+            )
+        self.test_rest_request(
+            f"/blocks/range/0/{start}",
+            req_type=ReqType.HEX,
+            status=404,
+            ret_type=RetType.OBJ,
+        )
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 tx and mine them on node 1
@@ -37,6 +37,7 @@ class RPCInterfaceTest(BitcoinTestFramework):
         self.num_nodes = 1
         self.setup_clean_chain = True
         self.supports_cli = False
+        self.extra_args = [["-rpcbatchparallelism=4"]]
 
     def test_getrpcinfo(self):
         self.log.info("Testing getrpcinfo...")
@@ -52,6 +53,40 @@ class RPCInterfaceTest(BitcoinTestFramework):
             os.path.join(self.nodes[0].datadir, self.chain, "debug.log"),
         )
 
+        self.log.info("Testing the work queues of getrpcinfo...")
+        queues = {queue["name"]: queue for queue in info["work_queues"]}
+        assert_equal(sorted(queues), ["rest", "rpc", "rpc_heavy"])
+        assert_equal(queues["rpc"]["threads"], 4)
+        assert_equal(queues["rpc_heavy"]["threads"], 2)
+        assert_equal(queues["rest"]["threads"], 2)
+        for queue in queues.values():
+            assert_equal(queue["max_depth"], 16)
+            assert_equal(queue["rejected"], 0)
+            for field in ["depth", "processed", "mean_wait", "max_wait",
+                          "mean_duration"]:
+                assert_greater_than_or_equal(queue[field], 0)
+        # The getrpcinfo call itself is being handled
+        assert_equal(queues["rpc"]["active"], 1)
+        assert_equal(queues["rpc_heavy"]["active"], 0)
+
+        # Heavy calls are handled by their own workers, the others are not
+        self.nodes[0].getblock(self.nodes[0].getbestblockhash())
+        self.nodes[0].batch([{"method": "getblockcount", "id": 0},
+                             {"method": "gettxoutsetinfo", "id": 1}])
+        self.nodes[0].getblockcount()
+
+        def processed(name):
+            return next(queue["processed"]
+                        for queue in self.nodes[0].getrpcinfo()["work_queues"]
+                        if queue["name"] == name)
+
+        # The statistics are updated right after the replies are sent. Batch
+        # helpers may add to the count of heavy work items.
+        self.wait_until(lambda: processed("rpc_heavy")
+                        >= queues["rpc_heavy"]["processed"] + 2)
+        self.wait_until(lambda: processed("rpc")
+                        >= queues["rpc"]["processed"] + 3)
+
     def test_batch_request(self):
         self.log.info("Testing basic JSON-RPC batch request...")
 
@@ -80,6 +115,21 @@ class RPCInterfaceTest(BitcoinTestFramework):
         assert_equal(result_by_id[3]["error"], None)
         assert result_by_id[3]["result"] is not None
 
+        self.log.info("Testing that batch replies are in the request order...")
+        results = self.nodes[0].batch(
+            [
+                {"method": "echo" if i % 7 else "invalidmethod", "id": i,
+                 "params": [i]}
+                for i in range(100)
+            ]
+        )
+        assert_equal([res["id"] for res in results], list(range(100)))
+        for i, res in enumerate(results):
+            if i % 7:
+                assert_equal(res["result"], [i])
+            else:
+                assert_equal(res["error"]["code"], -32601)
+
     def test_http_status_codes(self):
         self.log.info("Testing HTTP status codes for JSON-RPC requests...")
 
@@ -96,19 +146,25 @@ class RPCInterfaceTest(BitcoinTestFramework):
         processes = []
         error_queue = multiprocessing.Queue()
         stop_queue = multiprocessing.Queue()
-        for _ in range(3):
-            p = multiprocessing.Process(
-                target=test_work_queue_getrpcinfo,
-                args=(self.nodes[0], error_queue, stop_queue),
-            )
-            p.start()
-            processes.append(p)
-
-        while error_queue.empty():
-            time.sleep(0.1)
-        stop_queue.put(True)
-        for p in processes:
-            p.join()
+        with self.nodes[0].assert_debug_log(
+            [
+                "request rejected because the rpc http work queue depth exceeded",
+                "with the -rpcthreads= setting",
+            ]
+        ):
+            for _ in range(3):
+                p = multiprocessing.Process(
+                    target=test_work_queue_getrpcinfo,
+                    args=(self.nodes[0], error_queue, stop_queue),
+                )
+                p.start()
+                processes.append(p)
+
+            while error_queue.empty():
+                time.sleep(0.1)
+            stop_queue.put(True)
+            for p in processes:
+                p.join()
         while not error_queue.empty():
             assert_equal(
                 error_queue.get(), "error: Server response: Work queue depth exceeded\n"
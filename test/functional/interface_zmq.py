@@ -111,6 +111,7 @@ class ZMQTest(BitcoinTestFramework):
             self.test_mempool_sync()
             self.test_reorg()
             self.test_multiple_interfaces()
+            self.test_raw_tx_batch()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -701,6 +702,69 @@ class ZMQTest(BitcoinTestFramework):
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0].receive().hex())
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[1].receive().hex())
 
+    def test_raw_tx_batch(self):
+        self.log.info("Test the batches of raw transactions")
+        address = "tcp://127.0.0.1:28336"
+        socket = self.ctx.socket(zmq.SUB)
+        socket.setsockopt(zmq.SUBSCRIBE, b"rawtxbatch")
+        self.restart_node(
+            0,
+            [
+                f"-zmqpubrawtxbatch={address}",
+                "-zmqpubrawtxbatchsize=2",
+                "-zmqpubrawtxbatchdelay=5000",
+            ],
+        )
+        socket.connect(address)
+        socket.set(zmq.RCVTIMEO, 10000)
+
+        def receive_batch():
+            topic, *txs, seq = socket.recv_multipart()
+            assert_equal(topic, b"rawtxbatch")
+            return [hash256_reversed(tx).hex() for tx in txs], struct.unpack(
+                "<I", seq
+            )[-1]
+
+        def coinbase_txids(block_hashes):
+            return [
+                self.nodes[0].getblock(block_hash)["tx"][0]
+                for block_hash in block_hashes
+            ]
+
+        # Generate blocks until the subscriber is connected. A batch is sent
+        # when it is full or late, so no transaction is pending afterwards.
+        while True:
+            self.generatetoaddress(
+                self.nodes[0], 1, ADDRESS_ECREG_UNSPENDABLE, sync_fun=self.no_op
+            )
+            try:
+                _, seq = receive_batch()
+                break
+            except zmq.error.Again:
+                self.log.debug("Didn't receive sync-up batch, trying again.")
+
+        # A full batch is sent right away
+        block_hashes = self.generatetoaddress(
+            self.nodes[0], 2, ADDRESS_ECREG_UNSPENDABLE, sync_fun=self.no_op
+        )
+        txids, next_seq = receive_batch()
+        assert_equal(txids, coinbase_txids(block_hashes))
+        assert_equal(next_seq, seq + 1)
+
+        # An incomplete batch is sent once its deadline is reached
+        block_hashes = self.generatetoaddress(
+            self.nodes[0], 1, ADDRESS_ECREG_UNSPENDABLE, sync_fun=self.no_op
+        )
+        txids, last_seq = receive_batch()
+        assert_equal(txids, coinbase_txids(block_hashes))
+        assert_equal(last_seq, next_seq + 1)
+
+        assert_equal(
+            self.nodes[0].getzmqnotifications(),
+            [{"type": "pubrawtxbatch", "address": address, "hwm": 1000}],
+        )
+        socket.close()
+
 
 if __name__ == "__main__":
     ZMQTest().main()
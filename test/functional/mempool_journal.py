@@ -0,0 +1,111 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that the mempool journal restores the mempool after a crash.
+
+With -mempooljournal, the mempool changes are logged to disk as they happen.
+The node is killed before it ever gets to write mempool.dat, and must come
+back with the same mempool, including the transactions entry time and fee
+deltas, but without the transactions that were mined or replaced in the
+meantime.
+"""
+import os
+
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet
+
+
+class MempoolJournalTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [["-mempooljournal"]]
+
+    def mempool_state(self, node):
+        return {
+            txid: (entry["time"], entry["fees"]["modified"])
+            for txid, entry in node.getrawmempool(verbose=True).items()
+        }
+
+    def run_test(self):
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+        self.generate(wallet, COINBASE_MATURITY + 10)
+
+        mempool_dat = os.path.join(node.chain_path, "mempool.dat")
+        journal = mempool_dat + ".journal"
+        assert os.path.isfile(journal)
+        assert os.path.isfile(journal + ".key")
+        assert not os.path.exists(mempool_dat)
+
+        self.log.info("Mined transactions are dropped from the journal")
+        for _ in range(3):
+            wallet.send_self_transfer(from_node=node)
+        self.generate(node, 1)
+        assert_equal(node.getrawmempool(), [])
+
+        self.log.info("Add chained and independent transactions")
+        chain = wallet.send_self_transfer_chain(from_node=node, chain_length=4)
+        independent = [wallet.create_self_transfer() for _ in range(4)]
+        # Prioritised before entering the mempool, so the delta is journaled
+        node.prioritisetransaction(txid=independent[0]["txid"], fee_delta=1000)
+        for tx in independent:
+            wallet.sendrawtransaction(from_node=node, tx_hex=tx["hex"])
+        expected = self.mempool_state(node)
+        assert_equal(len(expected), 8)
+
+        self.log.info("Kill the node and restart it")
+        node.syncwithvalidationinterfacequeue()
+        node.kill_process()
+        assert not os.path.exists(mempool_dat)
+        with node.assert_debug_log(
+            ["Replayed 8 transactions from the mempool journal",
+             "Imported mempool transactions from disk: 8 succeeded"]
+        ):
+            self.start_node(0)
+            self.wait_until(lambda: node.getmempoolinfo()["loaded"])
+        assert_equal(self.mempool_state(node), expected)
+        assert_equal(
+            node.getmempoolentry(chain[-1]["txid"])["depends"],
+            [chain[-2]["txid"]],
+        )
+
+        self.log.info("The journal keeps working after a restart")
+        self.generate(node, 1)
+        tx = wallet.send_self_transfer(from_node=node)
+        node.syncwithvalidationinterfacequeue()
+        node.kill_process()
+        with node.assert_debug_log(
+            ["Replayed 1 transactions from the mempool journal"]
+        ):
+            self.start_node(0)
+            self.wait_until(lambda: node.getmempoolinfo()["loaded"])
+        assert_equal(node.getrawmempool(), [tx["txid"]])
+
+        self.log.info("A truncated record is ignored")
+        self.stop_node(0)
+        with open(journal, "ab") as f:
+            # Beginning of an ADD record
+            f.write(b"\x00\x01\x00")
+        self.start_node(0)
+        self.wait_until(lambda: node.getmempoolinfo()["loaded"])
+        assert_equal(node.getrawmempool(), [tx["txid"]])
+
+        self.log.info("Without the journal key, the scripts are verified again")
+        self.stop_node(0)
+        os.remove(journal + ".key")
+        self.start_node(0)
+        self.wait_until(lambda: node.getmempoolinfo()["loaded"])
+        assert_equal(node.getrawmempool(), [tx["txid"]])
+        assert os.path.isfile(journal + ".key")
+
+        self.log.info("The journal is removed when it is disabled")
+        self.restart_node(0, extra_args=["-mempooljournal=0"])
+        assert not os.path.exists(journal)
+        assert_equal(node.getrawmempool(), [tx["txid"]])
+
+
+if __name__ == "__main__":
+    MempoolJournalTest().main()
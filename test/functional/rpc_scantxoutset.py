@@ -2,11 +2,17 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the scantxoutset rpc call."""
+import threading
 from decimal import Decimal
 
 from test_framework.messages import XEC
 from test_framework.test_framework import BitcoinTestFramework
-from test_framework.util import assert_equal, assert_raises_rpc_error
+from test_framework.util import (
+    assert_equal,
+    assert_greater_than_or_equal,
+    assert_raises_rpc_error,
+    get_rpc_proxy,
+)
 from test_framework.wallet import MiniWallet, address_to_scriptpubkey, getnewdestination
 
 
@@ -458,6 +464,13 @@ class ScantxoutsetTest(BitcoinTestFramework):
             ],
         )
 
+        # The UTXO set is scanned in several ranges, every output is visited
+        # exactly once
+        scan = self.nodes[0].scantxoutset("start", ["raw(00)"])
+        assert_equal(scan["success"], True)
+        assert_equal(scan["unspents"], [])
+        assert_equal(scan["txouts"], self.nodes[0].gettxoutsetinfo()["txouts"])
+
         # Check that status and abort don't need second arg
         assert_equal(self.nodes[0].scantxoutset("status"), None)
         assert_equal(self.nodes[0].scantxoutset("abort"), False)
@@ -470,6 +483,51 @@ class ScantxoutsetTest(BitcoinTestFramework):
             "start",
         )
 
+        self.test_status()
+
+    def test_status(self):
+        self.log.info("Test the status of a scan in progress")
+        node = self.nodes[0]
+        # Deriving the scripts of a large range keeps the scan busy for a while
+        scanobjects = [
+            self.wallet.get_descriptor(),
+            {
+                "desc": "combo(tpubD6NzVbkrYhZ4WaWSyoBvQwbpLkojyoTZPRsgXELWz3Popb3qkjcJyJUGLnL4qHHoQvao8ESaAstxYSnhyswJ76uZPStJRJCTKvosUCJZL5B/1/1/*)",
+                "range": 20000,
+            },
+        ]
+        scan = {}
+
+        def run_scan():
+            # A connection of its own, the main one polls the status
+            rpc = get_rpc_proxy(node.url, 1, timeout=600, coveragedir=node.coverage_dir)
+            scan.update(rpc.scantxoutset("start", scanobjects))
+
+        thread = threading.Thread(target=run_scan)
+        thread.start()
+        statuses = []
+        while thread.is_alive():
+            status = node.scantxoutset("status")
+            if status is not None:
+                statuses.append(status)
+        thread.join()
+        assert_equal(scan["success"], True)
+        assert_equal(node.scantxoutset("status"), None)
+
+        assert len(statuses) > 0
+        final_unspents = {(u["txid"], u["vout"]): u for u in scan["unspents"]}
+        assert_equal(len(final_unspents), len(scan["unspents"]))
+        for status in statuses:
+            assert_equal(
+                sorted(status.keys()), ["found", "progress", "txouts", "unspents"]
+            )
+            assert 0 <= status["progress"] <= 100
+            assert_greater_than_or_equal(status["found"], len(status["unspents"]))
+            # The outputs found so far are reported as in the final reply
+            for unspent in status["unspents"]:
+                outpoint = (unspent["txid"], unspent["vout"])
+                assert_equal(final_unspents[outpoint], unspent)
+
 
 if __name__ == "__main__":
     ScantxoutsetTest().main()
@@ -0,0 +1,115 @@
+# Copyright (c) 2024 The Bitcoin developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the sendrawtransactions RPC."""
+
+import random
+from decimal import Decimal
+
+from test_framework.blocktools import COINBASE_MATURITY
+from test_framework.messages import COutPoint, CTxIn
+from test_framework.p2p import P2PTxInvStore
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+from test_framework.wallet import MiniWallet
+
+RPC_TRANSACTION_ERROR = -25
+RPC_TRANSACTION_REJECTED = -26
+
+
+class RPCSendRawTransactionsTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+
+    def run_test(self):
+        node = self.nodes[0]
+        self.wallet = MiniWallet(node)
+        self.generate(self.wallet, COINBASE_MATURITY + 20)
+        peer = node.add_p2p_connection(P2PTxInvStore())
+
+        self.log.info("Invalid batch sizes are rejected")
+        assert_raises_rpc_error(
+            -8, "Array must contain between 1 and 1000 transactions",
+            node.sendrawtransactions, [])
+        assert_raises_rpc_error(
+            -22, "TX decode failed", node.sendrawtransactions, ["00"])
+
+        self.log.info("Unsorted chained and independent transactions")
+        chain = self.wallet.create_self_transfer_chain(chain_length=5)
+        independent = [self.wallet.create_self_transfer() for _ in range(3)]
+        batch = chain + independent
+        random.shuffle(batch)
+        results = node.sendrawtransactions([tx["hex"] for tx in batch])
+        assert_equal(results, [{"txid": tx["txid"], "accepted": True}
+                               for tx in batch])
+        assert_equal(
+            sorted(node.getrawmempool()), sorted(tx["txid"] for tx in batch))
+        # The accepted transactions are announced to the peer
+        peer.wait_for_broadcast([tx["txid"] for tx in batch])
+
+        self.log.info("Transactions already in the mempool are accepted")
+        results = node.sendrawtransactions([tx["hex"] for tx in batch])
+        assert all(res["accepted"] for res in results)
+        self.generate(node, 1)
+
+        self.log.info("Transactions already in the chain are rejected")
+        results = node.sendrawtransactions([independent[0]["hex"]])
+        assert_equal(results[0]["accepted"], False)
+        assert_equal(results[0]["error-code"], -27)
+
+        self.log.info("Each transaction is rejected individually")
+        parent = self.wallet.create_self_transfer()
+        child = self.wallet.create_self_transfer(
+            utxo_to_spend=parent["new_utxo"])
+        orphan = self.wallet.create_self_transfer()
+        orphan["tx"].vin.append(
+            CTxIn(COutPoint(int(parent["txid"], 16), 42)))
+        orphan_hex = orphan["tx"].serialize().hex()
+        double_spend = self.wallet.create_self_transfer(
+            utxo_to_spend=parent["new_utxo"], fee_rate=Decimal("5000"))
+        valid = self.wallet.create_self_transfer()
+        results = node.sendrawtransactions(
+            [parent["hex"], child["hex"], orphan_hex, double_spend["hex"],
+             valid["hex"]])
+        assert_equal(results[0], {"txid": parent["txid"], "accepted": True})
+        assert_equal(results[1], {"txid": child["txid"], "accepted": True})
+        assert_equal(results[2]["accepted"], False)
+        assert_equal(results[2]["error-code"], RPC_TRANSACTION_ERROR)
+        assert_equal(results[2]["error"], "bad-txns-inputs-missingorspent")
+        assert_equal(results[3]["accepted"], False)
+        assert_equal(results[3]["error-code"], RPC_TRANSACTION_REJECTED)
+        assert_equal(results[3]["error"], "conflict-in-batch")
+        assert_equal(results[4], {"txid": valid["txid"], "accepted": True})
+
+        self.log.info("The children of rejected transactions are rejected")
+        parent = self.wallet.create_self_transfer()
+        parent["tx"].vin.append(CTxIn(COutPoint(int(valid["txid"], 16), 42)))
+        parent["tx"].rehash()
+        child = self.wallet.create_self_transfer_multi(
+            utxos_to_spend=[{
+                "txid": parent["tx"].hash,
+                "vout": 0,
+                "value": parent["new_utxo"]["value"],
+            }])
+        results = node.sendrawtransactions(
+            [child["hex"], parent["tx"].serialize().hex()])
+        for res in results:
+            assert_equal(res["accepted"], False)
+            assert_equal(res["error"], "bad-txns-inputs-missingorspent")
+
+        self.log.info("Transactions paying too much fees are rejected")
+        expensive = self.wallet.create_self_transfer()
+        results = node.sendrawtransactions([expensive["hex"]],
+                                           maxfeerate=Decimal("1"))
+        assert_equal(results[0]["accepted"], False)
+        assert_equal(results[0]["error-code"], RPC_TRANSACTION_ERROR)
+        assert_equal(
+            results[0]["error"],
+            "Fee exceeds maximum configured by user (e.g. -maxtxfee, "
+            "maxfeerate)")
+        assert expensive["txid"] not in node.getrawmempool()
+
+
+if __name__ == "__main__":
+    RPCSendRawTransactionsTest().main()
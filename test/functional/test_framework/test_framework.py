@@ -1052,6 +1052,11 @@ class BitcoinTestFramework(metaclass=BitcoinTestMetaClass):
         if not self.is_zmq_compiled():
             raise SkipTest("bitcoind has not been built with zmq enabled.")
 
+    def skip_if_no_zstd(self):
+        """Skip the running test if bitcoind has not been compiled with zstd support."""
+        if not self.is_zstd_compiled():
+            raise SkipTest("bitcoind has not been built with zstd enabled.")
+
     def skip_if_no_wallet(self):
         """Skip the running test if wallet has not been compiled."""
         if not self.is_wallet_compiled():
@@ -1101,6 +1106,10 @@ class BitcoinTestFramework(metaclass=BitcoinTestMetaClass):
         """Checks whether the zmq module was compiled."""
         return self.config["components"].getboolean("ENABLE_ZMQ")
 
+    def is_zstd_compiled(self):
+        """Checks whether block file compression was compiled."""
+        return self.config["components"].getboolean("ENABLE_ZSTD")
+
     def is_usdt_compiled(self):
         """Checks whether the USDT tracepoints were compiled."""
         return self.config["components"].getboolean("ENABLE_USDT_TRACEPOINTS")
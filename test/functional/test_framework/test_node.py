@@ -586,6 +586,19 @@ class TestNode:
         if wait_until_stopped:
             self.wait_until_stopped()
 
+    def kill_process(self):
+        """Kill the node process, skipping the clean shutdown."""
+        self.process.kill()
+        self.process.wait(timeout=BITCOIND_PROC_WAIT_TIMEOUT)
+        self.stdout.close()
+        self.stderr.close()
+        del self.p2ps[:]
+        self.running = False
+        self.process = None
+        self.rpc_connected = False
+        self.rpc = None
+        self.log.debug("Node killed")
+
     def is_node_stopped(self):
         """Checks whether the node has stopped.
 